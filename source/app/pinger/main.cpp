@@ -23,6 +23,7 @@ struct ping_state {
     std::chrono::microseconds min_time{std::chrono::microseconds::max()};
     std::chrono::microseconds max_time{std::chrono::microseconds::zero()};
     std::chrono::microseconds sum_time{std::chrono::microseconds::zero()};
+    latency_histogram latencies{};
     std::chrono::steady_clock::time_point start{std::chrono::steady_clock::now()};
     std::chrono::steady_clock::time_point finish{std::chrono::steady_clock::now()};
     std::intmax_t sent{0};
@@ -172,6 +173,7 @@ public:
         state.min_time = std::min(state.min_time, pong.age);
         state.max_time = std::max(state.max_time, pong.age);
         state.sum_time += pong.age;
+        state.latencies.add(pong.age);
         state.finish = std::chrono::steady_clock::now();
         if((++_rcvd % _mod) == 0) [[unlikely]] {
             const auto now{std::chrono::steady_clock::now()};
@@ -269,6 +271,10 @@ public:
               .arg("minTime", info.min_time)
               .arg("maxTime", info.max_time)
               .arg("avgTime", info.avg_time())
+              .arg("p50Time", info.latencies.percentile(0.50F))
+              .arg("p90Time", info.latencies.percentile(0.90F))
+              .arg("p99Time", info.latencies.percentile(0.99F))
+              .arg("p999Time", info.latencies.percentile(0.999F))
               .arg("responded", info.responded)
               .arg("timeouted", info.timeouted)
               .arg("duration", info.time_interval())
@@ -276,6 +282,15 @@ public:
               .arg(
                 "rspdPerSec", "RatePerSec", info.responds_per_second(), not_avail);
         }
+
+        const auto& latencies{this->ping_latencies()};
+        log_stat("overall ping round-trip times")
+          .arg("p50Time", latencies.percentile(0.50F))
+          .arg("p90Time", latencies.percentile(0.90F))
+          .arg("p99Time", latencies.percentile(0.99F))
+          .arg("p999Time", latencies.percentile(0.999F))
+          .arg("maxTime", std::chrono::microseconds{latencies.max_us})
+          .arg("responded", latencies.sample_count);
     }
 
 private:
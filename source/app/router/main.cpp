@@ -244,7 +244,7 @@ auto router_app::step(msgbus::router_node& node) -> work_done {
         ++stats.cycles_idle;
         stats.max_idle_streak =
           math::maximum(stats.max_idle_streak, ++stats.idle_streak);
-        std::this_thread::sleep_for(
+        router.wait_for_work(
           std::chrono::microseconds(math::minimum(stats.idle_streak, 5000)));
     }
     return something_done;
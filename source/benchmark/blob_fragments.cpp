@@ -0,0 +1,152 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+import eagine.core;
+import eagine.msgbus;
+import std;
+
+#include "report.hpp"
+
+namespace eagine {
+namespace msgbus {
+//------------------------------------------------------------------------------
+class bench_source_blob_io final : public source_blob_io {
+public:
+    bench_source_blob_io(const span_size_t size) noexcept
+      : _size{size} {}
+
+    auto total_size() noexcept -> span_size_t final {
+        return _size;
+    }
+
+    auto fetch_fragment(const span_size_t offs, memory::block dst) noexcept
+      -> span_size_t final {
+        return zero(head(dst, _size - offs)).size();
+    }
+
+private:
+    span_size_t _size;
+};
+//------------------------------------------------------------------------------
+class bench_target_blob_io final : public target_blob_io {
+public:
+    bench_target_blob_io(bool& done) noexcept
+      : _done{done} {}
+
+    void handle_finished(
+      const message_id,
+      const message_age,
+      const message_info&,
+      const blob_info&) noexcept final {
+        _done = true;
+    }
+
+    void handle_cancelled() noexcept final {
+        _done = true;
+    }
+
+    auto store_fragment(
+      const span_size_t,
+      memory::const_block data,
+      const blob_info&) noexcept -> bool final {
+        bench_keep(std::size_t(data.size()));
+        return true;
+    }
+
+private:
+    bool& _done;
+};
+//------------------------------------------------------------------------------
+} // namespace msgbus
+//------------------------------------------------------------------------------
+auto main(main_ctx& ctx) -> int {
+    span_size_t blob_size{64 * 1024 * 1024};
+    span_size_t fragment_size{4 * 1024};
+    bool shuffled{false};
+
+    if(const auto arg{ctx.args().find("--blob-size")}) {
+        assign_if_fits(arg.next(), blob_size);
+    }
+    if(const auto arg{ctx.args().find("--fragment-size")}) {
+        assign_if_fits(arg.next(), fragment_size);
+    }
+    if(ctx.args().find("--shuffled")) {
+        shuffled = true;
+    }
+
+    const message_id blob_msg_id{"eagiBench", "blob"};
+    const message_id send_msg_id{"eagiBench", "send"};
+    const message_id resend_msg_id{"eagiBench", "resend"};
+    const message_id prepare_msg_id{"eagiBench", "prepare"};
+    msgbus::blob_manipulator sender{
+      ctx, send_msg_id, resend_msg_id, prepare_msg_id};
+    msgbus::blob_manipulator receiver{
+      ctx, send_msg_id, resend_msg_id, prepare_msg_id};
+
+    // the fragments are collected first, so that only the merge is measured
+    std::vector<msgbus::stored_message> fragments;
+    const auto collect{[&](const message_id, const msgbus::message_view& message) {
+        fragments.emplace_back(message, memory::buffer{});
+        return true;
+    }};
+    const msgbus::blob_manipulator::send_handler collect_handler{
+      construct_from, collect};
+
+    sender.push_outgoing(
+      blob_msg_id,
+      1234,
+      2345,
+      0,
+      {hold<msgbus::bench_source_blob_io>, blob_size},
+      std::chrono::hours{1},
+      msgbus::message_priority::normal);
+    while(sender.process_outgoing(collect_handler, fragment_size, 64)) {
+    }
+
+    if(shuffled) {
+        std::mt19937 rng{0x5EED1234U};
+        std::shuffle(fragments.begin(), fragments.end(), rng);
+    }
+
+    bool done{false};
+    receiver.expect_incoming(
+      blob_msg_id,
+      1234,
+      msgbus::blob_id_t(0),
+      {hold<msgbus::bench_target_blob_io>, done},
+      std::chrono::hours{1});
+
+    const auto start{std::chrono::steady_clock::now()};
+    for(const auto& fragment : fragments) {
+        receiver.process_incoming(fragment);
+    }
+    receiver.handle_complete();
+    const std::chrono::duration<double> seconds{
+      std::chrono::steady_clock::now() - start};
+
+    msgbus::bench_result{"blob_fragments", "fragment_merge"}
+      .param("blobSize", blob_size)
+      .param("fragmentSize", fragment_size)
+      .param("order", shuffled ? "shuffled" : "sequential")
+      .param("fragments", span_size(fragments.size()))
+      .metric("seconds", seconds.count())
+      .metric("fragmentsPerSec", double(fragments.size()) / seconds.count())
+      .metric("bytesPerSec", double(blob_size) / seconds.count())
+      .metric("completed", done ? 1.0 : 0.0)
+      .write();
+
+    return 0;
+}
+//------------------------------------------------------------------------------
+} // namespace eagine
+//------------------------------------------------------------------------------
+auto main(int argc, const char** argv) -> int {
+    eagine::main_ctx_options options;
+    options.app_id = "BlobBench";
+    return eagine::main_impl(argc, argv, options, &eagine::main);
+}
+//------------------------------------------------------------------------------
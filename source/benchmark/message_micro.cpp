@@ -0,0 +1,208 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+import eagine.core;
+import eagine.msgbus;
+import std;
+
+#include "report.hpp"
+
+namespace eagine {
+namespace msgbus {
+//------------------------------------------------------------------------------
+class message_micro_bench {
+public:
+    message_micro_bench(main_ctx& ctx) noexcept {
+        if(const auto arg{ctx.args().find("--repeats")}) {
+            assign_if_fits(arg.next(), _repeats);
+        }
+        if(const auto arg{ctx.args().find("--message-size")}) {
+            assign_if_fits(arg.next(), _message_size);
+        }
+        // fixed seed, so that the runs are reproducible
+        std::mt19937 rng{_seed};
+        std::uniform_int_distribution<int> dist{0, 255};
+        _payload.resize(std::size_t(_message_size));
+        for(auto& b : _payload) {
+            b = byte(dist(rng));
+        }
+        _buffer.resize(_message_size + 1024);
+    }
+
+    void header_serialize_portable() {
+        const auto message{_make_message()};
+        const auto duration{bench_measure(_repeats, [&] {
+            block_data_sink sink(cover(_buffer));
+            default_serializer_backend backend(sink);
+            if(serialize_message(_msg_id, message, backend)) {
+                bench_keep(std::size_t(sink.done().size()));
+            }
+        })};
+        _report_per_op("header_serialize_portable", duration);
+    }
+
+    void header_deserialize_portable() {
+        const auto message{_make_message()};
+        block_data_sink sink(cover(_buffer));
+        default_serializer_backend backend(sink);
+        if(not serialize_message(_msg_id, message, backend)) {
+            return;
+        }
+        const auto serialized{sink.done()};
+        stored_message stored{};
+        const auto duration{bench_measure(_repeats, [&] {
+            message_id msg_id{};
+            block_data_source source(serialized);
+            default_deserializer_backend dbackend(source);
+            if(deserialize_message(msg_id, stored, dbackend)) {
+                bench_keep(std::size_t(stored.data().size()));
+            }
+        })};
+        _report_per_op("header_deserialize_portable", duration);
+    }
+
+    void header_serialize_compact() {
+        const auto message{_make_message()};
+        const auto duration{bench_measure(_repeats, [&] {
+            bench_keep(std::size_t(
+              compact_serialize_message(_msg_id, message, cover(_buffer))
+                .size()));
+        })};
+        _report_per_op("header_serialize_compact", duration);
+    }
+
+    void header_deserialize_compact() {
+        const auto message{_make_message()};
+        const auto serialized{
+          compact_serialize_message(_msg_id, message, cover(_buffer))};
+        const auto duration{bench_measure(_repeats, [&] {
+            message_id msg_id{};
+            message_view view{};
+            if(compact_deserialize_message(msg_id, view, serialized)) {
+                bench_keep(std::size_t(view.data().size()));
+            }
+        })};
+        _report_per_op("header_deserialize_compact", duration);
+    }
+
+    void storage_pack_into() {
+        const auto message{_make_message()};
+        block_data_sink sink(cover(_buffer));
+        default_serializer_backend backend(sink);
+        if(not serialize_message(_msg_id, message, backend)) {
+            return;
+        }
+        const auto serialized{sink.done()};
+        const span_size_t batch{64};
+        serialized_message_storage storage;
+        memory::buffer packed;
+        packed.resize(4 * 1024);
+        std::mt19937 rng{_seed};
+        std::uniform_int_distribution<int> prio{0, 3};
+
+        const auto duration{bench_measure(_repeats / batch, [&] {
+            for(span_size_t i = 0; i < batch; ++i) {
+                storage.push(serialized, message_priority(prio(rng)));
+            }
+            while(not storage.empty()) {
+                const auto info{storage.pack_into(cover(packed))};
+                if(info.is_empty()) {
+                    break;
+                }
+                bench_keep(std::size_t(info.used()));
+                storage.cleanup(info);
+            }
+        })};
+        // the warm-up batch of bench_measure is not timed
+        _report_per_op(
+          "storage_pack_into", duration, (_repeats / batch) * batch);
+    }
+
+    void priority_queue_push() {
+        const auto message{_make_message()};
+        const span_size_t batch{256};
+        message_priority_queue queue;
+        std::mt19937 rng{_seed};
+        std::uniform_int_distribution<int> prio{0, 3};
+        std::vector<message_view> messages(std::size_t(batch), message);
+        for(auto& msg : messages) {
+            msg.set_priority(message_priority(prio(rng)));
+        }
+
+        std::chrono::duration<double> duration{};
+        for(span_size_t r = 0; r < _repeats / batch; ++r) {
+            const auto start{std::chrono::steady_clock::now()};
+            for(const auto& msg : messages) {
+                queue.push(msg);
+            }
+            duration += std::chrono::steady_clock::now() - start;
+            for(auto& stored : queue.give_messages()) {
+                bench_keep(std::size_t(stored.data().size()));
+            }
+        }
+        _report_per_op(
+          "priority_queue_push", duration, (_repeats / batch) * batch);
+    }
+
+private:
+    auto _make_message() const noexcept -> message_view {
+        message_view message{view(_payload)};
+        message.set_source_id(endpoint_id_t{1234});
+        message.set_target_id(endpoint_id_t{2345});
+        message.set_sequence_no(message_sequence_t{3456});
+        return message;
+    }
+
+    void _report_per_op(
+      const std::string_view name,
+      const std::chrono::duration<double> duration) {
+        _report_per_op(name, duration, _repeats);
+    }
+
+    void _report_per_op(
+      const std::string_view name,
+      const std::chrono::duration<double> duration,
+      const span_size_t count) {
+        const auto seconds{duration.count()};
+        bench_result{"message_micro", name}
+          .param("repeats", count)
+          .param("messageSize", _message_size)
+          .metric("nsPerOp", seconds * 1e9 / double(std::max(count, 1)))
+          .metric("opsPerSec", double(count) / seconds)
+          .write();
+    }
+
+    static constexpr const message_id _msg_id{"eagiBench", "micro"};
+    static constexpr const std::uint32_t _seed{0x5EED1234U};
+
+    span_size_t _repeats{1000000};
+    span_size_t _message_size{256};
+    std::vector<byte> _payload;
+    memory::buffer _buffer;
+};
+//------------------------------------------------------------------------------
+} // namespace msgbus
+//------------------------------------------------------------------------------
+auto main(main_ctx& ctx) -> int {
+    msgbus::message_micro_bench bench{ctx};
+    bench.header_serialize_portable();
+    bench.header_deserialize_portable();
+    bench.header_serialize_compact();
+    bench.header_deserialize_compact();
+    bench.storage_pack_into();
+    bench.priority_queue_push();
+    return 0;
+}
+//------------------------------------------------------------------------------
+} // namespace eagine
+//------------------------------------------------------------------------------
+auto main(int argc, const char** argv) -> int {
+    eagine::main_ctx_options options;
+    options.app_id = "MsgMcBench";
+    return eagine::main_impl(argc, argv, options, &eagine::main);
+}
+//------------------------------------------------------------------------------
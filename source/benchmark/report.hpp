@@ -0,0 +1,130 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+#ifndef EAGINE_MSGBUS_BENCHMARK_REPORT
+#define EAGINE_MSGBUS_BENCHMARK_REPORT
+
+import std;
+import eagine.core;
+
+namespace eagine::msgbus {
+//------------------------------------------------------------------------------
+/// @brief Collects the parameters and metrics of a single benchmark result.
+/// @note The result is written to stdout as one JSON object per line, so that
+/// the outputs of runs of different builds can be collected and compared.
+class bench_result {
+public:
+    bench_result(const std::string_view suite, const std::string_view name) {
+        _line.append(R"({"suite":")");
+        _append_escaped(suite);
+        _line.append(R"(","benchmark":")");
+        _append_escaped(name);
+        _line.append(R"(","params":{)");
+    }
+
+    /// @brief Adds a string parameter of the benchmark.
+    auto param(const std::string_view key, const std::string_view value)
+      -> bench_result& {
+        _append_key(key, _param_count);
+        _line.push_back('"');
+        _append_escaped(value);
+        _line.push_back('"');
+        return *this;
+    }
+
+    /// @brief Adds a numeric parameter of the benchmark.
+    auto param(const std::string_view key, const span_size_t value)
+      -> bench_result& {
+        _append_key(key, _param_count);
+        _line.append(std::to_string(value));
+        return *this;
+    }
+
+    /// @brief Adds a measured value.
+    auto metric(const std::string_view key, const double value)
+      -> bench_result& {
+        if(_metric_count == 0) {
+            _line.append(R"(},"metrics":{)");
+        }
+        _append_key(key, _metric_count);
+        if(std::isfinite(value)) {
+            _line.append(std::format("{:.6g}", value));
+        } else {
+            _line.append("null");
+        }
+        return *this;
+    }
+
+    /// @brief Writes the result line to the standard output.
+    void write() {
+        if(_metric_count == 0) {
+            _line.append(R"(},"metrics":{)");
+        }
+        _line.append("}}");
+        std::cout << _line << std::endl;
+    }
+
+private:
+    void _append_key(const std::string_view key, span_size_t& count) {
+        if(count++ > 0) {
+            _line.push_back(',');
+        }
+        _line.push_back('"');
+        _append_escaped(key);
+        _line.append(R"(":)");
+    }
+
+    void _append_escaped(const std::string_view str) {
+        for(const char c : str) {
+            if((c == '"') or (c == '\\')) {
+                _line.push_back('\\');
+            }
+            _line.push_back(c);
+        }
+    }
+
+    std::string _line;
+    span_size_t _param_count{0};
+    span_size_t _metric_count{0};
+};
+//------------------------------------------------------------------------------
+/// @brief Keeps the compiler from optimizing away the benchmarked computation.
+inline void bench_keep(const std::size_t value) noexcept {
+    static volatile std::size_t sink{0U};
+    sink = sink + value;
+}
+//------------------------------------------------------------------------------
+/// @brief Calls the function the specified number of times, after a warm-up call.
+template <typename Function>
+auto bench_measure(const span_size_t repeats, Function func)
+  -> std::chrono::duration<double> {
+    func();
+    const auto start{std::chrono::steady_clock::now()};
+    for(span_size_t i = 0; i < repeats; ++i) {
+        func();
+    }
+    return std::chrono::steady_clock::now() - start;
+}
+//------------------------------------------------------------------------------
+/// @brief Returns the specified quantile of the samples, reordering them.
+inline auto bench_quantile(std::vector<double>& samples, const double q)
+  -> double {
+    if(samples.empty()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    const auto pos{static_cast<std::size_t>(
+      q * static_cast<double>(samples.size() - 1U))};
+    std::nth_element(
+      samples.begin(),
+      samples.begin() + static_cast<std::ptrdiff_t>(pos),
+      samples.end());
+    return samples[pos];
+}
+//------------------------------------------------------------------------------
+} // namespace eagine::msgbus
+
+#endif
@@ -0,0 +1,337 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+import eagine.core;
+import eagine.msgbus;
+import std;
+
+#include "report.hpp"
+
+namespace eagine {
+namespace msgbus {
+//------------------------------------------------------------------------------
+// a sender endpoint posting messages to several receivers through the router
+class forwarding_bench_group {
+public:
+    forwarding_bench_group(
+      main_ctx& ctx,
+      connection_factory& factory,
+      const string_view address,
+      const span_size_t index,
+      const span_size_t fan_out,
+      const span_size_t message_count) noexcept
+      : _sender{identifier{"Sender"}, ctx}
+      , _message_count{message_count} {
+        const auto first_id{1000 + index * (fan_out + 1)};
+        _sender.preconfigure_id(endpoint_id_t(first_id));
+        _sender.add_connection(factory.make_connector(address));
+        for(const auto r : integer_range(fan_out)) {
+            auto& receiver{*_receivers.emplace_back(
+              std::make_unique<endpoint>(identifier{"Receiver"}, ctx))};
+            receiver.preconfigure_id(endpoint_id_t(first_id + r + 1));
+            receiver.add_connection(factory.make_connector(address));
+            receiver.ensure_queue(_msg_id);
+        }
+        _latencies.reserve(std::size_t(fan_out * message_count));
+    }
+
+    auto is_ready() const noexcept -> bool {
+        return _sender.has_id() and
+               std::all_of(
+                 _receivers.begin(), _receivers.end(), [](const auto& receiver) {
+                     return receiver->has_id();
+                 });
+    }
+
+    auto is_done() const noexcept -> bool {
+        return received() >= _message_count * span_size(_receivers.size());
+    }
+
+    auto received() const noexcept -> span_size_t {
+        return span_size(_latencies.size());
+    }
+
+    auto latencies() noexcept -> std::vector<double>& {
+        return _latencies;
+    }
+
+    auto update() noexcept -> work_done {
+        some_true something_done{};
+        if(is_ready()) {
+            for(span_size_t i = 0; i < 64 and _sent < _message_count; ++i) {
+                const auto now{std::chrono::steady_clock::now()
+                                 .time_since_epoch()
+                                 .count()};
+                std::memcpy(_payload.data(), &now, sizeof(now));
+                message_view message{view(_payload)};
+                message.set_sequence_no(message_sequence_t(_sent));
+                for(const auto& receiver : _receivers) {
+                    message.set_target_id(receiver->get_id());
+                    _sender.post(_msg_id, message);
+                }
+                ++_sent;
+                something_done();
+            }
+        }
+        something_done(_sender.update());
+        for(const auto& receiver : _receivers) {
+            something_done(receiver->update());
+            something_done(
+              receiver->process_all(
+                _msg_id,
+                {construct_from,
+                 [this](const message_context&, const stored_message& msg) noexcept {
+                     _record_latency(msg);
+                     return true;
+                 }}) > 0);
+        }
+        return something_done;
+    }
+
+    void finish() noexcept {
+        _sender.finish();
+        for(const auto& receiver : _receivers) {
+            receiver->finish();
+        }
+    }
+
+private:
+    void _record_latency(const stored_message& msg) noexcept {
+        using clock = std::chrono::steady_clock;
+        clock::rep sent{0};
+        const auto content{msg.content()};
+        if(content.size() >= span_size(sizeof(sent))) [[likely]] {
+            std::memcpy(&sent, content.data(), sizeof(sent));
+            const std::chrono::duration<double, std::micro> latency{
+              clock::now() - clock::time_point{clock::duration{sent}}};
+            _latencies.push_back(latency.count());
+        }
+    }
+
+    static constexpr const message_id _msg_id{"eagiBench", "forward"};
+
+    endpoint _sender;
+    std::vector<std::unique_ptr<endpoint>> _receivers;
+    span_size_t _message_count;
+    span_size_t _sent{0};
+    std::vector<double> _latencies;
+    std::array<byte, 64> _payload{};
+};
+//------------------------------------------------------------------------------
+static auto make_bench_connection_factory(
+  main_ctx& ctx,
+  const string_view kind,
+  std::string& address) -> unique_holder<connection_factory> {
+    const auto default_address{[&](const string_view addr) {
+        if(address.empty()) {
+            address = to_string(addr);
+        }
+    }};
+    if(kind == string_view{"posix_mqueue"}) {
+        default_address("/eagine-bench");
+        return make_posix_mqueue_connection_factory(ctx);
+    }
+    if(kind == string_view{"shmem_ring"}) {
+        default_address("/eagine-bench-shm");
+        return make_shmem_ring_connection_factory(ctx);
+    }
+    if(kind == string_view{"asio_local_stream"}) {
+        default_address("/tmp/eagine-bench.socket");
+        return make_asio_local_stream_connection_factory(ctx);
+    }
+    if(kind == string_view{"asio_tcp_ipv4"}) {
+        default_address("localhost:34920");
+        return make_asio_tcp_ipv4_connection_factory(ctx);
+    }
+    if(kind == string_view{"asio_udp_ipv4"}) {
+        default_address("localhost:34921");
+        return make_asio_udp_ipv4_connection_factory(ctx);
+    }
+    default_address("bench");
+    return make_direct_connection_factory(ctx);
+}
+//------------------------------------------------------------------------------
+struct forwarding_bench_params {
+    std::string kind{"direct"};
+    std::string address;
+    span_size_t group_count{8};
+    span_size_t fan_out{1};
+    span_size_t message_count{100000};
+    span_size_t time_limit{60};
+};
+//------------------------------------------------------------------------------
+static auto run_forwarding_bench(
+  main_ctx& ctx,
+  connection_factory& factory,
+  const forwarding_bench_params& params,
+  const span_size_t workers) -> bool {
+    const auto& address{params.address};
+    const auto group_count{params.group_count};
+    const auto fan_out{params.fan_out};
+    const auto message_count{params.message_count};
+
+    // the router uses a workshop with exactly the specified number of threads
+    workshop router_workers{};
+    router_workers.populate(workers);
+    router router(ctx);
+    router.use_workshop(router_workers);
+    router.set_max_workers(workers);
+    router.add_acceptor(factory.make_acceptor(address));
+    router.update();
+
+    std::vector<std::unique_ptr<forwarding_bench_group>> groups;
+    for(const auto index : integer_range(group_count)) {
+        groups.emplace_back(std::make_unique<forwarding_bench_group>(
+          ctx, factory, address, index, fan_out, message_count));
+    }
+
+    const timeout deadline{std::chrono::seconds{params.time_limit}};
+    std::atomic<bool> started{false};
+    std::atomic<bool> stopped{false};
+    std::atomic<span_size_t> ready{0};
+    std::atomic<span_size_t> finished{0};
+    std::vector<std::thread> threads;
+    threads.reserve(groups.size());
+    for(auto& group : groups) {
+        threads.emplace_back([&, &group{*group}]() {
+            // the group endpoints are only accessed from this thread
+            while(not group.is_ready() and not stopped) {
+                group.update();
+                std::this_thread::yield();
+            }
+            ++ready;
+            while(not started and not stopped) {
+                group.update();
+                std::this_thread::yield();
+            }
+            while(not group.is_done() and not stopped) {
+                if(not group.update()) {
+                    std::this_thread::yield();
+                }
+            }
+            ++finished;
+        });
+    }
+
+    while(ready < group_count and not deadline.is_expired()) {
+        router.update();
+    }
+
+    const auto start{std::chrono::steady_clock::now()};
+    started = true;
+    while(finished < group_count) {
+        router.update();
+        if(deadline.is_expired()) {
+            stopped = true;
+        }
+    }
+    const std::chrono::duration<double> seconds{
+      std::chrono::steady_clock::now() - start};
+
+    for(auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<double> latencies;
+    for(auto& group : groups) {
+        latencies.insert(
+          latencies.end(), group->latencies().begin(), group->latencies().end());
+        group->finish();
+    }
+    router.update();
+    router.finish();
+
+    const auto received{span_size(latencies.size())};
+    const auto expected{group_count * fan_out * message_count};
+    bench_result{"router_forwarding", "throughput_latency"}
+      .param("connectionKind", params.kind)
+      .param("groups", group_count)
+      .param("fanOut", fan_out)
+      .param("workers", workers)
+      .param("messages", expected)
+      .metric("received", double(received))
+      .metric("completed", received >= expected ? 1.0 : 0.0)
+      .metric("seconds", seconds.count())
+      .metric("msgsPerSec", double(received) / seconds.count())
+      .metric("latencyP50Us", bench_quantile(latencies, 0.50))
+      .metric("latencyP99Us", bench_quantile(latencies, 0.99))
+      .metric("latencyMaxUs", bench_quantile(latencies, 1.00))
+      .write();
+
+    ctx.log()
+      .stat("forwarded ${count} messages in ${duration}")
+      .tag("fwdBench")
+      .arg("kind", params.kind)
+      .arg("groups", group_count)
+      .arg("fanOut", fan_out)
+      .arg("workers", workers)
+      .arg("count", received)
+      .arg("duration", seconds);
+
+    return received >= expected;
+}
+//------------------------------------------------------------------------------
+} // namespace msgbus
+//------------------------------------------------------------------------------
+auto main(main_ctx& ctx) -> int {
+    msgbus::forwarding_bench_params params;
+    span_size_t max_workers{
+      ctx.system().cpu_concurrent_threads().value_or(4)};
+
+    if(const auto arg{ctx.args().find("--group-count")}) {
+        assign_if_fits(arg.next(), params.group_count);
+    }
+    if(const auto arg{ctx.args().find("--fan-out")}) {
+        assign_if_fits(arg.next(), params.fan_out);
+    }
+    if(const auto arg{ctx.args().find("--message-count")}) {
+        assign_if_fits(arg.next(), params.message_count);
+    }
+    if(const auto arg{ctx.args().find("--time-limit")}) {
+        assign_if_fits(arg.next(), params.time_limit);
+    }
+    if(const auto arg{ctx.args().find("--max-workers")}) {
+        assign_if_fits(arg.next(), max_workers);
+    }
+    if(const auto arg{ctx.args().find("--connection-kind")}) {
+        params.kind = arg.next().get_string();
+    }
+    if(const auto arg{ctx.args().find("--address")}) {
+        params.address = arg.next().get_string();
+    }
+
+    auto factory{
+      msgbus::make_bench_connection_factory(ctx, params.kind, params.address)};
+    if(not factory) {
+        ctx.log()
+          .error("connection kind ${kind} is not available")
+          .tag("fwdBench")
+          .arg("kind", params.kind);
+        return 1;
+    }
+
+    // the number of router worker threads is doubled in each step
+    bool completed{true};
+    max_workers = std::max(max_workers, span_size(1));
+    for(span_size_t workers = 1;; workers = std::min(workers * 2, max_workers)) {
+        completed &= msgbus::run_forwarding_bench(ctx, *factory, params, workers);
+        if(workers >= max_workers) {
+            break;
+        }
+    }
+
+    return completed ? 0 : 2;
+}
+//------------------------------------------------------------------------------
+} // namespace eagine
+//------------------------------------------------------------------------------
+auto main(int argc, const char** argv) -> int {
+    eagine::main_ctx_options options;
+    options.app_id = "FwdBench";
+    return eagine::main_impl(argc, argv, options, &eagine::main);
+}
+//------------------------------------------------------------------------------
@@ -11,10 +11,31 @@ module;
 #include <asio/ip/tcp.hpp>
 #include <asio/ip/udp.hpp>
 #include <asio/local/stream_protocol.hpp>
+#include <asio/post.hpp>
 #include <asio/read.hpp>
 #include <asio/write.hpp>
 #include <cassert>
 
+#if __has_include(<sys/socket.h>) && defined(__linux__)
+#include <sys/socket.h>
+#include <cerrno>
+#define EAGINE_MSGBUS_ASIO_MMSG 1
+#else
+#define EAGINE_MSGBUS_ASIO_MMSG 0
+#endif
+
+#if __has_include(<sys/socket.h>)
+#include <sys/socket.h>
+#endif
+
+// only Linux distributes the datagrams between the sockets sharing a port,
+// elsewhere the last bound socket gets all of them
+#if defined(__linux__) && defined(SO_REUSEPORT)
+#define EAGINE_MSGBUS_ASIO_REUSEPORT 1
+#else
+#define EAGINE_MSGBUS_ASIO_REUSEPORT 0
+#endif
+
 module eagine.msgbus.core;
 
 import std;
@@ -100,6 +121,80 @@ struct asio_common_state {
         _update_flushing(_flushing);
     }
 
+    /// @brief Marks the context as being run by a dedicated thread.
+    /// @note Must be called before the thread is started.
+    void set_threaded() noexcept {
+        _threaded = true;
+    }
+
+    /// @brief Indicates if the context is run by a dedicated thread.
+    auto is_threaded() const noexcept -> bool {
+        return _threaded;
+    }
+
+    /// @brief Interrupts the wait of the thread running a threaded context.
+    void wake_runner() noexcept {
+        if(_threaded and not _wake_pending.exchange(true)) {
+            asio::post(context, [] {});
+        }
+    }
+
+    /// @brief Called by the thread running the context before it does work.
+    void clear_wake() noexcept {
+        _wake_pending = false;
+    }
+
+    /// @brief Wakes up the users waiting for work on a threaded context.
+    void notify_work() noexcept {
+        {
+            const std::unique_lock lock{_work_mutex};
+            _has_work = true;
+        }
+        _work_cond.notify_all();
+        _work_signal.notify();
+    }
+
+    /// @brief Clears the work notification before the received data is processed.
+    void clear_work() noexcept {
+        _work_signal.clear();
+    }
+
+    /// @brief Returns the native handle that becomes readable on notify_work.
+    auto wait_handle() const noexcept -> work_wait_handle {
+        return _work_signal.wait_handle();
+    }
+
+    /// @brief Blocks until an asynchronous operation completes or timeout.
+    /// If the context is threaded then waits for a notification from its thread.
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done {
+        if(_threaded) {
+            std::unique_lock lock{_work_mutex};
+            const bool notified{
+              _work_cond.wait_for(lock, timeout, [this] { return _has_work; })};
+            _has_work = false;
+            _work_signal.clear();
+            return notified;
+        }
+        return run_for(timeout);
+    }
+
+    /// @brief Runs the context until an operation completes or timeout.
+    auto run_for(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done {
+        const auto start{std::chrono::steady_clock::now()};
+        if(context.run_one_for(timeout)) {
+            return true;
+        }
+        context.reset();
+        // the context returns immediately if it has no pending operations
+        const auto elapsed{std::chrono::steady_clock::now() - start};
+        if(elapsed < timeout) {
+            std::this_thread::sleep_for(timeout - elapsed);
+        }
+        return false;
+    }
+
     auto has_flushing() const noexcept -> bool {
         return _has_flushing(_flushing);
     }
@@ -138,8 +233,28 @@ private:
       asio_flushing_sockets<asio::ip::tcp::socket>,
       asio_flushing_sockets<asio::ip::udp::socket>>
       _flushing;
+
+    std::mutex _work_mutex{};
+    std::condition_variable _work_cond{};
+    work_signal _work_signal{};
+    std::atomic<bool> _wake_pending{false};
+    bool _has_work{false};
+    bool _threaded{false};
 };
 //------------------------------------------------------------------------------
+/// @brief Returns the wait handle of a socket if it is a pollable descriptor.
+/// The socket is ready when the (not threaded) context has some work to do.
+template <typename Socket>
+auto asio_socket_wait_handle(Socket& socket, const bool writable) noexcept
+  -> work_wait_handle {
+    if constexpr(std::is_same_v<decltype(socket.native_handle()), int>) {
+        if(socket.is_open()) {
+            return {.native = socket.native_handle(), .writable = writable};
+        }
+    }
+    return {};
+}
+//------------------------------------------------------------------------------
 template <connection_addr_kind Kind, connection_protocol Proto>
 struct asio_connection_group : interface<asio_connection_group<Kind, Proto>> {
 
@@ -162,11 +277,266 @@ struct asio_connection_group : interface<asio_connection_group<Kind, Proto>> {
       -> std::shared_ptr<asio_connection_base<Kind, Proto>> = 0;
 };
 //------------------------------------------------------------------------------
+/// @brief Policy deciding when a partially filled send block goes out.
+struct asio_send_batching {
+    /// @brief The longest time the first message in a block may be held back.
+    std::chrono::microseconds max_delay{1000};
+    /// @brief The block fill ratio required to send when the inflow stalls.
+    float min_fill_ratio{0.F};
+    /// @brief Blocks containing messages of this priority are sent immediately.
+    message_priority flush_priority{message_priority::high};
+
+    template <typename T>
+    static auto get(
+      application_config& config,
+      const connection_protocol proto,
+      const std::string_view name,
+      const T fallback) noexcept -> T {
+        std::string key{"msgbus.asio."};
+        key.append(
+          proto == connection_protocol::datagram ? "datagram" : "stream");
+        key.append(".batching.");
+        key.append(name);
+        if(const auto value{config.get<T>(key)}) {
+            return *value;
+        }
+        key.assign("msgbus.asio.batching.");
+        key.append(name);
+        return config.get<T>(key).value_or(fallback);
+    }
+
+    void configure(
+      application_config& config,
+      const connection_protocol proto) noexcept {
+        max_delay = get(config, proto, "max_delay", max_delay);
+        min_fill_ratio = std::clamp(
+          get(config, proto, "min_fill_ratio", min_fill_ratio), 0.F, 1.F);
+        flush_priority = get(config, proto, "flush_priority", flush_priority);
+    }
+};
+//------------------------------------------------------------------------------
+// reliable datagrams
+//------------------------------------------------------------------------------
+static constexpr const span_size_t asio_datagram_header_size{
+  reliable_datagram_header::size};
+static constexpr const std::size_t asio_datagram_max_batch{64U};
+//------------------------------------------------------------------------------
+/// @brief Batched datagram socket I/O and the reliability state of the peers.
+template <typename Endpoint>
+class asio_datagram_state {
+public:
+    using clock_type = reliable_datagram_peer::clock_type;
+    using clock_time = reliable_datagram_peer::clock_time;
+
+    struct slot {
+        Endpoint target{};
+        memory::buffer buffer{};
+        span_size_t offset{0};
+        span_size_t size{0};
+    };
+
+    bool reliable{false};
+    span_size_t window{256};
+    span_size_t max_retries{10};
+    /// @brief Guards the message queues shared by a datagram server connection
+    /// and its accepted client connections.
+    std::recursive_mutex queues_mutex{};
+
+    void configure(
+      application_config& config,
+      const span_size_t frame_size) noexcept {
+        reliable =
+          config.get<bool>("msgbus.asio.datagram.reliable").value_or(false);
+        window = std::max(
+          config.get<span_size_t>("msgbus.asio.datagram.reliable_window")
+            .value_or(window),
+          span_size(1));
+        max_retries =
+          config.get<span_size_t>("msgbus.asio.datagram.max_retries")
+            .value_or(max_retries);
+        _peers.set_idle_timeout(std::chrono::seconds{
+          config.get<span_size_t>("msgbus.asio.datagram.peer_timeout")
+            .value_or(60)});
+        const auto batch_size{std::clamp(
+          config.get<span_size_t>("msgbus.asio.datagram.batch_size")
+            .value_or(16),
+          span_size(1),
+          span_size(asio_datagram_max_batch))};
+        _send_slots.resize(std::size_t(batch_size));
+        _recv_slots.resize(std::size_t(batch_size));
+        for(auto& entry : _send_slots) {
+            entry.buffer.resize(frame_size);
+        }
+        for(auto& entry : _recv_slots) {
+            entry.buffer.resize(frame_size);
+        }
+    }
+
+    auto peers() noexcept -> reliable_datagram_peers<Endpoint>& {
+        return _peers;
+    }
+
+    auto peer(const Endpoint& ep, const clock_time now) noexcept
+      -> reliable_datagram_peer& {
+        return _peers.get(ep, now);
+    }
+
+    /// @brief Indicates if the datagrams to the target should carry headers.
+    auto uses_headers(const Endpoint& target) noexcept -> bool {
+        if(auto found{_peers.find(target)}) {
+            return found->uses_headers(reliable);
+        }
+        return reliable;
+    }
+
+    /// @brief Removes the state of the peers that went silent.
+    void evict_idle_peers(const clock_time now) noexcept {
+        if(now - _last_eviction >= std::chrono::seconds{1}) {
+            _last_eviction = now;
+            _peers.evict_idle(now);
+        }
+    }
+
+    auto has_queued() const noexcept -> bool {
+        return _queued > 0U;
+    }
+
+    /// @brief Returns the next free send slot or nullptr if all are queued.
+    auto free_slot() noexcept -> slot* {
+        if(_queued < _send_slots.size()) {
+            return &_send_slots[_queued];
+        }
+        return nullptr;
+    }
+
+    void commit_slot(
+      const Endpoint& target,
+      const span_size_t size,
+      const span_size_t offset = 0) noexcept {
+        assert(_queued < _send_slots.size());
+        auto& entry{_send_slots[_queued++]};
+        entry.target = target;
+        entry.offset = offset;
+        entry.size = size;
+    }
+
+    /// @brief Sends the queued datagrams, with a single call if possible.
+    template <typename Socket>
+    auto send_queued(Socket& socket, std::error_code& error) noexcept
+      -> span_size_t {
+#if EAGINE_MSGBUS_ASIO_MMSG
+        std::array<::mmsghdr, asio_datagram_max_batch> headers{};
+        std::array<::iovec, asio_datagram_max_batch> vectors{};
+        for(const auto i : integer_range(_queued)) {
+            auto& entry{_send_slots[i]};
+            vectors[i].iov_base = skip(cover(entry.buffer), entry.offset).data();
+            vectors[i].iov_len = std::size_t(entry.size);
+            headers[i].msg_hdr.msg_name = entry.target.data();
+            headers[i].msg_hdr.msg_namelen = ::socklen_t(entry.target.size());
+            headers[i].msg_hdr.msg_iov = &vectors[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+        const auto sent{::sendmmsg(
+          socket.native_handle(),
+          headers.data(),
+          static_cast<unsigned>(_queued),
+          MSG_DONTWAIT)};
+        if(sent < 0) {
+            error = {errno, std::system_category()};
+            return 0;
+        }
+        _pop_sent(std::size_t(sent));
+        if(_queued > 0U) {
+            error = std::make_error_code(std::errc::operation_would_block);
+        }
+        return span_size(sent);
+#else
+        std::size_t sent{0U};
+        while(sent < _queued) {
+            auto& entry{_send_slots[sent]};
+            socket.send_to(
+              asio::buffer(
+                skip(cover(entry.buffer), entry.offset).data(), entry.size),
+              entry.target,
+              0,
+              error);
+            if(error) {
+                break;
+            }
+            ++sent;
+        }
+        _pop_sent(sent);
+        return span_size(sent);
+#endif
+    }
+
+    /// @brief Receives the available datagrams, with a single system call.
+    template <typename Socket, typename Function>
+    auto receive(
+      [[maybe_unused]] Socket& socket,
+      std::error_code& error,
+      [[maybe_unused]] Function func) noexcept -> span_size_t {
+#if EAGINE_MSGBUS_ASIO_MMSG
+        std::array<::mmsghdr, asio_datagram_max_batch> headers{};
+        std::array<::iovec, asio_datagram_max_batch> vectors{};
+        for(const auto i : integer_range(_recv_slots.size())) {
+            auto& entry{_recv_slots[i]};
+            vectors[i].iov_base = cover(entry.buffer).data();
+            vectors[i].iov_len = std::size_t(entry.buffer.size());
+            headers[i].msg_hdr.msg_name = entry.target.data();
+            headers[i].msg_hdr.msg_namelen =
+              ::socklen_t(entry.target.capacity());
+            headers[i].msg_hdr.msg_iov = &vectors[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+        const auto count{::recvmmsg(
+          socket.native_handle(),
+          headers.data(),
+          static_cast<unsigned>(_recv_slots.size()),
+          MSG_DONTWAIT,
+          nullptr)};
+        if(count < 0) {
+            error = {errno, std::system_category()};
+            return 0;
+        }
+        for(const auto i : integer_range(std::size_t(count))) {
+            auto& entry{_recv_slots[i]};
+            if((headers[i].msg_hdr.msg_flags & MSG_TRUNC) == 0) [[likely]] {
+                entry.target.resize(headers[i].msg_hdr.msg_namelen);
+                func(
+                  entry.target,
+                  head(view(entry.buffer), span_size(headers[i].msg_len)));
+            }
+        }
+        return span_size(count);
+#else
+        error = std::make_error_code(std::errc::operation_not_supported);
+        return 0;
+#endif
+    }
+
+private:
+    void _pop_sent(const std::size_t count) noexcept {
+        std::rotate(
+          _send_slots.begin(),
+          _send_slots.begin() + std::ptrdiff_t(count),
+          _send_slots.begin() + std::ptrdiff_t(_queued));
+        _queued -= count;
+    }
+
+    reliable_datagram_peers<Endpoint> _peers;
+    clock_time _last_eviction{clock_type::now()};
+    std::vector<slot> _send_slots;
+    std::vector<slot> _recv_slots;
+    std::size_t _queued{0U};
+};
+//------------------------------------------------------------------------------
 struct asio_connection_state_base : main_ctx_object {
     using clock_type = std::chrono::steady_clock;
     using clock_time = typename clock_type::time_point;
 
     const shared_holder<asio_common_state> common;
+    const span_size_t block_size;
     const memory::buffer push_buffer{};
     const memory::buffer read_buffer{};
     const memory::buffer write_buffer{};
@@ -177,18 +547,23 @@ struct asio_connection_state_base : main_ctx_object {
     std::int32_t total_sent_blocks{0};
     float usage_ratio{-1.F};
     float used_per_sec{-1.F};
+    float send_latency_ms{-1.F};
+    asio_send_batching batching{};
+    std::optional<clock_time> batch_start_time{};
     bool is_sending{false};
     bool is_recving{false};
 
     asio_connection_state_base(
       main_ctx_parent parent,
       shared_holder<asio_common_state> asio_state,
-      const span_size_t block_size) noexcept
+      const span_size_t blk_size,
+      const span_size_t frame_overhead) noexcept
       : main_ctx_object{"AsioConnSt", parent}
       , common{std::move(asio_state)}
+      , block_size{blk_size}
       , push_buffer{block_size, max_span_align()}
-      , read_buffer{block_size, max_span_align()}
-      , write_buffer{block_size, max_span_align()} {
+      , read_buffer{block_size + frame_overhead, max_span_align()}
+      , write_buffer{block_size + frame_overhead, max_span_align()} {
         assert(common);
         common->update();
 
@@ -202,6 +577,12 @@ struct asio_connection_state_base : main_ctx_object {
         log_debug("allocating read buffer of ${size}")
           .arg("size", "ByteSize", read_buffer.size());
     }
+
+    /// @brief Returns the part of the write buffer for the packed messages.
+    auto write_block(const span_size_t offs = 0) const noexcept
+      -> memory::block {
+        return head(skip(cover(write_buffer), offs), block_size);
+    }
 };
 //------------------------------------------------------------------------------
 template <connection_addr_kind Kind, connection_protocol Proto>
@@ -210,18 +591,34 @@ struct asio_connection_state : asio_connection_state_base {
     using clock_type = std::chrono::steady_clock;
     using clock_time = typename clock_type::time_point;
 
+    static constexpr const bool is_datagram{
+      Proto == connection_protocol::datagram};
+
     asio_socket_type<Kind, Proto> socket;
     endpoint_type conn_endpoint{};
     span_size_t prev_packed_count{0};
     span_size_t send_countdown{0};
+    [[no_unique_address]] std::conditional_t<
+      is_datagram,
+      asio_datagram_state<endpoint_type>,
+      nothing_t> datagrams{};
 
     asio_connection_state(
       main_ctx_parent parent,
       shared_holder<asio_common_state> asio_state,
       asio_socket_type<Kind, Proto> sock,
       const span_size_t block_size) noexcept
-      : asio_connection_state_base{parent, std::move(asio_state), block_size}
-      , socket{std::move(sock)} {}
+      : asio_connection_state_base{
+          parent,
+          std::move(asio_state),
+          block_size,
+          is_datagram ? asio_datagram_header_size : 0}
+      , socket{std::move(sock)} {
+        batching.configure(app_config(), Proto);
+        if constexpr(is_datagram) {
+            datagrams.configure(app_config(), write_buffer.size());
+        }
+    }
 
     asio_connection_state(
       main_ctx_parent parent,
@@ -239,8 +636,8 @@ struct asio_connection_state : asio_connection_state_base {
 
     void do_log_usage_stats() noexcept {
         const auto now{clock_type::now()};
-        usage_ratio = float(total_used_size) / float(total_sent_size);
-        const auto slack = 1.F - usage_ratio;
+        const auto slack =
+          1.F - float(total_used_size) / float(total_sent_size);
         const auto msgs_per_block =
           total_sent_blocks ? float(total_sent_messages) / float(total_sent_blocks)
                             : 0.F;
@@ -259,6 +656,7 @@ struct asio_connection_state : asio_connection_state_base {
           .arg("sentPerSec", "ByteSize", sent_per_sec)
           .arg("addrKind", Kind)
           .arg("protocol", Proto)
+          .arg("latency", send_latency_ms)
           .arg("slack", "Ratio", slack);
 
         total_used_size = 0;
@@ -306,7 +704,7 @@ struct asio_connection_state : asio_connection_state_base {
         start_async_send(
           connection_protocol_tag<Proto>{},
           target,
-          view(write_buffer),
+          write_block(),
           [this, self{group.self_ref()}, &group, target, packed](
             const std::error_code error,
             [[maybe_unused]] const std::size_t length) {
@@ -318,15 +716,25 @@ struct asio_connection_state : asio_connection_state_base {
               }
           });
 
-        total_used_size += packed.used();
-        total_sent_size += packed.total();
-        total_sent_messages += packed.count();
-        total_sent_blocks += 1;
+        account_sent(packed);
 
         const auto quarter_of_gib{span_size(2U << 27U)};
         log_usage_stats(quarter_of_gib);
     }
 
+    static auto smooth(const float prev, const float curr) noexcept -> float {
+        return prev < 0.F ? curr : prev * 0.9F + curr * 0.1F;
+    }
+
+    void update_send_stats(const message_pack_info& packed) noexcept {
+        const auto now{clock_type::now()};
+        const std::chrono::duration<float, std::milli> delay{
+          now - batch_start_time.value_or(now)};
+        send_latency_ms = smooth(send_latency_ms, delay.count());
+        usage_ratio = smooth(usage_ratio, packed.usage());
+        batch_start_time.reset();
+    }
+
     auto priority_to_countdown(const message_priority priority) const noexcept {
         return span_size(std::to_underlying(priority));
     }
@@ -343,18 +751,45 @@ struct asio_connection_state : asio_connection_state_base {
         return send_countdown <= priority_to_countdown(priority);
     }
 
+    auto should_send(
+      const message_pack_info& packed,
+      const span_size_t packed_count) noexcept -> bool {
+        const auto now{clock_type::now()};
+        if(not batch_start_time) {
+            batch_start_time = now;
+        }
+        if(not(packed.max_priority() < batching.flush_priority)) {
+            return true;
+        }
+        if(packed.is_max_count(packed_count)) {
+            return true;
+        }
+        if(now - *batch_start_time >= batching.max_delay) {
+            return true;
+        }
+        update_send_countdown(packed_count);
+        return send_countdown_end(packed.max_priority()) and
+               (packed.usage() >= batching.min_fill_ratio);
+    }
+
     auto start_send_if_needed(
+      asio_connection_group<Kind, Proto>& group,
+      bool force) noexcept -> bool {
+        if constexpr(is_datagram) {
+            return start_datagram_send(group, force);
+        } else {
+            return start_block_send(group, force);
+        }
+    }
+
+    auto start_block_send(
       asio_connection_group<Kind, Proto>& group,
       bool force) noexcept -> bool {
         endpoint_type target{conn_endpoint};
-        const auto packed{group.pack_into(target, cover(write_buffer))};
-        if(force or not packed.is_empty()) {
+        const auto packed{group.pack_into(target, write_block())};
+        if(not packed.is_empty()) {
             const auto curr_packed_count{packed.count()};
-            update_send_countdown(curr_packed_count);
-
-            if(
-              send_countdown_end(packed.max_priority()) or
-              packed.is_max_count(curr_packed_count)) {
+            if(should_send(packed, curr_packed_count)) {
                 prev_packed_count = 0;
                 reset_send_countdown();
                 is_sending = true;
@@ -366,7 +801,7 @@ struct asio_connection_state : asio_connection_state_base {
             return true;
         }
         is_sending = false;
-        return false;
+        return force;
     }
 
     auto start_send(asio_connection_group<Kind, Proto>& group) noexcept -> bool {
@@ -376,6 +811,159 @@ struct asio_connection_state : asio_connection_state_base {
         return true;
     }
 
+    void account_sent(const message_pack_info& packed) noexcept {
+        update_send_stats(packed);
+        total_used_size += packed.used();
+        total_sent_size += packed.total();
+        total_sent_messages += packed.count();
+        total_sent_blocks += 1;
+    }
+
+    // fills the send slots with resent, new and acknowledgement datagrams
+    auto fill_datagrams(asio_connection_group<Kind, Proto>& group) noexcept
+      -> bool {
+        auto& dgrams{datagrams};
+        const auto now{clock_type::now()};
+        const auto header_size{asio_datagram_header_size};
+        dgrams.evict_idle_peers(now);
+
+        dgrams.peers().for_each([&](const endpoint_type& ep, auto& peer) {
+            if(not peer.uses_headers(dgrams.reliable)) {
+                // the peer does not understand the headers, resend plain
+                peer.drain_unacked([&](memory::const_block payload) {
+                    auto slot{dgrams.free_slot()};
+                    if(not slot) {
+                        return false;
+                    }
+                    copy(payload, cover(slot->buffer));
+                    dgrams.commit_slot(ep, payload.size());
+                    return true;
+                });
+                return;
+            }
+            peer.retransmit(
+              now, dgrams.max_retries, [&](memory::const_block stored) {
+                  auto slot{dgrams.free_slot()};
+                  if(not slot) {
+                      return false;
+                  }
+                  const auto dst{cover(slot->buffer)};
+                  copy(stored, dst);
+                  // the acknowledgement is refreshed
+                  reliable_datagram_header header{};
+                  header.read(stored);
+                  peer.make_ack(header);
+                  header.write(dst);
+                  dgrams.commit_slot(ep, stored.size());
+                  return true;
+              });
+        });
+
+        bool packed_new{false};
+        span_size_t window_full_count{0};
+        const auto max_tries{2 * asio_datagram_max_batch};
+        for(std::size_t tries = 0; tries < max_tries; ++tries) {
+            auto slot{dgrams.free_slot()};
+            if(not slot) {
+                break;
+            }
+            endpoint_type target{conn_endpoint};
+            const auto dst{cover(slot->buffer)};
+            // the room for the header is always left, it is decided
+            // whether to use it only after the target is known
+            const auto packed{group.pack_into(
+              target, head(skip(dst, header_size), block_size))};
+            if(packed.is_empty()) {
+                break;
+            }
+            const auto curr_packed_count{packed.count()};
+            if(not should_send(packed, curr_packed_count)) {
+                prev_packed_count = curr_packed_count;
+                break;
+            }
+            span_size_t offset{header_size};
+            if(dgrams.uses_headers(target)) {
+                auto& peer{dgrams.peer(target, now)};
+                if(peer.is_window_full(dgrams.window)) {
+                    // the messages stay queued until acknowledgements arrive
+                    if(++window_full_count >= dgrams.peers().count()) {
+                        break;
+                    }
+                    continue;
+                }
+                reliable_datagram_header header{};
+                peer.make_data_header(header);
+                header.write(dst);
+                peer.register_sent(
+                  head(dst, header_size + packed.total()),
+                  header.sequence_no,
+                  now);
+                offset = 0;
+            }
+            prev_packed_count = 0;
+            reset_send_countdown();
+            dgrams.commit_slot(
+              target, header_size + packed.total() - offset, offset);
+            group.on_sent(target, packed);
+            account_sent(packed);
+            packed_new = true;
+        }
+
+        dgrams.peers().for_each([&](const endpoint_type& ep, auto& peer) {
+            if(peer.has_pending_ack()) {
+                if(auto slot{dgrams.free_slot()}) {
+                    reliable_datagram_header header{};
+                    peer.make_ack(header);
+                    header.write(cover(slot->buffer));
+                    dgrams.commit_slot(ep, header_size);
+                }
+            }
+        });
+        return packed_new;
+    }
+
+    static auto is_would_block(const std::error_code error) noexcept -> bool {
+        return (error == std::errc::operation_would_block) or
+               (error == std::errc::resource_unavailable_try_again) or
+               (error == asio::error::would_block);
+    }
+
+    void flush_datagrams(asio_connection_group<Kind, Proto>& group) noexcept {
+        std::error_code error{};
+        datagrams.send_queued(socket, error);
+        if(is_would_block(error)) {
+            // wait until the socket can take more datagrams
+            is_sending = true;
+            socket.async_wait(
+              asio::socket_base::wait_write,
+              [this, self{group.self_ref()}, &group](
+                const std::error_code error) {
+                  if(not error) [[likely]] {
+                      flush_datagrams(group);
+                  } else {
+                      handle_send_error(error);
+                  }
+              });
+        } else if(error) [[unlikely]] {
+            handle_send_error(error);
+        } else {
+            is_sending = false;
+        }
+        const auto quarter_of_gib{span_size(2U << 27U)};
+        log_usage_stats(quarter_of_gib);
+    }
+
+    auto start_datagram_send(
+      asio_connection_group<Kind, Proto>& group,
+      const bool force) noexcept -> bool {
+        const bool packed_new{fill_datagrams(group)};
+        if(datagrams.has_queued()) {
+            flush_datagrams(group);
+            return true;
+        }
+        return packed_new or force;
+    }
+
     void handle_sent(
       asio_connection_group<Kind, Proto>& group,
       const endpoint_type& target_endpoint,
@@ -424,10 +1012,75 @@ struct asio_connection_state : asio_connection_state_base {
         socket.close();
     }
 
+    void receive_datagrams(asio_connection_group<Kind, Proto>& group) noexcept {
+        std::error_code error{};
+        // drain the socket, each call receives a batch of datagrams
+        for(span_size_t batches = 0; batches < 8; ++batches) {
+            const auto count{datagrams.receive(
+              socket,
+              error,
+              [&](const endpoint_type& ep, const memory::const_block data) {
+                  handle_datagram(group, ep, data);
+              })};
+            if(error or (count == 0)) {
+                break;
+            }
+        }
+        if(error and not is_would_block(error)) [[unlikely]] {
+            handle_receive_error({}, group, error);
+        } else {
+            do_start_receive(group);
+        }
+    }
+
+    void handle_datagram(
+      asio_connection_group<Kind, Proto>& group,
+      const endpoint_type& ep,
+      const memory::const_block data) noexcept {
+        const auto now{clock_type::now()};
+        // the headers are recognized even if reliability is not offered
+        // to answer the peers that offer it in kind
+        reliable_datagram_header header{};
+        if(header.read(data)) {
+            auto& peer{datagrams.peer(ep, now)};
+            if(header.has(reliable_datagram_header::has_ack)) {
+                peer.handle_ack(header, now);
+            }
+            if(header.has(reliable_datagram_header::has_data)) {
+                if(peer.handle_data(header, now)) {
+                    group.on_received(ep, skip(data, asio_datagram_header_size));
+                }
+            }
+            return;
+        }
+        if(auto peer{datagrams.peers().find(ep)}) {
+            peer->handle_plain(now);
+        }
+        group.on_received(ep, data);
+    }
+
     void do_start_receive(asio_connection_group<Kind, Proto>& group) noexcept {
+        is_recving = true;
+        if constexpr(is_datagram and EAGINE_MSGBUS_ASIO_MMSG) {
+            socket.async_wait(
+              asio::socket_base::wait_read,
+              [this, selfref{group.self_ref()}, &group](
+                const std::error_code error) {
+                  if(not error) [[likely]] {
+                      receive_datagrams(group);
+                  } else {
+                      handle_receive_error({}, group, error);
+                  }
+              });
+        } else {
+            do_start_block_receive(group);
+        }
+    }
+
+    void do_start_block_receive(
+      asio_connection_group<Kind, Proto>& group) noexcept {
         auto blk = cover(read_buffer);
 
-        is_recving = true;
         do_start_receive(
           connection_protocol_tag<Proto>{},
           blk,
@@ -452,7 +1105,11 @@ struct asio_connection_state : asio_connection_state_base {
     void handle_received(
       const memory::const_block data,
       asio_connection_group<Kind, Proto>& group) noexcept {
-        group.on_received(conn_endpoint, data);
+        if constexpr(is_datagram) {
+            handle_datagram(group, conn_endpoint, data);
+        } else {
+            group.on_received(conn_endpoint, data);
+        }
         do_start_receive(group);
     }
 
@@ -466,8 +1123,22 @@ struct asio_connection_state : asio_connection_state_base {
         return something_done;
     }
 
+    void log_datagram_stats() noexcept {
+        auto& peers{datagrams.peers()};
+        log_stat("reliable datagram statistics")
+          .tag("dgramStats")
+          .arg("peers", peers.count())
+          .arg("resent", peers.retransmitted_count())
+          .arg("lost", peers.lost_count());
+    }
+
     void cleanup(asio_connection_group<Kind, Proto>& group) noexcept {
         log_usage_stats();
+        if constexpr(is_datagram) {
+            if(datagrams.reliable or datagrams.peers().has_reliable()) {
+                log_datagram_stats();
+            }
+        }
         const timeout too_long{std::chrono::seconds{5}};
         while(is_usable() and start_send(group) and not too_long) {
             log_debug("flushing connection outbox");
@@ -519,15 +1190,75 @@ public:
     }
 
     auto max_data_size() noexcept -> valid_if_positive<span_size_t> final {
-        return {conn_state().write_buffer.size()};
+        return {conn_state().block_size};
     }
 
     auto is_usable() noexcept -> bool final {
         return conn_state().is_usable();
     }
 
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done final {
+        return conn_state().common->wait_for_work(timeout);
+    }
+
+    auto add_wait_handles(work_waiter& waiter) noexcept -> bool override {
+        auto& state{conn_state()};
+        if(state.common->is_threaded()) {
+            return waiter.add_handle(state.common->wait_handle());
+        }
+        return waiter.add_handle(
+          asio_socket_wait_handle(state.socket, state.is_sending));
+    }
+
+    /// @brief Returns the message header format to be sent to the peer.
+    /// Compact if configured and acknowledged by the peer, or if the peer
+    /// itself sends compact headers.
+    auto header_format_for(const connection_incoming_messages& incoming) noexcept
+      -> message_header_format {
+        if(_configured_header_format() == message_header_format::compact) {
+            if(incoming.peer_accepts_compact()) {
+                return message_header_format::compact;
+            }
+            return message_header_format::portable;
+        }
+        return incoming.peer_header_format();
+    }
+
+    /// @brief Announces or acknowledges the support of compact headers.
+    void negotiate_header_format(
+      connection_outgoing_messages& outgoing,
+      connection_incoming_messages& incoming) noexcept {
+        if(not _compact_announced) [[unlikely]] {
+            if(_configured_header_format() == message_header_format::compact) {
+                _compact_announced = outgoing.enqueue_header_format_notice(
+                  *this, false, cover(conn_state().push_buffer));
+            } else {
+                _compact_announced = true;
+            }
+        }
+        if(incoming.should_acknowledge_compact()) [[unlikely]] {
+            if(not outgoing.enqueue_header_format_notice(
+                 *this, true, cover(conn_state().push_buffer))) {
+                this->log_warning("failed to acknowledge compact headers");
+            }
+        }
+    }
+
 protected:
+    auto _configured_header_format() noexcept -> message_header_format {
+        if(not _header_format) [[unlikely]] {
+            _header_format = app_config()
+                               .get<message_header_format>(
+                                 "msgbus.asio.header_format")
+                               .value_or(message_header_format::portable);
+        }
+        return *_header_format;
+    }
+
     const shared_holder<asio_connection_state<Kind, Proto>> _state;
+    std::optional<message_header_format> _header_format{};
+    bool _compact_announced{false};
 
     asio_connection_base(
       main_ctx_parent parent,
@@ -585,19 +1316,27 @@ public:
 
     auto send(const message_id msg_id, const message_view& message) noexcept
       -> bool final {
+        this->negotiate_header_format(_outgoing, _incoming);
         return _outgoing.enqueue(
-          *this, msg_id, message, cover(conn_state().push_buffer));
+          *this,
+          msg_id,
+          message,
+          cover(conn_state().push_buffer),
+          this->header_format_for(_incoming));
     }
 
     auto fetch_messages(const connection::fetch_handler handler) noexcept
       -> work_done final {
-        return _incoming.fetch_messages(*this, handler);
+        const auto result{_incoming.fetch_messages(*this, handler)};
+        this->negotiate_header_format(_outgoing, _incoming);
+        return result;
     }
 
     auto query_statistics(connection_statistics& stats) noexcept -> bool final {
         auto& state = conn_state();
         stats.block_usage_ratio = state.usage_ratio;
         stats.bytes_per_second = state.used_per_sec;
+        stats.send_latency_ms = state.send_latency_ms;
         return true;
     }
 
@@ -662,20 +1401,34 @@ public:
     auto send(const message_id msg_id, const message_view& message) noexcept
       -> bool final {
         assert(_outgoing);
-        return _outgoing->enqueue(
-          *this, msg_id, message, cover(conn_state().push_buffer));
+        const std::unique_lock lock{conn_state().datagrams.queues_mutex};
+        this->negotiate_header_format(*_outgoing, *_incoming);
+        if(_outgoing->enqueue(
+             *this,
+             msg_id,
+             message,
+             cover(conn_state().push_buffer),
+             this->header_format_for(*_incoming))) [[likely]] {
+            conn_state().common->wake_runner();
+            return true;
+        }
+        return false;
     }
 
     auto fetch_messages(const connection::fetch_handler handler) noexcept
       -> work_done final {
         assert(_incoming);
-        return _incoming->fetch_messages(*this, handler);
+        const std::unique_lock lock{conn_state().datagrams.queues_mutex};
+        const auto result{_incoming->fetch_messages(*this, handler)};
+        this->negotiate_header_format(*_outgoing, *_incoming);
+        return result;
     }
 
     auto query_statistics(connection_statistics& stats) noexcept -> bool final {
         auto& state = conn_state();
         stats.block_usage_ratio = state.usage_ratio;
         stats.bytes_per_second = state.used_per_sec;
+        stats.send_latency_ms = state.send_latency_ms;
         return true;
     }
 
@@ -685,11 +1438,17 @@ public:
 
     auto update() noexcept -> work_done final {
         some_true something_done{};
-        something_done(conn_state().update());
+        // sharded server contexts are run by their own threads
+        if(not conn_state().common->is_threaded()) {
+            something_done(conn_state().update());
+        } else {
+            conn_state().common->clear_work();
+        }
         return something_done;
     }
 
     void cleanup() noexcept override {
+        const std::unique_lock lock{conn_state().datagrams.queues_mutex};
         _outgoing->log_stats(*this);
         _incoming->log_stats(*this);
     }
@@ -715,6 +1474,7 @@ public:
     auto pack_into(endpoint_type& target, memory::block dest) noexcept
       -> message_pack_info final {
         assert(_index >= 0);
+        const std::unique_lock lock{conn_state().datagrams.queues_mutex};
         const auto prev_idx{_index};
         do {
             if(_index < span_size(_current.size())) {
@@ -739,16 +1499,19 @@ public:
     void on_sent(
       const endpoint_type& ep,
       const message_pack_info& to_be_removed) noexcept final {
+        const std::unique_lock lock{conn_state().datagrams.queues_mutex};
         _outgoing(ep).cleanup(to_be_removed);
     }
 
     void on_received(
       const endpoint_type& ep,
       const memory::const_block data) noexcept final {
+        const std::unique_lock lock{conn_state().datagrams.queues_mutex};
         _incoming(ep).push(data);
     }
 
     auto has_received() noexcept -> bool final {
+        const std::unique_lock lock{conn_state().datagrams.queues_mutex};
         for(auto m : {&_current, &_pending}) {
             for(const auto& p : *m) {
                 const auto& incoming = std::get<1>(std::get<1>(p));
@@ -788,6 +1551,7 @@ public:
     auto process_accepted(const acceptor::accept_handler handler) noexcept
       -> work_done {
         some_true something_done;
+        const std::unique_lock lock{conn_state().datagrams.queues_mutex};
         for(auto& p : _pending) {
             handler[{
               hold<asio_datagram_client_connection<Kind>>,
@@ -862,6 +1626,107 @@ private:
     span_size_t _index{0};
 };
 //------------------------------------------------------------------------------
+/// @brief One of the datagram server sockets sharing the same port.
+/// @note The kernel distributes the incoming datagrams between the sockets
+/// sharing a port by the hash of the source address, so each shard serves
+/// a stable subset of the client endpoints.
+template <connection_addr_kind Kind>
+class asio_datagram_server_shard {
+    using server_connection = asio_datagram_server_connection<Kind>;
+
+public:
+    asio_datagram_server_shard(
+      main_ctx_parent parent,
+      shared_holder<asio_common_state> asio_state,
+      asio_socket_type<Kind, connection_protocol::datagram> socket,
+      const span_size_t block_size,
+      const bool threaded) noexcept
+      : _asio_state{std::move(asio_state)}
+      , _conn{
+          hold<server_connection>,
+          parent,
+          _asio_state,
+          std::move(socket),
+          block_size} {
+        if(threaded) {
+            _asio_state->set_threaded();
+            _thread = std::thread{[this] {
+                _run();
+            }};
+        }
+    }
+
+    asio_datagram_server_shard(asio_datagram_server_shard&&) = delete;
+    asio_datagram_server_shard(const asio_datagram_server_shard&) = delete;
+    auto operator=(asio_datagram_server_shard&&) = delete;
+    auto operator=(const asio_datagram_server_shard&) = delete;
+
+    ~asio_datagram_server_shard() noexcept {
+        if(_thread.joinable()) {
+            _done = true;
+            _asio_state->context.stop();
+            _thread.join();
+            // let the aborted operations release the connection
+            std::error_code error{};
+            _conn->conn_state().socket.close(error);
+            _asio_state->context.reset();
+            _asio_state->context.poll();
+        }
+    }
+
+    auto update() noexcept -> work_done {
+        if(_asio_state->is_threaded()) {
+            _asio_state->clear_work();
+            return false;
+        }
+        return _conn->update();
+    }
+
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done {
+        return _asio_state->wait_for_work(timeout);
+    }
+
+    auto add_wait_handles(work_waiter& waiter) noexcept -> bool {
+        if(_asio_state->is_threaded()) {
+            return waiter.add_handle(_asio_state->wait_handle());
+        }
+        return _conn->add_wait_handles(waiter);
+    }
+
+    auto process_accepted(const acceptor::accept_handler handler) noexcept
+      -> work_done {
+        return _conn->process_accepted(handler);
+    }
+
+private:
+    void _run() noexcept {
+        auto& state{_conn->conn_state()};
+        auto& context{_asio_state->context};
+        // keeps the context blocking while there are no pending operations,
+        // the thread is woken up by wake_runner or stopped by the destructor
+        const auto work{asio::make_work_guard(context)};
+        while(not _done) {
+            _asio_state->clear_wake();
+            if(state.socket.is_open()) [[likely]] {
+                state.start_receive(*_conn);
+                state.start_send(*_conn);
+            }
+            if(context.run_one()) {
+                state.update();
+            }
+            if(_conn->has_received()) {
+                _asio_state->notify_work();
+            }
+        }
+    }
+
+    const shared_holder<asio_common_state> _asio_state;
+    const shared_holder<server_connection> _conn;
+    std::atomic<bool> _done{false};
+    std::thread _thread{};
+};
+//------------------------------------------------------------------------------
 // TCP/IPv4
 //------------------------------------------------------------------------------
 template <typename Base>
@@ -923,6 +1788,11 @@ public:
         return something_done;
     }
 
+    auto add_wait_handles(work_waiter& waiter) noexcept -> bool final {
+        // the resolution and connection complete only by running the context
+        return not _connecting and base::add_wait_handles(waiter);
+    }
+
 private:
     asio::ip::tcp::resolver _resolver;
     std::tuple<std::string, ipv4_port> _addr;
@@ -1026,6 +1896,15 @@ public:
         return something_done;
     }
 
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done final {
+        return this->_asio_state->wait_for_work(timeout);
+    }
+
+    auto add_wait_handles(work_waiter& waiter) noexcept -> bool final {
+        return waiter.add_handle(asio_socket_wait_handle(_acceptor, false));
+    }
+
     auto process_accepted(const accept_handler handler) noexcept
       -> work_done final {
         some_true something_done{};
@@ -1191,6 +2070,8 @@ class asio_acceptor<connection_addr_kind::ipv4, connection_protocol::datagram>
       connection_protocol::datagram>
   , public main_ctx_object {
 
+    using server_shard = asio_datagram_server_shard<connection_addr_kind::ipv4>;
+
 public:
     asio_acceptor(
       main_ctx_parent parent,
@@ -1199,29 +2080,121 @@ public:
       const span_size_t block_size) noexcept
       : main_ctx_object{"AsioAccptr", parent}
       , _asio_state{std::move(asio_state)}
-      , _addr{parse_ipv4_addr(addr_str)}
-      , _conn{
-          *this,
-          _asio_state,
-          asio::ip::udp::socket{
-            _asio_state->context,
-            asio::ip::udp::endpoint{asio::ip::udp::v4(), std::get<1>(_addr)}},
-          block_size} {}
+      , _addr{parse_ipv4_addr(addr_str)} {
+        const asio::ip::udp::endpoint local_ep{
+          asio::ip::udp::v4(), std::get<1>(_addr)};
+        const auto shard_count{
+          app_config()
+            .get<span_size_t>("msgbus.asio.datagram.shards")
+            .value_or(1)};
+        if(shard_count > 1) {
+            _open_shards(local_ep, shard_count, block_size);
+        }
+        if(_shards.empty()) {
+            _shards.emplace_back(
+              hold<server_shard>,
+              *this,
+              _asio_state,
+              asio::ip::udp::socket{_asio_state->context, local_ep},
+              block_size,
+              false);
+        }
+    }
 
     auto update() noexcept -> work_done final {
-        return _conn.update();
+        some_true something_done{};
+        for(auto& shard : _shards) {
+            something_done(shard->update());
+        }
+        return something_done;
+    }
+
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done final {
+        // the shards are waited on together, not in turn
+        work_waiter waiter;
+        for(auto& shard : _shards) {
+            waiter.add(*shard);
+        }
+        return waiter.wait(timeout);
+    }
+
+    auto add_wait_handles(work_waiter& waiter) noexcept -> bool final {
+        bool result{true};
+        for(auto& shard : _shards) {
+            result = shard->add_wait_handles(waiter) and result;
+        }
+        return result;
     }
 
     auto process_accepted(const accept_handler handler) noexcept
       -> work_done final {
-        return _conn.process_accepted(handler);
+        some_true something_done{};
+        for(auto& shard : _shards) {
+            something_done(shard->process_accepted(handler));
+        }
+        return something_done;
     }
 
 private:
     const shared_holder<asio_common_state> _asio_state;
     const std::tuple<std::string, ipv4_port> _addr;
 
-    asio_datagram_server_connection<connection_addr_kind::ipv4> _conn;
+    std::vector<unique_holder<server_shard>> _shards;
+
+    void _open_shards(
+      const asio::ip::udp::endpoint& local_ep,
+      const span_size_t shard_count,
+      const span_size_t block_size) noexcept {
+        for(span_size_t index = 0; index < shard_count; ++index) {
+            // each shard has its own context, run by the shard's thread
+            shared_holder<asio_common_state> shard_state{default_selector};
+            auto socket{_open_shared_socket(shard_state->context, local_ep)};
+            if(not socket) {
+                break;
+            }
+            _shards.emplace_back(
+              hold<server_shard>,
+              *this,
+              std::move(shard_state),
+              std::move(*socket),
+              block_size,
+              true);
+        }
+        if(not _shards.empty()) {
+            log_info("serving datagrams on ${count} shards")
+              .tag("dgramShard")
+              .arg("count", _shards.size())
+              .arg("port", "IpV4Port", std::get<1>(_addr));
+        }
+    }
+
+    auto _open_shared_socket(
+      [[maybe_unused]] asio::io_context& context,
+      [[maybe_unused]] const asio::ip::udp::endpoint& local_ep) noexcept
+      -> std::optional<asio::ip::udp::socket> {
+#if EAGINE_MSGBUS_ASIO_REUSEPORT
+        using reuse_port =
+          asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+        asio::ip::udp::socket socket{context};
+        std::error_code error{};
+        socket.open(local_ep.protocol(), error);
+        if(not error) {
+            socket.set_option(reuse_port{true}, error);
+        }
+        if(not error) {
+            socket.bind(local_ep, error);
+        }
+        if(not error) [[likely]] {
+            return {std::move(socket)};
+        }
+        log_warning("failed to open shared datagram socket: ${error}")
+          .arg("error", error.message());
+#else
+        log_warning("sharing of datagram sockets is not supported");
+#endif
+        return {};
+    }
 };
 //------------------------------------------------------------------------------
 // Local/Stream
@@ -1286,6 +2259,11 @@ public:
         return something_done;
     }
 
+    auto add_wait_handles(work_waiter& waiter) noexcept -> bool final {
+        // the connection completes only by running the context
+        return not _connecting and base::add_wait_handles(waiter);
+    }
+
 private:
     std::string _addr_str;
     timeout _should_reconnect{
@@ -1376,6 +2354,15 @@ public:
         return something_done;
     }
 
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done final {
+        return this->_asio_state->wait_for_work(timeout);
+    }
+
+    auto add_wait_handles(work_waiter& waiter) noexcept -> bool final {
+        return waiter.add_handle(asio_socket_wait_handle(_acceptor, false));
+    }
+
     auto process_accepted(const accept_handler handler) noexcept
       -> work_done final {
         some_true something_done{};
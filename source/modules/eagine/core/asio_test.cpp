@@ -92,6 +92,10 @@ void asio_roundtrip_F(eagitest::case_& test, Fact fact, eagine::string_view addr
     eagine::shared_holder<eagine::msgbus::connection> write_conn;
     test.check(not bool(write_conn), "has not write connection");
 
+    // the datagram acceptor accepts a connection on the first received message
+    read_conn->send(
+      eagine::message_id{"test", "hello"}, eagine::msgbus::message_view{});
+
     const eagine::timeout accept_time{std::chrono::seconds{5}};
     while(not write_conn) {
         read_conn->update();
@@ -174,16 +178,55 @@ void asio_udp_ipv4_roundtrip(auto& s) {
       "localhost:34913");
 }
 //------------------------------------------------------------------------------
+// wait for work
+//------------------------------------------------------------------------------
+void asio_udp_ipv4_wait_for_work(auto& s) {
+    eagitest::case_ test{s, 7, "wait for work UDP/IPv4"};
+    auto fact{eagine::msgbus::make_asio_udp_ipv4_connection_factory(s.context())};
+    test.ensure(bool(fact), "has factory");
+    auto cacc{fact->make_acceptor(eagine::string_view{"localhost:34915"})};
+    test.ensure(bool(cacc), "has acceptor");
+    cacc->update();
+
+    const auto start{std::chrono::steady_clock::now()};
+    test.check(
+      not cacc->wait_for_work(std::chrono::milliseconds{20}),
+      "nothing to wait for");
+    test.check(
+      std::chrono::steady_clock::now() - start >= std::chrono::milliseconds{10},
+      "not busy waiting");
+
+    auto conn{fact->make_connector(eagine::string_view{"localhost:34915"})};
+    test.ensure(bool(conn), "has connection");
+    conn->send(
+      eagine::message_id{"test", "hello"}, eagine::msgbus::message_view{});
+
+    eagine::shared_holder<eagine::msgbus::connection> accepted;
+    const eagine::timeout accept_time{std::chrono::seconds{5}};
+    while(not accepted and not accept_time.is_expired()) {
+        conn->update();
+        cacc->wait_for_work(std::chrono::milliseconds{10});
+        cacc->update();
+        cacc->process_accepted(
+          {eagine::construct_from,
+           [&](eagine::shared_holder<eagine::msgbus::connection> c) {
+               accepted = std::move(c);
+           }});
+    }
+    test.check(bool(accepted), "accepted after wait");
+}
+//------------------------------------------------------------------------------
 // main
 //------------------------------------------------------------------------------
 auto test_main(eagine::test_ctx& ctx) -> int {
-    eagitest::ctx_suite test{ctx, "asio connection", 5};
+    eagitest::ctx_suite test{ctx, "asio connection", 7};
     test.once(asio_tcp_ipv4_type_id);
     test.once(asio_udp_ipv4_type_id);
     test.once(asio_tcp_ipv4_addr_kind);
     test.once(asio_udp_ipv4_addr_kind);
     test.once(asio_tcp_ipv4_roundtrip);
-    // test.once(asio_udp_ipv4_roundtrip);
+    test.once(asio_udp_ipv4_roundtrip);
+    test.once(asio_udp_ipv4_wait_for_work);
     return test.exit_code();
 }
 //------------------------------------------------------------------------------
@@ -20,6 +20,7 @@ import eagine.core.utility;
 import eagine.core.main_ctx;
 import :types;
 import :message;
+import :timer_wheel;
 
 namespace eagine::msgbus {
 //------------------------------------------------------------------------------
@@ -226,40 +227,200 @@ export auto make_target_blob_chunk_io(
   blob_stream_signals& sigs,
   memory::buffer_pool& buffers) -> unique_holder<target_blob_io>;
 //------------------------------------------------------------------------------
+/// @brief Set of disjoint, non-adjacent [begin, end) blob byte ranges.
+class blob_fragment_set {
+public:
+    using range = std::tuple<span_size_t, span_size_t>;
+
+    auto empty() const noexcept -> bool {
+        return _parts.empty();
+    }
+
+    auto size() const noexcept -> span_size_t {
+        return span_size(_parts.size());
+    }
+
+    /// @brief Returns the sum of the sizes of all ranges.
+    auto total() const noexcept -> span_size_t {
+        return _total;
+    }
+
+    auto front() const noexcept -> range {
+        assert(not empty());
+        const auto& [end, bgn] = *_parts.begin();
+        return {bgn, end};
+    }
+
+    auto back() const noexcept -> range {
+        assert(not empty());
+        const auto& [end, bgn] = *_parts.rbegin();
+        return {bgn, end};
+    }
+
+    /// @brief Returns the first range in [0, total_size) not in this set.
+    auto first_missing(const span_size_t total_size) const noexcept -> range {
+        auto pos{_parts.begin()};
+        if((pos == _parts.end()) or (pos->second > 0)) {
+            return {0, pos == _parts.end() ? total_size : pos->second};
+        }
+        const auto bgn{pos->first};
+        ++pos;
+        return {bgn, pos == _parts.end() ? total_size : pos->second};
+    }
+
+    void clear() noexcept {
+        _parts.clear();
+        _total = 0;
+    }
+
+    /// @brief Calls the function on each range in ascending order.
+    template <typename Function>
+    void for_each(Function func) const {
+        for(const auto& [end, bgn] : _parts) {
+            func(bgn, end);
+        }
+    }
+
+    /// @brief Merges the [bgn, end) range into this set.
+    /// @note The function is called for consecutive sub-ranges of [bgn, end)
+    /// with a flag indicating if the sub-range is new or was already present.
+    template <typename Function>
+    void merge(const span_size_t bgn, const span_size_t end, Function func) {
+        if(not(bgn < end)) {
+            return;
+        }
+        span_size_t new_bgn{bgn};
+        span_size_t new_end{end};
+        span_size_t curr{bgn};
+        // the first range ending at or after bgn (touching ranges coalesce)
+        auto pos{_parts.lower_bound(bgn)};
+        while((pos != _parts.end()) and (pos->second <= end)) {
+            const auto [part_end, part_bgn] = *pos;
+            if(curr < part_bgn) {
+                func(curr, part_bgn, true);
+            }
+            const auto ovl_bgn{std::max(curr, part_bgn)};
+            const auto ovl_end{std::min(end, part_end)};
+            if(ovl_bgn < ovl_end) {
+                func(ovl_bgn, ovl_end, false);
+            }
+            curr = std::max(curr, part_end);
+            new_bgn = std::min(new_bgn, part_bgn);
+            new_end = std::max(new_end, part_end);
+            _total -= part_end - part_bgn;
+            pos = _parts.erase(pos);
+        }
+        if(curr < end) {
+            func(curr, end, true);
+        }
+        _parts.emplace_hint(pos, new_end, new_bgn);
+        _total += new_end - new_bgn;
+    }
+
+    /// @brief Merges the [bgn, end) range into this set.
+    void merge(const span_size_t bgn, const span_size_t end) {
+        merge(bgn, end, [](span_size_t, span_size_t, bool) {});
+    }
+
+    /// @brief Removes the given number of bytes from the start of the last range.
+    void consume_back(const span_size_t size) noexcept {
+        assert(not empty());
+        auto pos{std::prev(_parts.end())};
+        const auto removed{std::min(size, pos->first - pos->second)};
+        pos->second += removed;
+        _total -= removed;
+        if(pos->second >= pos->first) {
+            _parts.erase(pos);
+        }
+    }
+
+    /// @brief Changes the end of the last range.
+    void resize_back(const span_size_t end) {
+        assert(not empty());
+        auto node{_parts.extract(std::prev(_parts.end()))};
+        _total += end - node.key();
+        node.key() = end;
+        _parts.insert(std::move(node));
+    }
+
+private:
+    // maps the end of each range to its beginning
+    std::map<span_size_t, span_size_t> _parts;
+    span_size_t _total{0};
+};
+//------------------------------------------------------------------------------
+/// @brief Limits of the sliding window used by outgoing blob transfers.
+struct blob_flow_limits {
+    span_size_t initial_window{256 * 1024};
+    span_size_t min_window{16 * 1024};
+    span_size_t max_window{8 * 1024 * 1024};
+    span_size_t max_target_in_flight{16 * 1024 * 1024};
+    // how many fragments must be acknowledged past a gap before it is lost
+    span_size_t reorder_fragments{3};
+    // how long the parts declared lost are not counted and resent again
+    std::chrono::milliseconds lost_expiry{500};
+};
+//------------------------------------------------------------------------------
+/// @brief Selective acknowledgement of received blob ranges.
+/// @note The first three members keep the layout of the older resend request.
+using blob_sack_params = std::tuple<
+  identifier_t,
+  std::uint64_t,
+  std::uint64_t,
+  std::uint64_t,
+  std::array<std::uint64_t, 32>>;
+//------------------------------------------------------------------------------
+/// @brief State of an incoming or outgoing blob transfer.
 struct pending_blob {
     message_id msg_id{};
     blob_info info{};
     shared_holder<source_blob_io> source_io{};
     shared_holder<target_blob_io> target_io{};
-    // TODO: recycle the done parts vectors?
-    double_buffer<std::vector<std::tuple<span_size_t, span_size_t>>>
-      fragment_parts{};
+    // received parts of incoming or yet unsent parts of outgoing blobs
+    blob_fragment_set fragment_parts{};
     std::chrono::steady_clock::time_point latest_update{};
     timeout linger_time{std::chrono::seconds{15}};
     timeout prepare_update_time{std::chrono::seconds{5}};
     timeout max_time{};
     blob_id_t source_blob_id{0U};
     blob_id_t target_blob_id{0U};
+    // key of the next cleanup check in the deadline wheel
+    blob_id_t deadline_id{0U};
     float prepare_progress{0.F};
     float previous_progress{0.F};
+    // flow control of outgoing blobs
+    span_size_t window_size{0};
+    span_size_t acked_size{0};
+    span_size_t fragment_size{0};
+    float drop_rate{0.F};
+    timeout ack_timeout{std::chrono::seconds{2}};
+    // sent parts already declared lost, not counted again while being resent
+    blob_fragment_set lost_parts{};
+    // parts declared lost since the last expiration of the lost parts
+    blob_fragment_set recent_lost_parts{};
+    std::chrono::steady_clock::time_point lost_expired{};
+    bool is_windowed{false};
+    // acknowledgement of incoming blobs
+    span_size_t reported_size{0};
+    timeout ack_time{std::chrono::milliseconds{50}};
 
     auto source_buffer_io() noexcept -> buffer_blob_io*;
     auto target_buffer_io() noexcept -> buffer_blob_io*;
 
     auto done_parts() const noexcept -> const auto& {
-        return fragment_parts.current();
+        return fragment_parts;
     }
 
     auto done_parts() noexcept -> auto& {
-        return fragment_parts.current();
+        return fragment_parts;
     }
 
     auto todo_parts() const noexcept -> const auto& {
-        return fragment_parts.next();
+        return fragment_parts;
     }
 
     auto todo_parts() noexcept -> auto& {
-        return fragment_parts.next();
+        return fragment_parts;
     }
 
     auto sent_size() const noexcept -> span_size_t;
@@ -283,6 +444,16 @@ struct pending_blob {
       const memory::const_block) noexcept -> bool;
     void merge_resend_request(const span_size_t bgn, span_size_t end) noexcept;
     void handle_target_preparing(float) noexcept;
+
+    auto in_flight_size() const noexcept -> span_size_t;
+    auto is_window_full() const noexcept -> bool;
+    auto make_sack(const span_size_t resend_bgn, const span_size_t resend_end)
+      const noexcept -> blob_sack_params;
+    void handle_sack(
+      const blob_sack_params&,
+      const message_age,
+      const blob_flow_limits&) noexcept;
+    auto handle_ack_timeout() noexcept -> bool;
 };
 //------------------------------------------------------------------------------
 export class blob_manipulator : main_ctx_object {
@@ -406,20 +577,44 @@ public:
     auto has_outgoing() const noexcept -> bool {
         return not _outgoing.empty();
     }
+
+    /// @brief Returns the number of pending blobs with a scheduled check.
+    auto scheduled_count() const noexcept -> span_size_t {
+        return span_size(_deadlines.size());
+    }
     auto process_outgoing(
       const send_handler,
       const span_size_t max_data_size,
       span_size_t max_messages) noexcept -> work_done;
 
 private:
+    void _schedule_cleanup(pending_blob& pending, const bool outgoing) noexcept;
     auto _cleanup_outgoing() noexcept -> std::size_t;
     auto _cleanup_incoming() noexcept -> std::size_t;
+
+    // erases the incoming blobs and their scheduled checks
+    template <typename Predicate>
+    auto _erase_incoming(Predicate predicate) noexcept -> span_size_t {
+        return span_size(std::erase_if(_incoming, [&](auto& pending) {
+            if(predicate(pending)) {
+                _deadlines.cancel(pending.deadline_id);
+                return true;
+            }
+            return false;
+        }));
+    }
     auto _done_begin_end(
-      const std::vector<std::tuple<span_size_t, span_size_t>>& done,
+      const blob_fragment_set& done,
       const span_size_t total_size,
       const span_size_t max_message_size) const noexcept
       -> std::tuple<span_size_t, span_size_t>;
 
+    auto _target_in_flight(const endpoint_id_t target_id) const noexcept
+      -> span_size_t;
+    auto _can_send(pending_blob& pending) noexcept -> bool;
+    auto _unpack_incoming(pending_blob& pending) noexcept
+      -> blob_preparation_status;
+
     auto _process_preparing_outgoing(
       const send_handler do_send,
       const span_size_t max_message_size,
@@ -433,12 +628,16 @@ private:
     const message_id _resend_msg_id;
     const message_id _prepare_msg_id;
     std::int64_t _max_blob_size{128 * 1024 * 1024};
+    blob_flow_limits _flow_limits{};
     blob_id_t _blob_id_sequence{0U};
     memory::buffer _scratch_buffer{};
     memory::buffer_pool _buffers{};
     std::size_t _outgoing_index{};
     std::vector<pending_blob> _outgoing{};
     std::vector<pending_blob> _incoming{};
+    // the lists of pending blobs are scanned only when some check is due
+    blob_id_t _deadline_id_sequence{0U};
+    timer_wheel<blob_id_t, bool> _deadlines{std::chrono::milliseconds{10}};
 
     auto _message_size(const pending_blob&, const span_size_t max_message_size)
       const noexcept -> span_size_t;
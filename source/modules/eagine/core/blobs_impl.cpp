@@ -17,6 +17,7 @@ import eagine.core.types;
 import eagine.core.memory;
 import eagine.core.math;
 import eagine.core.utility;
+import eagine.core.runtime;
 import eagine.core.container;
 import eagine.core.identifier;
 import eagine.core.serialization;
@@ -338,6 +339,366 @@ auto make_target_blob_chunk_io(
     return {hold<blob_chunk_io>, blob_id, chunk_size, sigs, buffers};
 }
 //------------------------------------------------------------------------------
+// compressed blob I/O
+//------------------------------------------------------------------------------
+// compressed blobs consist of independently compressed frames, each starting
+// with a header containing the unpacked and the packed size of the frame
+static constexpr const span_size_t blob_frame_size{1024 * 1024};
+static constexpr const span_size_t blob_frame_header_size{8};
+
+static void write_blob_frame_header(
+  memory::block dst,
+  const span_size_t unpacked_size,
+  const span_size_t packed_size) noexcept {
+    const auto put{[&](span_size_t offs, std::uint32_t value) {
+        for(span_size_t i = 0; i < 4; ++i) {
+            dst[offs + i] = byte((value >> (8U * unsigned(i))) & 0xFFU);
+        }
+    }};
+    put(0, limit_cast<std::uint32_t>(unpacked_size));
+    put(4, limit_cast<std::uint32_t>(packed_size));
+}
+
+static auto read_blob_frame_header(const memory::const_block src) noexcept
+  -> std::tuple<span_size_t, span_size_t> {
+    const auto get{[&](span_size_t offs) {
+        std::uint32_t value{0U};
+        for(span_size_t i = 0; i < 4; ++i) {
+            value |= std::uint32_t(src[offs + i]) << (8U * unsigned(i));
+        }
+        return span_size(value);
+    }};
+    return {get(0), get(4)};
+}
+//------------------------------------------------------------------------------
+class blob_frame_work_unit : public latched_work_unit {
+public:
+    blob_frame_work_unit() noexcept = default;
+
+    // compresses the source into a new frame
+    blob_frame_work_unit(std::latch& completed, memory::const_block src) noexcept
+      : latched_work_unit{completed}
+      , _src{src}
+      , _compress{true} {}
+
+    // decompresses the frame content into the destination
+    blob_frame_work_unit(
+      std::latch& completed,
+      memory::const_block src,
+      memory::block dst) noexcept
+      : latched_work_unit{completed}
+      , _src{src}
+      , _dst{dst} {}
+
+    auto do_it() noexcept -> bool final {
+        memory::buffer_pool buffers;
+        data_compressor compressor{buffers};
+        if(_compress) {
+            const auto packed{
+              compressor.compress(_src, data_compression_level::normal)};
+            _frame.resize(blob_frame_header_size + packed.size());
+            write_blob_frame_header(cover(_frame), _src.size(), packed.size());
+            copy(packed, skip(cover(_frame), blob_frame_header_size));
+            _succeeded = not packed.empty() or _src.empty();
+        } else {
+            // the frame does not decompress past the announced size
+            span_size_t done{0};
+            const auto store{
+              [&](const memory::const_block chunk) noexcept -> bool {
+                  if(chunk.size() > _dst.size() - done) {
+                      return false;
+                  }
+                  copy(chunk, skip(_dst, done));
+                  done += chunk.size();
+                  return true;
+              }};
+            _succeeded =
+              compressor.decompress(
+                _src, data_compressor::data_handler{construct_from, store}) and
+              (done == _dst.size());
+        }
+        return true;
+    }
+
+    auto has_succeeded() const noexcept -> bool {
+        return _succeeded;
+    }
+
+    auto frame() const noexcept -> memory::const_block {
+        return view(_frame);
+    }
+
+private:
+    memory::const_block _src{};
+    memory::block _dst{};
+    memory::buffer _frame{};
+    bool _compress{false};
+    bool _succeeded{false};
+};
+//------------------------------------------------------------------------------
+class compressed_source_blob_io final : public source_blob_io {
+public:
+    compressed_source_blob_io(
+      shared_holder<source_blob_io> source,
+      workshop& workers) noexcept
+      : _source{std::move(source)}
+      , _workers{workers} {}
+
+    compressed_source_blob_io(compressed_source_blob_io&&) = delete;
+    compressed_source_blob_io(const compressed_source_blob_io&) = delete;
+    auto operator=(compressed_source_blob_io&&) = delete;
+    auto operator=(const compressed_source_blob_io&) = delete;
+
+    ~compressed_source_blob_io() noexcept override {
+        if(_batch_done) {
+            _batch_done->wait();
+        }
+    }
+
+    auto prepare() noexcept -> blob_preparation_result final;
+
+    auto total_size() noexcept -> span_size_t final {
+        return _is_prepared ? span_size(_packed.size()) : _source->total_size();
+    }
+
+    auto fetch_fragment(const span_size_t offs, memory::block dst) noexcept
+      -> span_size_t final {
+        const memory::const_block packed{
+          _packed.data(), span_size(_packed.size())};
+        return copy(head(skip(packed, offs), dst.size()), dst).size();
+    }
+
+private:
+    auto _progress() const noexcept -> float {
+        return _unpacked_size > 0 ? float(_unpacked_done) / float(_unpacked_size)
+                                  : 0.F;
+    }
+
+    auto _start_batch() noexcept -> bool;
+    auto _finish_batch() noexcept -> bool;
+
+    shared_holder<source_blob_io> _source;
+    workshop& _workers;
+    std::vector<byte> _packed;
+    std::vector<memory::buffer> _unpacked;
+    std::vector<blob_frame_work_unit> _units;
+    std::optional<std::latch> _batch_done;
+    span_size_t _unpacked_size{0};
+    span_size_t _unpacked_offs{0};
+    span_size_t _unpacked_done{0};
+    bool _source_prepared{false};
+    bool _is_prepared{false};
+};
+//------------------------------------------------------------------------------
+auto compressed_source_blob_io::_start_batch() noexcept -> bool {
+    const auto frames_left{
+      (_unpacked_size - _unpacked_offs + blob_frame_size - 1) / blob_frame_size};
+    const auto count{std::min(
+      frames_left,
+      span_size(2 * std::max(std::thread::hardware_concurrency(), 1U)))};
+
+    _unpacked.resize(std::size_t(count));
+    _units.resize(std::size_t(count));
+    _batch_done.emplace(count);
+    for(const auto i : integer_range(std::size_t(count))) {
+        auto& unpacked{_unpacked[i]};
+        unpacked.resize(
+          std::min(blob_frame_size, _unpacked_size - _unpacked_offs));
+        const auto fetched{
+          _source->fetch_fragment(_unpacked_offs, cover(unpacked))};
+        if(fetched != unpacked.size()) [[unlikely]] {
+            unpacked.resize(fetched);
+        }
+        _unpacked_offs += unpacked.size();
+        _units[i] = {*_batch_done, view(unpacked)};
+    }
+    for(auto& unit : _units) {
+        _workers.enqueue(unit);
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+auto compressed_source_blob_io::_finish_batch() noexcept -> bool {
+    bool result{true};
+    for(const auto i : integer_range(_units.size())) {
+        if(_units[i].has_succeeded() and not _unpacked[i].empty()) {
+            const auto frame{_units[i].frame()};
+            _packed.insert(_packed.end(), frame.begin(), frame.end());
+            _unpacked_done += _unpacked[i].size();
+        } else {
+            result = false;
+        }
+    }
+    _batch_done.reset();
+    return result;
+}
+//------------------------------------------------------------------------------
+auto compressed_source_blob_io::prepare() noexcept -> blob_preparation_result {
+    if(_is_prepared) {
+        return blob_preparation_result::finished();
+    }
+    if(not _source_prepared) {
+        const auto result{_source->prepare()};
+        if(not result.has_finished()) {
+            return {0.F, result.status()};
+        }
+        _source_prepared = true;
+        _unpacked_size = _source->total_size();
+    }
+    if(_batch_done) {
+        if(not _batch_done->try_wait()) {
+            return {_progress(), blob_preparation_status::working};
+        }
+        if(not _finish_batch()) {
+            return {blob_preparation_status::failed};
+        }
+    }
+    if(_unpacked_offs >= _unpacked_size) {
+        _unpacked.clear();
+        _units.clear();
+        _is_prepared = true;
+        return blob_preparation_result::finished();
+    }
+    _start_batch();
+    return {_progress(), blob_preparation_status::working};
+}
+//------------------------------------------------------------------------------
+class compressed_target_blob_io final : public target_blob_io {
+public:
+    compressed_target_blob_io(shared_holder<target_blob_io> target) noexcept
+      : _target{std::move(target)} {}
+
+    compressed_target_blob_io(compressed_target_blob_io&&) = delete;
+    compressed_target_blob_io(const compressed_target_blob_io&) = delete;
+    auto operator=(compressed_target_blob_io&&) = delete;
+    auto operator=(const compressed_target_blob_io&) = delete;
+
+    ~compressed_target_blob_io() noexcept override {
+        if(_frames_done) {
+            _frames_done->wait();
+        }
+    }
+
+    auto store_fragment(
+      const span_size_t offs,
+      const memory::const_block src,
+      const blob_info& info) noexcept -> bool final {
+        if(_frames_done) [[unlikely]] {
+            // a duplicate of an already received fragment
+            return true;
+        }
+        if(_packed.empty()) {
+            _packed.resize(info.total_size);
+        }
+        auto dst{skip(cover(_packed), offs)};
+        if(src.size() <= dst.size()) [[likely]] {
+            copy(src, dst);
+            return true;
+        }
+        return false;
+    }
+
+    void handle_prepared(float progress) noexcept final {
+        _target->handle_prepared(progress);
+    }
+
+    void handle_cancelled() noexcept final {
+        _target->handle_cancelled();
+    }
+
+    /// @brief Decompresses the frames in parallel into the unpacked buffer.
+    /// @see release_unpacked
+    ///
+    /// The first call enqueues the frames to the workers, the subsequent
+    /// calls just check if all of them were decompressed.
+    auto unpack(
+      workshop& workers,
+      memory::buffer_pool& buffers,
+      const span_size_t max_unpacked_size) noexcept -> blob_preparation_status;
+
+    auto release_unpacked() noexcept -> memory::buffer {
+        return std::move(_unpacked);
+    }
+
+    auto release_target() noexcept -> shared_holder<target_blob_io> {
+        return std::move(_target);
+    }
+
+private:
+    auto _start_unpack(
+      workshop& workers,
+      memory::buffer_pool& buffers,
+      const span_size_t max_unpacked_size) noexcept -> bool;
+
+    shared_holder<target_blob_io> _target;
+    memory::buffer _packed;
+    memory::buffer _unpacked;
+    std::vector<blob_frame_work_unit> _units;
+    std::optional<std::latch> _frames_done;
+};
+//------------------------------------------------------------------------------
+auto compressed_target_blob_io::_start_unpack(
+  workshop& workers,
+  memory::buffer_pool& buffers,
+  const span_size_t max_unpacked_size) noexcept -> bool {
+    // the first pass over the headers finds the frames and the unpacked size
+    std::vector<std::tuple<memory::const_block, span_size_t, span_size_t>>
+      frames;
+    span_size_t unpacked_size{0};
+    auto packed{view(_packed)};
+    while(packed.size() >= blob_frame_header_size) {
+        const auto [frame_unpacked, frame_packed] =
+          read_blob_frame_header(packed);
+        packed = skip(packed, blob_frame_header_size);
+        // the sizes come from the peer, do not trust them
+        if(
+          (frame_packed > packed.size()) or (frame_unpacked > blob_frame_size) or
+          (frame_unpacked > max_unpacked_size - unpacked_size)) [[unlikely]] {
+            return false;
+        }
+        frames.emplace_back(
+          head(packed, frame_packed), unpacked_size, frame_unpacked);
+        unpacked_size += frame_unpacked;
+        packed = skip(packed, frame_packed);
+    }
+    if(not packed.empty()) [[unlikely]] {
+        return false;
+    }
+
+    _unpacked = buffers.get(unpacked_size);
+    _unpacked.resize(unpacked_size);
+    _units.resize(frames.size());
+    _frames_done.emplace(std::ptrdiff_t(frames.size()));
+    for(const auto i : integer_range(frames.size())) {
+        const auto& [src, offs, size] = frames[i];
+        _units[i] = {*_frames_done, src, head(skip(cover(_unpacked), offs), size)};
+    }
+    for(auto& unit : _units) {
+        workers.enqueue(unit);
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+auto compressed_target_blob_io::unpack(
+  workshop& workers,
+  memory::buffer_pool& buffers,
+  const span_size_t max_unpacked_size) noexcept -> blob_preparation_status {
+    if(not _frames_done) {
+        if(not _start_unpack(workers, buffers, max_unpacked_size)) {
+            return blob_preparation_status::failed;
+        }
+    }
+    if(not _frames_done->try_wait()) {
+        return blob_preparation_status::working;
+    }
+    const bool succeeded{
+      std::all_of(_units.begin(), _units.end(), [](const auto& unit) {
+          return unit.has_succeeded();
+      })};
+    return succeeded ? blob_preparation_status::finished
+                     : blob_preparation_status::failed;
+}
+//------------------------------------------------------------------------------
 // pending blob
 //------------------------------------------------------------------------------
 auto pending_blob::source_buffer_io() noexcept -> buffer_blob_io* {
@@ -349,19 +710,11 @@ auto pending_blob::target_buffer_io() noexcept -> buffer_blob_io* {
 }
 //------------------------------------------------------------------------------
 auto pending_blob::sent_size() const noexcept -> span_size_t {
-    span_size_t result = 0;
-    for(const auto& [bgn, end] : todo_parts()) {
-        result += end - bgn;
-    }
-    return info.total_size - result;
+    return info.total_size - todo_parts().total();
 }
 //------------------------------------------------------------------------------
 auto pending_blob::received_size() const noexcept -> span_size_t {
-    span_size_t result = 0;
-    for(const auto& [bgn, end] : done_parts()) {
-        result += end - bgn;
-    }
-    return result;
+    return done_parts().total();
 }
 //------------------------------------------------------------------------------
 auto pending_blob::total_size() const noexcept -> span_size_t {
@@ -377,7 +730,7 @@ void pending_blob::handle_source_preparing(float new_progress) noexcept {
     if(not todo_parts().empty()) {
         linger_time.reset();
         info.total_size = source_io->total_size();
-        std::get<1>(todo_parts().back()) = info.total_size;
+        todo_parts().resize_back(info.total_size);
     }
     prepare_progress = new_progress;
 }
@@ -390,6 +743,9 @@ auto pending_blob::prepare() noexcept -> blob_preparation_result {
     } else {
         if(result.has_failed()) {
             todo_parts().clear();
+        } else if(prepare_progress < 1.F) {
+            // the final size may differ, for example for compressed blobs
+            handle_source_preparing(1.F);
         }
         prepare_progress = 1.F;
     }
@@ -439,62 +795,15 @@ auto pending_blob::age() const noexcept -> message_age {
 auto pending_blob::merge_fragment(
   const span_size_t bgn,
   const memory::const_block fragment) noexcept -> bool {
-    const auto end = bgn + fragment.size();
-    fragment_parts.swap();
-    auto& dst = done_parts();
-    const auto& src = todo_parts();
-    dst.clear();
-
     bool result = true;
-    bool new_done = false;
-
-    for(const auto [src_bgn, src_end] : src) {
-        if(bgn < src_bgn) {
-            if(end < src_bgn) {
-                if(not new_done) {
-                    dst.emplace_back(bgn, end);
-                    result &= store(bgn, fragment);
-                    new_done = true;
-                }
-                dst.emplace_back(src_bgn, src_end);
-            } else if(end <= src_end) {
-                if(new_done) {
-                    std::get<1>(dst.back()) = src_end;
-                } else {
-                    dst.emplace_back(bgn, src_end);
-                    result &= store(bgn, head(fragment, src_bgn - bgn));
-                    new_done = true;
-                }
-                result &= check(src_bgn, skip(fragment, src_bgn - bgn));
-            } else {
-                if(not new_done) {
-                    dst.emplace_back(bgn, end);
-                    result &= store(bgn, head(fragment, src_bgn - bgn));
-                    result &= store(src_end, skip(fragment, src_end - bgn));
-                    new_done = true;
-                }
-                result &= check(
-                  src_bgn, head(skip(fragment, src_bgn - bgn), src_end - src_bgn));
-            }
-        } else if(bgn <= src_end) {
-            if(end <= src_end) {
-                dst.emplace_back(src_bgn, src_end);
-                new_done = true;
-                result &= check(bgn, fragment);
-            } else {
-                dst.emplace_back(src_bgn, end);
-                result &= store(src_end, skip(fragment, src_end - bgn));
-                result &= check(bgn, head(fragment, src_end - bgn));
-                new_done = true;
-            }
-        } else {
-            dst.emplace_back(src_bgn, src_end);
-        }
-    }
-    if(not new_done) {
-        dst.emplace_back(bgn, end);
-        result &= store(bgn, fragment);
-    }
+    done_parts().merge(
+      bgn,
+      bgn + fragment.size(),
+      [&](const span_size_t part_bgn, const span_size_t part_end, bool is_new) {
+          const auto part{
+            head(skip(fragment, part_bgn - bgn), part_end - part_bgn)};
+          result &= is_new ? store(part_bgn, part) : check(part_bgn, part);
+      });
     latest_update = std::chrono::steady_clock::now();
 
     return result;
@@ -506,51 +815,7 @@ void pending_blob::merge_resend_request(
     if(end == 0) {
         end = info.total_size;
     }
-    if(bgn < end) {
-        fragment_parts.swap();
-        auto& dst = todo_parts();
-        const auto& src = done_parts();
-        dst.clear();
-
-        bool new_done = false;
-
-        for(const auto& [src_bgn, src_end] : src) {
-            if(bgn < src_bgn) {
-                if(end < src_bgn) {
-                    if(not new_done) {
-                        dst.emplace_back(bgn, end);
-                        new_done = true;
-                    }
-                    dst.emplace_back(src_bgn, src_end);
-                } else if(end <= src_end) {
-                    if(new_done) {
-                        std::get<1>(dst.back()) = src_end;
-                    } else {
-                        dst.emplace_back(bgn, src_end);
-                        new_done = true;
-                    }
-                } else {
-                    if(not new_done) {
-                        dst.emplace_back(bgn, end);
-                        new_done = true;
-                    }
-                }
-            } else if(bgn <= src_end) {
-                if(end <= src_end) {
-                    dst.emplace_back(src_bgn, src_end);
-                    new_done = true;
-                } else {
-                    dst.emplace_back(src_bgn, end);
-                    new_done = true;
-                }
-            } else {
-                dst.emplace_back(src_bgn, src_end);
-            }
-        }
-        if(not new_done) {
-            dst.emplace_back(bgn, end);
-        }
-    }
+    todo_parts().merge(bgn, end);
 }
 //------------------------------------------------------------------------------
 void pending_blob::handle_target_preparing(float new_progress) noexcept {
@@ -562,6 +827,119 @@ void pending_blob::handle_target_preparing(float new_progress) noexcept {
     linger_time.reset();
 }
 //------------------------------------------------------------------------------
+auto pending_blob::in_flight_size() const noexcept -> span_size_t {
+    return std::max(sent_size() - acked_size, span_size(0));
+}
+//------------------------------------------------------------------------------
+auto pending_blob::is_window_full() const noexcept -> bool {
+    return is_windowed and (in_flight_size() >= window_size);
+}
+//------------------------------------------------------------------------------
+auto pending_blob::make_sack(
+  const span_size_t resend_bgn,
+  const span_size_t resend_end) const noexcept -> blob_sack_params {
+    blob_sack_params result{};
+    auto& [blob_id, miss_bgn, miss_end, received, ranges] = result;
+    blob_id = source_blob_id;
+    miss_bgn = limit_cast<std::uint64_t>(resend_bgn);
+    miss_end = limit_cast<std::uint64_t>(resend_end);
+    received = limit_cast<std::uint64_t>(received_size());
+    std::size_t idx{0U};
+    done_parts().for_each([&](const span_size_t bgn, const span_size_t end) {
+        if(idx + 1U < ranges.size()) {
+            ranges[idx++] = limit_cast<std::uint64_t>(bgn);
+            ranges[idx++] = limit_cast<std::uint64_t>(end);
+        }
+    });
+    return result;
+}
+//------------------------------------------------------------------------------
+void pending_blob::handle_sack(
+  const blob_sack_params& sack,
+  const message_age sack_age,
+  const blob_flow_limits& limits) noexcept {
+    const auto& [blob_id, miss_bgn, miss_end, received, ranges] = sack;
+    merge_resend_request(
+      limit_cast<span_size_t>(miss_bgn), limit_cast<span_size_t>(miss_end));
+
+    // the resent parts may get lost again, forget the parts declared lost
+    // more than one expiration period ago so that they are resent again
+    const auto now{std::chrono::steady_clock::now()};
+    if(now - lost_expired >= limits.lost_expiry) {
+        if(now - lost_expired >= 2 * limits.lost_expiry) {
+            recent_lost_parts.clear();
+        }
+        lost_parts = std::exchange(recent_lost_parts, {});
+        lost_expired = now;
+    }
+
+    std::size_t range_count{0U};
+    span_size_t highest_end{0};
+    for(; range_count + 1U < ranges.size(); range_count += 2U) {
+        const auto bgn{limit_cast<span_size_t>(ranges[range_count])};
+        const auto end{limit_cast<span_size_t>(ranges[range_count + 1U])};
+        if(end <= bgn) {
+            break;
+        }
+        highest_end = end;
+    }
+
+    // gaps between acknowledged ranges were sent, but the fragments may just
+    // arrive out of order, so they are lost only if enough data after them
+    // was acknowledged already
+    const auto reorder_distance{
+      limits.reorder_fragments * std::max(fragment_size, span_size(1))};
+    span_size_t lost{0};
+    const auto count_sent{
+      [&](const span_size_t bgn, const span_size_t end, const bool was_sent) {
+          if(was_sent) {
+              lost += end - bgn;
+          }
+      }};
+    const auto resend_new{
+      [&](const span_size_t bgn, const span_size_t end, const bool is_new) {
+          if(is_new) {
+              recent_lost_parts.merge(bgn, end);
+              todo_parts().merge(bgn, end, count_sent);
+          }
+      }};
+    span_size_t prev_end{0};
+    for(std::size_t idx = 0U; idx < range_count; idx += 2U) {
+        const auto bgn{limit_cast<span_size_t>(ranges[idx])};
+        if(highest_end - bgn >= reorder_distance) {
+            lost_parts.merge(prev_end, bgn, resend_new);
+        }
+        prev_end = limit_cast<span_size_t>(ranges[idx + 1U]);
+    }
+
+    const auto acked{limit_cast<span_size_t>(received)};
+    const auto acked_delta{std::max(acked - acked_size, span_size(0))};
+    acked_size = std::max(acked_size, acked);
+    if(const auto observed{acked_delta + lost}; observed > 0) {
+        drop_rate = drop_rate * 0.875F + 0.125F * float(lost) / float(observed);
+    }
+
+    if((lost > 0) or (sack_age > message_age::zero())) {
+        const auto factor{1.F - std::clamp(drop_rate, 0.125F, 0.5F)};
+        window_size = std::max(
+          span_size(float(window_size) * factor), limits.min_window);
+    } else if(acked_delta > 0) {
+        window_size = std::min(
+          window_size + std::min(acked_delta, 2 * fragment_size),
+          limits.max_window);
+    }
+    ack_timeout.reset();
+}
+//------------------------------------------------------------------------------
+auto pending_blob::handle_ack_timeout() noexcept -> bool {
+    if(is_windowed and ack_timeout.is_expired()) {
+        // the peer does not send acknowledgements, stop limiting
+        is_windowed = false;
+        return true;
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
 // blob manipulator
 //------------------------------------------------------------------------------
 blob_manipulator::blob_manipulator(
@@ -572,7 +950,55 @@ blob_manipulator::blob_manipulator(
   : main_ctx_object{"BlobManipl", parent}
   , _fragment_msg_id{std::move(fragment_msg_id)}
   , _resend_msg_id{std::move(resend_msg_id)}
-  , _prepare_msg_id{std::move(prepare_msg_id)} {}
+  , _prepare_msg_id{std::move(prepare_msg_id)} {
+    auto& limits{_flow_limits};
+    limits.initial_window =
+      app_config()
+        .get<span_size_t>("msgbus.blobs.initial_window")
+        .value_or(limits.initial_window);
+    limits.max_window = app_config()
+                          .get<span_size_t>("msgbus.blobs.max_window")
+                          .value_or(limits.max_window);
+    limits.max_target_in_flight =
+      app_config()
+        .get<span_size_t>("msgbus.blobs.max_target_in_flight")
+        .value_or(limits.max_target_in_flight);
+    limits.max_window = std::max(limits.max_window, limits.min_window);
+    limits.initial_window = std::clamp(
+      limits.initial_window, limits.min_window, limits.max_window);
+}
+//------------------------------------------------------------------------------
+static auto blob_time_left(const timeout& t) noexcept
+  -> std::chrono::steady_clock::duration {
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      t.period() - t.elapsed_time());
+}
+//------------------------------------------------------------------------------
+void blob_manipulator::_schedule_cleanup(
+  pending_blob& pending,
+  const bool outgoing) noexcept {
+    if(pending.deadline_id == 0U) {
+        if(++_deadline_id_sequence == 0U) [[unlikely]] {
+            ++_deadline_id_sequence;
+        }
+        pending.deadline_id = _deadline_id_sequence;
+    }
+    // the timeouts can only be extended later, so an earlier check is safe
+    auto delay{blob_time_left(pending.max_time)};
+    if(outgoing) {
+        // an expired linger time matters only after everything was sent
+        // and sending resets it, so it is checked again one period later
+        const auto linger_left{blob_time_left(pending.linger_time)};
+        delay = std::min(
+          delay,
+          linger_left > std::chrono::steady_clock::duration::zero()
+            ? linger_left
+            : std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                pending.linger_time.period()));
+    }
+    _deadlines.schedule(
+      pending.deadline_id, outgoing, std::max(delay, _deadlines.tick()));
+}
 //------------------------------------------------------------------------------
 auto blob_manipulator::_cleanup_outgoing() noexcept -> std::size_t {
     return std::erase_if(_outgoing, [this](auto& pending) {
@@ -582,8 +1008,12 @@ auto blob_manipulator::_cleanup_outgoing() noexcept -> std::size_t {
             if(auto buf_io{pending.source_buffer_io()}) {
                 _buffers.eat(buf_io->release_buffer());
             }
+            _deadlines.cancel(pending.deadline_id);
             return true;
         }
+        if(not _deadlines.contains(pending.deadline_id)) {
+            _schedule_cleanup(pending, true);
+        }
         return false;
     });
 }
@@ -595,33 +1025,24 @@ auto blob_manipulator::_cleanup_incoming() noexcept -> std::size_t {
             if(auto buf_io{pending.target_buffer_io()}) {
                 _buffers.eat(buf_io->release_buffer());
             }
+            _deadlines.cancel(pending.deadline_id);
             return true;
         }
+        if(not _deadlines.contains(pending.deadline_id)) {
+            _schedule_cleanup(pending, false);
+        }
         return false;
     });
 }
 //------------------------------------------------------------------------------
 auto blob_manipulator::_done_begin_end(
-  const std::vector<std::tuple<span_size_t, span_size_t>>& done,
+  const blob_fragment_set& done,
   const span_size_t total_size,
   const span_size_t max_message_size) const noexcept
   -> std::tuple<span_size_t, span_size_t> {
     const auto max{2 * max_message_size / 3};
-    if(std::get<0>(done[0]) > 0) {
-        return {0, std::min(std::get<0>(done[0]), max)};
-    } else {
-        if(done.size() == 1) {
-            return {
-              std::get<1>(done[0]),
-              std::get<1>(done[0]) +
-                std::min(total_size - std::get<1>(done[0]), max)};
-        } else {
-            return {
-              std::get<1>(done[0]),
-              std::get<1>(done[0]) +
-                std::min(std::get<0>(done[1]) - std::get<1>(done[0]), max)};
-        }
-    }
+    const auto [bgn, end]{done.first_missing(total_size)};
+    return {bgn, bgn + std::min(end - bgn, max)};
 }
 //------------------------------------------------------------------------------
 auto blob_manipulator::update(
@@ -632,37 +1053,57 @@ auto blob_manipulator::update(
     const auto now = std::chrono::steady_clock::now();
     some_true something_done{};
 
-    if(const auto erased_count{_cleanup_outgoing()}; erased_count > 0) {
-        log_debug("erased ${erased} outgoing blobs")
-          .tag("delOutBlob")
-          .arg("erased", erased_count)
-          .arg("remaining", _outgoing.size());
-        something_done();
+    bool outgoing_due{false};
+    bool incoming_due{false};
+    _deadlines.expire(now, [&](const blob_id_t, const bool outgoing) {
+        (outgoing ? outgoing_due : incoming_due) = true;
+    });
+
+    if(outgoing_due) {
+        if(const auto erased_count{_cleanup_outgoing()}; erased_count > 0) {
+            log_debug("erased ${erased} outgoing blobs")
+              .tag("delOutBlob")
+              .arg("erased", erased_count)
+              .arg("remaining", _outgoing.size());
+            something_done();
+        }
     }
 
-    if(const auto erased_count{_cleanup_incoming()}; erased_count > 0) {
-        log_debug("erased ${erased} incoming blobs")
-          .tag("delIncBlob")
-          .arg("erased", erased_count)
-          .arg("remaining", _incoming.size());
-        something_done();
+    if(incoming_due) {
+        if(const auto erased_count{_cleanup_incoming()}; erased_count > 0) {
+            log_debug("erased ${erased} incoming blobs")
+              .tag("delIncBlob")
+              .arg("erased", erased_count)
+              .arg("remaining", _incoming.size());
+            something_done();
+        }
     }
 
     for(auto& pending : _incoming) {
         auto& done = pending.done_parts();
         if(not done.empty()) {
-            if(now - pending.latest_update > std::chrono::milliseconds{250}) {
+            const bool stalled{
+              now - pending.latest_update > std::chrono::milliseconds{250}};
+            const bool has_news{pending.received_size() != pending.reported_size};
+            if(stalled or (has_news and pending.ack_time.is_expired())) {
+                // older senders handle only the resend range,
+                // which is left empty unless the transfer stalled
                 const auto [bgn, end]{
-                  _done_begin_end(done, pending.info.total_size, max_message_size)};
-
-                const std::tuple<identifier_t, std::uint64_t, std::uint64_t> params{
-                  pending.source_blob_id, bgn, end};
+                  stalled ? _done_begin_end(
+                              done, pending.info.total_size, max_message_size)
+                          : std::make_tuple(
+                              pending.info.total_size, pending.info.total_size)};
+                const auto params{pending.make_sack(bgn, end)};
                 auto buffer{default_serialize_buffer_for(params)};
                 const auto serialized{default_serialize(params, cover(buffer))};
                 assert(serialized);
                 message_view resend_request{*serialized};
                 resend_request.set_target_id(pending.info.source_id);
-                pending.latest_update = now;
+                if(stalled) {
+                    pending.latest_update = now;
+                }
+                pending.reported_size = pending.received_size();
+                pending.ack_time.reset();
                 something_done(do_send(_resend_msg_id, resend_request));
             }
         }
@@ -710,6 +1151,7 @@ auto blob_manipulator::expect_incoming(
     pending.target_io = std::move(io);
     pending.latest_update = std::chrono::steady_clock::now();
     pending.max_time = timeout{max_time};
+    _schedule_cleanup(pending, false);
     return true;
 }
 //------------------------------------------------------------------------------
@@ -751,6 +1193,10 @@ auto blob_manipulator::push_incoming_fragment(
             pending.info.priority = priority;
             pending.info.options = options;
             pending.info.total_size = limit_cast<span_size_t>(total_size);
+            if(options.has(blob_option::compressed)) {
+                pending.target_io = {
+                  hold<compressed_target_blob_io>, std::move(pending.target_io)};
+            }
             log_debug("updating expected blob fragment")
               .arg("source", source_id)
               .arg("srcBlobId", source_blob_id)
@@ -809,8 +1255,13 @@ auto blob_manipulator::push_incoming_fragment(
             pending.source_blob_id = source_blob_id;
             pending.target_blob_id = target_blob_id;
             pending.target_io = std::move(io);
+            if(options.has(blob_option::compressed)) {
+                pending.target_io = {
+                  hold<compressed_target_blob_io>, std::move(pending.target_io)};
+            }
             pending.max_time = timeout{adjusted_duration(
               std::chrono::seconds{60}, memory_access_rate::high)};
+            _schedule_cleanup(pending, false);
             pending.done_parts().clear();
             if(pending.merge_fragment(integer(offset), fragment)) {
                 log_debug("merged first blob fragment")
@@ -899,6 +1350,24 @@ auto blob_manipulator::process_incoming(const message_view& message) noexcept
 //------------------------------------------------------------------------------
 auto blob_manipulator::process_resend(const message_view& message) noexcept
   -> bool {
+    blob_sack_params sack{};
+    if(default_deserialize(sack, message.content())) {
+        const auto source_blob_id{std::get<0>(sack)};
+        const auto pos{std::find_if(
+          _outgoing.begin(), _outgoing.end(), [source_blob_id](auto& pending) {
+              return pending.source_blob_id == source_blob_id;
+          })};
+        if(pos != _outgoing.end()) {
+            pos->handle_sack(sack, message.age(), _flow_limits);
+            log_debug("received blob acknowledgement from ${target}")
+              .arg("target", message.source_id)
+              .arg("srcBlobId", source_blob_id)
+              .arg("acked", "ByteSize", pos->acked_size)
+              .arg("window", "ByteSize", pos->window_size)
+              .arg("dropRate", "Ratio", pos->drop_rate);
+        }
+        return true;
+    }
     std::tuple<identifier_t, std::uint64_t, std::uint64_t> params{};
     if(default_deserialize(params, message.content())) {
         const auto source_blob_id{std::get<0>(params)};
@@ -915,6 +1384,8 @@ auto blob_manipulator::process_resend(const message_view& message) noexcept
           })};
         if(pos != _outgoing.end()) {
             pos->merge_resend_request(bgn, end);
+            // older targets do not acknowledge the received fragments
+            pos->is_windowed = false;
         }
     }
     return true;
@@ -948,6 +1419,7 @@ auto blob_manipulator::cancel_incoming(const endpoint_id_t target_blob_id) noexc
         if(auto buf_io{pending.target_buffer_io()}) {
             _buffers.eat(buf_io->release_buffer());
         }
+        _deadlines.cancel(pending.deadline_id);
         _incoming.erase(pos);
         return true;
     }
@@ -993,6 +1465,9 @@ auto blob_manipulator::push_outgoing(
   const blob_options options,
   const message_priority priority) noexcept -> blob_id_t {
     assert(io);
+    if(options.has(blob_option::compressed)) {
+        io = {hold<compressed_source_blob_io>, std::move(io), workers()};
+    }
     if(io->total_size() > 0) {
         _outgoing.emplace_back();
         auto& pending = _outgoing.back();
@@ -1007,7 +1482,10 @@ auto blob_manipulator::push_outgoing(
         pending.source_io = std::move(io);
         pending.linger_time.reset();
         pending.max_time = timeout{max_time};
-        pending.todo_parts().emplace_back(0, pending.info.total_size);
+        _schedule_cleanup(pending, true);
+        pending.todo_parts().merge(0, pending.info.total_size);
+        pending.window_size = _flow_limits.initial_window;
+        pending.is_windowed = target_id != broadcast_endpoint_id();
         return pending.source_blob_id;
     }
     return 0;
@@ -1065,7 +1543,7 @@ auto blob_manipulator::_process_finished_outgoing(
   const span_size_t max_message_size,
   pending_blob& pending) noexcept -> work_done {
     some_true something_done{};
-    auto& [bgn, end] = pending.todo_parts().back();
+    [[maybe_unused]] const auto [bgn, end] = pending.todo_parts().back();
     assert(end != 0);
 
     const auto header{std::make_tuple(
@@ -1085,10 +1563,11 @@ auto blob_manipulator::_process_finished_outgoing(
         if(auto written_size{pending.fetch(offset, sink.free())}) {
 
             sink.mark_used(written_size);
-            bgn += written_size;
-            if(bgn >= end) {
-                pending.todo_parts().pop_back();
+            if(pending.in_flight_size() == 0) {
+                pending.ack_timeout.reset();
             }
+            pending.todo_parts().consume_back(written_size);
+            pending.fragment_size = written_size;
             message_view message(sink.done());
             message.set_source_id(pending.info.source_id);
             message.set_target_id(pending.info.target_id);
@@ -1122,6 +1601,35 @@ auto blob_manipulator::_process_finished_outgoing(
     return something_done;
 }
 //------------------------------------------------------------------------------
+auto blob_manipulator::_target_in_flight(
+  const endpoint_id_t target_id) const noexcept -> span_size_t {
+    span_size_t result{0};
+    for(const auto& pending : _outgoing) {
+        if(pending.is_windowed and (pending.info.target_id == target_id)) {
+            result += pending.in_flight_size();
+        }
+    }
+    return result;
+}
+//------------------------------------------------------------------------------
+auto blob_manipulator::_can_send(pending_blob& pending) noexcept -> bool {
+    if(not pending.is_windowed) {
+        return true;
+    }
+    if(pending.is_window_full() or
+       (_target_in_flight(pending.info.target_id) >=
+        _flow_limits.max_target_in_flight)) {
+        if(pending.handle_ack_timeout()) {
+            log_debug("blob target does not acknowledge fragments")
+              .arg("target", pending.info.target_id)
+              .arg("srcBlobId", pending.source_blob_id);
+            return true;
+        }
+        return false;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
 auto blob_manipulator::process_outgoing(
   const send_handler do_send,
   const span_size_t max_message_size,
@@ -1133,8 +1641,10 @@ auto blob_manipulator::process_outgoing(
         auto& pending{_outgoing[_outgoing_index++ % _outgoing.size()]};
         const auto preparation{pending.prepare()};
         if(preparation.has_finished() and not pending.sent_everything()) {
-            something_done(
-              _process_finished_outgoing(do_send, max_message_size, pending));
+            if(_can_send(pending)) {
+                something_done(
+                  _process_finished_outgoing(do_send, max_message_size, pending));
+            }
         } else if(preparation.is_working()) {
             something_done(
               _process_preparing_outgoing(do_send, max_message_size, pending));
@@ -1144,10 +1654,59 @@ auto blob_manipulator::process_outgoing(
     return something_done;
 }
 //------------------------------------------------------------------------------
+auto blob_manipulator::_unpack_incoming(pending_blob& pending) noexcept
+  -> blob_preparation_status {
+    auto packed_io{dynamic_cast<compressed_target_blob_io*>(
+      pending.target_io.get())};
+    if(not packed_io) {
+        return blob_preparation_status::finished;
+    }
+    const auto status{
+      packed_io->unpack(workers(), _buffers, span_size(_max_blob_size))};
+    if(status == blob_preparation_status::working) {
+        return status;
+    }
+    auto unpacked{packed_io->release_unpacked()};
+    pending.target_io = packed_io->release_target();
+    pending.info.total_size = unpacked.size();
+    pending.info.options.clear(blob_option::compressed);
+
+    bool result{status == blob_preparation_status::finished};
+    if(result) {
+        if(pending.target_buffer_io()) {
+            pending.target_io = {
+              hold<buffer_blob_io>,
+              _buffers.get(unpacked.size()),
+              view(unpacked)};
+        } else {
+            result = pending.target_io->store_fragment(
+              0, view(unpacked), pending.info);
+        }
+    }
+    if(not result) {
+        log_error("failed to decompress blob ${id}")
+          .arg("source", pending.info.source_id)
+          .arg("srcBlobId", pending.source_blob_id)
+          .arg("message", pending.msg_id);
+        pending.target_io->handle_cancelled();
+    }
+    _buffers.eat(std::move(unpacked));
+    return result ? blob_preparation_status::finished
+                  : blob_preparation_status::failed;
+}
+//------------------------------------------------------------------------------
 auto blob_manipulator::handle_complete() noexcept -> span_size_t {
 
     const auto predicate{[this](auto& pending) {
         if(pending.received_everything()) {
+            // the decompression runs on the workers, check again later
+            const auto unpacked{_unpack_incoming(pending)};
+            if(unpacked == blob_preparation_status::working) {
+                return false;
+            }
+            if(unpacked == blob_preparation_status::failed) {
+                return true;
+            }
             log_debug("handling complete blob ${id}")
               .arg("source", pending.info.source_id)
               .arg("srcBlobId", pending.source_blob_id)
@@ -1166,7 +1725,7 @@ auto blob_manipulator::handle_complete() noexcept -> span_size_t {
         return false;
     }};
 
-    return span_size(std::erase_if(_incoming, predicate));
+    return _erase_incoming(predicate);
 }
 //------------------------------------------------------------------------------
 auto blob_manipulator::fetch_all(
@@ -1174,6 +1733,14 @@ auto blob_manipulator::fetch_all(
 
     const auto predicate{[this, &handle_fetch](auto& pending) {
         if(pending.received_everything()) {
+            // the decompression runs on the workers, check again later
+            const auto unpacked{_unpack_incoming(pending)};
+            if(unpacked == blob_preparation_status::working) {
+                return false;
+            }
+            if(unpacked == blob_preparation_status::failed) {
+                return true;
+            }
             log_debug("fetching complete blob ${id}")
               .arg("source", pending.info.source_id)
               .arg("srcBlobId", pending.source_blob_id)
@@ -1203,7 +1770,7 @@ auto blob_manipulator::fetch_all(
         return false;
     }};
 
-    return span_size(std::erase_if(_incoming, predicate));
+    return _erase_incoming(predicate);
 }
 //------------------------------------------------------------------------------
 } // namespace eagine::msgbus
@@ -126,7 +126,12 @@ void blobs_roundtrip_zeroes_single_big(auto& s) {
       eagine::construct_from, send_s2r};
 
     auto send_r2s{
-      [&](const eagine::message_id, const eagine::msgbus::message_view&) -> bool {
+      [&](
+        const eagine::message_id msg_id,
+        const eagine::msgbus::message_view& message) -> bool {
+          if(msg_id == resend_msg_id) {
+              sender.process_resend(message);
+          }
           return true;
       }};
     const eagine::msgbus::blob_manipulator::send_handler handler_r2s{
@@ -187,7 +192,12 @@ void blobs_roundtrip_zeroes_single(unsigned r, auto& s) {
       eagine::construct_from, send_s2r};
 
     auto send_r2s{
-      [&](const eagine::message_id, const eagine::msgbus::message_view&) -> bool {
+      [&](
+        const eagine::message_id msg_id,
+        const eagine::msgbus::message_view& message) -> bool {
+          if(msg_id == resend_msg_id) {
+              sender.process_resend(message);
+          }
           return true;
       }};
     const eagine::msgbus::blob_manipulator::send_handler handler_r2s{
@@ -335,7 +345,12 @@ void blobs_roundtrip_bfs_single(auto& s) {
       eagine::construct_from, send_s2r};
 
     auto send_r2s{
-      [&](const eagine::message_id, const eagine::msgbus::message_view&) -> bool {
+      [&](
+        const eagine::message_id msg_id,
+        const eagine::msgbus::message_view& message) -> bool {
+          if(msg_id == resend_msg_id) {
+              sender.process_resend(message);
+          }
           return true;
       }};
     const eagine::msgbus::blob_manipulator::send_handler handler_r2s{
@@ -485,7 +500,12 @@ void blobs_roundtrip_ces_multiple(auto& s) {
       eagine::construct_from, send_s2r};
 
     auto send_r2s{
-      [&](const eagine::message_id, const eagine::msgbus::message_view&) -> bool {
+      [&](
+        const eagine::message_id msg_id,
+        const eagine::msgbus::message_view& message) -> bool {
+          if(msg_id == resend_msg_id) {
+              sender.process_resend(message);
+          }
           return true;
       }};
     const eagine::msgbus::blob_manipulator::send_handler handler_r2s{
@@ -584,7 +604,12 @@ void blobs_roundtrip_chunk_signals_finished(auto& s) {
       eagine::construct_from, send_s2r};
 
     auto send_r2s{
-      [&](const eagine::message_id, const eagine::msgbus::message_view&) -> bool {
+      [&](
+        const eagine::message_id msg_id,
+        const eagine::msgbus::message_view& message) -> bool {
+          if(msg_id == resend_msg_id) {
+              sender.process_resend(message);
+          }
           return true;
       }};
     const eagine::msgbus::blob_manipulator::send_handler handler_r2s{
@@ -806,7 +831,12 @@ void blobs_roundtrip_chunk_signals_failed(auto& s) {
       eagine::construct_from, send_s2r};
 
     auto send_r2s{
-      [&](const eagine::message_id, const eagine::msgbus::message_view&) -> bool {
+      [&](
+        const eagine::message_id msg_id,
+        const eagine::msgbus::message_view& message) -> bool {
+          if(msg_id == resend_msg_id) {
+              sender.process_resend(message);
+          }
           return true;
       }};
     const eagine::msgbus::blob_manipulator::send_handler handler_r2s{
@@ -1009,10 +1039,522 @@ void blobs_roundtrip_resend_2(auto& s) {
     }
 }
 //------------------------------------------------------------------------------
+// round-trip shuffled
+//------------------------------------------------------------------------------
+void blobs_roundtrip_shuffled(auto& s) {
+    eagitest::case_ test{s, 10, "round-trip shuffled"};
+    eagitest::track trck{test, 1, 4};
+    auto& rg{test.random()};
+
+    const eagine::message_id test_msg_id{eagine::random_identifier(), "test"};
+    const eagine::message_id send_msg_id{"check", "send"};
+    const eagine::message_id resend_msg_id{"check", "resend"};
+    const eagine::message_id prepare_msg_id{"test", "prepare"};
+    eagine::msgbus::blob_manipulator sender{
+      s.context(), send_msg_id, resend_msg_id, prepare_msg_id};
+    eagine::msgbus::blob_manipulator receiver{
+      s.context(), send_msg_id, resend_msg_id, prepare_msg_id};
+
+    std::vector<eagine::msgbus::stored_message> fragments;
+    auto collect{
+      [&](
+        const eagine::message_id msg_id,
+        const eagine::msgbus::message_view& message) -> bool {
+          test.check(msg_id == send_msg_id, "message id");
+          fragments.emplace_back(message, eagine::memory::buffer{});
+          return true;
+      }};
+    const eagine::msgbus::blob_manipulator::send_handler collect_handler{
+      eagine::construct_from, collect};
+
+    const eagine::span_size_t blob_size{256 * 1024};
+    sender.push_outgoing(
+      test_msg_id,
+      1,
+      0,
+      eagine::msgbus::blob_id_t(0),
+      {eagine::hold<bfs_source_blob_io>, blob_size},
+      std::chrono::hours{1},
+      eagine::msgbus::message_priority::normal);
+
+    const eagine::span_size_t max_message_size{1024};
+    while(sender.process_outgoing(collect_handler, max_message_size, 16)) {
+    }
+    test.check(not fragments.empty(), "has fragments");
+
+    // some fragments arrive twice and all of them in random order
+    const auto count{fragments.size()};
+    fragments.reserve(count + count / 7 + 1);
+    for(std::size_t i = 0; i < count; i += 7) {
+        fragments.emplace_back(
+          eagine::msgbus::message_view(fragments[i]), eagine::memory::buffer{});
+    }
+    std::mt19937 rng{rg.get_between<unsigned>(0U, 1000000U)};
+    std::shuffle(fragments.begin(), fragments.end(), rng);
+
+    bool done{false};
+    receiver.expect_incoming(
+      test_msg_id,
+      1,
+      eagine::msgbus::blob_id_t(0),
+      {eagine::hold<bfs_target_blob_io>, test, trck, blob_size, done},
+      std::chrono::hours{1});
+
+    for(const auto& fragment : fragments) {
+        receiver.process_incoming(fragment);
+        trck.checkpoint(1);
+    }
+    receiver.handle_complete();
+    test.check(done, "is done");
+}
+//------------------------------------------------------------------------------
+// round-trip compressed
+//------------------------------------------------------------------------------
+void blobs_roundtrip_compressed(auto& s) {
+    eagitest::case_ test{s, 11, "round-trip compressed"};
+    eagitest::track trck{test, 1, 3};
+
+    const eagine::message_id test_msg_id{"test", eagine::random_identifier()};
+    const eagine::message_id send_msg_id{"test", "send"};
+    const eagine::message_id resend_msg_id{"test", "resend"};
+    const eagine::message_id prepare_msg_id{"test", "prepare"};
+    eagine::msgbus::blob_manipulator sender{
+      s.context(), send_msg_id, resend_msg_id, prepare_msg_id};
+    eagine::msgbus::blob_manipulator receiver{
+      s.context(), send_msg_id, resend_msg_id, prepare_msg_id};
+
+    auto send_s2r{
+      [&](
+        const eagine::message_id msg_id,
+        const eagine::msgbus::message_view& message) -> bool {
+          test.check(msg_id == send_msg_id, "message id");
+
+          receiver.process_incoming(message);
+
+          trck.checkpoint(1);
+          return true;
+      }};
+    const eagine::msgbus::blob_manipulator::send_handler handler_s2r{
+      eagine::construct_from, send_s2r};
+
+    auto send_r2s{
+      [&](
+        const eagine::message_id msg_id,
+        const eagine::msgbus::message_view& message) -> bool {
+          if(msg_id == resend_msg_id) {
+              sender.process_resend(message);
+          }
+          return true;
+      }};
+    const eagine::msgbus::blob_manipulator::send_handler handler_r2s{
+      eagine::construct_from, send_r2s};
+
+    // several frames, the last one partial
+    const eagine::span_size_t blob_size{5 * 1024 * 1024 + 1234};
+    sender.push_outgoing(
+      test_msg_id,
+      1234,
+      2345,
+      0,
+      {eagine::hold<zeroes_source_blob_io>, blob_size},
+      std::chrono::hours{1},
+      eagine::msgbus::blob_options{eagine::msgbus::blob_option::compressed},
+      eagine::msgbus::message_priority::normal);
+
+    bool done{false};
+
+    receiver.expect_incoming(
+      test_msg_id,
+      1234,
+      eagine::msgbus::blob_id_t(0),
+      {eagine::hold<zeroes_target_blob_io>, test, trck, blob_size, done},
+      std::chrono::hours{1});
+
+    const eagine::span_size_t max_message_size{4096};
+    while(not done) {
+        sender.update(handler_s2r, max_message_size);
+        sender.process_outgoing(handler_s2r, max_message_size, 1);
+        receiver.update(handler_r2s, max_message_size);
+        receiver.handle_complete();
+    }
+}
+//------------------------------------------------------------------------------
+// flow control
+//------------------------------------------------------------------------------
+using blobs_sack_ranges =
+  std::vector<std::tuple<eagine::span_size_t, eagine::span_size_t>>;
+//------------------------------------------------------------------------------
+static auto blobs_fragment_offset(const eagine::msgbus::message_view& message)
+  -> eagine::span_size_t {
+    eagine::identifier class_id{};
+    eagine::identifier method_id{};
+    eagine::msgbus::blob_id_t source_blob_id{0U};
+    eagine::msgbus::blob_id_t target_blob_id{0U};
+    std::int64_t offset{-1};
+    std::int64_t total_size{0};
+    std::underlying_type_t<eagine::msgbus::blob_option> options{0};
+
+    auto header{std::tie(
+      class_id,
+      method_id,
+      source_blob_id,
+      target_blob_id,
+      offset,
+      total_size,
+      options)};
+    eagine::block_data_source source{message.content()};
+    eagine::default_deserializer_backend backend(source);
+    if(not eagine::deserialize(header, backend)) {
+        return -1;
+    }
+    return eagine::span_size(offset);
+}
+//------------------------------------------------------------------------------
+// sends a blob of zeroes, records the offsets of the sent fragments
+// and acknowledges the specified ranges the way the targets do
+struct blobs_sack_sender {
+    const eagine::message_id test_msg_id{"test", eagine::random_identifier()};
+    const eagine::message_id send_msg_id{"test", "send"};
+    const eagine::message_id resend_msg_id{"test", "resend"};
+    const eagine::message_id prepare_msg_id{"test", "prepare"};
+    eagine::msgbus::blob_manipulator sender;
+    const eagine::span_size_t blob_size;
+    const eagine::span_size_t max_message_size{4096};
+    eagine::msgbus::blob_id_t blob_id{0U};
+    std::vector<eagine::span_size_t> offsets;
+
+    blobs_sack_sender(auto& s, const eagine::span_size_t size)
+      : sender{s.context(), send_msg_id, resend_msg_id, prepare_msg_id}
+      , blob_size{size} {
+        blob_id = sender.push_outgoing(
+          test_msg_id,
+          1234,
+          2345,
+          0,
+          {eagine::hold<zeroes_source_blob_io>, blob_size},
+          std::chrono::hours{1},
+          eagine::msgbus::message_priority::normal);
+    }
+
+    // returns the count of fragments sent until the window got full
+    auto send_all() -> eagine::span_size_t {
+        const auto sent_before{offsets.size()};
+        auto send_s2r{
+          [&](
+            const eagine::message_id,
+            const eagine::msgbus::message_view& message) -> bool {
+              offsets.push_back(blobs_fragment_offset(message));
+              return true;
+          }};
+        const eagine::msgbus::blob_manipulator::send_handler handler_s2r{
+          eagine::construct_from, send_s2r};
+        while(sender.process_outgoing(handler_s2r, max_message_size, 16)) {
+        }
+        return eagine::span_size(offsets.size() - sent_before);
+    }
+
+    auto sent_count() const -> std::size_t {
+        return offsets.size();
+    }
+
+    auto end_of(const std::size_t index) const -> eagine::span_size_t {
+        return std::min(offsets[index] + offsets[1] - offsets[0], blob_size);
+    }
+
+    auto acknowledge(
+      const blobs_sack_ranges& received,
+      const eagine::span_size_t resend_bgn,
+      const eagine::span_size_t resend_end) -> bool {
+        std::array<std::uint64_t, 32> ranges{};
+        std::uint64_t received_size{0U};
+        std::size_t index{0U};
+        for(const auto& [bgn, end] : received) {
+            ranges[index++] = std::uint64_t(bgn);
+            ranges[index++] = std::uint64_t(end);
+            received_size += std::uint64_t(end - bgn);
+        }
+        const auto params{std::make_tuple(
+          eagine::identifier_t(blob_id),
+          std::uint64_t(resend_bgn),
+          std::uint64_t(resend_end),
+          received_size,
+          ranges)};
+        auto buffer{eagine::default_serialize_buffer_for(params)};
+        const auto serialized{eagine::default_serialize(params, cover(buffer))};
+        return serialized and
+               sender.process_resend(eagine::msgbus::message_view{*serialized});
+    }
+
+    auto acknowledge(const blobs_sack_ranges& received) -> bool {
+        return acknowledge(received, blob_size, blob_size);
+    }
+};
+//------------------------------------------------------------------------------
+void blobs_sack_window(auto& s) {
+    eagitest::case_ test{s, 12, "acknowledgement window"};
+    blobs_sack_sender snd{s, 4 * 1024 * 1024};
+    test.ensure(snd.blob_id != 0, "has blob id");
+
+    const auto initial_count{snd.send_all()};
+    test.check(initial_count > 8, "some sent");
+    test.check(
+      initial_count * snd.max_message_size < snd.blob_size, "limited by window");
+    test.check_equal(snd.send_all(), eagine::span_size_t(0), "window is full");
+
+    // the acknowledged fragments make room and the window grows
+    const auto half{std::size_t(initial_count / 2)};
+    test.check(snd.acknowledge({{0, snd.end_of(half - 1U)}}), "acknowledged");
+    test.check(snd.send_all() > eagine::span_size(half), "window grows");
+
+    const auto acked_count{snd.sent_count()};
+    test.check(
+      snd.acknowledge({{0, snd.end_of(acked_count - 1U)}}), "all acknowledged");
+    const auto full_count{snd.send_all()};
+    test.check(full_count > initial_count, "window grew");
+
+    // one fragment early in the last batch is lost
+    const auto lost{acked_count + 1U};
+    test.check(
+      snd.acknowledge(
+        {{0, snd.offsets[lost]},
+         {snd.end_of(lost), snd.end_of(snd.sent_count() - 1U)}}),
+      "acknowledged with loss");
+    test.check(snd.send_all() < full_count, "window shrinks");
+}
+//------------------------------------------------------------------------------
+void blobs_sack_reordering(auto& s) {
+    eagitest::case_ test{s, 13, "acknowledgement reordering"};
+    blobs_sack_sender snd{s, 64 * 1024};
+    test.ensure(snd.blob_id != 0, "has blob id");
+
+    snd.send_all();
+    test.ensure(snd.sent_count() >= 16U, "fragment count");
+    const auto last{snd.sent_count() - 1U};
+    test.check_equal(snd.end_of(last), snd.blob_size, "everything sent");
+
+    // a fragment arrives after the one sent after it
+    snd.acknowledge({{0, snd.end_of(7)}, {snd.offsets[9], snd.end_of(9)}});
+    test.check_equal(snd.send_all(), eagine::span_size_t(0), "not resent");
+
+    snd.acknowledge({{0, snd.end_of(9)}});
+    test.check_equal(snd.send_all(), eagine::span_size_t(0), "still not resent");
+
+    // the gap stays open while the following fragments are acknowledged
+    snd.acknowledge({{0, snd.end_of(9)}, {snd.offsets[11], snd.end_of(last)}});
+    test.check_equal(snd.send_all(), eagine::span_size_t(1), "resent");
+    test.check_equal(snd.offsets.back(), snd.offsets[10], "resent fragment");
+
+    // the lost part is not resent again while the resend is in flight
+    snd.acknowledge({{0, snd.end_of(9)}, {snd.offsets[11], snd.end_of(last)}});
+    test.check_equal(snd.send_all(), eagine::span_size_t(0), "resent once");
+
+    // the explicit resend request of a stalled target is always handled
+    snd.acknowledge(
+      {{0, snd.end_of(last)}}, snd.offsets[2], snd.offsets[2] + 1024);
+    test.check_equal(snd.send_all(), eagine::span_size_t(1), "resend request");
+    test.check_equal(snd.offsets.back(), snd.offsets[2], "requested fragment");
+}
+//------------------------------------------------------------------------------
+void blobs_sack_timeout(auto& s) {
+    eagitest::case_ test{s, 14, "acknowledgement timeout"};
+    blobs_sack_sender snd{s, 4 * 1024 * 1024};
+    test.ensure(snd.blob_id != 0, "has blob id");
+
+    const auto initial_count{snd.send_all()};
+    test.check(initial_count > 1, "some sent");
+    test.check_equal(snd.send_all(), eagine::span_size_t(0), "window is full");
+
+    snd.acknowledge({{0, snd.end_of(0)}});
+    test.check(snd.send_all() > 0, "acknowledged");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{1100});
+    test.check_equal(snd.send_all(), eagine::span_size_t(0), "not timeouted");
+
+    // the target does not acknowledge, the window is not used anymore
+    std::this_thread::sleep_for(std::chrono::milliseconds{1000});
+    snd.send_all();
+    test.check_equal(
+      snd.end_of(snd.sent_count() - 1U), snd.blob_size, "not limited by window");
+}
+//------------------------------------------------------------------------------
+void blobs_sack_lost_resend(auto& s) {
+    eagitest::case_ test{s, 15, "acknowledgement lost resend"};
+    blobs_sack_sender snd{s, 64 * 1024};
+    test.ensure(snd.blob_id != 0, "has blob id");
+
+    snd.send_all();
+    test.ensure(snd.sent_count() >= 8U, "fragment count");
+    const auto last{snd.sent_count() - 1U};
+    const blobs_sack_ranges received{
+      {0, snd.offsets[1]}, {snd.end_of(1), snd.end_of(last)}};
+
+    snd.acknowledge(received);
+    test.check_equal(snd.send_all(), eagine::span_size_t(1), "resent");
+    test.check_equal(snd.offsets.back(), snd.offsets[1], "resent fragment");
+
+    snd.acknowledge(received);
+    test.check_equal(snd.send_all(), eagine::span_size_t(0), "in flight");
+
+    // the resent fragment is lost as well, it is resent after a while
+    std::this_thread::sleep_for(std::chrono::milliseconds{1100});
+    snd.acknowledge(received);
+    test.check_equal(snd.send_all(), eagine::span_size_t(1), "resent again");
+    test.check_equal(snd.offsets.back(), snd.offsets[1], "resent again fragment");
+}
+//------------------------------------------------------------------------------
+void blobs_legacy_resend(auto& s) {
+    eagitest::case_ test{s, 16, "legacy resend request"};
+
+    const eagine::message_id test_msg_id{"test", eagine::random_identifier()};
+    const eagine::message_id send_msg_id{"test", "send"};
+    const eagine::message_id resend_msg_id{"test", "resend"};
+    const eagine::message_id prepare_msg_id{"test", "prepare"};
+    eagine::msgbus::blob_manipulator sender{
+      s.context(), send_msg_id, resend_msg_id, prepare_msg_id};
+
+    eagine::span_size_t sent_count{0};
+    auto send_s2r{
+      [&](
+        const eagine::message_id msg_id,
+        const eagine::msgbus::message_view&) -> bool {
+          test.check(msg_id == send_msg_id, "message id");
+          ++sent_count;
+          return true;
+      }};
+    const eagine::msgbus::blob_manipulator::send_handler handler_s2r{
+      eagine::construct_from, send_s2r};
+
+    const eagine::span_size_t blob_size{4 * 1024 * 1024};
+    const eagine::span_size_t max_message_size{4096};
+    const auto source_blob_id{sender.push_outgoing(
+      test_msg_id,
+      1234,
+      2345,
+      0,
+      {eagine::hold<zeroes_source_blob_io>, blob_size},
+      std::chrono::hours{1},
+      eagine::msgbus::message_priority::normal)};
+    test.ensure(source_blob_id != 0, "has blob id");
+
+    const auto send_all{[&] {
+        while(sender.process_outgoing(handler_s2r, max_message_size, 16)) {
+            if(sent_count * max_message_size > 2 * blob_size) {
+                break;
+            }
+        }
+    }};
+    send_all();
+    const auto windowed_count{sent_count};
+    test.check(windowed_count > 0, "some sent");
+    test.check(
+      windowed_count * max_message_size < blob_size, "limited by window");
+
+    // older targets send only the resend range
+    const std::tuple<eagine::identifier_t, std::uint64_t, std::uint64_t> params{
+      source_blob_id, 0U, 1024U};
+    auto buffer{eagine::default_serialize_buffer_for(params)};
+    const auto serialized{eagine::default_serialize(params, cover(buffer))};
+    test.ensure(bool(serialized), "serialized");
+    const eagine::msgbus::message_view request{*serialized};
+    test.check(sender.process_resend(request), "resend processed");
+
+    send_all();
+    test.check(
+      sent_count * max_message_size >= blob_size, "not limited by window");
+}
+//------------------------------------------------------------------------------
+// scheduled checks
+//------------------------------------------------------------------------------
+void blobs_scheduled_checks(auto& s) {
+    eagitest::case_ test{s, 17, "scheduled checks"};
+    eagitest::track trck{test, 0, 4};
+
+    const eagine::message_id test_msg_id{eagine::random_identifier(), "test"};
+    const eagine::message_id send_msg_id{"check", "send"};
+    const eagine::message_id resend_msg_id{"check", "resend"};
+    const eagine::message_id prepare_msg_id{"test", "prepare"};
+    eagine::msgbus::blob_manipulator sender{
+      s.context(), send_msg_id, resend_msg_id, prepare_msg_id};
+    eagine::msgbus::blob_manipulator receiver{
+      s.context(), send_msg_id, resend_msg_id, prepare_msg_id};
+
+    auto send_s2r{
+      [&](
+        const eagine::message_id,
+        const eagine::msgbus::message_view& message) -> bool {
+          receiver.process_incoming(message);
+          return true;
+      }};
+    const eagine::msgbus::blob_manipulator::send_handler handler_s2r{
+      eagine::construct_from, send_s2r};
+
+    auto send_r2s{
+      [&](
+        const eagine::message_id msg_id,
+        const eagine::msgbus::message_view& message) -> bool {
+          if(msg_id == resend_msg_id) {
+              sender.process_resend(message);
+          }
+          return true;
+      }};
+    const eagine::msgbus::blob_manipulator::send_handler handler_r2s{
+      eagine::construct_from, send_r2s};
+
+    const eagine::span_size_t blob_size{16 * 1024};
+    for(unsigned r = 0; r < 3; ++r) {
+        sender.push_outgoing(
+          test_msg_id,
+          1,
+          0,
+          eagine::msgbus::blob_id_t(r),
+          {eagine::hold<bfs_source_blob_io>, blob_size},
+          std::chrono::hours{1},
+          eagine::msgbus::message_priority::normal);
+
+        bool done{false};
+        receiver.expect_incoming(
+          test_msg_id,
+          1,
+          eagine::msgbus::blob_id_t(r),
+          {eagine::hold<bfs_target_blob_io>, test, trck, blob_size, done},
+          std::chrono::hours{1});
+        test.check_equal(
+          receiver.scheduled_count(), eagine::span_size(1), "incoming scheduled");
+
+        const eagine::span_size_t max_message_size{2048};
+        const eagine::timeout max_time{std::chrono::seconds{10}};
+        while(not done and not max_time.is_expired()) {
+            sender.update(handler_s2r, max_message_size);
+            sender.process_outgoing(handler_s2r, max_message_size, 7);
+            receiver.update(handler_r2s, max_message_size);
+            receiver.handle_complete();
+        }
+        test.check(done, "done");
+
+        // the completed blobs do not leave their checks behind
+        test.check_equal(
+          receiver.scheduled_count(), eagine::span_size(0), "incoming done");
+        // the sent blobs linger, each with a single check
+        test.check_equal(
+          sender.scheduled_count(),
+          eagine::span_size(r + 1U),
+          "outgoing lingering");
+    }
+
+    // the lingering blobs are not checked on every update
+    const eagine::span_size_t max_message_size{2048};
+    for(int i = 0; i < 10; ++i) {
+        sender.update(handler_s2r, max_message_size);
+    }
+    test.check(sender.has_outgoing(), "still lingering");
+    test.check_equal(
+      sender.scheduled_count(), eagine::span_size(3), "outgoing scheduled");
+}
+//------------------------------------------------------------------------------
 // main
 //------------------------------------------------------------------------------
 auto test_main(eagine::test_ctx& ctx) -> int {
-    eagitest::ctx_suite test{ctx, "blobs", 9};
+    eagitest::ctx_suite test{ctx, "blobs", 17};
     test.once(blobs_roundtrip_zeroes_single_big);
     test.repeat(5, blobs_roundtrip_zeroes_single);
     test.once(blobs_roundtrip_bfs_single);
@@ -1022,6 +1564,14 @@ auto test_main(eagine::test_ctx& ctx) -> int {
     test.once(blobs_roundtrip_chunk_signals_failed);
     test.once(blobs_roundtrip_resend_1);
     test.once(blobs_roundtrip_resend_2);
+    test.once(blobs_roundtrip_shuffled);
+    test.once(blobs_roundtrip_compressed);
+    test.once(blobs_sack_window);
+    test.once(blobs_sack_reordering);
+    test.once(blobs_sack_timeout);
+    test.once(blobs_sack_lost_resend);
+    test.once(blobs_legacy_resend);
+    test.once(blobs_scheduled_checks);
     return test.exit_code();
 }
 //------------------------------------------------------------------------------
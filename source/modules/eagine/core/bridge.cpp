@@ -18,9 +18,54 @@ import :types;
 import :message;
 import :interface;
 import :context;
+import :trace;
 
 namespace eagine::msgbus {
 //------------------------------------------------------------------------------
+/// @brief Negotiates the binary framing of one direction of a bridge stream.
+/// @ingroup msgbus
+/// @see bridge
+///
+/// The side that wants to write binary frames sends an offer line and keeps
+/// writing text lines until the other side answers with an accept line.
+/// Then it writes a switch line and only binary frames after it. Peers not
+/// knowing the offer never accept it and the stream stays in text mode.
+/// The input functions are called by the input reading thread and the output
+/// functions by the output encoding thread.
+export class bridge_framing {
+public:
+    bridge_framing(const bool binary_output) noexcept
+      : _offer_binary{binary_output} {}
+
+    /// @brief Handles a line read in text mode. Returns if it was a framing line.
+    auto handle_input_line(const memory::const_block line) noexcept -> bool;
+
+    /// @brief Indicates if the input consists of binary frames from now on.
+    auto binary_input() const noexcept -> bool {
+        return _binary_input;
+    }
+
+    /// @brief Returns the next framing line to be written, empty if none.
+    /// @note Has to be called before the messages of each output batch.
+    auto next_output_line() noexcept -> string_view;
+
+    /// @brief Indicates if the output should consist of binary frames.
+    auto binary_output() const noexcept -> bool {
+        return _binary_output;
+    }
+
+private:
+    const bool _offer_binary;
+    // written by the reading thread, read by the encoding thread
+    std::atomic<bool> _accept_pending{false};
+    std::atomic<bool> _peer_accepted{false};
+    // used by the reading thread only
+    bool _binary_input{false};
+    // used by the encoding thread only
+    bool _offer_sent{false};
+    bool _binary_output{false};
+};
+//------------------------------------------------------------------------------
 export class bridge_state;
 export class bridge
   : public main_ctx_object
@@ -74,6 +119,7 @@ private:
       -> message_handling_result;
     auto _handle_stats_query(const message_view&, const bool) noexcept
       -> message_handling_result;
+    void _post_trace_records(const message_view&, const bool) noexcept;
 
     auto _handle_special(
       const message_id,
@@ -88,6 +134,7 @@ private:
     void _log_bridge_stats_c2o() noexcept;
     void _log_bridge_stats_i2c() noexcept;
     auto _forward_messages() noexcept -> work_done;
+    auto _update_flow_info() noexcept -> work_done;
 
     shared_context _context{};
 
@@ -106,12 +153,17 @@ private:
     std::chrono::steady_clock::duration _message_age_sum_i2c;
     std::chrono::steady_clock::duration _message_age_sum_c2o;
     std::int64_t _state_count{0};
+    span_size_t _queue_size{1024};
+    bool _binary_framing{false};
     std::int64_t _forwarded_messages_i2c{0};
     std::int64_t _forwarded_messages_c2o{0};
     std::int64_t _prev_forwarded_messages{0};
     std::int64_t _dropped_messages_i2c{0};
     std::int64_t _dropped_messages_c2o{0};
     bridge_statistics _stats{};
+    message_tracer _tracer{node_kind::bridge, *this};
+    message_flow_info _flow_info{};
+    timeout _flow_info_timeout{adjusted_duration(std::chrono::seconds{1})};
 
     shared_holder<bridge_state> _state{};
     timeout _no_connection_timeout{adjusted_duration(std::chrono::seconds{30})};
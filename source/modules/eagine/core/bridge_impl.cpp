@@ -25,43 +25,253 @@ import eagine.core.main_ctx;
 
 namespace eagine::msgbus {
 //------------------------------------------------------------------------------
+// binary stream framing
+//------------------------------------------------------------------------------
+// lines offering the binary framing, accepting the other side's offer and
+// announcing that the rest of the stream consists of binary frames
+static constexpr const string_view bridge_binary_framing_offer{
+  "@eagiMsgBus:binary-frames:1:offer"};
+static constexpr const string_view bridge_binary_framing_accept{
+  "@eagiMsgBus:binary-frames:1:accept"};
+static constexpr const string_view bridge_binary_framing_marker{
+  "@eagiMsgBus:binary-frames:1"};
+static constexpr const span_size_t bridge_frame_length_size{4};
+// the text message headers are short, only the content is longer
+static constexpr const span_size_t bridge_max_header_size{1024};
+//------------------------------------------------------------------------------
+auto bridge_framing::handle_input_line(const memory::const_block line) noexcept
+  -> bool {
+    if(line.empty() or line.front() != byte('@')) [[likely]] {
+        return false;
+    }
+    if(are_equal(line, as_bytes(bridge_binary_framing_offer))) {
+        _accept_pending = true;
+        return true;
+    }
+    if(are_equal(line, as_bytes(bridge_binary_framing_accept))) {
+        // only an answer to our own offer counts
+        if(_offer_binary) {
+            _peer_accepted = true;
+        }
+        return true;
+    }
+    if(are_equal(line, as_bytes(bridge_binary_framing_marker))) {
+        _binary_input = true;
+        return true;
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+auto bridge_framing::next_output_line() noexcept -> string_view {
+    if(_offer_binary and not _offer_sent) {
+        _offer_sent = true;
+        return bridge_binary_framing_offer;
+    }
+    // the accept of the other side's offer is read before our offer's
+    // accept, so it is not missed when both are raised at the same time
+    const bool peer_accepted{_peer_accepted};
+    if(_accept_pending.exchange(false) and not _binary_output) {
+        return bridge_binary_framing_accept;
+    }
+    if(peer_accepted and not _binary_output) {
+        _binary_output = true;
+        return bridge_binary_framing_marker;
+    }
+    return {};
+}
+//------------------------------------------------------------------------------
+// bridge_queue
+//------------------------------------------------------------------------------
+// bounded lock-free queue with a single producer and a single consumer thread,
+// the slots keep their buffers so the data is not re-allocated
+template <typename Slot>
+class bridge_queue {
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    bridge_queue(const span_size_t capacity)
+      : _slots(std::bit_ceil(std::size_t(std::max(capacity, span_size_t(2)))))
+      , _mask{_slots.size() - 1U} {}
+
+    auto capacity() const noexcept -> std::size_t {
+        return _slots.size();
+    }
+
+    auto size() const noexcept -> std::size_t {
+        return _tail.load(std::memory_order_acquire) -
+               _head.load(std::memory_order_acquire);
+    }
+
+    auto empty() const noexcept -> bool {
+        return size() == 0U;
+    }
+
+    auto is_full() const noexcept -> bool {
+        return size() >= capacity();
+    }
+
+    auto fill_ratio() const noexcept -> float {
+        return float(size()) / float(capacity());
+    }
+
+    /// @brief Returns the average time the slots wait in the queue.
+    auto average_wait() const noexcept -> std::chrono::microseconds {
+        return std::chrono::microseconds{
+          _avg_wait_us.load(std::memory_order_relaxed)};
+    }
+
+    /// @brief Lets the function fill the next slot, called by the producer.
+    ///
+    /// The function's Boolean return value indicates if the slot should be kept.
+    template <typename Function>
+    auto push_if(Function function) noexcept -> bool {
+        const auto tail{_tail.load(std::memory_order_relaxed)};
+        if(tail - _head.load(std::memory_order_acquire) >= _slots.size())
+          [[unlikely]] {
+            return false;
+        }
+        auto& [slot, insert_time] = _slots[tail & _mask];
+        if(not function(slot)) [[unlikely]] {
+            return false;
+        }
+        insert_time = clock_type::now();
+        _tail.store(tail + 1U, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief Calls the handler on the queued slots, called by the consumer.
+    ///
+    /// Stops at the first slot that the handler does not consume.
+    template <typename Handler>
+    auto fetch_all(Handler& handler) noexcept -> bool {
+        auto head{_head.load(std::memory_order_relaxed)};
+        const auto tail{_tail.load(std::memory_order_acquire)};
+        const auto now{clock_type::now()};
+        auto avg_wait_us{_avg_wait_us.load(std::memory_order_relaxed)};
+        bool fetched{false};
+        for(; head != tail; ++head) {
+            auto& [slot, insert_time] = _slots[head & _mask];
+            const auto wait{now - insert_time};
+            if(not handler(slot, wait)) {
+                break;
+            }
+            avg_wait_us +=
+              (std::chrono::duration_cast<std::chrono::microseconds>(wait)
+                 .count() -
+               avg_wait_us) /
+              16;
+            _head.store(head + 1U, std::memory_order_release);
+            fetched = true;
+        }
+        _avg_wait_us.store(avg_wait_us, std::memory_order_relaxed);
+        return fetched;
+    }
+
+private:
+    std::vector<std::tuple<Slot, clock_type::time_point>> _slots;
+    const std::size_t _mask;
+    alignas(64) std::atomic<std::size_t> _head{0U};
+    alignas(64) std::atomic<std::size_t> _tail{0U};
+    std::atomic<std::int64_t> _avg_wait_us{0};
+};
+//------------------------------------------------------------------------------
+struct bridge_message_slot {
+    message_id msg_id{};
+    stored_message message{};
+};
+//------------------------------------------------------------------------------
+class bridge_message_queue : public bridge_queue<bridge_message_slot> {
+public:
+    using bridge_queue<bridge_message_slot>::bridge_queue;
+
+    /// @brief Lets the function fill the next message, called by the producer.
+    template <typename Function>
+    auto push_message_if(Function function) noexcept -> bool {
+        return push_if([&](bridge_message_slot& slot) {
+            return function(slot.msg_id, slot.message);
+        });
+    }
+
+    /// @brief Copies the message into the next slot, called by the producer.
+    auto push(const message_id msg_id, const message_view& message) noexcept
+      -> bool {
+        return push_message_if([&](message_id& dst_id, stored_message& dst) {
+            dst_id = msg_id;
+            static_cast<message_info&>(dst) = message;
+            dst.store_content(message.data());
+            return true;
+        });
+    }
+
+    /// @brief Calls the handler on the queued messages, called by the consumer.
+    template <typename Handler>
+    auto fetch_messages(Handler& handler) noexcept -> bool {
+        const auto fetch{
+          [&](bridge_message_slot& slot, const clock_type::duration wait) {
+              return handler(
+                slot.msg_id,
+                std::chrono::duration_cast<message_age>(wait),
+                message_view(slot.message));
+          }};
+        return fetch_all(fetch);
+    }
+};
+//------------------------------------------------------------------------------
+// a line or a binary frame read from the input, not decoded yet
+struct bridge_input_chunk {
+    memory::buffer data{};
+    bool is_binary{false};
+};
+//------------------------------------------------------------------------------
 // bridge_state
 //------------------------------------------------------------------------------
+// the reading and the decoding stage of the input and the encoding and the
+// writing stage of the output run in separate threads, connected by queues
 class bridge_state : public std::enable_shared_from_this<bridge_state> {
 public:
-    bridge_state(const valid_if_positive<span_size_t>& max_data_size) noexcept
-      : _max_read{max_data_size.value_or(2048) * 2} {}
+    bridge_state(
+      const valid_if_positive<span_size_t>& max_data_size,
+      const span_size_t queue_size,
+      const bool binary_framing) noexcept
+      : _max_read{max_data_size.value_or(2048) * 2}
+      , _outgoing{queue_size}
+      , _incoming{queue_size}
+      , _encoded{std::max(queue_size / 64, span_size_t(4))}
+      , _read{queue_size}
+      , _framing{binary_framing} {
+        _input_waiter.add_handle(stdin_wait_handle());
+    }
     bridge_state(bridge_state&&) = delete;
     bridge_state(const bridge_state&) = delete;
     auto operator=(bridge_state&&) = delete;
     auto operator=(const bridge_state&) = delete;
     ~bridge_state() noexcept {
         _output_ready.notify_all();
+        _encoded_ready.notify_all();
+        _encoded_space.notify_all();
+        _read_ready.notify_all();
+        _read_space.notify_all();
+        _input_space.notify_all();
     }
 
     auto weak_ref() noexcept {
         return std::weak_ptr(this->shared_from_this());
     }
 
-    auto make_input_main() noexcept {
-        return [selfref{weak_ref()}]() {
-            while(auto self{selfref.lock()}) {
-                self->recv_input();
-            }
-        };
-    }
-
-    auto make_output_main() noexcept {
+    template <auto Stage>
+    auto make_stage_main() noexcept {
         return [selfref{weak_ref()}]() {
             while(auto self{selfref.lock()}) {
-                self->send_output();
+                (self.get()->*Stage)();
             }
         };
     }
 
     void start() noexcept {
-        std::thread(make_input_main()).detach();
-        std::thread(make_output_main()).detach();
+        std::thread(make_stage_main<&bridge_state::read_input>()).detach();
+        std::thread(make_stage_main<&bridge_state::decode_input>()).detach();
+        std::thread(make_stage_main<&bridge_state::encode_output>()).detach();
+        std::thread(make_stage_main<&bridge_state::write_output>()).detach();
     }
 
     auto input_usable() noexcept {
@@ -78,12 +288,30 @@ public:
         return input_usable() and output_usable();
     }
 
-    void push(const message_id msg_id, const message_view& message) noexcept {
-        const std::unique_lock lock{_output_mutex};
-        _outgoing.next().push(msg_id, message);
+    /// @brief Indicates that the output queue has no space for more messages.
+    auto is_output_full() const noexcept -> bool {
+        return _outgoing.is_full();
+    }
+
+    /// @brief Enqueues a message for output, fails if the queue is full.
+    auto push(const message_id msg_id, const message_view& message) noexcept
+      -> bool {
+        return _outgoing.push(msg_id, message);
+    }
+
+    /// @brief Indicates how full the output queue is (0.0 - 1.0).
+    auto output_fill_ratio() const noexcept -> float {
+        return _outgoing.fill_ratio();
+    }
+
+    /// @brief Returns the average time messages wait for output.
+    auto output_delay() const noexcept -> std::chrono::microseconds {
+        return _outgoing.average_wait();
     }
 
     void notify_output_ready() noexcept {
+        // the waiting thread checks the queue with the mutex locked
+        const std::unique_lock lock{_output_mutex};
         _output_ready.notify_one();
     }
 
@@ -95,50 +323,76 @@ public:
         return _dropped_messages;
     }
 
-    auto decode_errors() const noexcept {
+    auto decode_errors() const noexcept -> span_size_t {
         return _decode_errors;
     }
 
-    void send_output() noexcept;
-
     using fetch_handler = message_storage::fetch_handler;
 
-    auto fetch_messages(const fetch_handler handler) noexcept {
-        auto& queue{[this]() -> message_storage& {
+    auto fetch_messages(fetch_handler handler) noexcept {
+        const bool result{_incoming.fetch_messages(handler)};
+        if(result) {
             const std::unique_lock lock{_input_mutex};
-            _incoming.swap();
-            return _incoming.current();
-        }()};
-        return queue.fetch_all(handler);
+            _input_space.notify_one();
+        }
+        return result;
     }
 
-    void recv_input() noexcept;
+    void read_input() noexcept;
+    void decode_input() noexcept;
+    void encode_output() noexcept;
+    void write_output() noexcept;
 
 private:
     auto _make_send_handler() noexcept;
+    auto _make_binary_send_handler() noexcept;
+    void _push_encoded() noexcept;
 
-    void _do_recv_input(const span_size_t pos) noexcept;
+    void _push_read(const memory::const_block, const bool is_binary) noexcept;
+    void _read_text_input() noexcept;
+    void _read_binary_input() noexcept;
+    void _wait_for_input() noexcept;
+    auto _decode_text(const memory::const_block) noexcept -> bool;
+    auto _decode_binary(const memory::const_block) noexcept -> bool;
 
     const span_size_t _max_read;
 
     std::mutex _input_mutex{};
     std::mutex _output_mutex{};
 
+    // used only for waiting, the queues do not need locking
     std::condition_variable _output_ready{};
+    std::condition_variable _encoded_ready{};
+    std::condition_variable _encoded_space{};
+    std::condition_variable _read_ready{};
+    std::condition_variable _read_space{};
+    std::condition_variable _input_space{};
 
     std::istream& _input{std::cin};
     std::ostream& _output{std::cout};
 
+    // used by the reading stage only
     istream_data_source _source{_input};
-    ostream_data_sink _sink{_output};
-
+    work_waiter _input_waiter{};
+    bool _skip_line{false};
+    // used by the decoding stage only
     memory::buffer _buffer{};
-    double_buffer<message_storage> _outgoing{};
-    double_buffer<message_storage> _incoming{};
-    stored_message _recv_dest{};
+    // used by the encoding stage only
+    memory::buffer _out_buffer{};
+    span_size_t _out_size{0};
     span_size_t _forwarded_messages{0};
     span_size_t _dropped_messages{0};
-    span_size_t _decode_errors{0};
+
+    // the bus side and the encoding stage
+    bridge_message_queue _outgoing;
+    // the decoding stage and the bus side
+    bridge_message_queue _incoming;
+    // the encoding and the writing stage
+    bridge_queue<memory::buffer> _encoded;
+    // the reading and the decoding stage
+    bridge_queue<bridge_input_chunk> _read;
+    std::atomic<span_size_t> _decode_errors{0};
+    bridge_framing _framing;
 };
 //------------------------------------------------------------------------------
 auto bridge_state::_make_send_handler() noexcept {
@@ -146,22 +400,62 @@ auto bridge_state::_make_send_handler() noexcept {
       [this](
         const message_id msg_id, const message_age msg_age, message_view message) {
           if(not message.add_age(msg_age).too_old()) [[likely]] {
-              default_serializer_backend backend(_sink);
+              // the message header is short, the content is encoded below
+              _out_buffer.resize(_out_size + bridge_max_header_size);
+              block_data_sink header_sink(skip(cover(_out_buffer), _out_size));
+              default_serializer_backend backend(header_sink);
               if(serialize_message_header(msg_id, message, backend)) [[likely]] {
+                  _out_size += header_sink.done().size();
+                  // the encoded content is appended to the batch
+                  _out_buffer.resize(
+                    _out_size + (message.data().size() + 2) / 3 * 4 + 1);
                   span_size_t i{0};
+                  span_size_t o{_out_size};
+                  const auto dst{cover(_out_buffer)};
                   do_dissolve_bits(
                     make_span_getter(i, message.data()),
-                    [this](byte b) {
+                    [&](byte b) {
                         const auto encode{make_base64_encode_transform()};
                         if(auto opt_c{encode(b)}) [[likely]] {
-                            this->_output << *opt_c;
+                            dst[o++] = byte(*opt_c);
                             return true;
                         }
                         return false;
                     },
                     6);
-
-                  _output << '\n' << std::flush;
+                  dst[o++] = byte('\n');
+                  _out_size = o;
+                  ++_forwarded_messages;
+              } else {
+                  ++_dropped_messages;
+              }
+          } else {
+              ++_dropped_messages;
+          }
+          return true;
+      };
+}
+//------------------------------------------------------------------------------
+auto bridge_state::_make_binary_send_handler() noexcept {
+    return
+      [this](
+        const message_id msg_id, const message_age msg_age, message_view message) {
+          if(not message.add_age(msg_age).too_old()) [[likely]] {
+              // frames of a whole batch are gathered and written at once
+              const auto max_frame_size{
+                bridge_frame_length_size + compact_message_header_size() +
+                message.data().size()};
+              _out_buffer.resize(_out_size + max_frame_size);
+              auto frame{skip(cover(_out_buffer), _out_size)};
+              const auto serialized{compact_serialize_message(
+                msg_id, message, skip(frame, bridge_frame_length_size))};
+              if(not serialized.empty()) [[likely]] {
+                  const auto length{
+                    limit_cast<std::uint32_t>(serialized.size())};
+                  for(span_size_t i = 0; i < bridge_frame_length_size; ++i) {
+                      frame[i] = byte((length >> (8U * unsigned(i))) & 0xFFU);
+                  }
+                  _out_size += bridge_frame_length_size + serialized.size();
                   ++_forwarded_messages;
               } else {
                   ++_dropped_messages;
@@ -173,50 +467,243 @@ auto bridge_state::_make_send_handler() noexcept {
       };
 }
 //------------------------------------------------------------------------------
-void bridge_state::send_output() noexcept {
-    const auto handler{_make_send_handler()};
-    auto& queue{[this]() -> message_storage& {
+void bridge_state::_push_encoded() noexcept {
+    // the batch buffer is exchanged with the buffer kept in the slot
+    const auto exchange{[this](memory::buffer& batch) {
+        _out_buffer.resize(_out_size);
+        std::swap(batch, _out_buffer);
+        return true;
+    }};
+    if(_encoded.push_if(exchange)) [[likely]] {
+        const std::unique_lock lock{_output_mutex};
+        _encoded_ready.notify_one();
+    }
+    _out_buffer.clear();
+    _out_size = 0;
+}
+//------------------------------------------------------------------------------
+void bridge_state::encode_output() noexcept {
+    if(_encoded.is_full()) [[unlikely]] {
+        // the messages wait in the output queue until the writer catches up
+        std::unique_lock lock{_output_mutex};
+        _encoded_space.wait_for(lock, std::chrono::milliseconds{10}, [this] {
+            return not _encoded.is_full();
+        });
+        return;
+    }
+    if(_outgoing.empty()) {
         std::unique_lock lock{_output_mutex};
-        _output_ready.wait(lock);
-        _outgoing.swap();
-        return _outgoing.current();
-    }()};
-    queue.fetch_all({construct_from, handler});
+        _output_ready.wait_for(lock, std::chrono::milliseconds{50}, [this] {
+            return not _outgoing.empty();
+        });
+    }
+    // the framing lines are written in text mode before the messages
+    for(auto line{_framing.next_output_line()}; not line.empty();
+        line = _framing.next_output_line()) {
+        const auto text{as_bytes(line)};
+        _out_buffer.resize(_out_size + text.size() + 1);
+        const auto dst{skip(cover(_out_buffer), _out_size)};
+        copy(text, dst);
+        dst[text.size()] = byte('\n');
+        _out_size += text.size() + 1;
+    }
+    if(_framing.binary_output()) {
+        auto handler{_make_binary_send_handler()};
+        _outgoing.fetch_messages(handler);
+    } else {
+        auto handler{_make_send_handler()};
+        _outgoing.fetch_messages(handler);
+    }
+    if(_out_size > 0) {
+        _push_encoded();
+    }
 }
 //------------------------------------------------------------------------------
-void bridge_state::_do_recv_input(const span_size_t pos) noexcept {
-    block_data_source source(_source.top(pos));
-    default_deserializer_backend backend(source);
-    identifier class_id{};
-    identifier method_id{};
-    _recv_dest.clear_data();
-
-    if(deserialize_message_header(class_id, method_id, _recv_dest, backend))
-      [[likely]] {
-        _buffer.ensure(source.remaining().size());
-        span_size_t i{0};
-        span_size_t o{0};
-        if(do_concentrate_bits(
-             make_span_getter(
-               i, source.remaining(), make_base64_decode_transform()),
-             make_span_putter(o, cover(_buffer)),
-             6)) {
-            _recv_dest.store_content(head(view(_buffer), o));
-        }
-
+void bridge_state::write_output() noexcept {
+    if(_encoded.empty()) {
+        std::unique_lock lock{_output_mutex};
+        _encoded_ready.wait_for(lock, std::chrono::milliseconds{50}, [this] {
+            return not _encoded.empty();
+        });
+    }
+    const auto write{[this](memory::buffer& batch, auto) {
+        write_to_stream(_output, view(batch));
+        return true;
+    }};
+    if(_encoded.fetch_all(write)) {
+        // one flush per batch of messages
+        _output.flush();
+        const std::unique_lock lock{_output_mutex};
+        _encoded_space.notify_one();
+    }
+}
+//------------------------------------------------------------------------------
+void bridge_state::_push_read(
+  const memory::const_block chunk,
+  const bool is_binary) noexcept {
+    // read_input checks that the queue is not full before reading
+    const auto store{[&](bridge_input_chunk& dst) {
+        dst.data.clear();
+        dst.data.resize(chunk.size());
+        copy(chunk, cover(dst.data));
+        dst.is_binary = is_binary;
+        return true;
+    }};
+    if(_read.push_if(store)) [[likely]] {
         const std::unique_lock lock{_input_mutex};
-        _incoming.next().push({class_id, method_id}, _recv_dest);
+        _read_ready.notify_one();
+    }
+}
+//------------------------------------------------------------------------------
+void bridge_state::_wait_for_input() noexcept {
+    // the blocking reads return less data than requested only at the end
+    // of the input or on error and there is nothing to block on after that
+    if(_input.eof() or _input.fail()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
     } else {
+        _input_waiter.wait(std::chrono::milliseconds{50});
+    }
+}
+//------------------------------------------------------------------------------
+void bridge_state::_read_binary_input() noexcept {
+    // top blocks on the input stream until the requested data is available
+    const auto prefix{_source.top(bridge_frame_length_size)};
+    if(prefix.size() < bridge_frame_length_size) [[unlikely]] {
+        _wait_for_input();
+        return;
+    }
+    std::uint32_t length{0U};
+    for(span_size_t i = 0; i < bridge_frame_length_size; ++i) {
+        length |= std::uint32_t(prefix[i]) << (8U * unsigned(i));
+    }
+    const auto frame_size{span_size(length)};
+    if(frame_size > _max_read + compact_message_header_size()) [[unlikely]] {
+        // the framing cannot be recovered after this
         ++_decode_errors;
+        const std::unique_lock lock{_input_mutex};
+        _input.setstate(std::ios::failbit);
+        return;
+    }
+    const auto frame{_source.top(bridge_frame_length_size + frame_size)};
+    if(frame.size() < bridge_frame_length_size + frame_size) [[unlikely]] {
+        _wait_for_input();
+        return;
     }
-    _source.pop(pos + 1);
+    _push_read(skip(frame, bridge_frame_length_size), true);
+    _source.pop(bridge_frame_length_size + frame_size);
 }
 //------------------------------------------------------------------------------
-void bridge_state::recv_input() noexcept {
+void bridge_state::_read_text_input() noexcept {
     if(const auto pos{_source.scan_for('\n', _max_read)}) {
-        _do_recv_input(*pos);
+        if(_skip_line) [[unlikely]] {
+            _skip_line = false;
+        } else if(_framing.handle_input_line(_source.top(*pos))) [[unlikely]] {
+            // an accept may have to be written even if there are no messages
+            notify_output_ready();
+        } else {
+            _push_read(_source.top(*pos), false);
+        }
+        _source.pop(*pos + 1);
+    } else if(_input.peek() == std::istream::traits_type::eof()) {
+        _wait_for_input();
+    } else if(_source.top(_max_read).size() >= _max_read) [[unlikely]] {
+        // the line is too long to be decoded, skip it up to its end
+        if(not _skip_line) {
+            ++_decode_errors;
+            _skip_line = true;
+        }
+        _source.pop(_max_read);
     } else {
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        // only a part of the line is available, block until more arrives
+        _input_waiter.wait(std::chrono::milliseconds{50});
+    }
+}
+//------------------------------------------------------------------------------
+void bridge_state::read_input() noexcept {
+    if(_read.is_full()) [[unlikely]] {
+        // the input is not read until the decoding stage catches up, so that
+        // the backpressure propagates to the writer on the other side
+        std::unique_lock lock{_input_mutex};
+        _read_space.wait_for(lock, std::chrono::milliseconds{10}, [this] {
+            return not _read.is_full();
+        });
+        return;
+    }
+    // the switch to binary frames is read by this stage, so the chunks
+    // after the switch line are already read as frames
+    if(_framing.binary_input()) {
+        _read_binary_input();
+    } else {
+        _read_text_input();
+    }
+}
+//------------------------------------------------------------------------------
+auto bridge_state::_decode_text(const memory::const_block line) noexcept
+  -> bool {
+    block_data_source source(line);
+    default_deserializer_backend backend(source);
+    const auto decode{[&](message_id& msg_id, stored_message& message) {
+        identifier class_id{};
+        identifier method_id{};
+        message.clear_data();
+
+        if(deserialize_message_header(class_id, method_id, message, backend))
+          [[likely]] {
+            _buffer.ensure(source.remaining().size());
+            span_size_t i{0};
+            span_size_t o{0};
+            if(do_concentrate_bits(
+                 make_span_getter(
+                   i, source.remaining(), make_base64_decode_transform()),
+                 make_span_putter(o, cover(_buffer)),
+                 6)) {
+                message.store_content(head(view(_buffer), o));
+            }
+            msg_id = {class_id, method_id};
+            return true;
+        }
+        return false;
+    }};
+    return _incoming.push_message_if(decode);
+}
+//------------------------------------------------------------------------------
+auto bridge_state::_decode_binary(const memory::const_block frame) noexcept
+  -> bool {
+    const auto decode{[&](message_id& msg_id, stored_message& message) {
+        return compact_deserialize_message(msg_id, message, frame);
+    }};
+    return _incoming.push_message_if(decode);
+}
+//------------------------------------------------------------------------------
+void bridge_state::decode_input() noexcept {
+    if(_incoming.is_full()) [[unlikely]] {
+        // the read chunks wait until the bus side catches up
+        std::unique_lock lock{_input_mutex};
+        _input_space.wait_for(lock, std::chrono::milliseconds{10}, [this] {
+            return not _incoming.is_full();
+        });
+        return;
+    }
+    if(_read.empty()) {
+        std::unique_lock lock{_input_mutex};
+        _read_ready.wait_for(lock, std::chrono::milliseconds{50}, [this] {
+            return not _read.empty();
+        });
+    }
+    const auto decode{[this](bridge_input_chunk& chunk, auto) {
+        if(_incoming.is_full()) [[unlikely]] {
+            return false;
+        }
+        const auto data{view(chunk.data)};
+        if(not(chunk.is_binary ? _decode_binary(data) : _decode_text(data)))
+          [[unlikely]] {
+            ++_decode_errors;
+        }
+        return true;
+    }};
+    if(_read.fetch_all(decode)) {
+        const std::unique_lock lock{_input_mutex};
+        _read_space.notify_one();
     }
 }
 //------------------------------------------------------------------------------
@@ -252,7 +739,11 @@ auto bridge::add_connection(shared_holder<connection> conn) noexcept -> bool {
 }
 //------------------------------------------------------------------------------
 void bridge::_setup_from_config() {
-    // TODO: use app_config()
+    _binary_framing =
+      app_config().get<bool>("msgbus.bridge.binary_framing").value_or(false);
+    _queue_size = app_config()
+                    .get<span_size_t>("msgbus.bridge.queue_size")
+                    .value_or(_queue_size);
 }
 //------------------------------------------------------------------------------
 auto bridge::_handle_id_assigned(const message_view& message) noexcept
@@ -364,9 +855,28 @@ auto bridge::_handle_stats_query(
             _send(msgbus_id{"statsBrdg"}, response);
         }
     }
+    _post_trace_records(message, to_connection);
     return should_be_forwarded;
 }
 //------------------------------------------------------------------------------
+void bridge::_post_trace_records(
+  const message_view& query,
+  const bool to_connection) noexcept {
+    for(const auto& record : _tracer.fetch_records(_id)) {
+        auto temp{default_serialize_buffer_for(record)};
+        if(const auto serialized{default_serialize(record, cover(temp))}) {
+            message_view response{*serialized};
+            response.setup_response(query);
+            response.set_source_id(_id);
+            if(to_connection) {
+                _do_push(msgbus_id{"statsTrace"}, response);
+            } else {
+                _send(msgbus_id{"statsTrace"}, response);
+            }
+        }
+    }
+}
+//------------------------------------------------------------------------------
 auto bridge::_handle_special(
   const message_id msg_id,
   const message_view& message,
@@ -405,7 +915,9 @@ auto bridge::_do_send(const message_id msg_id, message_view& message) noexcept
   -> bool {
     message.add_hop();
     if(_connection) [[likely]] {
+        _tracer.stamp(message_trace_point::submit, msg_id, message);
         if(_connection->send(msg_id, message)) {
+            _tracer.stamp(message_trace_point::accept, msg_id, message);
             log_trace("forwarding message ${message} to connection")
               .arg("message", msg_id)
               .arg("data", message.data());
@@ -426,11 +938,14 @@ auto bridge::_do_push(const message_id msg_id, message_view& message) noexcept
   -> bool {
     if(_state) [[likely]] {
         message.add_hop();
-        _state->push(msg_id, message);
-        log_trace("forwarding message ${message} to stream")
-          .arg("message", msg_id)
-          .arg("data", message.data());
-        return true;
+        // written to the output stream by the output stages
+        _tracer.stamp(message_trace_point::enqueue, msg_id, message);
+        if(_state->push(msg_id, message)) [[likely]] {
+            log_trace("forwarding message ${message} to stream")
+              .arg("message", msg_id)
+              .arg("data", message.data());
+            return true;
+        }
     }
     return false;
 }
@@ -472,6 +987,8 @@ void bridge::_log_bridge_stats_c2o() noexcept {
           .arg("dropped", _dropped_messages_c2o)
           .arg("interval", interval)
           .arg("avgMsgAge", _avg_msg_age_c2o())
+          .arg(
+            "queueFill", "Ratio", _state ? _state->output_fill_ratio() : 0.F)
           .arg("msgsPerSec", "RatePerSec", msgs_per_sec);
     }
 
@@ -508,6 +1025,12 @@ auto bridge::_forward_messages() noexcept -> work_done {
 
     const auto forward_conn_to_output{
       [this](const message_id msg_id, message_age msg_age, message_view message) {
+          if(_state and _state->is_output_full()) [[unlikely]] {
+              // the message is kept in the connection until there is space,
+              // the congestion is reported upstream in the message flow info
+              return false;
+          }
+          _tracer.stamp(message_trace_point::receive, msg_id, message);
           _message_age_sum_c2o += message.add_age(msg_age).age();
           if(message.too_old()) [[unlikely]] {
               ++_dropped_messages_c2o;
@@ -519,19 +1042,28 @@ auto bridge::_forward_messages() noexcept -> work_done {
           if(_handle_special(msg_id, message, false) == was_handled) {
               return true;
           }
-          return this->_do_push(msg_id, message);
+          if(not this->_do_push(msg_id, message)) [[unlikely]] {
+              if(_state) {
+                  return false;
+              }
+              // there is no stream to forward the message to
+              ++_dropped_messages_c2o;
+          }
+          return true;
       }};
 
     if(_connection) [[likely]] {
         something_done(
           _connection->fetch_messages({construct_from, forward_conn_to_output}));
     }
-    _state->notify_output_ready();
 
     if(_state) [[likely]] {
+        _state->notify_output_ready();
+
         const auto forward_input_to_conn{
           [this](
             const message_id msg_id, message_age msg_age, message_view message) {
+              _tracer.stamp(message_trace_point::receive, msg_id, message);
               _message_age_sum_i2c += message.add_age(msg_age).age();
               if(message.too_old()) [[unlikely]] {
                   ++_dropped_messages_i2c;
@@ -565,7 +1097,7 @@ auto bridge::_check_state() noexcept -> work_done {
         if(_recoverable_state() and _connection) {
             if(const auto max_data_size{_connection->max_data_size()}) {
                 ++_state_count;
-                _state.emplace(*max_data_size);
+                _state.emplace(*max_data_size, _queue_size, _binary_framing);
                 _state->start();
                 something_done();
             }
@@ -593,6 +1125,29 @@ auto bridge::_update_connections() noexcept -> work_done {
     return something_done;
 }
 //------------------------------------------------------------------------------
+auto bridge::_update_flow_info() noexcept -> work_done {
+    if(_state and has_id() and _flow_info_timeout) {
+        _flow_info_timeout.reset();
+        // the time messages wait for the output adds to their age
+        message_flow_info flow_info{};
+        flow_info.set_average_message_age(
+          _avg_msg_age_c2o() + _state->output_delay());
+        // while congested the info is repeated, so that it does not expire
+        // in the router
+        if(_flow_info != flow_info or flow_info.avg_msg_age_ms > 0) {
+            _flow_info = flow_info;
+            auto buf{default_serialize_buffer_for(flow_info)};
+            if(const auto serialized{default_serialize(flow_info, cover(buf))})
+              [[likely]] {
+                message_view message{*serialized};
+                message.set_priority(message_priority::high);
+                return _send(msgbus_id{"msgFlowInf"}, message);
+            }
+        }
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
 auto bridge::update() noexcept -> work_done {
     static const auto exec_time_id{register_time_interval("busUpdate")};
     const auto exec_time{measure_time_interval(exec_time_id)};
@@ -602,6 +1157,7 @@ auto bridge::update() noexcept -> work_done {
     something_done(_check_state());
     something_done(_update_connections());
     something_done(_forward_messages());
+    something_done(_update_flow_info());
 
     // if processing the messages assigned the id
     if(has_id() and not had_id) [[unlikely]] {
@@ -0,0 +1,124 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+
+#include <eagine/testing/unit_begin_ctx.hpp>
+import std;
+import eagine.core;
+import eagine.msgbus.core;
+//------------------------------------------------------------------------------
+// passes all pending framing lines from one side to the other
+auto bridge_framing_pass(
+  eagine::msgbus::bridge_framing& from,
+  eagine::msgbus::bridge_framing& to) -> std::size_t {
+    std::size_t count{0U};
+    for(auto line{from.next_output_line()}; not line.empty();
+        line = from.next_output_line()) {
+        to.handle_input_line(eagine::as_bytes(line));
+        ++count;
+    }
+    return count;
+}
+//------------------------------------------------------------------------------
+// binary framing negotiated
+//------------------------------------------------------------------------------
+void bridge_framing_negotiated(auto& s) {
+    eagitest::case_ test{s, 1, "negotiated"};
+    eagine::msgbus::bridge_framing writer{true};
+    eagine::msgbus::bridge_framing reader{false};
+
+    // the offer does not switch the output yet
+    test.check_equal(bridge_framing_pass(writer, reader), std::size_t(1), "offer");
+    test.check(not writer.binary_output(), "writer not binary after offer");
+    test.check(not reader.binary_input(), "reader not binary after offer");
+
+    // nothing more until the other side echoes the offer
+    test.check_equal(
+      bridge_framing_pass(writer, reader), std::size_t(0), "no switch");
+    test.check(not writer.binary_output(), "writer still not binary");
+
+    test.check_equal(bridge_framing_pass(reader, writer), std::size_t(1), "accept");
+    test.check(not reader.binary_output(), "reader output stays text");
+    test.check(not writer.binary_input(), "writer input stays text");
+
+    test.check_equal(bridge_framing_pass(writer, reader), std::size_t(1), "switch");
+    test.check(writer.binary_output(), "writer binary");
+    test.check(reader.binary_input(), "reader binary");
+
+    test.check_equal(bridge_framing_pass(writer, reader), std::size_t(0), "done 1");
+    test.check_equal(bridge_framing_pass(reader, writer), std::size_t(0), "done 2");
+}
+//------------------------------------------------------------------------------
+// binary framing both directions
+//------------------------------------------------------------------------------
+void bridge_framing_both(auto& s) {
+    eagitest::case_ test{s, 2, "both directions"};
+    eagine::msgbus::bridge_framing left{true};
+    eagine::msgbus::bridge_framing right{true};
+
+    // both offers cross each other
+    test.check_equal(
+      bridge_framing_pass(left, right), std::size_t(1), "left offer");
+    test.check_equal(
+      bridge_framing_pass(right, left), std::size_t(2), "right offer+accept");
+    test.check(not right.binary_output(), "right not binary yet");
+
+    test.check_equal(
+      bridge_framing_pass(left, right), std::size_t(2), "accept+switch");
+    test.check(left.binary_output(), "left binary output");
+    test.check(right.binary_input(), "right binary input");
+
+    test.check_equal(
+      bridge_framing_pass(right, left), std::size_t(1), "right switch");
+    test.check(right.binary_output(), "right binary output");
+    test.check(left.binary_input(), "left binary input");
+}
+//------------------------------------------------------------------------------
+// binary framing with an old peer
+//------------------------------------------------------------------------------
+void bridge_framing_old_peer(auto& s) {
+    eagitest::case_ test{s, 3, "old peer"};
+    eagine::msgbus::bridge_framing writer{true};
+
+    test.check(not writer.next_output_line().empty(), "offer");
+    // the peer does not know the offer and never accepts it
+    for(int i = 0; i < 10; ++i) {
+        test.check(writer.next_output_line().empty(), "nothing more");
+    }
+    test.check(not writer.binary_output(), "text output");
+
+    // an accept that is not an answer to an offer does not switch
+    eagine::msgbus::bridge_framing text{false};
+    text.handle_input_line(eagine::as_bytes(std::string_view{
+      "@eagiMsgBus:binary-frames:1:accept"}));
+    test.check(text.next_output_line().empty(), "no switch");
+    test.check(not text.binary_output(), "still text");
+
+    test.check(
+      not text.handle_input_line(eagine::as_bytes(std::string_view{"@eagi"})),
+      "not a framing line 1");
+    test.check(
+      not text.handle_input_line(eagine::as_bytes(std::string_view{"abcd"})),
+      "not a framing line 2");
+    test.check(not text.binary_input(), "text input");
+}
+//------------------------------------------------------------------------------
+// main
+//------------------------------------------------------------------------------
+auto test_main(eagine::test_ctx& ctx) -> int {
+    eagitest::ctx_suite test{ctx, "bridge", 3};
+    test.once(bridge_framing_negotiated);
+    test.once(bridge_framing_both);
+    test.once(bridge_framing_old_peer);
+    return test.exit_code();
+}
+//------------------------------------------------------------------------------
+auto main(int argc, const char** argv) -> int {
+    return eagine::test_main_impl(argc, argv, test_main);
+}
+//------------------------------------------------------------------------------
+#include <eagine/testing/unit_end_ctx.hpp>
@@ -21,6 +21,9 @@ namespace eagine::msgbus {
 export auto make_posix_mqueue_connection_factory(main_ctx_parent parent)
   -> unique_holder<connection_factory>;
 
+export auto make_shmem_ring_connection_factory(main_ctx_parent parent)
+  -> unique_holder<connection_factory>;
+
 export auto make_asio_tcp_ipv4_connection_factory(main_ctx_parent parent)
   -> unique_holder<connection_factory>;
 
@@ -257,6 +257,9 @@ void connection_setup_configure(
     if(config.is_set("msgbus.posix_mqueue")) {
         setup.add_factory(make_posix_mqueue_connection_factory(setup));
     }
+    if(config.is_set("msgbus.shmem_ring")) {
+        setup.add_factory(make_shmem_ring_connection_factory(setup));
+    }
     if(config.is_set("msgbus.direct")) {
         setup.add_factory(make_direct_connection_factory(setup));
     }
@@ -19,11 +19,96 @@ import :message;
 
 namespace eagine::msgbus {
 //------------------------------------------------------------------------------
+/// @brief Session MAC keys shared by this and a remote bus node.
+/// @ingroup msgbus
+/// @see context::make_session_key
+/// @see context::accept_session_key
+export class session_mac_keys {
+public:
+    using clock_type = std::chrono::steady_clock;
+    using key_type = std::array<byte, 32>;
+
+    /// @brief The size of the computed MACs.
+    static constexpr const span_size_t mac_size{32};
+
+    session_mac_keys() noexcept = default;
+
+    /// @brief Construction with the previous key grace and key exchange periods.
+    session_mac_keys(
+      const clock_type::duration grace_period,
+      const clock_type::duration exchange_period) noexcept
+      : _grace_period{grace_period}
+      , _exchange_period{exchange_period} {}
+
+    /// @brief Starts a sign key exchange after signing the remote node's nonce.
+    /// @see expected_nonce
+    /// @see accept_sign_key
+    void expect_sign_key(
+      const memory::const_block nonce,
+      const clock_type::time_point now = clock_type::now()) noexcept;
+
+    /// @brief Returns the nonce signed for the sign key exchange in progress.
+    /// @note Returns an empty block if no key exchange is in progress.
+    auto expected_nonce(
+      const clock_type::time_point now = clock_type::now()) const noexcept
+      -> memory::const_block;
+
+    /// @brief Stores a sign key if a key exchange is in progress.
+    auto accept_sign_key(
+      const memory::const_block key,
+      const clock_type::time_point now = clock_type::now()) noexcept -> bool;
+
+    /// @brief Indicates if there is a key for signing messages to the remote.
+    auto has_sign_key() const noexcept -> bool {
+        return _has_sign_key;
+    }
+
+    /// @brief Sets a new verify key, keeping the previous one for a grace period.
+    auto set_verify_key(
+      const memory::const_block key,
+      const clock_type::time_point now = clock_type::now()) noexcept -> bool;
+
+    /// @brief Keeps the current verify key only for the grace period.
+    void retire_verify_key(
+      const clock_type::time_point now = clock_type::now()) noexcept;
+
+    /// @brief Indicates if there is a key for verifying messages from the remote.
+    auto has_verify_key(
+      const clock_type::time_point now = clock_type::now()) const noexcept
+      -> bool;
+
+    /// @brief Computes the MAC of the data with the sign key into dst.
+    auto sign(const memory::const_block data, memory::block dst) const noexcept
+      -> memory::const_block;
+
+    /// @brief Verifies the MAC of the data with the current or previous key.
+    auto verify(
+      const memory::const_block data,
+      const memory::const_block mac,
+      const clock_type::time_point now = clock_type::now()) const noexcept
+      -> bool;
+
+private:
+    clock_type::duration _grace_period{std::chrono::seconds{15}};
+    clock_type::duration _exchange_period{std::chrono::seconds{30}};
+    clock_type::time_point _exchange_started{};
+    clock_type::time_point _verify_key_retired{};
+    memory::buffer _nonce;
+    key_type _sign_key{};
+    key_type _verify_key{};
+    key_type _prev_verify_key{};
+    bool _has_sign_key{false};
+    bool _has_verify_key{false};
+    bool _has_prev_verify_key{false};
+};
+//------------------------------------------------------------------------------
 struct context_remote_node {
     std::array<byte, 256> nonce{};
     memory::buffer cert_pem;
     sslplus::owned_x509 cert{};
     sslplus::owned_pkey pubkey{};
+    // MAC keys of messages from and to the remote node
+    session_mac_keys session{};
     bool verified_key{false};
 };
 //------------------------------------------------------------------------------
@@ -167,12 +252,46 @@ public:
       const memory::const_block sig,
       const endpoint_id_t) noexcept -> bool;
 
+    /// @brief Makes a session key for a remote node with verified private key.
+    /// @return The session key sealed with the public key of the remote node
+    ///         and signed with the private key of this node.
+    /// @see accept_session_key
+    auto make_session_key(const endpoint_id_t) noexcept -> memory::const_block;
+
+    /// @brief Starts accepting a session key after signing a remote node's nonce.
+    /// @see accept_session_key
+    auto expect_session_key(
+      const endpoint_id_t,
+      const memory::const_block nonce) noexcept -> bool;
+
+    /// @brief Verifies, unseals and stores a session key made by a remote node.
+    /// @see make_session_key
+    /// @see expect_session_key
+    auto accept_session_key(
+      const endpoint_id_t,
+      const memory::const_block sealed) noexcept -> bool;
+
+    /// @brief Indicates if messages to a remote node can use the session MAC.
+    auto has_session_key(const endpoint_id_t) const noexcept -> bool;
+
+    /// @brief Computes the session MAC of a data block sent to a remote node.
+    auto session_mac(
+      const memory::const_block data,
+      const endpoint_id_t,
+      memory::block dst) noexcept -> memory::const_block;
+
+    /// @brief Verifies the session MAC on a data block from a remote node.
+    auto verify_session_mac(
+      const memory::const_block data,
+      const memory::const_block mac,
+      const endpoint_id_t) noexcept -> verification_bits;
+
 private:
-    //
     std::mt19937_64 _rand_engine{std::random_device{}()};
     flat_map<message_id, message_sequence_t> _msg_id_seq{};
     //
     memory::buffer _scratch_space{};
+    memory::buffer _session_key_msg{};
     memory::buffer _own_cert_pem{};
     memory::buffer _ca_cert_pem{};
     //
@@ -5,6 +5,17 @@
 /// See accompanying file LICENSE_1_0.txt or copy at
 /// https://www.boost.org/LICENSE_1_0.txt
 ///
+module;
+
+#if __has_include(<openssl/evp.h>) && __has_include(<openssl/hmac.h>)
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#define EAGINE_MSGBUS_HAS_HMAC 1
+#else
+#define EAGINE_MSGBUS_HAS_HMAC 0
+#endif
+
 module eagine.msgbus.core;
 
 import std;
@@ -19,6 +30,155 @@ import eagine.sslplus;
 
 namespace eagine::msgbus {
 //------------------------------------------------------------------------------
+// session_mac_keys
+//------------------------------------------------------------------------------
+static auto session_hmac(
+  const session_mac_keys::key_type& key,
+  const memory::const_block data,
+  memory::block dst) noexcept -> memory::const_block {
+#if EAGINE_MSGBUS_HAS_HMAC
+    if(dst.size() >= session_mac_keys::mac_size) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        std::size_t size{0U};
+        if(EVP_Q_mac(
+             nullptr,
+             "HMAC",
+             nullptr,
+             "SHA256",
+             nullptr,
+             key.data(),
+             key.size(),
+             data.data(),
+             std_size(data.size()),
+             dst.data(),
+             std_size(dst.size()),
+             &size)) {
+            return head(dst, span_size(size));
+        }
+#else
+        unsigned size{0U};
+        if(HMAC(
+             EVP_sha256(),
+             key.data(),
+             static_cast<int>(key.size()),
+             data.data(),
+             std_size(data.size()),
+             dst.data(),
+             &size)) {
+            return head(dst, span_size(size));
+        }
+#endif
+    }
+#else
+    (void)key;
+    (void)data;
+    (void)dst;
+#endif
+    return {};
+}
+//------------------------------------------------------------------------------
+static auto session_hmac_equal(
+  const session_mac_keys::key_type& key,
+  const memory::const_block data,
+  const memory::const_block mac) noexcept -> bool {
+#if EAGINE_MSGBUS_HAS_HMAC
+    std::array<byte, session_mac_keys::mac_size> temp{};
+    if(const auto expected{session_hmac(key, data, cover(temp))}) {
+        // compare in constant time
+        return (expected.size() == mac.size()) and
+               (CRYPTO_memcmp(
+                  expected.data(), mac.data(), std_size(mac.size())) == 0);
+    }
+#else
+    (void)key;
+    (void)data;
+    (void)mac;
+#endif
+    return false;
+}
+//------------------------------------------------------------------------------
+void session_mac_keys::expect_sign_key(
+  const memory::const_block nonce,
+  const clock_type::time_point now) noexcept {
+    memory::copy_into(nonce, _nonce);
+    _exchange_started = now;
+}
+//------------------------------------------------------------------------------
+auto session_mac_keys::expected_nonce(
+  const clock_type::time_point now) const noexcept -> memory::const_block {
+    if(not _nonce.empty() and (now - _exchange_started <= _exchange_period)) {
+        return view(_nonce);
+    }
+    return {};
+}
+//------------------------------------------------------------------------------
+auto session_mac_keys::accept_sign_key(
+  const memory::const_block key,
+  const clock_type::time_point now) noexcept -> bool {
+    if(expected_nonce(now) and (key.size() == span_size(_sign_key.size()))) {
+        std::copy(key.begin(), key.end(), _sign_key.begin());
+        _has_sign_key = true;
+        _nonce.clear();
+        return true;
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+auto session_mac_keys::set_verify_key(
+  const memory::const_block key,
+  const clock_type::time_point now) noexcept -> bool {
+    if(key.size() == span_size(_verify_key.size())) {
+        retire_verify_key(now);
+        std::copy(key.begin(), key.end(), _verify_key.begin());
+        _has_verify_key = true;
+        return true;
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+void session_mac_keys::retire_verify_key(
+  const clock_type::time_point now) noexcept {
+    if(_has_verify_key) {
+        _prev_verify_key = _verify_key;
+        _has_prev_verify_key = true;
+        _has_verify_key = false;
+        _verify_key_retired = now;
+    }
+}
+//------------------------------------------------------------------------------
+auto session_mac_keys::has_verify_key(
+  const clock_type::time_point now) const noexcept -> bool {
+    return _has_verify_key or
+           (_has_prev_verify_key and
+            (now - _verify_key_retired <= _grace_period));
+}
+//------------------------------------------------------------------------------
+auto session_mac_keys::sign(
+  const memory::const_block data,
+  memory::block dst) const noexcept -> memory::const_block {
+    if(_has_sign_key) {
+        return session_hmac(_sign_key, data, dst);
+    }
+    return {};
+}
+//------------------------------------------------------------------------------
+auto session_mac_keys::verify(
+  const memory::const_block data,
+  const memory::const_block mac,
+  const clock_type::time_point now) const noexcept -> bool {
+    if(_has_verify_key and session_hmac_equal(_verify_key, data, mac)) {
+        return true;
+    }
+    if(
+      _has_prev_verify_key and (now - _verify_key_retired <= _grace_period) and
+      session_hmac_equal(_prev_verify_key, data, mac)) {
+        return true;
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+// context
+//------------------------------------------------------------------------------
 context::context(main_ctx_parent parent) noexcept
   : main_ctx_object{"MsgBusCtxt", parent} {
 
@@ -155,6 +315,8 @@ auto context::add_remote_certificate_pem(
                 _ssl.delete_pkey(std::move(info.pubkey));
             }
             info.cert = std::move(cert.get());
+            // messages MAC-ed with the current key can still be in flight
+            info.session.retire_verify_key();
             memory::copy_into(blk, info.cert_pem);
             if(verify_certificate(info.cert)) {
                 if(ok pubkey{_ssl.get_x509_pubkey(info.cert)}) {
@@ -339,6 +501,158 @@ auto context::verify_remote_signature(
     return false;
 }
 //------------------------------------------------------------------------------
+auto context::make_session_key(const endpoint_id_t node_id) noexcept
+  -> memory::const_block {
+    const auto remote{find(_remotes, node_id)};
+    if(not remote or not remote->pubkey or not remote->verified_key) {
+        return {};
+    }
+    session_mac_keys::key_type key{};
+    main_context().fill_with_random_bytes(cover(key));
+
+    const auto req_size{
+      _ssl.pkey_encrypt.required_size(remote->pubkey, view(key))};
+    _scratch_space.ensure(req_size.value_or(0));
+    auto free{cover(_scratch_space)};
+
+    if(ok sealed{_ssl.pkey_encrypt(remote->pubkey, view(key), free)}) {
+        // size of the sealed key, the sealed key and the nonce of the remote
+        // node which are replaced by the signature after signing
+        const auto sealed_size{sealed.get().size()};
+        const auto nonce{view(remote->nonce)};
+        const auto signed_size{2 + sealed_size};
+        _session_key_msg.resize(signed_size + nonce.size());
+        auto dst{cover(_session_key_msg)};
+        dst[0] = byte((sealed_size >> 8U) & 0xFFU);
+        dst[1] = byte(sealed_size & 0xFFU);
+        copy(sealed.get(), skip(dst, 2));
+        copy(nonce, skip(dst, signed_size));
+
+        if(const auto sig{get_own_signature(view(_session_key_msg))}) {
+            _session_key_msg.resize(signed_size + sig.size());
+            copy(sig, skip(cover(_session_key_msg), signed_size));
+            remote->session.set_verify_key(view(key));
+            return view(_session_key_msg);
+        }
+        log_debug("failed to sign session key").arg("nodeId", node_id);
+    } else {
+        log_debug("failed to seal session key")
+          .arg("nodeId", node_id)
+          .arg("reason", (not sealed).message());
+    }
+    return {};
+}
+//------------------------------------------------------------------------------
+auto context::expect_session_key(
+  const endpoint_id_t node_id,
+  const memory::const_block nonce) noexcept -> bool {
+    if(const auto remote{find(_remotes, node_id)}) {
+        // only nodes with a verified certificate can send a session key
+        if(remote->pubkey and nonce) {
+            remote->session.expect_sign_key(nonce);
+            return true;
+        }
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+auto context::accept_session_key(
+  const endpoint_id_t node_id,
+  const memory::const_block message) noexcept -> bool {
+    // never add remote node entries for arbitrary ids here
+    const auto remote{find(_remotes, node_id)};
+    if(not remote or not remote->pubkey or not _own_pkey) {
+        log_debug("received session key from unknown node")
+          .arg("nodeId", node_id);
+        return false;
+    }
+    const auto nonce{remote->session.expected_nonce()};
+    if(not nonce) {
+        log_debug("received unexpected session key").arg("nodeId", node_id);
+        return false;
+    }
+    if(message.size() < 2) {
+        return false;
+    }
+    const auto sealed_size{
+      (span_size(message[0]) << 8U) | span_size(message[1])};
+    const auto signed_size{2 + sealed_size};
+    if(sealed_size == 0 or message.size() <= signed_size) {
+        log_debug("received malformed session key").arg("nodeId", node_id);
+        return false;
+    }
+
+    _session_key_msg.resize(signed_size + nonce.size());
+    copy(head(message, signed_size), cover(_session_key_msg));
+    copy(nonce, skip(cover(_session_key_msg), signed_size));
+    const auto result{verify_remote_signature(
+      view(_session_key_msg), skip(message, signed_size), node_id)};
+    if(not result.has(verification_bit::message_content)) {
+        log_debug("failed to verify session key signature")
+          .arg("nodeId", node_id);
+        return false;
+    }
+
+    const auto sealed{head(skip(message, 2), sealed_size)};
+    const auto req_size{_ssl.pkey_decrypt.required_size(_own_pkey, sealed)};
+    _scratch_space.ensure(req_size.value_or(0));
+    auto free{cover(_scratch_space)};
+
+    if(ok key{_ssl.pkey_decrypt(_own_pkey, sealed, free)}) {
+        if(remote->session.accept_sign_key(key.get())) {
+            return true;
+        }
+        log_debug("received session key has invalid size")
+          .arg("nodeId", node_id)
+          .arg("size", key.get().size());
+    } else {
+        log_debug("failed to unseal session key")
+          .arg("nodeId", node_id)
+          .arg("reason", (not key).message());
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+auto context::has_session_key(const endpoint_id_t node_id) const noexcept
+  -> bool {
+    if(const auto remote{find(_remotes, node_id)}) {
+        return remote->session.has_sign_key();
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+auto context::session_mac(
+  const memory::const_block data,
+  const endpoint_id_t node_id,
+  memory::block dst) noexcept -> memory::const_block {
+    if(const auto remote{find(_remotes, node_id)}) {
+        return remote->session.sign(data, dst);
+    }
+    return {};
+}
+//------------------------------------------------------------------------------
+auto context::verify_session_mac(
+  const memory::const_block content,
+  const memory::const_block mac,
+  const endpoint_id_t node_id) noexcept -> verification_bits {
+    verification_bits result{};
+
+    if(content and mac) {
+        if(const auto remote{find(_remotes, node_id)}) {
+            if(remote->session.verify(content, mac)) {
+                // only the owner of the verified key could unseal it
+                result |= verification_bit::source_private_key;
+                result |= verification_bit::source_certificate;
+                result |= verification_bit::message_content;
+            } else {
+                log_debug("failed to verify session MAC")
+                  .arg("nodeId", node_id);
+            }
+        }
+    }
+    return result;
+}
+//------------------------------------------------------------------------------
 auto make_context(main_ctx_parent parent) -> shared_holder<context> {
     return {default_selector, parent};
 }
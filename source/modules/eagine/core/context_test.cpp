@@ -0,0 +1,184 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+
+#include <eagine/testing/unit_begin_ctx.hpp>
+import std;
+import eagine.core;
+import eagine.msgbus.core;
+//------------------------------------------------------------------------------
+using session_test_clock = eagine::msgbus::session_mac_keys::clock_type;
+using session_test_key = eagine::msgbus::session_mac_keys::key_type;
+using session_test_mac =
+  std::array<eagine::byte, eagine::msgbus::session_mac_keys::mac_size>;
+//------------------------------------------------------------------------------
+auto session_test_make_key(eagine::byte seed) -> session_test_key {
+    session_test_key key{};
+    for(auto& b : key) {
+        b = seed;
+        seed = eagine::byte(seed * 7U + 3U);
+    }
+    return key;
+}
+//------------------------------------------------------------------------------
+auto session_test_view(const session_test_key& key)
+  -> eagine::memory::const_block {
+    return {key.data(), eagine::span_size(key.size())};
+}
+//------------------------------------------------------------------------------
+auto session_test_cover(session_test_mac& mac) -> eagine::memory::block {
+    return {mac.data(), eagine::span_size(mac.size())};
+}
+//------------------------------------------------------------------------------
+// makes a pair of sender and receiver keys sharing the specified key
+void session_test_share(
+  eagine::msgbus::session_mac_keys& sender,
+  eagine::msgbus::session_mac_keys& receiver,
+  const session_test_key& key,
+  const session_test_clock::time_point now) {
+    const auto nonce{eagine::as_bytes(std::string_view{"test nonce"})};
+    sender.expect_sign_key(nonce, now);
+    sender.accept_sign_key(session_test_view(key), now);
+    receiver.set_verify_key(session_test_view(key), now);
+}
+//------------------------------------------------------------------------------
+// MAC round-trip
+//------------------------------------------------------------------------------
+void session_mac_roundtrip(auto& s) {
+    eagitest::case_ test{s, 1, "MAC round-trip"};
+    const auto now{session_test_clock::now()};
+    eagine::msgbus::session_mac_keys sender;
+    eagine::msgbus::session_mac_keys receiver;
+
+    test.check(not sender.has_sign_key(), "no sign key");
+    test.check(not receiver.has_verify_key(now), "no verify key");
+
+    session_test_share(sender, receiver, session_test_make_key(0x11U), now);
+    test.check(sender.has_sign_key(), "has sign key");
+    test.check(receiver.has_verify_key(now), "has verify key");
+
+    const auto data{eagine::as_bytes(std::string_view{"message content"})};
+    session_test_mac mac{};
+    const auto signature{sender.sign(data, session_test_cover(mac))};
+    test.check_equal(
+      signature.size(), eagine::msgbus::session_mac_keys::mac_size, "MAC size");
+    test.check(receiver.verify(data, signature, now), "verified");
+
+    const auto other{eagine::as_bytes(std::string_view{"message_content"})};
+    test.check(not receiver.verify(other, signature, now), "other content");
+    test.check(
+      not receiver.verify(data, eagine::head(signature, 16), now), "short MAC");
+
+    std::array<eagine::byte, 8> small{};
+    test.check(
+      not sender.sign(data, {small.data(), eagine::span_size(small.size())}),
+      "too small");
+}
+//------------------------------------------------------------------------------
+// forged key rejection
+//------------------------------------------------------------------------------
+void session_mac_forged_key(auto& s) {
+    eagitest::case_ test{s, 2, "forged key"};
+    const auto now{session_test_clock::now()};
+    eagine::msgbus::session_mac_keys sender;
+    eagine::msgbus::session_mac_keys receiver;
+    session_test_share(sender, receiver, session_test_make_key(0x22U), now);
+
+    // a sign key that does not follow a nonce signature is not accepted
+    eagine::msgbus::session_mac_keys forger;
+    const auto forged{session_test_make_key(0x33U)};
+    test.check(
+      not forger.accept_sign_key(session_test_view(forged), now), "unexpected");
+    test.check(not forger.has_sign_key(), "no forged sign key");
+
+    // nor one arriving after the key exchange period
+    const auto nonce{eagine::as_bytes(std::string_view{"nonce"})};
+    forger.expect_sign_key(nonce, now);
+    const auto later{now + std::chrono::minutes{5}};
+    test.check(not forger.expected_nonce(later), "exchange expired");
+    test.check(
+      not forger.accept_sign_key(session_test_view(forged), later), "late");
+
+    // nor a sign key with the wrong size
+    test.check(
+      not forger.accept_sign_key(eagine::head(session_test_view(forged), 16), now),
+      "wrong size");
+    test.check(forger.accept_sign_key(session_test_view(forged), now), "ok");
+    test.check(not forger.expected_nonce(now), "exchange finished");
+
+    // MACs made with a forged key do not verify
+    const auto data{eagine::as_bytes(std::string_view{"forged content"})};
+    session_test_mac mac{};
+    const auto signature{forger.sign(data, session_test_cover(mac))};
+    test.check(bool(signature), "signed");
+    test.check(not receiver.verify(data, signature, now), "rejected");
+
+    // session keys from unknown nodes do not create remote node entries
+    eagine::msgbus::context msg_ctx{s.context()};
+    test.check(
+      not msg_ctx.expect_session_key(0x1234U, nonce), "not expecting unknown");
+    test.check(
+      not msg_ctx.accept_session_key(0x1234U, session_test_view(forged)),
+      "not accepted from unknown");
+    test.check(not msg_ctx.has_session_key(0x1234U), "no session key");
+    test.check(not msg_ctx.get_remote_nonce(0x1234U), "no remote node");
+}
+//------------------------------------------------------------------------------
+// key rotation
+//------------------------------------------------------------------------------
+void session_mac_rotation(auto& s) {
+    eagitest::case_ test{s, 3, "key rotation"};
+    const auto now{session_test_clock::now()};
+    eagine::msgbus::session_mac_keys old_sender;
+    eagine::msgbus::session_mac_keys new_sender;
+    eagine::msgbus::session_mac_keys receiver{
+      std::chrono::seconds{10}, std::chrono::seconds{30}};
+    session_test_share(old_sender, receiver, session_test_make_key(0x44U), now);
+
+    const auto data{eagine::as_bytes(std::string_view{"rotated content"})};
+    session_test_mac old_mac{};
+    const auto old_sig{old_sender.sign(data, session_test_cover(old_mac))};
+    test.check(receiver.verify(data, old_sig, now), "old before rotation");
+
+    // the receiver makes a new key, the old one is kept for the grace period
+    const auto rotated{now + std::chrono::seconds{1}};
+    session_test_share(
+      new_sender, receiver, session_test_make_key(0x55U), rotated);
+    session_test_mac new_mac{};
+    const auto new_sig{new_sender.sign(data, session_test_cover(new_mac))};
+    test.check(receiver.verify(data, new_sig, rotated), "new after rotation");
+    test.check(receiver.verify(data, old_sig, rotated), "old in grace period");
+
+    const auto expired{rotated + std::chrono::seconds{11}};
+    test.check(receiver.verify(data, new_sig, expired), "new after grace");
+    test.check(not receiver.verify(data, old_sig, expired), "old after grace");
+
+    // re-nonce retires the current key, it is still valid for a while
+    receiver.retire_verify_key(expired);
+    test.check(receiver.has_verify_key(expired), "retired in grace period");
+    test.check(receiver.verify(data, new_sig, expired), "retired verified");
+
+    const auto gone{expired + std::chrono::seconds{11}};
+    test.check(not receiver.has_verify_key(gone), "retired after grace");
+    test.check(not receiver.verify(data, new_sig, gone), "retired rejected");
+}
+//------------------------------------------------------------------------------
+// main
+//------------------------------------------------------------------------------
+auto test_main(eagine::test_ctx& ctx) -> int {
+    eagitest::ctx_suite test{ctx, "context", 3};
+    test.once(session_mac_roundtrip);
+    test.once(session_mac_forged_key);
+    test.once(session_mac_rotation);
+    return test.exit_code();
+}
+//------------------------------------------------------------------------------
+auto main(int argc, const char** argv) -> int {
+    return eagine::test_main_impl(argc, argv, test_main);
+}
+//------------------------------------------------------------------------------
+#include <eagine/testing/unit_end_ctx.hpp>
@@ -8,10 +8,15 @@
 export module eagine.msgbus.core;
 
 export import :types;
+export import :timer_wheel;
+export import :endpoint_index;
 export import :future;
 export import :handler_map;
 export import :message;
+export import :trace;
 export import :context;
+export import :wait;
+export import :datagram;
 export import :interface;
 export import :router_address;
 export import :blobs;
@@ -0,0 +1,480 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+export module eagine.msgbus.core:datagram;
+
+import std;
+import eagine.core.types;
+import eagine.core.memory;
+import eagine.core.container;
+
+namespace eagine::msgbus {
+//------------------------------------------------------------------------------
+/// @brief Indicates if sequence number l precedes r, with wrap-around.
+/// @ingroup msgbus
+export constexpr auto datagram_sequence_before(
+  const std::uint32_t l,
+  const std::uint32_t r) noexcept -> bool {
+    return std::int32_t(l - r) < 0;
+}
+//------------------------------------------------------------------------------
+/// @brief Header of the datagrams sent in the reliable mode.
+/// @ingroup msgbus
+/// @see reliable_datagram_peer
+///
+/// Layout: [0] marker, [1] flags, [2] version, [3] reserved,
+/// [4-7] sequence number of the contained data,
+/// [8-11] the next expected sequence number from the peer,
+/// [12-19] bits of selectively acknowledged sequence numbers after that.
+export struct reliable_datagram_header {
+    static constexpr const span_size_t size{20};
+    static constexpr const byte marker{0xD7U};
+    static constexpr const byte version{0x01U};
+
+    static constexpr const std::uint8_t has_data{0x01U};
+    static constexpr const std::uint8_t has_ack{0x02U};
+    static constexpr const std::uint8_t new_stream{0x04U};
+    static constexpr const std::uint8_t all_flags{0x07U};
+
+    std::uint8_t flags{0U};
+    std::uint32_t sequence_no{0U};
+    std::uint32_t ack_next{0U};
+    std::uint64_t ack_bits{0U};
+
+    auto has(const std::uint8_t flag) const noexcept -> bool {
+        return (flags & flag) != 0U;
+    }
+
+    /// @brief Writes the header to the start of the destination block.
+    void write(memory::block dst) const noexcept {
+        dst[0] = marker;
+        dst[1] = byte(flags);
+        dst[2] = version;
+        dst[3] = byte{0U};
+        _put(dst, 4, sequence_no, 4);
+        _put(dst, 8, ack_next, 4);
+        _put(dst, 12, ack_bits, 8);
+    }
+
+    /// @brief Reads the header, returns false if the block does not start with one.
+    auto read(const memory::const_block src) noexcept -> bool {
+        // in packed message blocks the first size prefix byte is followed by
+        // a continuation byte, that is never a valid combination of flags
+        if(
+          (src.size() < size) or (src[0] != marker) or (src[2] != version) or
+          (src[3] != byte{0U}) or ((std::uint8_t(src[1]) & ~all_flags) != 0U)) {
+            return false;
+        }
+        flags = std::uint8_t(src[1]);
+        sequence_no = std::uint32_t(_get(src, 4, 4));
+        ack_next = std::uint32_t(_get(src, 8, 4));
+        ack_bits = _get(src, 12, 8);
+        return true;
+    }
+
+private:
+    static void _put(
+      memory::block dst,
+      const span_size_t offs,
+      const std::uint64_t value,
+      const span_size_t len) noexcept {
+        for(span_size_t i = 0; i < len; ++i) {
+            dst[offs + i] = byte((value >> (8U * unsigned(i))) & 0xFFU);
+        }
+    }
+
+    static auto _get(
+      const memory::const_block src,
+      const span_size_t offs,
+      const span_size_t len) noexcept -> std::uint64_t {
+        std::uint64_t value{0U};
+        for(span_size_t i = 0; i < len; ++i) {
+            value |= std::uint64_t(src[offs + i]) << (8U * unsigned(i));
+        }
+        return value;
+    }
+};
+//------------------------------------------------------------------------------
+/// @brief Sequencing, acknowledgement and retransmission state of a peer.
+/// @ingroup msgbus
+/// @see reliable_datagram_header
+/// @see reliable_datagram_peers
+///
+/// The reliable mode is negotiated with each peer separately. A side
+/// offering it sends the datagrams with headers, until the peer keeps
+/// answering with plain datagrams. The datagrams with headers are always
+/// answered in kind.
+export class reliable_datagram_peer {
+public:
+    using clock_type = std::chrono::steady_clock;
+    using clock_time = typename clock_type::time_point;
+
+    /// @brief Number of plain datagrams after which the headers are dropped.
+    static constexpr const span_size_t plain_limit{4};
+
+    /// @brief Returns an initial sequence number differing between streams.
+    static auto make_initial_sequence() noexcept -> std::uint32_t {
+        // restarted senders do not start at the same sequence number
+        static std::atomic<std::uint32_t> next{std::uint32_t(
+          std::uint64_t(clock_type::now().time_since_epoch().count()) *
+          2654435761U)};
+        return next.fetch_add(0x01000193U);
+    }
+
+    reliable_datagram_peer(
+      const std::uint32_t initial_sequence = make_initial_sequence(),
+      const clock_time now = clock_type::now()) noexcept
+      : _last_heard{now}
+      , _send_next{initial_sequence} {}
+
+    /// @brief Indicates if the datagrams to this peer should carry headers.
+    auto uses_headers(const bool offered) const noexcept -> bool {
+        return _peer_reliable or (offered and not _peer_plain);
+    }
+
+    /// @brief Indicates if the peer sent a datagram with a header.
+    auto is_reliable() const noexcept -> bool {
+        return _peer_reliable;
+    }
+
+    /// @brief Handles a datagram without a header received from the peer.
+    void handle_plain(const clock_time now) noexcept {
+        _last_heard = now;
+        // the plain datagrams sent before ours arrived do not count
+        if(_headers_sent and not _peer_reliable) {
+            _peer_plain = ++_plain_count >= plain_limit;
+        }
+    }
+
+    /// @brief Returns the time the peer was last heard from.
+    auto last_heard() const noexcept -> clock_time {
+        return _last_heard;
+    }
+
+    auto unacked_count() const noexcept -> span_size_t {
+        return span_size(_unacked.size());
+    }
+
+    auto is_window_full(const span_size_t window) const noexcept -> bool {
+        return unacked_count() >= window;
+    }
+
+    auto has_pending_ack() const noexcept -> bool {
+        return _ack_pending and _recv_synced;
+    }
+
+    auto retransmitted_count() const noexcept -> span_size_t {
+        return _retransmitted;
+    }
+
+    auto lost_count() const noexcept -> span_size_t {
+        return _lost;
+    }
+
+    /// @brief Fills the header of the next sent datagram with data.
+    void make_data_header(reliable_datagram_header& header) noexcept {
+        header.flags = reliable_datagram_header::has_data;
+        if(_new_stream) [[unlikely]] {
+            header.flags |= reliable_datagram_header::new_stream;
+            _new_stream = false;
+        }
+        header.sequence_no = _send_next++;
+        _headers_sent = true;
+        make_ack(header);
+    }
+
+    /// @brief Adds the acknowledgement of the received data to the header.
+    void make_ack(reliable_datagram_header& header) noexcept {
+        if(_recv_synced) {
+            header.flags |= reliable_datagram_header::has_ack;
+            header.ack_next = _recv_next;
+            header.ack_bits = 0U;
+            for(const auto seq : _recv_ahead) {
+                const auto bit{seq - _recv_next - 1U};
+                if(bit < 64U) {
+                    header.ack_bits |= std::uint64_t(1U) << bit;
+                }
+            }
+            _ack_pending = false;
+        }
+    }
+
+    /// @brief Keeps a copy of the sent datagram until it is acknowledged.
+    void register_sent(
+      const memory::const_block datagram,
+      const std::uint32_t sequence_no,
+      const clock_time now) noexcept {
+        auto buf{_buffers.get(datagram.size())};
+        memory::copy_into(datagram, buf);
+        _unacked.push_back({std::move(buf), now, sequence_no});
+    }
+
+    /// @brief Handles the acknowledgement in a received header.
+    void handle_ack(
+      const reliable_datagram_header& header,
+      const clock_time now) noexcept {
+        _heard(now);
+        const auto is_acked{[&](const std::uint32_t seq) {
+            if(datagram_sequence_before(seq, header.ack_next)) {
+                return true;
+            }
+            const auto bit{seq - header.ack_next - 1U};
+            return (bit < 64U) and (((header.ack_bits >> bit) & 1U) != 0U);
+        }};
+        // datagrams sent before the last selectively acknowledged one
+        // that are not acknowledged are considered lost
+        const auto last_acked{
+          header.ack_bits ? header.ack_next + 64U -
+                              unsigned(std::countl_zero(header.ack_bits))
+                          : header.ack_next};
+        for(auto& sent : _unacked) {
+            if(sent.acked) {
+                continue;
+            }
+            if(is_acked(sent.sequence_no)) {
+                sent.acked = true;
+                if(sent.retries == 0) {
+                    _update_rtt(now - sent.sent_time);
+                }
+            } else if(
+              datagram_sequence_before(sent.sequence_no, last_acked) and
+              (now - sent.sent_time >= _srtt)) {
+                sent.nacked = true;
+            }
+        }
+        _pop_acked();
+    }
+
+    /// @brief Handles the data header, returns if the data should be delivered.
+    auto handle_data(
+      const reliable_datagram_header& header,
+      const clock_time now = clock_type::now()) noexcept -> bool {
+        _heard(now);
+        const auto seq{header.sequence_no};
+        _ack_pending = true;
+        if(header.has(reliable_datagram_header::new_stream)) {
+            if(not _recv_synced or (seq != _stream_start)) {
+                _recv_synced = true;
+                _stream_start = seq;
+                _recv_next = seq;
+                std::erase_if(_recv_ahead, [seq](const auto ahead) {
+                    return datagram_sequence_before(ahead, seq);
+                });
+            }
+        } else if(not _recv_synced) [[unlikely]] {
+            // the start of the stream was not received yet
+            return _recv_ahead.insert(seq).second;
+        }
+        if(datagram_sequence_before(seq, _recv_next)) {
+            return false;
+        }
+        if(seq == _recv_next) {
+            ++_recv_next;
+            while(_recv_ahead.erase(_recv_next) > 0) {
+                ++_recv_next;
+            }
+            return true;
+        }
+        return _recv_ahead.insert(seq).second;
+    }
+
+    /// @brief Calls the function on the datagrams that should be resent.
+    template <typename Function>
+    void retransmit(
+      const clock_time now,
+      const span_size_t max_retries,
+      Function func) noexcept {
+        for(auto& sent : _unacked) {
+            if(sent.acked) {
+                continue;
+            }
+            const auto backoff{1 << std::min(sent.retries, span_size(6))};
+            if(sent.nacked or (now - sent.sent_time >= _rto * backoff)) {
+                if(sent.retries >= max_retries) [[unlikely]] {
+                    // the peer is probably gone, start a new stream
+                    sent.acked = true;
+                    _new_stream = true;
+                    ++_lost;
+                    continue;
+                }
+                if(not func(view(sent.data))) {
+                    break;
+                }
+                sent.sent_time = now;
+                sent.nacked = false;
+                ++sent.retries;
+                ++_retransmitted;
+            }
+        }
+        _pop_acked();
+    }
+
+    /// @brief Calls the function on the payloads of all unacknowledged datagrams.
+    /// @note Used after the peer turned out not to understand the headers.
+    template <typename Function>
+    void drain_unacked(Function func) noexcept {
+        while(not _unacked.empty()) {
+            auto& sent{_unacked.front()};
+            if(not sent.acked) {
+                const auto payload{
+                  skip(view(sent.data), reliable_datagram_header::size)};
+                if(not func(payload)) {
+                    break;
+                }
+            }
+            _buffers.eat(std::move(sent.data));
+            _unacked.pop_front();
+        }
+    }
+
+private:
+    struct sent_datagram {
+        memory::buffer data;
+        clock_time sent_time;
+        std::uint32_t sequence_no{0U};
+        span_size_t retries{0};
+        bool acked{false};
+        bool nacked{false};
+    };
+
+    void _heard(const clock_time now) noexcept {
+        _last_heard = now;
+        _peer_reliable = true;
+        _peer_plain = false;
+        _plain_count = 0;
+    }
+
+    void _pop_acked() noexcept {
+        while(not _unacked.empty() and _unacked.front().acked) {
+            _buffers.eat(std::move(_unacked.front().data));
+            _unacked.pop_front();
+        }
+    }
+
+    void _update_rtt(const clock_type::duration sample) noexcept {
+        _srtt = (_srtt == clock_type::duration::zero())
+                  ? sample
+                  : (_srtt * 7 + sample) / 8;
+        _rto = std::clamp<clock_type::duration>(
+          _srtt * 2, std::chrono::milliseconds{2}, std::chrono::seconds{1});
+    }
+
+    memory::buffer_pool _buffers;
+    std::deque<sent_datagram> _unacked;
+    flat_set<std::uint32_t> _recv_ahead;
+    clock_type::duration _srtt{clock_type::duration::zero()};
+    clock_type::duration _rto{std::chrono::milliseconds{50}};
+    clock_time _last_heard;
+    span_size_t _retransmitted{0};
+    span_size_t _lost{0};
+    span_size_t _plain_count{0};
+    std::uint32_t _send_next{0U};
+    std::uint32_t _recv_next{0U};
+    std::uint32_t _stream_start{0U};
+    bool _new_stream{true};
+    bool _recv_synced{false};
+    bool _ack_pending{false};
+    bool _headers_sent{false};
+    bool _peer_reliable{false};
+    bool _peer_plain{false};
+};
+//------------------------------------------------------------------------------
+/// @brief The reliable datagram states of the peers of a socket.
+/// @ingroup msgbus
+/// @see reliable_datagram_peer
+///
+/// The peers that were not heard from for the idle timeout are evicted.
+export template <typename Endpoint>
+class reliable_datagram_peers {
+public:
+    using clock_type = reliable_datagram_peer::clock_type;
+    using clock_time = reliable_datagram_peer::clock_time;
+
+    /// @brief Sets the duration after which silent peers are evicted.
+    void set_idle_timeout(const clock_type::duration idle_timeout) noexcept {
+        _idle_timeout = idle_timeout;
+    }
+
+    /// @brief Returns the state of the specified peer, adding it if necessary.
+    auto get(const Endpoint& ep, const clock_time now = clock_type::now())
+      -> reliable_datagram_peer& {
+        auto pos{_peers.find(ep)};
+        if(pos == _peers.end()) {
+            pos = _peers
+                    .try_emplace(
+                      ep, reliable_datagram_peer::make_initial_sequence(), now)
+                    .first;
+        }
+        return std::get<1>(*pos);
+    }
+
+    /// @brief Returns the state of the specified peer if it exists.
+    auto find(const Endpoint& ep) noexcept -> reliable_datagram_peer* {
+        const auto pos{_peers.find(ep)};
+        return pos != _peers.end() ? &std::get<1>(*pos) : nullptr;
+    }
+
+    auto count() const noexcept -> span_size_t {
+        return span_size(_peers.size());
+    }
+
+    /// @brief Indicates if any of the peers sent datagrams with headers.
+    auto has_reliable() const noexcept -> bool {
+        return std::any_of(_peers.begin(), _peers.end(), [](const auto& entry) {
+            return std::get<1>(entry).is_reliable();
+        });
+    }
+
+    template <typename Function>
+    void for_each(Function func) noexcept {
+        for(auto& [ep, peer] : _peers) {
+            func(ep, peer);
+        }
+    }
+
+    /// @brief Removes the peers not heard from for the idle timeout.
+    auto evict_idle(const clock_time now = clock_type::now()) noexcept
+      -> span_size_t {
+        const auto before{_peers.size()};
+        _peers.erase_if([&](const auto& entry) {
+            const auto& peer{std::get<1>(entry)};
+            if(now - peer.last_heard() > _idle_timeout) {
+                _retransmitted += peer.retransmitted_count();
+                _lost += peer.lost_count() + peer.unacked_count();
+                return true;
+            }
+            return false;
+        });
+        return span_size(before - _peers.size());
+    }
+
+    /// @brief Returns the number of resent datagrams, including evicted peers.
+    auto retransmitted_count() const noexcept -> span_size_t {
+        auto result{_retransmitted};
+        for(const auto& [ep, peer] : _peers) {
+            result += peer.retransmitted_count();
+        }
+        return result;
+    }
+
+    /// @brief Returns the number of lost datagrams, including evicted peers.
+    auto lost_count() const noexcept -> span_size_t {
+        auto result{_lost};
+        for(const auto& [ep, peer] : _peers) {
+            result += peer.lost_count();
+        }
+        return result;
+    }
+
+private:
+    flat_map<Endpoint, reliable_datagram_peer> _peers;
+    clock_type::duration _idle_timeout{std::chrono::seconds{60}};
+    span_size_t _retransmitted{0};
+    span_size_t _lost{0};
+};
+//------------------------------------------------------------------------------
+} // namespace eagine::msgbus
@@ -0,0 +1,372 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+
+#include <eagine/testing/unit_begin_ctx.hpp>
+import std;
+import eagine.core;
+import eagine.msgbus.core;
+//------------------------------------------------------------------------------
+using datagram_test_clock = eagine::msgbus::reliable_datagram_peer::clock_type;
+using datagram_test_time = eagine::msgbus::reliable_datagram_peer::clock_time;
+using datagram_test_buffer = std::array<eagine::byte, 24>;
+//------------------------------------------------------------------------------
+auto datagram_test_block(datagram_test_buffer& buf) -> eagine::memory::block {
+    return {buf.data(), eagine::span_size(buf.size())};
+}
+//------------------------------------------------------------------------------
+// sends a datagram with a header and one byte of payload
+auto datagram_test_send(
+  eagine::msgbus::reliable_datagram_peer& sender,
+  const datagram_test_time now) -> eagine::msgbus::reliable_datagram_header {
+    eagine::msgbus::reliable_datagram_header header{};
+    sender.make_data_header(header);
+    datagram_test_buffer buf{};
+    const auto blk{datagram_test_block(buf)};
+    header.write(blk);
+    blk[eagine::msgbus::reliable_datagram_header::size] =
+      eagine::byte(header.sequence_no & 0xFFU);
+    sender.register_sent(
+      eagine::head(blk, eagine::msgbus::reliable_datagram_header::size + 1),
+      header.sequence_no,
+      now);
+    return header;
+}
+//------------------------------------------------------------------------------
+auto datagram_test_ack(eagine::msgbus::reliable_datagram_peer& receiver)
+  -> eagine::msgbus::reliable_datagram_header {
+    eagine::msgbus::reliable_datagram_header header{};
+    receiver.make_ack(header);
+    return header;
+}
+//------------------------------------------------------------------------------
+// header
+//------------------------------------------------------------------------------
+void datagram_header_roundtrip(auto& s) {
+    eagitest::case_ test{s, 1, "header roundtrip"};
+    using header_t = eagine::msgbus::reliable_datagram_header;
+    header_t header{};
+    header.flags = header_t::has_data | header_t::has_ack;
+    header.sequence_no = 0xFEDCBA98U;
+    header.ack_next = 0x01234567U;
+    header.ack_bits = 0x8000'0000'0000'0001U;
+
+    datagram_test_buffer buf{};
+    const auto blk{datagram_test_block(buf)};
+    header.write(blk);
+
+    header_t read{};
+    test.check(read.read(blk), "read");
+    test.check(read.has(header_t::has_data), "has data");
+    test.check(read.has(header_t::has_ack), "has ack");
+    test.check(not read.has(header_t::new_stream), "not new stream");
+    test.check_equal(read.sequence_no, header.sequence_no, "sequence");
+    test.check_equal(read.ack_next, header.ack_next, "ack next");
+    test.check_equal(read.ack_bits, header.ack_bits, "ack bits");
+
+    test.check(
+      not read.read(eagine::head(blk, header_t::size - 1)), "too short");
+    blk[1] = eagine::byte{0x80U};
+    test.check(not read.read(blk), "invalid flags");
+    blk[1] = eagine::byte{0x01U};
+    blk[2] = eagine::byte{0x02U};
+    test.check(not read.read(blk), "other version");
+    blk[2] = eagine::byte{0x01U};
+    blk[0] = eagine::byte{0x00U};
+    test.check(not read.read(blk), "no marker");
+}
+//------------------------------------------------------------------------------
+// in order
+//------------------------------------------------------------------------------
+void datagram_in_order(auto& s) {
+    eagitest::case_ test{s, 2, "in order"};
+    const auto now{datagram_test_clock::now()};
+    eagine::msgbus::reliable_datagram_peer sender{1000U, now};
+    eagine::msgbus::reliable_datagram_peer receiver{2000U, now};
+
+    for(std::uint32_t i = 0; i < 10; ++i) {
+        const auto header{datagram_test_send(sender, now)};
+        test.check_equal(header.sequence_no, 1000U + i, "sequence");
+        test.check_equal(
+          header.has(eagine::msgbus::reliable_datagram_header::new_stream),
+          i == 0U,
+          "new stream");
+        test.check(receiver.handle_data(header, now), "delivered");
+    }
+    test.check_equal(sender.unacked_count(), eagine::span_size(10), "unacked");
+    test.check(receiver.has_pending_ack(), "pending ack");
+
+    const auto ack{datagram_test_ack(receiver)};
+    test.check(not receiver.has_pending_ack(), "no pending ack");
+    test.check_equal(ack.ack_next, 1010U, "ack next");
+    test.check_equal(ack.ack_bits, std::uint64_t(0U), "ack bits");
+
+    sender.handle_ack(ack, now + std::chrono::milliseconds{5});
+    test.check_equal(sender.unacked_count(), eagine::span_size(0), "acked");
+
+    std::size_t resent{0U};
+    sender.retransmit(now + std::chrono::seconds{10}, 10, [&](auto) {
+        ++resent;
+        return true;
+    });
+    test.check_equal(resent, std::size_t(0), "nothing resent");
+}
+//------------------------------------------------------------------------------
+// loss
+//------------------------------------------------------------------------------
+void datagram_loss(auto& s) {
+    eagitest::case_ test{s, 3, "loss"};
+    using header_t = eagine::msgbus::reliable_datagram_header;
+    const auto now{datagram_test_clock::now()};
+    eagine::msgbus::reliable_datagram_peer sender{0xFFFFFFFEU, now};
+    eagine::msgbus::reliable_datagram_peer receiver{0U, now};
+
+    // the sequence numbers wrap around, the second datagram gets lost
+    std::vector<header_t> sent;
+    for(int i = 0; i < 4; ++i) {
+        sent.push_back(datagram_test_send(sender, now));
+    }
+    test.check(receiver.handle_data(sent[0], now), "delivered 0");
+    test.check(receiver.handle_data(sent[2], now), "delivered 2");
+    test.check(receiver.handle_data(sent[3], now), "delivered 3");
+
+    const auto ack{datagram_test_ack(receiver)};
+    test.check_equal(ack.ack_next, 0xFFFFFFFFU, "ack next");
+    test.check_equal(ack.ack_bits, std::uint64_t(0b11U), "ack bits");
+
+    // the later datagrams are acknowledged so the missing one is resent
+    const auto later{now + std::chrono::milliseconds{10}};
+    sender.handle_ack(ack, later);
+    test.check_equal(sender.unacked_count(), eagine::span_size(3), "unacked");
+
+    std::vector<header_t> resent;
+    sender.retransmit(later, 10, [&](eagine::memory::const_block blk) {
+        header_t header{};
+        test.check(header.read(blk), "header");
+        test.check_equal(blk.size(), header_t::size + 1, "size");
+        resent.push_back(header);
+        return true;
+    });
+    test.ensure(resent.size() == 1U, "resent one");
+    test.check_equal(resent[0].sequence_no, 0xFFFFFFFFU, "resent sequence");
+    test.check_equal(sender.retransmitted_count(), eagine::span_size(1), "count");
+
+    test.check(receiver.handle_data(resent[0], later), "delivered 1");
+    const auto ack2{datagram_test_ack(receiver)};
+    test.check_equal(ack2.ack_next, 2U, "ack next wrapped");
+    test.check_equal(ack2.ack_bits, std::uint64_t(0U), "no ack bits");
+    sender.handle_ack(ack2, later);
+    test.check_equal(sender.unacked_count(), eagine::span_size(0), "acked");
+    test.check_equal(sender.lost_count(), eagine::span_size(0), "not lost");
+}
+//------------------------------------------------------------------------------
+// reordering
+//------------------------------------------------------------------------------
+void datagram_reordering(auto& s) {
+    eagitest::case_ test{s, 4, "reordering"};
+    using header_t = eagine::msgbus::reliable_datagram_header;
+    const auto now{datagram_test_clock::now()};
+    eagine::msgbus::reliable_datagram_peer sender{500U, now};
+    eagine::msgbus::reliable_datagram_peer receiver{0U, now};
+
+    std::vector<header_t> sent;
+    for(int i = 0; i < 5; ++i) {
+        sent.push_back(datagram_test_send(sender, now));
+    }
+    // nothing is acknowledged until the start of the stream arrives
+    test.check(receiver.handle_data(sent[2], now), "delivered 2");
+    test.check(not receiver.has_pending_ack(), "not synced");
+    test.check(not receiver.handle_data(sent[2], now), "duplicate 2");
+    test.check(receiver.handle_data(sent[4], now), "delivered 4");
+    test.check(receiver.handle_data(sent[0], now), "delivered 0");
+    test.check(receiver.has_pending_ack(), "synced");
+
+    const auto ack{datagram_test_ack(receiver)};
+    test.check_equal(ack.ack_next, 501U, "ack next");
+    test.check_equal(ack.ack_bits, std::uint64_t(0b101U), "ack bits");
+
+    test.check(not receiver.handle_data(sent[0], now), "duplicate 0");
+    test.check(receiver.handle_data(sent[1], now), "delivered 1");
+    test.check(receiver.handle_data(sent[3], now), "delivered 3");
+    test.check(not receiver.handle_data(sent[4], now), "duplicate 4");
+    test.check(not receiver.handle_data(sent[1], now), "duplicate 1");
+
+    const auto ack2{datagram_test_ack(receiver)};
+    test.check_equal(ack2.ack_next, 505U, "all acked");
+    test.check_equal(ack2.ack_bits, std::uint64_t(0U), "no ack bits");
+
+    sender.handle_ack(ack2, now);
+    test.check_equal(sender.unacked_count(), eagine::span_size(0), "acked");
+}
+//------------------------------------------------------------------------------
+// new stream
+//------------------------------------------------------------------------------
+void datagram_new_stream(auto& s) {
+    eagitest::case_ test{s, 5, "new stream"};
+    using header_t = eagine::msgbus::reliable_datagram_header;
+    const auto now{datagram_test_clock::now()};
+    eagine::msgbus::reliable_datagram_peer receiver{0U, now};
+
+    {
+        eagine::msgbus::reliable_datagram_peer sender{100U, now};
+        for(int i = 0; i < 3; ++i) {
+            test.check(
+              receiver.handle_data(datagram_test_send(sender, now), now),
+              "delivered old");
+        }
+    }
+    test.check_equal(datagram_test_ack(receiver).ack_next, 103U, "old stream");
+
+    // the sender restarted with a different initial sequence number
+    // and the first datagram of the new stream arrives late
+    eagine::msgbus::reliable_datagram_peer sender{5000U, now};
+    const auto first{datagram_test_send(sender, now)};
+    const auto second{datagram_test_send(sender, now)};
+    test.check(first.has(header_t::new_stream), "new stream");
+    test.check(not second.has(header_t::new_stream), "same stream");
+
+    test.check(receiver.handle_data(second, now), "delivered second");
+    test.check(receiver.handle_data(first, now), "delivered first");
+    test.check(not receiver.handle_data(second, now), "duplicate second");
+    test.check(not receiver.handle_data(first, now), "duplicate first");
+
+    const auto ack{datagram_test_ack(receiver)};
+    test.check_equal(ack.ack_next, 5002U, "ack next");
+    test.check_equal(ack.ack_bits, std::uint64_t(0U), "ack bits");
+    sender.handle_ack(ack, now);
+    test.check_equal(sender.unacked_count(), eagine::span_size(0), "acked");
+
+    test.check(
+      eagine::msgbus::reliable_datagram_peer::make_initial_sequence() !=
+        eagine::msgbus::reliable_datagram_peer::make_initial_sequence(),
+      "different initial sequences");
+}
+//------------------------------------------------------------------------------
+// give up
+//------------------------------------------------------------------------------
+void datagram_give_up(auto& s) {
+    eagitest::case_ test{s, 6, "give up"};
+    using header_t = eagine::msgbus::reliable_datagram_header;
+    auto now{datagram_test_clock::now()};
+    eagine::msgbus::reliable_datagram_peer sender{7U, now};
+
+    datagram_test_send(sender, now);
+    std::size_t resent{0U};
+    for(int i = 0; i < 5; ++i) {
+        now += std::chrono::seconds{100};
+        sender.retransmit(now, 3, [&](auto) {
+            ++resent;
+            return true;
+        });
+    }
+    test.check_equal(resent, std::size_t(3), "resent");
+    test.check_equal(sender.lost_count(), eagine::span_size(1), "lost");
+    test.check_equal(sender.unacked_count(), eagine::span_size(0), "dropped");
+
+    // the peer must resynchronize
+    const auto header{datagram_test_send(sender, now)};
+    test.check(header.has(header_t::new_stream), "new stream");
+    test.check_equal(header.sequence_no, 8U, "sequence");
+}
+//------------------------------------------------------------------------------
+// negotiation
+//------------------------------------------------------------------------------
+void datagram_negotiation(auto& s) {
+    eagitest::case_ test{s, 7, "negotiation"};
+    const auto now{datagram_test_clock::now()};
+
+    eagine::msgbus::reliable_datagram_peer offering{10U, now};
+    test.check(offering.uses_headers(true), "offered");
+    test.check(not offering.uses_headers(false), "not offered");
+
+    // the plain datagrams sent before any header do not count
+    for(int i = 0; i < 10; ++i) {
+        offering.handle_plain(now);
+    }
+    test.check(offering.uses_headers(true), "still offered");
+
+    // the other side understands the headers and answers in kind
+    eagine::msgbus::reliable_datagram_peer answering{20U, now};
+    test.check(
+      answering.handle_data(datagram_test_send(offering, now), now), "data");
+    test.check(answering.is_reliable(), "reliable");
+    test.check(answering.uses_headers(false), "answered in kind");
+
+    // an old peer keeps sending plain datagrams
+    eagine::msgbus::reliable_datagram_peer old_peer{30U, now};
+    datagram_test_send(old_peer, now);
+    datagram_test_send(old_peer, now);
+    const auto limit{eagine::msgbus::reliable_datagram_peer::plain_limit};
+    for(eagine::span_size_t i = 1; i < limit; ++i) {
+        old_peer.handle_plain(now);
+        test.check(old_peer.uses_headers(true), "not yet downgraded");
+    }
+    old_peer.handle_plain(now);
+    test.check(not old_peer.uses_headers(true), "downgraded");
+
+    std::vector<eagine::byte> payloads;
+    old_peer.drain_unacked([&](eagine::memory::const_block blk) {
+        test.check_equal(blk.size(), eagine::span_size(1), "payload only");
+        payloads.push_back(blk[0]);
+        return true;
+    });
+    test.check_equal(payloads.size(), std::size_t(2), "drained");
+    test.check(payloads[0] == eagine::byte(30U), "payload 0");
+    test.check(payloads[1] == eagine::byte(31U), "payload 1");
+    test.check_equal(old_peer.unacked_count(), eagine::span_size(0), "empty");
+}
+//------------------------------------------------------------------------------
+// eviction
+//------------------------------------------------------------------------------
+void datagram_evict_idle(auto& s) {
+    eagitest::case_ test{s, 8, "evict idle"};
+    const auto now{datagram_test_clock::now()};
+    eagine::msgbus::reliable_datagram_peers<int> peers;
+    peers.set_idle_timeout(std::chrono::seconds{10});
+
+    datagram_test_send(peers.get(1, now), now);
+    peers.get(2, now);
+    peers.get(3, now);
+    test.check_equal(peers.count(), eagine::span_size(3), "three");
+    test.check(peers.find(4) == nullptr, "not found");
+
+    peers.find(2)->handle_plain(now + std::chrono::seconds{8});
+    test.check_equal(
+      peers.evict_idle(now + std::chrono::seconds{5}),
+      eagine::span_size(0),
+      "none evicted");
+    test.check_equal(
+      peers.evict_idle(now + std::chrono::seconds{12}),
+      eagine::span_size(2),
+      "two evicted");
+    test.check_equal(peers.count(), eagine::span_size(1), "one");
+    test.check(peers.find(1) == nullptr, "evicted 1");
+    test.check(peers.find(2) != nullptr, "kept 2");
+    test.check(peers.find(3) == nullptr, "evicted 3");
+    test.check_equal(peers.lost_count(), eagine::span_size(1), "lost");
+}
+//------------------------------------------------------------------------------
+// main
+//------------------------------------------------------------------------------
+auto test_main(eagine::test_ctx& ctx) -> int {
+    eagitest::ctx_suite test{ctx, "reliable datagrams", 8};
+    test.once(datagram_header_roundtrip);
+    test.once(datagram_in_order);
+    test.once(datagram_loss);
+    test.once(datagram_reordering);
+    test.once(datagram_new_stream);
+    test.once(datagram_give_up);
+    test.once(datagram_negotiation);
+    test.once(datagram_evict_idle);
+    return test.exit_code();
+}
+//------------------------------------------------------------------------------
+auto main(int argc, const char** argv) -> int {
+    return eagine::test_main_impl(argc, argv, test_main);
+}
+//------------------------------------------------------------------------------
+#include <eagine/testing/unit_end_ctx.hpp>
@@ -21,9 +21,69 @@ import eagine.core.main_ctx;
 import :types;
 import :message;
 import :interface;
+import :wait;
 
 namespace eagine::msgbus {
 //------------------------------------------------------------------------------
+/// @brief Lets the receiving side of a direct connection wait for messages.
+/// @ingroup msgbus
+/// @note Implementation detail. Do not use directly.
+class direct_connection_signal {
+public:
+    /// @brief Notifies the waiting side, if any, that a message was sent.
+    void notify() noexcept {
+        _pending = true;
+        if(_waiting > 0) [[unlikely]] {
+            // locking prevents losing the notification between
+            // the check of the predicate and the wait
+            const std::unique_lock lock{_mutex};
+            _condition.notify_all();
+        }
+        if(_polled) [[unlikely]] {
+            _signal.notify();
+        }
+    }
+
+    /// @brief Waits until a message is sent or the timeout expires.
+    auto wait_for(const std::chrono::steady_clock::duration timeout) noexcept
+      -> bool {
+        ++_waiting;
+        std::unique_lock lock{_mutex};
+        const bool result{
+          _condition.wait_for(lock, timeout, [this] { return bool(_pending); })};
+        --_waiting;
+        _pending = false;
+        return result;
+    }
+
+    /// @brief Returns the native handle that becomes readable on notification.
+    /// The native signal is used only after the handle was requested.
+    auto wait_handle() noexcept -> work_wait_handle {
+        if(not _polled.exchange(true)) [[unlikely]] {
+            if(_pending) {
+                _signal.notify();
+            }
+        }
+        return _signal.wait_handle();
+    }
+
+    /// @brief Clears the notification before the sent messages are processed.
+    void clear() noexcept {
+        _pending = false;
+        if(_polled) [[unlikely]] {
+            _signal.clear();
+        }
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    work_signal _signal;
+    std::atomic<bool> _pending{false};
+    std::atomic<bool> _polled{false};
+    std::atomic<int> _waiting{0};
+};
+//------------------------------------------------------------------------------
 /// @brief Common shared state for a direct connection.
 /// @ingroup msgbus
 /// @note Implementation detail. Do not use directly.
@@ -60,8 +120,11 @@ public:
     void send_to_server(
       const message_id msg_id,
       const message_view& message) noexcept {
-        const std::unique_lock lock{_client_to_server_lock};
-        _client_to_server.next().push(msg_id, message);
+        {
+            const std::unique_lock lock{_client_to_server_lock};
+            _client_to_server.next().push(msg_id, message);
+        }
+        _client_to_server_signal.notify();
     }
 
     /// @brief Sends a message to the client counterpart.
@@ -69,16 +132,42 @@ public:
       const message_id msg_id,
       const message_view& message) noexcept -> bool {
         if(_client_connected) [[likely]] {
-            const std::unique_lock lock{_server_to_client_lock};
-            _server_to_client.next().push(msg_id, message);
+            {
+                const std::unique_lock lock{_server_to_client_lock};
+                _server_to_client.next().push(msg_id, message);
+            }
+            _server_to_client_signal.notify();
             return true;
         }
         return false;
     }
 
+    /// @brief Waits until the client counterpart sends a message or timeout.
+    auto wait_for_client(
+      const std::chrono::steady_clock::duration timeout) noexcept -> bool {
+        return _client_to_server_signal.wait_for(timeout);
+    }
+
+    /// @brief Waits until the server counterpart sends a message or timeout.
+    auto wait_for_server(
+      const std::chrono::steady_clock::duration timeout) noexcept -> bool {
+        return _server_to_client_signal.wait_for(timeout);
+    }
+
+    /// @brief Returns the handle signalling messages from the client counterpart.
+    auto client_wait_handle() noexcept -> work_wait_handle {
+        return _client_to_server_signal.wait_handle();
+    }
+
+    /// @brief Returns the handle signalling messages from the server counterpart.
+    auto server_wait_handle() noexcept -> work_wait_handle {
+        return _server_to_client_signal.wait_handle();
+    }
+
     /// @brief Fetches received messages from the client counterpart.
     auto fetch_from_client(const connection::fetch_handler handler) noexcept
       -> std::tuple<bool, bool> {
+        _client_to_server_signal.clear();
         auto& c2s{[this]() -> message_storage& {
             const std::unique_lock lock{_client_to_server_lock};
             _client_to_server.swap();
@@ -90,6 +179,7 @@ public:
     /// @brief Fetches received messages from the service counterpart.
     auto fetch_from_server(const connection::fetch_handler handler) noexcept
       -> bool {
+        _server_to_client_signal.clear();
         auto& s2c{[this]() -> message_storage& {
             const std::unique_lock lock{_server_to_client_lock};
             _server_to_client.swap();
@@ -103,6 +193,8 @@ private:
     Lockable _client_to_server_lock;
     double_buffer<message_storage> _server_to_client;
     double_buffer<message_storage> _client_to_server;
+    direct_connection_signal _server_to_client_signal;
+    direct_connection_signal _client_to_server_signal;
     std::atomic<bool> _server_connected{true};
     std::atomic<bool> _client_connected{false};
 };
@@ -133,12 +225,25 @@ public:
     auto connect() noexcept -> shared_state {
         shared_state state{default_selector, *this};
         _pending.push_back(state);
+        _connected.notify();
         return state;
     }
 
+    /// @brief Waits until a client connects or the timeout expires.
+    auto wait_for_connect(
+      const std::chrono::steady_clock::duration timeout) noexcept -> bool {
+        return _connected.wait_for(timeout);
+    }
+
+    /// @brief Returns the handle signalling newly connected clients.
+    auto wait_handle() noexcept -> work_wait_handle {
+        return _connected.wait_handle();
+    }
+
     /// @brief Handles the pending server counterparts for created client connections.
     /// @see connect
     auto process_all(const process_handler handler) noexcept -> work_done {
+        _connected.clear();
         some_true something_done{};
         for(auto& state : _pending) {
             handler(state);
@@ -150,6 +255,7 @@ public:
 
 private:
     small_vector<shared_state, 4> _pending;
+    direct_connection_signal _connected;
 };
 //------------------------------------------------------------------------------
 /// @brief Implementation of the connection_info interface for direct connections.
@@ -217,6 +323,21 @@ public:
         return false;
     }
 
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done final {
+        if(_state) [[likely]] {
+            return _state->wait_for_server(timeout);
+        }
+        return connection::wait_for_work(timeout);
+    }
+
+    auto add_wait_handles(work_waiter& waiter) noexcept -> bool final {
+        if(_state) [[likely]] {
+            return waiter.add_handle(_state->server_wait_handle());
+        }
+        return false;
+    }
+
     auto fetch_messages(const connection::fetch_handler handler) noexcept
       -> work_done final {
         some_true something_done{_checkup()};
@@ -294,6 +415,21 @@ public:
         return false;
     }
 
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done final {
+        if(_state) [[likely]] {
+            return _state->wait_for_client(timeout);
+        }
+        return connection::wait_for_work(timeout);
+    }
+
+    auto add_wait_handles(work_waiter& waiter) noexcept -> bool final {
+        if(_state) [[likely]] {
+            return waiter.add_handle(_state->client_wait_handle());
+        }
+        return false;
+    }
+
     auto fetch_messages(const connection::fetch_handler handler) noexcept
       -> work_done final {
         bool result = false;
@@ -343,6 +479,21 @@ public:
       : main_ctx_object{"DrctAccptr", parent}
       , _address{default_selector, *this} {}
 
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done final {
+        if(_address) {
+            return _address->wait_for_connect(timeout);
+        }
+        return acceptor::wait_for_work(timeout);
+    }
+
+    auto add_wait_handles(work_waiter& waiter) noexcept -> bool final {
+        if(_address) {
+            return waiter.add_handle(_address->wait_handle());
+        }
+        return false;
+    }
+
     auto process_accepted(const accept_handler handler) noexcept
       -> work_done final {
         some_true something_done{};
@@ -185,14 +185,205 @@ void direct_roundtrip_thread(auto& s) {
     test.check(hashes.empty(), "all hashes checked");
 }
 //------------------------------------------------------------------------------
+void direct_wait_for_work(auto& s) {
+    eagitest::case_ test{s, 5, "wait for work"};
+
+    auto fact{eagine::msgbus::make_direct_connection_factory(s.context())};
+    test.ensure(bool(fact), "has factory");
+    auto cacc{fact->make_acceptor(eagine::identifier{"test"})
+                .as(std::type_identity<eagine::msgbus::direct_acceptor_intf>{})};
+    test.ensure(bool(cacc), "has acceptor");
+    auto read_conn{cacc->make_connection()};
+    test.ensure(bool(read_conn), "has read connection");
+
+    eagine::shared_holder<eagine::msgbus::connection> write_conn;
+    cacc->process_accepted(
+      {eagine::construct_from,
+       [&](eagine::shared_holder<eagine::msgbus::connection> conn) {
+           write_conn = std::move(conn);
+       }});
+    test.ensure(bool(write_conn), "has write connection");
+
+    test.check(
+      not read_conn->wait_for_work(std::chrono::milliseconds{5}),
+      "nothing to wait for");
+
+    const eagine::message_id test_msg_id{"test", "method"};
+    std::thread writer{[&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        write_conn->send(test_msg_id, eagine::msgbus::message_view{});
+    }};
+    test.check(
+      read_conn->wait_for_work(std::chrono::seconds{5}), "woken up by send");
+    writer.join();
+
+    bool received{false};
+    read_conn->fetch_messages(
+      {eagine::construct_from,
+       [&](
+         const eagine::message_id msg_id,
+         const eagine::msgbus::message_age,
+         const eagine::msgbus::message_view&) -> bool {
+           received = msg_id == test_msg_id;
+           return true;
+       }});
+    test.check(received, "message received");
+}
+//------------------------------------------------------------------------------
+void direct_wait_handles(auto& s) {
+    eagitest::case_ test{s, 6, "wait handles"};
+
+    auto fact{eagine::msgbus::make_direct_connection_factory(s.context())};
+    test.ensure(bool(fact), "has factory");
+    auto cacc{fact->make_acceptor(eagine::identifier{"test"})
+                .as(std::type_identity<eagine::msgbus::direct_acceptor_intf>{})};
+    test.ensure(bool(cacc), "has acceptor");
+    auto read_conn{cacc->make_connection()};
+    test.ensure(bool(read_conn), "has read connection");
+
+    eagine::shared_holder<eagine::msgbus::connection> write_conn;
+    const auto accept{[&] {
+        return cacc->process_accepted(
+          {eagine::construct_from,
+           [&](eagine::shared_holder<eagine::msgbus::connection> conn) {
+               write_conn = std::move(conn);
+           }});
+    }};
+    accept();
+    test.ensure(bool(write_conn), "has write connection");
+
+    eagine::msgbus::work_waiter waiter;
+    const auto prepare{[&] {
+        waiter.reset();
+        waiter.add(*read_conn);
+        waiter.add(*cacc);
+    }};
+    prepare();
+    if(not eagine::msgbus::work_waiter::has_native_handles()) {
+        return;
+    }
+
+    test.check(
+      not waiter.wait(std::chrono::milliseconds{5}), "nothing to wait for");
+
+    const eagine::message_id test_msg_id{"test", "method"};
+    std::thread writer{[&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        write_conn->send(test_msg_id, eagine::msgbus::message_view{});
+    }};
+    test.check(waiter.wait(std::chrono::seconds{5}), "woken up by send");
+    writer.join();
+
+    bool received{false};
+    read_conn->fetch_messages(
+      {eagine::construct_from,
+       [&](
+         const eagine::message_id msg_id,
+         const eagine::msgbus::message_age,
+         const eagine::msgbus::message_view&) -> bool {
+           received = msg_id == test_msg_id;
+           return true;
+       }});
+    test.check(received, "message received");
+
+    prepare();
+    test.check(
+      not waiter.wait(std::chrono::milliseconds{5}), "cleared by fetch");
+
+    auto other_conn{cacc->make_connection()};
+    test.ensure(bool(other_conn), "has other connection");
+    test.check(waiter.wait(std::chrono::seconds{5}), "woken up by connect");
+    test.check(accept(), "accepted");
+
+    prepare();
+    test.check(
+      not waiter.wait(std::chrono::milliseconds{5}), "cleared by accept");
+}
+//------------------------------------------------------------------------------
+// wait with fallback sources
+//------------------------------------------------------------------------------
+// a source without native handles that has work once it is raised
+struct direct_test_fallback_source {
+    std::atomic<bool> raised{false};
+
+    auto add_wait_handles(eagine::msgbus::work_waiter&) noexcept -> bool {
+        return false;
+    }
+
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> eagine::work_done {
+        const auto deadline{std::chrono::steady_clock::now() + timeout};
+        while(not raised) {
+            if(std::chrono::steady_clock::now() >= deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        return true;
+    }
+};
+//------------------------------------------------------------------------------
+void direct_wait_fallbacks(auto& s) {
+    eagitest::case_ test{s, 7, "wait with fallback sources"};
+    auto& ctx{s.context()};
+    auto cacc{eagine::msgbus::make_direct_acceptor(ctx)};
+    test.ensure(bool(cacc), "has acceptor");
+    auto read_conn{cacc->make_connection()};
+    test.ensure(bool(read_conn), "has read connection");
+    eagine::shared_holder<eagine::msgbus::connection> write_conn;
+    cacc->process_accepted(
+      {eagine::construct_from,
+       [&](eagine::shared_holder<eagine::msgbus::connection> conn) {
+           write_conn = std::move(conn);
+       }});
+    test.ensure(bool(write_conn), "has write connection");
+
+    direct_test_fallback_source first;
+    direct_test_fallback_source second;
+    eagine::msgbus::work_waiter waiter;
+    waiter.add(*read_conn);
+    waiter.add(first);
+    waiter.add(second);
+
+    using clock = std::chrono::steady_clock;
+    test.check(
+      not waiter.wait(std::chrono::milliseconds{5}), "nothing to wait for");
+
+    // work on the first fallback while the later ones could be waited on
+    std::thread raiser{[&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        first.raised = true;
+    }};
+    auto start{clock::now()};
+    test.check(waiter.wait(std::chrono::seconds{10}), "woken up by fallback");
+    test.check(
+      clock::now() - start < std::chrono::seconds{2}, "fallback wake-up");
+    raiser.join();
+    first.raised = false;
+
+    // work on the native handle while the fallbacks are checked
+    const eagine::message_id test_msg_id{"test", "method"};
+    std::thread writer{[&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        write_conn->send(test_msg_id, eagine::msgbus::message_view{});
+    }};
+    start = clock::now();
+    test.check(waiter.wait(std::chrono::seconds{10}), "woken up by send");
+    test.check(clock::now() - start < std::chrono::seconds{2}, "native wake-up");
+    writer.join();
+}
+//------------------------------------------------------------------------------
 // main
 //------------------------------------------------------------------------------
 auto test_main(eagine::test_ctx& ctx) -> int {
-    eagitest::ctx_suite test{ctx, "direct connection", 4};
+    eagitest::ctx_suite test{ctx, "direct connection", 7};
     test.once(direct_type_id);
     test.once(direct_addr_kind);
     test.once(direct_roundtrip);
     test.once(direct_roundtrip_thread);
+    test.once(direct_wait_for_work);
+    test.once(direct_wait_handles);
+    test.once(direct_wait_fallbacks);
     return test.exit_code();
 }
 //------------------------------------------------------------------------------
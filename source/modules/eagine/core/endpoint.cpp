@@ -21,12 +21,14 @@ import eagine.core.container;
 import eagine.core.valid_if;
 import eagine.core.utility;
 import eagine.core.logging;
+import eagine.core.runtime;
 import eagine.core.main_ctx;
 import :types;
 import :blobs;
 import :message;
 import :context;
 import :interface;
+import :trace;
 
 namespace eagine::msgbus {
 //------------------------------------------------------------------------------
@@ -36,6 +38,58 @@ export constexpr auto endpoint_alive_notify_period() noexcept {
     return std::chrono::seconds{30};
 }
 //------------------------------------------------------------------------------
+// signed incoming messages verified in one endpoint update
+struct incoming_verify_round {
+    std::vector<stored_message*> messages;
+    context* ctx{nullptr};
+    main_ctx_object* user{nullptr};
+    std::size_t batch_size{1U};
+    std::size_t batch_count{0U};
+    std::atomic<std::size_t> next_batch{0U};
+    std::atomic<std::size_t> done_batches{0U};
+
+    auto verify_batch() noexcept -> bool;
+    void wait_until_done() noexcept;
+};
+//------------------------------------------------------------------------------
+class incoming_verify_work_unit : public work_unit {
+public:
+    auto is_idle() const noexcept -> bool {
+        return not _queued.load(std::memory_order_acquire);
+    }
+
+    void assign(shared_holder<incoming_verify_round> round) noexcept {
+        _queued.store(true, std::memory_order_release);
+        _round = std::move(round);
+    }
+
+    auto do_it() noexcept -> bool final;
+    void deliver() noexcept final;
+
+private:
+    shared_holder<incoming_verify_round> _round{};
+    std::atomic<bool> _queued{false};
+};
+//------------------------------------------------------------------------------
+class incoming_verifier {
+public:
+    incoming_verifier(const span_size_t batch_size) noexcept;
+    incoming_verifier(incoming_verifier&&) = delete;
+    incoming_verifier(const incoming_verifier&) = delete;
+    auto operator=(incoming_verifier&&) = delete;
+    auto operator=(const incoming_verifier&) = delete;
+    ~incoming_verifier() noexcept;
+
+    auto verify(
+      std::vector<stored_message*> messages,
+      context&,
+      main_ctx_object&) noexcept -> work_done;
+
+private:
+    std::size_t _batch_size;
+    std::vector<unique_holder<incoming_verify_work_unit>> _units;
+};
+//------------------------------------------------------------------------------
 /// @brief Message bus client endpoint that can send and receive messages.
 /// @ingroup msgbus
 /// @see static_subscriber
@@ -152,12 +206,28 @@ public:
     /// @brief Updates the internal state, sends and receives pending messages.
     auto update() noexcept -> work_done;
 
+    /// @brief Waits until there may be incoming messages or the timeout expires.
+    /// Can be used instead of sleeping when the update did not do any work.
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done;
+
     /// @brief Says to the message bus that this endpoint is disconnecting.
     void finish() noexcept {
         say_bye();
         flush_outbox();
     }
 
+    /// @brief Sets if signed messages are verified before subscribers get them.
+    /// @note The messages are verified in batches, partly on worker threads,
+    /// and the result is cached in the stored messages.
+    /// @see stored_message::cache_verify_bits
+    void verify_incoming(const bool enable) noexcept;
+
+    /// @brief Indicates if signed incoming messages are verified in batches.
+    auto is_verifying_incoming() const noexcept -> bool {
+        return bool(_verifier);
+    }
+
     /// @brief Subscribes to messages with the specified id/type.
     void subscribe(const message_id) noexcept;
 
@@ -432,6 +502,18 @@ public:
         return _ensure_incoming(msg_id).queue;
     }
 
+    /// @brief Processes all messages in a queue from ensure_queue with a handler.
+    /// @see ensure_queue
+    /// @see process_all
+    auto process_queue(
+      message_priority_queue& queue,
+      const message_context& msg_ctx,
+      const method_handler handler) noexcept -> span_size_t {
+        return _dispatch(handler, [&](const method_handler hndlr) {
+            return queue.process_all(msg_ctx, hndlr);
+        });
+    }
+
     /// @brief Returns the average message age in the connected router.
     /// @see flow_congestion
     auto flow_average_message_age() const noexcept {
@@ -471,6 +553,8 @@ private:
 
     auto _uptime_seconds() noexcept -> std::int64_t;
 
+    const bool _session_mac{cfg_init("msgbus.endpoint.session_mac", false)};
+
     timeout _no_id_timeout{
       cfg_init(
         "msgbus.endpoint.no_id_timeout",
@@ -491,9 +575,33 @@ private:
     struct incoming_state {
         span_size_t subscription_count{0};
         message_priority_queue queue{};
+        bool has_unverified{false};
     };
 
     flat_map<message_id, unique_holder<incoming_state>> _incoming{};
+    unique_holder<incoming_verifier> _verifier{};
+    bool _has_unverified{false};
+    message_tracer _tracer{node_kind::endpoint, *this};
+
+    template <typename Function>
+    auto _dispatch(const method_handler handler, Function func) noexcept {
+        if(_tracer.is_enabled()) [[unlikely]] {
+            const auto traced{[this, handler](
+                                const message_context& msg_ctx,
+                                const stored_message& message) noexcept {
+                _tracer.stamp(
+                  message_trace_point::dispatch, msg_ctx.msg_id(), message);
+                return handler(msg_ctx, message);
+            }};
+            return func(method_handler{construct_from, traced});
+        }
+        return func(handler);
+    }
+
+    void _post_trace_records(const message_view& query) noexcept;
+
+    void _note_unverified(incoming_state&, const message_view&) noexcept;
+    auto _verify_incoming() noexcept -> work_done;
 
     auto _declare_states() noexcept;
 
@@ -554,6 +662,8 @@ private:
       -> message_handling_result;
     auto _handle_signed_nonce(const message_view&) noexcept
       -> message_handling_result;
+    auto _handle_session_key(const message_view&) noexcept
+      -> message_handling_result;
     auto _handle_topology_query(const message_view&) noexcept
       -> message_handling_result;
     auto _handle_stats_query(const message_view&) noexcept
@@ -586,6 +696,9 @@ private:
       , _connection{std::move(temp._connection)}
       , _outgoing{std::move(temp._outgoing)}
       , _incoming{std::move(temp._incoming)}
+      , _verifier{std::move(temp._verifier)}
+      , _has_unverified{temp._has_unverified}
+      , _tracer{std::move(temp._tracer)}
       , _blobs{std::move(temp._blobs)} {}
 
     endpoint(endpoint&& temp, fetch_handler store_message) noexcept
@@ -596,6 +709,9 @@ private:
       , _connection{std::move(temp._connection)}
       , _outgoing{std::move(temp._outgoing)}
       , _incoming{std::move(temp._incoming)}
+      , _verifier{std::move(temp._verifier)}
+      , _has_unverified{temp._has_unverified}
+      , _tracer{std::move(temp._tracer)}
       , _blobs{std::move(temp._blobs)}
       , _store_handler{std::move(store_message)} {}
 
@@ -19,6 +19,7 @@ import eagine.core.identifier;
 import eagine.core.container;
 import eagine.core.utility;
 import eagine.core.valid_if;
+import eagine.core.runtime;
 import eagine.core.main_ctx;
 import :types;
 import :blobs;
@@ -27,6 +28,100 @@ import :context;
 
 namespace eagine::msgbus {
 //------------------------------------------------------------------------------
+// incoming_verify_round
+//------------------------------------------------------------------------------
+auto incoming_verify_round::verify_batch() noexcept -> bool {
+    const auto batch{next_batch.fetch_add(1U, std::memory_order_relaxed)};
+    if(batch >= batch_count) {
+        return false;
+    }
+    const auto begin{batch * batch_size};
+    const auto end{std::min(begin + batch_size, messages.size())};
+    for(auto i = begin; i < end; ++i) {
+        messages[i]->cache_verify_bits(*ctx, *user);
+    }
+    done_batches.fetch_add(1U, std::memory_order_acq_rel);
+    done_batches.notify_all();
+    return true;
+}
+//------------------------------------------------------------------------------
+void incoming_verify_round::wait_until_done() noexcept {
+    auto done{done_batches.load(std::memory_order_acquire)};
+    while(done < batch_count) {
+        done_batches.wait(done, std::memory_order_acquire);
+        done = done_batches.load(std::memory_order_acquire);
+    }
+}
+//------------------------------------------------------------------------------
+// incoming_verify_work_unit
+//------------------------------------------------------------------------------
+auto incoming_verify_work_unit::do_it() noexcept -> bool {
+    if(_round) [[likely]] {
+        while(_round->verify_batch()) {
+        }
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+void incoming_verify_work_unit::deliver() noexcept {
+    _round = {};
+    _queued.store(false, std::memory_order_release);
+}
+//------------------------------------------------------------------------------
+// incoming_verifier
+//------------------------------------------------------------------------------
+incoming_verifier::incoming_verifier(const span_size_t batch_size) noexcept
+  : _batch_size{std::size_t(std::max(batch_size, span_size(1)))} {
+    const auto count{std::clamp(std::thread::hardware_concurrency(), 1U, 8U)};
+    _units.reserve(count);
+    for(unsigned i = 0; i < count; ++i) {
+        _units.emplace_back(default_selector);
+    }
+}
+//------------------------------------------------------------------------------
+incoming_verifier::~incoming_verifier() noexcept {
+    // the queued units may still be referenced by the workers
+    for(auto& unit : _units) {
+        while(not unit->is_idle()) {
+            std::this_thread::yield();
+        }
+    }
+}
+//------------------------------------------------------------------------------
+auto incoming_verifier::verify(
+  std::vector<stored_message*> messages,
+  context& ctx,
+  main_ctx_object& user) noexcept -> work_done {
+    if(messages.empty()) {
+        return false;
+    }
+    shared_holder<incoming_verify_round> round{default_selector};
+    round->batch_size = _batch_size;
+    round->batch_count = (messages.size() + _batch_size - 1U) / _batch_size;
+    round->messages = std::move(messages);
+    round->ctx = &ctx;
+    round->user = &user;
+
+    // the calling thread verifies batches too and then waits only for
+    // the batches already taken by the workers, so this never deadlocks
+    // even if all the workers are busy (or if this runs on a worker)
+    auto helpers{round->batch_count - 1U};
+    for(auto& unit : _units) {
+        if(helpers == 0U) {
+            break;
+        }
+        if(unit->is_idle()) {
+            unit->assign(round);
+            user.workers().enqueue(*unit);
+            --helpers;
+        }
+    }
+    while(round->verify_batch()) {
+    }
+    round->wait_until_done();
+    return true;
+}
+//------------------------------------------------------------------------------
 // endpoint
 //------------------------------------------------------------------------------
 auto endpoint::_default_store_handler() noexcept -> fetch_handler {
@@ -66,11 +161,13 @@ auto endpoint::_get_incoming(const message_id msg_id) const noexcept
 endpoint::endpoint(main_ctx_object obj) noexcept
   : main_ctx_object{std::move(obj)} {
     _declare_states();
+    verify_incoming(cfg_init("msgbus.endpoint.verify_incoming", false));
 }
 //------------------------------------------------------------------------------
 endpoint::endpoint(const identifier id, main_ctx_parent parent) noexcept
   : main_ctx_object{id, parent} {
     _declare_states();
+    verify_incoming(cfg_init("msgbus.endpoint.verify_incoming", false));
 }
 //------------------------------------------------------------------------------
 auto endpoint::_uptime_seconds() noexcept -> std::int64_t {
@@ -96,7 +193,9 @@ auto endpoint::_do_send(const message_id msg_id, message_view message) noexcept
   -> bool {
     assert(has_id());
     message.set_source_id(_endpoint_id);
+    _tracer.stamp(message_trace_point::submit, msg_id, message);
     if(_connection and _connection->send(msg_id, message)) [[likely]] {
+        _tracer.stamp(message_trace_point::accept, msg_id, message);
         ++_stats.sent_messages;
         if(not _had_working_connection) [[unlikely]] {
             _had_working_connection = true;
@@ -277,6 +376,10 @@ auto endpoint::_handle_sign_nonce_request(const message_view& message) noexcept
         log_debug("sending nonce signature")
           .arg("endpoint", _endpoint_id)
           .arg("target", message.source_id);
+        if(_session_mac) {
+            // the session key must follow this nonce signature
+            _context->expect_session_key(message.source_id, message.content());
+        }
     }
     return was_handled;
 }
@@ -287,6 +390,31 @@ auto endpoint::_handle_signed_nonce(const message_view& message) noexcept
         log_debug("verified nonce signature")
           .arg("endpoint", _endpoint_id)
           .arg("source", message.source_id);
+
+        if(_session_mac) {
+            if(const auto sealed{_context->make_session_key(message.source_id)}) {
+                post_blob(
+                  msgbus_id{"eptSessKey"},
+                  message.source_id,
+                  message.sequence_no,
+                  sealed,
+                  std::chrono::seconds(30),
+                  message_priority::normal);
+                log_debug("sending session key")
+                  .arg("endpoint", _endpoint_id)
+                  .arg("target", message.source_id);
+            }
+        }
+    }
+    return was_handled;
+}
+//------------------------------------------------------------------------------
+auto endpoint::_handle_session_key(const message_view& message) noexcept
+  -> message_handling_result {
+    if(_context->accept_session_key(message.source_id, message.content())) {
+        log_debug("accepted session key")
+          .arg("endpoint", _endpoint_id)
+          .arg("source", message.source_id);
     }
     return was_handled;
 }
@@ -320,6 +448,7 @@ auto endpoint::_handle_stats_query(const message_view& message) noexcept
         message_view response{*serialized};
         response.setup_response(message);
         if(post(msgbus_id{"statsEndpt"}, response)) [[likely]] {
+            _post_trace_records(message);
             return was_handled;
         }
     }
@@ -329,6 +458,18 @@ auto endpoint::_handle_stats_query(const message_view& message) noexcept
     return was_not_handled;
 }
 //------------------------------------------------------------------------------
+void endpoint::_post_trace_records(const message_view& query) noexcept {
+    for(const auto& record : _tracer.fetch_records(_endpoint_id)) {
+        auto temp{default_serialize_buffer_for(record)};
+        if(const auto serialized{default_serialize(record, cover(temp))})
+          [[likely]] {
+            message_view response{*serialized};
+            response.setup_response(query);
+            post(msgbus_id{"statsTrace"}, response);
+        }
+    }
+}
+//------------------------------------------------------------------------------
 auto endpoint::_handle_special(
   const message_id msg_id,
   const message_view& message) noexcept -> message_handling_result {
@@ -362,6 +503,8 @@ auto endpoint::_handle_special(
                 return _handle_sign_nonce_request(message);
             case id_v("eptNnceSig"):
                 return _handle_signed_nonce(message);
+            case id_v("eptSessKey"):
+                return _handle_session_key(message);
             case id_v("rtrCertPem"):
                 return _handle_router_certificate(message);
             case id_v("topoQuery"):
@@ -384,6 +527,9 @@ auto endpoint::_handle_special(
             case id_v("topoRutrCn"):
             case id_v("topoBrdgCn"):
             case id_v("topoEndpt"):
+            case id_v("statsTrace"):
+            case id_v("statsLtHst"):
+            case id_v("statsCnLat"):
                 return should_be_stored;
         }
 
@@ -406,18 +552,21 @@ auto endpoint::_store_message(
   const message_age msg_age,
   const message_view& message) noexcept -> bool {
     ++_stats.received_messages;
+    _tracer.stamp(message_trace_point::receive, msg_id, message);
     if(_handle_special(msg_id, message) == should_be_stored) {
         if((message.target_id == _endpoint_id) or not is_valid_id(message.target_id))
           [[likely]] {
             if(auto found{_find_incoming(msg_id)}) [[likely]] {
                 log_trace("stored message ${message}").arg("message", msg_id);
                 found->queue.push(message).add_age(msg_age);
+                _note_unverified(*found, message);
             } else {
                 auto& state = _ensure_incoming(msg_id);
                 assert(state.subscription_count == 0);
                 log_debug("storing new type of message ${message}")
                   .arg("message", msg_id);
                 state.queue.push(message).add_age(msg_age);
+                _note_unverified(state, message);
             }
         } else {
             ++_stats.dropped_messages;
@@ -434,6 +583,7 @@ auto endpoint::_store_message(
 auto endpoint::_accept_message(
   const message_id msg_id,
   const message_view& message) noexcept -> bool {
+    _tracer.stamp(message_trace_point::receive, msg_id, message);
     if(_handle_special(msg_id, message) == was_handled) {
         return true;
     }
@@ -441,12 +591,58 @@ auto endpoint::_accept_message(
         if((message.target_id == _endpoint_id) or not is_valid_id(message.target_id)) {
             log_trace("accepted message ${message}").arg("message", msg_id);
             found->queue.push(message);
+            _note_unverified(*found, message);
         }
         return true;
     }
     return false;
 }
 //------------------------------------------------------------------------------
+void endpoint::_note_unverified(
+  incoming_state& state,
+  const message_view& message) noexcept {
+    if(_verifier and message.is_signed()) [[unlikely]] {
+        state.has_unverified = true;
+        _has_unverified = true;
+    }
+}
+//------------------------------------------------------------------------------
+auto endpoint::_verify_incoming() noexcept -> work_done {
+    if(not _has_unverified) [[likely]] {
+        return false;
+    }
+    _has_unverified = false;
+    if(not _verifier or not _context) {
+        return false;
+    }
+    std::vector<stored_message*> messages;
+    for(auto& [msg_id, state] : _incoming) {
+        if(state->has_unverified) {
+            state->has_unverified = false;
+            state->queue.for_each([&](stored_message& message) {
+                if(message.is_signed() and not message.has_cached_verify_bits()) {
+                    messages.push_back(&message);
+                }
+            });
+        }
+    }
+    return _verifier->verify(std::move(messages), *_context, *this);
+}
+//------------------------------------------------------------------------------
+void endpoint::verify_incoming(const bool enable) noexcept {
+    if(enable) {
+        if(not _verifier) {
+            _verifier = unique_holder<incoming_verifier>{
+              default_selector,
+              app_config()
+                .get<span_size_t>("msgbus.endpoint.verify_batch_size")
+                .value_or(32)};
+        }
+    } else {
+        _verifier = {};
+    }
+}
+//------------------------------------------------------------------------------
 void endpoint::add_certificate_pem(const memory::const_block blk) noexcept {
     assert(_context);
     if(_context->add_own_certificate_pem(blk)) {
@@ -598,6 +794,15 @@ auto endpoint::_update_send_outbox() noexcept -> work_done {
     return _outgoing.fetch_all(make_callable_ref<&endpoint::_handle_send>(this));
 }
 //------------------------------------------------------------------------------
+auto endpoint::wait_for_work(
+  const std::chrono::steady_clock::duration timeout) noexcept -> work_done {
+    if(_connection) [[likely]] {
+        return _connection->wait_for_work(timeout);
+    }
+    std::this_thread::sleep_for(timeout);
+    return false;
+}
+//------------------------------------------------------------------------------
 auto endpoint::update() noexcept -> work_done {
     static const auto exec_time_id{register_time_interval("busUpdate")};
     const auto exec_time{measure_time_interval(exec_time_id)};
@@ -627,6 +832,7 @@ auto endpoint::update() noexcept -> work_done {
         }
         something_done(_connection->update());
         something_done(_connection->fetch_messages(_store_handler));
+        something_done(_verify_incoming());
 
         // if processing the messages assigned the endpoint id
         if(not had_id) [[unlikely]] {
@@ -823,7 +1029,9 @@ auto endpoint::process_one(
   const method_handler handler) noexcept -> bool {
     if(const auto found{_find_incoming(msg_id)}) [[likely]] {
         const message_context msg_ctx{*this, msg_id};
-        return found->queue.process_one(msg_ctx, handler);
+        return _dispatch(handler, [&](const method_handler hndlr) {
+            return found->queue.process_one(msg_ctx, hndlr);
+        });
     }
     return false;
 }
@@ -833,7 +1041,7 @@ auto endpoint::process_all(
   const method_handler handler) noexcept -> span_size_t {
     if(const auto found{_find_incoming(msg_id)}) [[likely]] {
         const message_context msg_ctx{*this, msg_id};
-        return found->queue.process_all(msg_ctx, handler);
+        return process_queue(found->queue, msg_ctx, handler);
     }
     return 0;
 }
@@ -844,7 +1052,7 @@ auto endpoint::process_everything(const method_handler handler) noexcept
 
     for(auto& [msg_id, state] : _incoming) {
         const message_context msg_ctx{*this, msg_id};
-        result += state->queue.process_all(msg_ctx, handler);
+        result += process_queue(state->queue, msg_ctx, handler);
     }
     return result;
 }
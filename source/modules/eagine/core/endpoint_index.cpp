@@ -0,0 +1,141 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+export module eagine.msgbus.core:endpoint_index;
+
+import std;
+import eagine.core.identifier;
+import :types;
+
+namespace eagine::msgbus {
+//------------------------------------------------------------------------------
+/// @brief Open-addressing hash index of endpoint ids to adjacent node ids.
+/// @ingroup msgbus
+///
+/// Uses linear probing and backward-shift deletion (no tombstones).
+/// The lookups may run concurrently with each other, the modifications
+/// (including the rehashing) exclude the lookups.
+export class endpoint_index {
+public:
+    /// @brief Returns the node id for the specified endpoint or invalid id.
+    auto find(const endpoint_id_t endpoint_id) const noexcept -> endpoint_id_t {
+        const std::shared_lock lk{_lock};
+        if(not _entries.empty() and is_valid_id(endpoint_id)) [[likely]] {
+            for(auto pos{_home_of(endpoint_id)};
+                is_valid_id(_entries[pos].endpoint_id);
+                pos = _next_of(pos)) {
+                if(_entries[pos].endpoint_id == endpoint_id) {
+                    return _entries[pos].node_id;
+                }
+            }
+        }
+        return {};
+    }
+
+    /// @brief Sets the node id for the specified endpoint.
+    /// @return Indicates if the node id has changed.
+    auto set(const endpoint_id_t endpoint_id, const endpoint_id_t node_id) noexcept
+      -> bool {
+        if(not is_valid_id(endpoint_id)) [[unlikely]] {
+            return false;
+        }
+        const std::unique_lock lk{_lock};
+        // keep the load factor at or below one half
+        if((_count + 1U) * 2U > _entries.size()) {
+            _rehash(_entries.empty() ? 64U : _entries.size() * 2U);
+        }
+        auto pos{_home_of(endpoint_id)};
+        while(is_valid_id(_entries[pos].endpoint_id)) {
+            if(_entries[pos].endpoint_id == endpoint_id) {
+                return std::exchange(_entries[pos].node_id, node_id) != node_id;
+            }
+            pos = _next_of(pos);
+        }
+        _entries[pos] = {.endpoint_id = endpoint_id, .node_id = node_id};
+        ++_count;
+        return true;
+    }
+
+    /// @brief Removes the specified endpoint from the index.
+    void erase(const endpoint_id_t endpoint_id) noexcept {
+        if(not is_valid_id(endpoint_id)) [[unlikely]] {
+            return;
+        }
+        const std::unique_lock lk{_lock};
+        if(_entries.empty()) {
+            return;
+        }
+        auto pos{_home_of(endpoint_id)};
+        while(_entries[pos].endpoint_id != endpoint_id) {
+            if(not is_valid_id(_entries[pos].endpoint_id)) {
+                return;
+            }
+            pos = _next_of(pos);
+        }
+        // shift the following entries of the probe sequence back
+        const auto mask{_entries.size() - 1U};
+        for(auto next{_next_of(pos)}; is_valid_id(_entries[next].endpoint_id);
+            next = _next_of(next)) {
+            const auto home{_home_of(_entries[next].endpoint_id)};
+            if(((next - home) & mask) >= ((next - pos) & mask)) {
+                _entries[pos] = _entries[next];
+                pos = next;
+            }
+        }
+        _entries[pos] = {};
+        --_count;
+    }
+
+    /// @brief Returns the number of endpoints in the index.
+    auto size() const noexcept -> std::size_t {
+        const std::shared_lock lk{_lock};
+        return _count;
+    }
+
+    /// @brief Returns the number of slots in the hash table.
+    auto capacity() const noexcept -> std::size_t {
+        const std::shared_lock lk{_lock};
+        return _entries.size();
+    }
+
+private:
+    struct entry {
+        endpoint_id_t endpoint_id{0U};
+        endpoint_id_t node_id{0U};
+    };
+
+    auto _home_of(const endpoint_id_t endpoint_id) const noexcept
+      -> std::size_t {
+        // Fibonacci hashing, the capacity is always a power of two
+        const auto hash{
+          std::uint64_t(endpoint_id.value()) * 0x9E3779B97F4A7C15U};
+        return std::size_t(hash ^ (hash >> 32U)) & (_entries.size() - 1U);
+    }
+
+    auto _next_of(const std::size_t pos) const noexcept -> std::size_t {
+        return (pos + 1U) & (_entries.size() - 1U);
+    }
+
+    void _rehash(const std::size_t capacity) noexcept {
+        auto old_entries{std::exchange(_entries, std::vector<entry>(capacity))};
+        for(const auto& old : old_entries) {
+            if(is_valid_id(old.endpoint_id)) {
+                auto pos{_home_of(old.endpoint_id)};
+                while(is_valid_id(_entries[pos].endpoint_id)) {
+                    pos = _next_of(pos);
+                }
+                _entries[pos] = old;
+            }
+        }
+    }
+
+    mutable std::shared_mutex _lock;
+    std::vector<entry> _entries{};
+    std::size_t _count{0U};
+};
+//------------------------------------------------------------------------------
+} // namespace eagine::msgbus
@@ -0,0 +1,137 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+
+#include <eagine/testing/unit_begin_ctx.hpp>
+import std;
+import eagine.core;
+import eagine.msgbus.core;
+//------------------------------------------------------------------------------
+auto endpoint_index_node_of(std::uint64_t id) -> eagine::msgbus::endpoint_id_t {
+    return eagine::msgbus::endpoint_id_t{1000U + id % 7U};
+}
+//------------------------------------------------------------------------------
+// insert
+//------------------------------------------------------------------------------
+void endpoint_index_insert(auto& s) {
+    eagitest::case_ test{s, 1, "insert"};
+    using eagine::msgbus::endpoint_id_t;
+    eagine::msgbus::endpoint_index index;
+
+    test.check(not index.find(endpoint_id_t{1U}), "empty");
+    test.check(not index.set(endpoint_id_t{}, endpoint_id_t{2U}), "invalid id");
+    test.check_equal(index.size(), std::size_t(0), "size 0");
+
+    test.check(index.set(endpoint_id_t{1U}, endpoint_id_t{2U}), "new");
+    test.check(index.find(endpoint_id_t{1U}) == endpoint_id_t{2U}, "found");
+    test.check(not index.set(endpoint_id_t{1U}, endpoint_id_t{2U}), "same");
+    test.check(index.set(endpoint_id_t{1U}, endpoint_id_t{3U}), "changed");
+    test.check(index.find(endpoint_id_t{1U}) == endpoint_id_t{3U}, "updated");
+    test.check_equal(index.size(), std::size_t(1), "size 1");
+    test.check(not index.find(endpoint_id_t{4U}), "not found");
+}
+//------------------------------------------------------------------------------
+// erase
+//------------------------------------------------------------------------------
+void endpoint_index_erase(auto& s) {
+    eagitest::case_ test{s, 2, "erase"};
+    using eagine::msgbus::endpoint_id_t;
+    eagine::msgbus::endpoint_index index;
+    auto& rg{test.random()};
+
+    // fill up to the load limit so that there are long probe sequences
+    std::vector<std::uint64_t> ids;
+    while(ids.size() < 32U) {
+        const auto id{rg.get_between<std::uint64_t>(1U, 100000U)};
+        if(std::find(ids.begin(), ids.end(), id) == ids.end()) {
+            ids.push_back(id);
+            index.set(endpoint_id_t{id}, endpoint_index_node_of(id));
+        }
+    }
+    test.check_equal(index.capacity(), std::size_t(64), "no rehash");
+
+    // every erased entry shifts the following ones back to their probe path
+    while(not ids.empty()) {
+        const auto pos{rg.get_between<std::size_t>(0U, ids.size() - 1U)};
+        index.erase(endpoint_id_t{ids[pos]});
+        test.check(not index.find(endpoint_id_t{ids[pos]}), "erased");
+        ids.erase(ids.begin() + std::ptrdiff_t(pos));
+        for(const auto id : ids) {
+            test.check(
+              index.find(endpoint_id_t{id}) == endpoint_index_node_of(id),
+              "still found");
+        }
+        test.check_equal(index.size(), ids.size(), "size");
+    }
+    index.erase(endpoint_id_t{1U});
+    test.check_equal(index.size(), std::size_t(0), "empty");
+}
+//------------------------------------------------------------------------------
+// rehash
+//------------------------------------------------------------------------------
+void endpoint_index_rehash(auto& s) {
+    eagitest::case_ test{s, 3, "rehash"};
+    using eagine::msgbus::endpoint_id_t;
+    eagine::msgbus::endpoint_index index;
+
+    for(std::uint64_t id = 1U; id <= 1000U; ++id) {
+        test.check(index.set(endpoint_id_t{id}, endpoint_index_node_of(id)), "set");
+    }
+    test.check_equal(index.size(), std::size_t(1000), "size");
+    test.check(index.capacity() >= std::size_t(2000), "load factor");
+    for(std::uint64_t id = 1U; id <= 1000U; ++id) {
+        test.check(
+          index.find(endpoint_id_t{id}) == endpoint_index_node_of(id), "found");
+    }
+    test.check(not index.find(endpoint_id_t{1001U}), "not found");
+}
+//------------------------------------------------------------------------------
+// concurrent find
+//------------------------------------------------------------------------------
+void endpoint_index_concurrent(auto& s) {
+    eagitest::case_ test{s, 4, "concurrent find"};
+    using eagine::msgbus::endpoint_id_t;
+    eagine::msgbus::endpoint_index index;
+    index.set(endpoint_id_t{1U}, endpoint_index_node_of(1U));
+
+    std::atomic<bool> done{false};
+    std::atomic<std::size_t> misses{0U};
+    std::thread reader{[&] {
+        while(not done.load()) {
+            if(index.find(endpoint_id_t{1U}) != endpoint_index_node_of(1U)) {
+                ++misses;
+            }
+        }
+    }};
+    // the rehashes replace the table while the reader looks up
+    for(std::uint64_t id = 2U; id <= 5000U; ++id) {
+        index.set(endpoint_id_t{id}, endpoint_index_node_of(id));
+        if(id % 3U == 0U) {
+            index.erase(endpoint_id_t{id});
+        }
+    }
+    done = true;
+    reader.join();
+    test.check_equal(misses.load(), std::size_t(0), "no misses");
+}
+//------------------------------------------------------------------------------
+// main
+//------------------------------------------------------------------------------
+auto test_main(eagine::test_ctx& ctx) -> int {
+    eagitest::ctx_suite test{ctx, "endpoint index", 4};
+    test.once(endpoint_index_insert);
+    test.once(endpoint_index_erase);
+    test.once(endpoint_index_rehash);
+    test.once(endpoint_index_concurrent);
+    return test.exit_code();
+}
+//------------------------------------------------------------------------------
+auto main(int argc, const char** argv) -> int {
+    return eagine::test_main_impl(argc, argv, test_main);
+}
+//------------------------------------------------------------------------------
+#include <eagine/testing/unit_end_ctx.hpp>
@@ -300,18 +300,141 @@ void endpoint_id_assigned(unsigned, auto& s) {
     }
 }
 //------------------------------------------------------------------------------
+// verify incoming
+//------------------------------------------------------------------------------
+void endpoint_verify_incoming(unsigned, auto& s) {
+    eagitest::case_ test{s, 6, "verify incoming"};
+    auto& ctx{s.context()};
+
+    eagine::msgbus::endpoint endpoint{"Endpoint", ctx};
+    auto acceptor = eagine::msgbus::make_direct_acceptor(ctx);
+    endpoint.add_connection(acceptor->make_connection());
+
+    eagine::msgbus::router router(ctx);
+    router.add_acceptor(std::move(acceptor));
+
+    endpoint.verify_incoming(true);
+    test.check(endpoint.is_verifying_incoming(), "is verifying");
+    endpoint.verify_incoming(true);
+    test.check(endpoint.is_verifying_incoming(), "still verifying");
+
+    eagine::timeout get_id_time{std::chrono::seconds{5}};
+    while(not endpoint.has_id()) {
+        if(get_id_time.is_expired()) {
+            test.fail("failed to get id");
+            break;
+        }
+        router.update();
+        endpoint.update();
+    }
+
+    endpoint.verify_incoming(false);
+    test.check(not endpoint.is_verifying_incoming(), "is not verifying");
+}
+//------------------------------------------------------------------------------
+// verify incoming signed
+//------------------------------------------------------------------------------
+// stores the content with size and a fake signature into dst
+auto endpoint_fake_signed(
+  const eagine::memory::const_block content,
+  eagine::memory::block dst) -> eagine::memory::const_block {
+    using namespace eagine;
+    if(const auto used{store_data_with_size(content, dst)}) {
+        auto sig{skip(dst, used.size())};
+        for(span_size_t i = 0; i < 64; ++i) {
+            sig[i] = byte(i);
+        }
+        return head(dst, used.size() + 64);
+    }
+    return {};
+}
+//------------------------------------------------------------------------------
+void endpoint_verify_incoming_signed(unsigned, auto& s) {
+    eagitest::case_ test{s, 7, "verify incoming signed"};
+    auto& ctx{s.context()};
+    const eagine::message_id msg_id{"eagiTest", "signed"};
+    // more than the default msgbus.endpoint.verify_batch_size
+    const eagine::span_size_t count{3 * 32 + 5};
+
+    eagine::msgbus::endpoint sender{"Sender", ctx};
+    eagine::msgbus::endpoint receiver{"Receiver", ctx};
+    auto acceptor = eagine::msgbus::make_direct_acceptor(ctx);
+    sender.add_connection(acceptor->make_connection());
+    receiver.add_connection(acceptor->make_connection());
+
+    eagine::msgbus::router router(ctx);
+    router.add_acceptor(std::move(acceptor));
+    receiver.verify_incoming(true);
+
+    eagine::timeout get_id_time{std::chrono::seconds{5}};
+    while(not sender.has_id() or not receiver.has_id()) {
+        if(get_id_time.is_expired()) {
+            test.fail("failed to get id");
+            return;
+        }
+        router.update();
+        sender.update();
+        receiver.update();
+    }
+
+    std::array<eagine::byte, 256> temp{};
+    for(eagine::span_size_t i = 0; i < count; ++i) {
+        const auto content{std::to_string(i)};
+        eagine::msgbus::message_view message{endpoint_fake_signed(
+          eagine::as_bytes(eagine::string_view{content}),
+          {temp.data(), eagine::span_size(temp.size())})};
+        message.set_target_id(receiver.get_id());
+        message.crypto_flags |= eagine::msgbus::message_crypto_flag::asymmetric;
+        message.crypto_flags |=
+          eagine::msgbus::message_crypto_flag::signed_content;
+        test.ensure(sender.post(msg_id, message), "posted");
+    }
+
+    eagine::span_size_t received{0};
+    const auto handler = [&](
+                           const eagine::msgbus::message_context&,
+                           const eagine::msgbus::stored_message& message)
+      -> bool {
+        test.check(message.is_signed(), "is signed");
+        test.check(message.has_cached_verify_bits(), "verified before handling");
+        // the source certificate is unknown so nothing was verified
+        test.check(
+          not message.verify_bits(receiver.ctx(), receiver)
+                .has(eagine::msgbus::verification_bit::message_content),
+          "not verified");
+        test.check(not message.text_content().empty(), "has content");
+        ++received;
+        return true;
+    };
+
+    eagine::timeout receive_time{std::chrono::seconds{10}};
+    while(received < count) {
+        if(receive_time.is_expired()) {
+            test.fail("failed to receive messages");
+            break;
+        }
+        router.update();
+        sender.update();
+        receiver.update();
+        receiver.process_all(msg_id, {eagine::construct_from, handler});
+    }
+    test.check_equal(received, count, "received all");
+}
+//------------------------------------------------------------------------------
 // main
 //------------------------------------------------------------------------------
 auto test_main(eagine::test_ctx& ctx) -> int {
     enable_message_bus(ctx);
     ctx.preinitialize();
 
-    eagitest::ctx_suite test{ctx, "endpoint", 5};
+    eagitest::ctx_suite test{ctx, "endpoint", 7};
     test.repeat(5, endpoint_connection_established);
     test.repeat(5, endpoint_connection_lost);
     test.repeat(5, endpoint_preconfigure_id);
     test.repeat(5, endpoint_get_id);
     test.repeat(5, endpoint_id_assigned);
+    test.repeat(5, endpoint_verify_incoming);
+    test.repeat(3, endpoint_verify_incoming_signed);
     return test.exit_code();
 }
 //------------------------------------------------------------------------------
@@ -9,9 +9,9 @@ export module eagine.msgbus.core:future;
 
 import std;
 import eagine.core.types;
-import eagine.core.container;
 import eagine.core.utility;
 import :types;
+import :timer_wheel;
 
 namespace eagine::msgbus {
 //------------------------------------------------------------------------------
@@ -49,6 +49,16 @@ public:
         return true;
     }
 
+    /// @brief Returns the time remaining until the promise times out.
+    auto time_left() const noexcept -> std::chrono::steady_clock::duration {
+        if(const auto state{_state.lock()}) {
+            return std::chrono::duration_cast<
+              std::chrono::steady_clock::duration>(
+              state->too_late.period() - state->too_late.elapsed_time());
+        }
+        return {};
+    }
+
     /// @brief Fulfills the promise and the corresponding future.
     void fulfill(T value) noexcept {
         if(const auto state{_state.lock()}) {
@@ -166,23 +176,32 @@ public:
     auto make() noexcept -> std::tuple<message_sequence_t, future<T>> {
         future<T> result{};
         const auto id{++_id_seq};
-        _promises[id] = result.get_promise();
+        // the timeout is usually set after this, so check it in the next tick
+        _promises.schedule(
+          id, result.get_promise(), std::chrono::milliseconds{0});
         return {id, result};
     }
 
     /// @brief Fulfills the promise/future pair identified by id with the given value.
     void fulfill(const message_sequence_t id, T value) noexcept {
-        if(const auto found{find(_promises, id)}) {
+        if(auto found{_promises.extract(id)}) {
             found->fulfill(std::move(value));
-            _promises.erase(found.position());
         }
         update();
     }
 
     /// @brief Update the internal state of this promise/future tracker.
     auto update() noexcept -> bool {
-        return _promises.erase_if(
-                 [](auto& p) { return p.second.should_be_removed(); }) > 0;
+        std::size_t removed{0U};
+        _promises.expire([&](const message_sequence_t id, promise<T>& p) {
+            if(p.should_be_removed()) {
+                ++removed;
+            } else {
+                const auto time_left{p.time_left()};
+                _promises.schedule(id, std::move(p), time_left);
+            }
+        });
+        return removed > 0U;
     }
 
     /// @brief Indicates if there are any unfulfilled pending promises.
@@ -199,7 +218,7 @@ public:
 
 private:
     message_sequence_t _id_seq{0};
-    flat_map<message_sequence_t, promise<T>> _promises{};
+    timer_wheel<message_sequence_t, promise<T>> _promises{};
 };
 //------------------------------------------------------------------------------
 } // namespace eagine::msgbus
@@ -15,6 +15,7 @@ import eagine.core.valid_if;
 import eagine.core.utility;
 import :types;
 import :message;
+import :wait;
 
 namespace eagine::msgbus {
 //------------------------------------------------------------------------------
@@ -50,6 +51,22 @@ export struct connection : connection_info {
         return {};
     }
 
+    /// @brief Waits until there may be incoming work or until the timeout expires.
+    /// The default implementation just sleeps for the specified time.
+    /// @see update
+    virtual auto wait_for_work(
+      const std::chrono::steady_clock::duration timeout) noexcept -> work_done {
+        std::this_thread::sleep_for(timeout);
+        return false;
+    }
+
+    /// @brief Adds the native handles signalling incoming work to the waiter.
+    /// Returns false if there are no such handles and wait_for_work must be used.
+    /// @see wait_for_work
+    virtual auto add_wait_handles(work_waiter&) noexcept -> bool {
+        return false;
+    }
+
     /// @brief Cleans up the connection before destroying it.
     virtual void cleanup() noexcept {}
 
@@ -106,6 +123,22 @@ export struct acceptor : connection_info {
         return {};
     }
 
+    /// @brief Waits until there may be accepted connections or the timeout expires.
+    /// The default implementation just sleeps for the specified time.
+    /// @see update
+    virtual auto wait_for_work(
+      const std::chrono::steady_clock::duration timeout) noexcept -> work_done {
+        std::this_thread::sleep_for(timeout);
+        return false;
+    }
+
+    /// @brief Adds the native handles signalling new connections to the waiter.
+    /// Returns false if there are no such handles and wait_for_work must be used.
+    /// @see wait_for_work
+    virtual auto add_wait_handles(work_waiter&) noexcept -> bool {
+        return false;
+    }
+
     /// @brief Lets the handler process the pending accepted connections.
     virtual auto process_accepted(const accept_handler handler) noexcept
       -> work_done = 0;
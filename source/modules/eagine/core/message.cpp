@@ -297,9 +297,23 @@ public:
         return as_chars(content());
     }
 
+    /// @brief Returns the received compact-serialized form of this message.
+    /// @note Empty unless the view was deserialized from a compact header.
+    /// @see compact_deserialize_message
+    [[nodiscard]] auto serialized() const noexcept -> memory::const_block {
+        return _serialized;
+    }
+
+    /// @brief Sets the received compact-serialized form of this message.
+    /// @see serialized
+    void set_serialized(const memory::const_block blk) noexcept {
+        _serialized = blk;
+    }
+
 private:
     /// @brief View of the message data content.
     memory::const_block _data;
+    memory::const_block _serialized;
 };
 //------------------------------------------------------------------------------
 /// @brief Serializes a bus message header with the specified serializer backend.
@@ -417,11 +431,13 @@ public:
     template <typename Source>
     void fetch_all_from(Source& source) noexcept {
         _buffer.clear();
+        _verified.reset();
         source.fetch_all(_buffer);
     }
 
     /// @brief Copies the content from the given block into the internal buffer.
     void store_content(memory::const_block blk) noexcept {
+        _verified.reset();
         memory::copy_into(blk, _buffer);
     }
 
@@ -533,11 +549,24 @@ public:
       main_ctx_object&) noexcept -> bool;
 
     /// @brief Verifies the signatures of this message.
+    /// @see cache_verify_bits
     [[nodiscard]] auto verify_bits(context&, main_ctx_object&) const noexcept
       -> verification_bits;
 
+    /// @brief Verifies the signatures and stores the result in this message.
+    /// @see verify_bits
+    /// @see has_cached_verify_bits
+    void cache_verify_bits(context&, main_ctx_object&) noexcept;
+
+    /// @brief Indicates if the result of verification is stored in this message.
+    /// @see cache_verify_bits
+    [[nodiscard]] auto has_cached_verify_bits() const noexcept -> bool {
+        return _verified.has_value();
+    }
+
 private:
     memory::buffer _buffer{};
+    std::optional<verification_bits> _verified{};
 };
 //------------------------------------------------------------------------------
 /// @brief Deserializes a bus message header with the specified deserializer backend.
@@ -619,6 +648,51 @@ export template <typename Backend>
     return deserialized;
 }
 //------------------------------------------------------------------------------
+// compact message header
+//------------------------------------------------------------------------------
+/// @brief The size of the fixed-layout compact message header in bytes.
+/// @ingroup msgbus
+/// @see compact_serialize_message
+export [[nodiscard]] constexpr auto compact_message_header_size() noexcept
+  -> span_size_t {
+    return 50;
+}
+//------------------------------------------------------------------------------
+/// @brief Indicates if the serialized message in a block has a compact header.
+/// @ingroup msgbus
+/// @see compact_serialize_message
+/// @see compact_deserialize_message
+export [[nodiscard]] auto has_compact_message_header(
+  const memory::const_block) noexcept -> bool;
+//------------------------------------------------------------------------------
+/// @brief Serializes a bus message with the compact header into a memory block.
+/// @ingroup msgbus
+/// @see compact_deserialize_message
+/// @see serialize_message
+/// @note Returns an empty block if the message does not fit into the destination.
+export [[nodiscard]] auto compact_serialize_message(
+  const message_id msg_id,
+  const message_view& msg,
+  memory::block dest) noexcept -> memory::const_block;
+//------------------------------------------------------------------------------
+/// @brief Deserializes a message with the compact header into a view of the block.
+/// @ingroup msgbus
+/// @see compact_deserialize_message
+/// @note The resulting message view references the content in the source block.
+export [[nodiscard]] auto compact_deserialize_message(
+  message_id& msg_id,
+  message_view& msg,
+  const memory::const_block src) noexcept -> bool;
+//------------------------------------------------------------------------------
+/// @brief Deserializes a bus message with the compact header from a memory block.
+/// @ingroup msgbus
+/// @see compact_serialize_message
+/// @see deserialize_message
+export [[nodiscard]] auto compact_deserialize_message(
+  message_id& msg_id,
+  stored_message& msg,
+  const memory::const_block src) noexcept -> bool;
+//------------------------------------------------------------------------------
 // default_deserialize
 //------------------------------------------------------------------------------
 /// @brief Uses the default backend to deserialize a value from a memory block.
@@ -926,6 +1000,12 @@ public:
       const memory::const_block message,
       const message_priority priority) noexcept;
 
+    /// @brief Adds a message of the specified size and returns its storage.
+    /// The returned block is to be filled with the serialized message.
+    [[nodiscard]] auto emplace(
+      const span_size_t size,
+      const message_priority priority) noexcept -> memory::block;
+
     auto fetch_all(const fetch_handler handler) noexcept -> bool;
 
     [[nodiscard]] auto pack_into(memory::block dest) noexcept
@@ -1008,52 +1088,144 @@ private:
     const message_sequence_t _invocation_id{0};
 };
 //------------------------------------------------------------------------------
+/// @brief FIFO ring of stored messages, growing when full.
+/// @ingroup msgbus
+/// @note The slots keep their stored_message objects, the buffers are released
+/// to the pool of the owning queue.
+class stored_message_ring {
+public:
+    [[nodiscard]] auto empty() const noexcept -> bool {
+        return _count == 0U;
+    }
+
+    [[nodiscard]] auto size() const noexcept -> span_size_t {
+        return span_size(_count);
+    }
+
+    auto push(const message_view& message, memory::buffer buf) noexcept
+      -> stored_message& {
+        if(_count == _slots.size()) [[unlikely]] {
+            _grow();
+        }
+        auto& slot{_slots[_index(_count)]};
+        slot = stored_message{message, std::move(buf)};
+        ++_count;
+        return slot;
+    }
+
+    [[nodiscard]] auto front() noexcept -> stored_message& {
+        assert(not empty());
+        return _slots[_head];
+    }
+
+    auto pop_front() noexcept -> memory::buffer {
+        auto buf{front().release_buffer()};
+        _head = _index(1U);
+        --_count;
+        return buf;
+    }
+
+    [[nodiscard]] auto at(const std::size_t i) noexcept -> stored_message& {
+        return _slots[_index(i)];
+    }
+
+    /// @brief Removes the messages for which the function returns true.
+    /// The order of the remaining messages is preserved.
+    template <typename Function>
+    auto remove_if(Function func) noexcept -> span_size_t {
+        std::size_t kept{0U};
+        for(std::size_t i = 0U; i < _count; ++i) {
+            auto& message{at(i)};
+            if(not func(message)) {
+                if(kept != i) {
+                    std::swap(at(kept), message);
+                }
+                ++kept;
+            }
+        }
+        const auto removed{_count - kept};
+        _count = kept;
+        return span_size(removed);
+    }
+
+    void clear() noexcept {
+        _head = 0U;
+        _count = 0U;
+    }
+
+private:
+    auto _index(const std::size_t i) const noexcept -> std::size_t {
+        // the number of slots is always a power of two
+        return (_head + i) & (_slots.size() - 1U);
+    }
+
+    void _grow() noexcept {
+        std::vector<stored_message> slots;
+        slots.resize(std::max<std::size_t>(_slots.size() * 2U, 16U));
+        for(std::size_t i = 0U; i < _count; ++i) {
+            slots[i] = std::move(at(i));
+        }
+        _slots = std::move(slots);
+        _head = 0U;
+    }
+
+    std::vector<stored_message> _slots;
+    std::size_t _head{0U};
+    std::size_t _count{0U};
+};
+//------------------------------------------------------------------------------
+/// @brief Queue of received messages, ordered by priority and FIFO within
+/// the same priority.
+/// @ingroup msgbus
 export class message_priority_queue {
 public:
     using handler_type =
       callable_ref<bool(const message_context&, const stored_message&) noexcept>;
 
-    message_priority_queue() noexcept {
-        _messages.reserve(128);
-    }
-
     [[nodiscard]] auto empty() const noexcept -> bool {
-        return _messages.empty();
+        return _count == 0;
     }
 
     [[nodiscard]] auto size() const noexcept -> span_size_t {
-        return _messages.size();
+        return _count;
     }
 
     auto push(const message_view& message) noexcept -> stored_message& {
-        const auto pos = std::lower_bound(
-          _messages.begin(),
-          _messages.end(),
-          message.priority,
-          [](auto& msg, auto pri) { return msg.priority < pri; });
-
-        return *_messages.emplace(
-          pos, message, _buffers.get(message.data().size()));
+        ++_count;
+        return _ring(message.priority)
+          .push(message, _buffers.get(message.data().size()));
     }
 
     auto process_one(
       const message_context& msg_ctx,
       const handler_type handler) noexcept -> bool {
-        if(not _messages.empty()) {
-            if(handler(msg_ctx, _messages.back())) {
-                _buffers.eat(_messages.back().release_buffer());
-                _messages.pop_back();
+        if(auto ring{_highest_nonempty()}) {
+            if(handler(msg_ctx, ring->front())) {
+                _buffers.eat(ring->pop_front());
+                --_count;
                 return true;
             }
         }
         return false;
     }
 
+    /// @brief Calls the specified function on each of the stored messages.
+    template <typename Function>
+    void for_each(Function func) noexcept {
+        for(auto& ring : _rings) {
+            for(std::size_t i = 0U, n = std::size_t(ring.size()); i < n; ++i) {
+                func(ring.at(i));
+            }
+        }
+    }
+
     void just_process_all(
       const message_context& msg_ctx,
       const handler_type handler) noexcept {
-        for(auto& message : _messages) {
-            handler(msg_ctx, message);
+        for(auto& ring : std::views::reverse(_rings)) {
+            for(std::size_t i = 0U, n = std::size_t(ring.size()); i < n; ++i) {
+                handler(msg_ctx, ring.at(i));
+            }
         }
     }
 
@@ -1062,17 +1234,40 @@ public:
       const handler_type handler) noexcept -> span_size_t;
 
     [[nodiscard]] auto give_messages() noexcept
-      -> pointee_generator<std::vector<stored_message>::iterator> {
-        for(auto pos{_messages.begin()}; pos != _messages.end(); ++pos) {
-            co_yield pos;
-            _buffers.eat(pos->release_buffer());
+      -> pointee_generator<stored_message*> {
+        for(auto& ring : std::views::reverse(_rings)) {
+            while(not ring.empty()) {
+                co_yield &ring.front();
+                _buffers.eat(ring.pop_front());
+                --_count;
+            }
         }
-        _messages.clear();
     }
 
 private:
+    static constexpr const std::size_t _ring_count{
+      std::size_t(std::to_underlying(message_priority::critical)) + 1U};
+
+    auto _ring(const message_priority priority) noexcept
+      -> stored_message_ring& {
+        return _rings[std::min(
+          std::size_t(std::to_underlying(priority)), _ring_count - 1U)];
+    }
+
+    auto _highest_nonempty() noexcept -> stored_message_ring* {
+        if(_count > 0) {
+            for(auto& ring : std::views::reverse(_rings)) {
+                if(not ring.empty()) {
+                    return &ring;
+                }
+            }
+        }
+        return nullptr;
+    }
+
     memory::buffer_pool _buffers{};
-    std::vector<stored_message> _messages;
+    std::array<stored_message_ring, _ring_count> _rings{};
+    span_size_t _count{0};
 };
 //------------------------------------------------------------------------------
 export class connection_outgoing_messages {
@@ -1089,6 +1284,15 @@ public:
       main_ctx_object& user,
       const message_id,
       const message_view&,
+      memory::block,
+      const message_header_format = message_header_format::portable) noexcept
+      -> bool;
+
+    /// @brief Enqueues the announcement or acknowledgement of compact headers.
+    /// @see connection_incoming_messages::peer_accepts_compact
+    [[nodiscard]] auto enqueue_header_format_notice(
+      main_ctx_object& user,
+      const bool acknowledge,
       memory::block) noexcept -> bool;
 
     [[nodiscard]] auto pack_into(memory::block dest) noexcept
@@ -1100,6 +1304,12 @@ public:
         _serialized.cleanup(packed);
     }
 
+    /// @brief Calls the handler on each serialized message, without packing.
+    auto fetch_all(const serialized_message_storage::fetch_handler handler) noexcept
+      -> bool {
+        return _serialized.fetch_all(handler);
+    }
+
     void log_stats(main_ctx_object& user) {
         _serialized.log_stats(user);
     }
@@ -1125,6 +1335,26 @@ public:
         _packed.push(data, message_priority::normal);
     }
 
+    /// @brief Returns the header format used by the remote peer.
+    /// Switches to compact when the first message with such header arrives.
+    [[nodiscard]] auto peer_header_format() const noexcept
+      -> message_header_format {
+        return _peer_header_format;
+    }
+
+    /// @brief Indicates if the peer announced or acknowledged compact headers.
+    /// @see connection_outgoing_messages::enqueue_header_format_notice
+    [[nodiscard]] auto peer_accepts_compact() const noexcept -> bool {
+        return _peer_accepts_compact or
+               (_peer_header_format == message_header_format::compact);
+    }
+
+    /// @brief Indicates if the peer's compact header announcement should be acked.
+    /// @note Returns true only once for each received announcement.
+    [[nodiscard]] auto should_acknowledge_compact() noexcept -> bool {
+        return std::exchange(_should_ack_compact, false);
+    }
+
     auto fetch_messages(
       main_ctx_object& user,
       const fetch_handler handler) noexcept -> bool;
@@ -1135,8 +1365,15 @@ public:
     }
 
 private:
+    auto _handle_header_format_notice(
+      const message_id,
+      const message_view&) noexcept -> bool;
+
     serialized_message_storage _packed{};
     message_storage _unpacked{};
+    message_header_format _peer_header_format{message_header_format::portable};
+    bool _peer_accepts_compact{false};
+    bool _should_ack_compact{false};
 };
 //------------------------------------------------------------------------------
 /// @brief Class tying information about subscriber message queue and its handler.
@@ -1170,7 +1407,7 @@ public:
 
     /// @brief Returns a view of messages in the message queue and later removes them.
     [[nodiscard]] auto give_messages() const noexcept
-      -> pointee_generator<std::vector<stored_message>::iterator> {
+      -> pointee_generator<stored_message*> {
         return _queue.give_messages();
     }
 
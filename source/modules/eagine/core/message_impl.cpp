@@ -60,6 +60,21 @@ auto stored_message::store_and_sign(
   const span_size_t max_size,
   context& ctx,
   main_ctx_object& user) noexcept -> bool {
+    _verified.reset();
+
+    if(target_id != broadcast_endpoint_id() and ctx.has_session_key(target_id)) {
+        _buffer.resize(max_size);
+        if(const auto used{store_data_with_size(data, storage())}) [[likely]] {
+            if(const auto mac{ctx.session_mac(
+                 data, target_id, skip(storage(), used.size()))}) [[likely]] {
+                crypto_flags |= message_crypto_flag::session_mac;
+                crypto_flags |= message_crypto_flag::signed_content;
+                _buffer.resize(used.size() + mac.size());
+                return true;
+            }
+            user.log_debug("failed to compute session MAC, signing message");
+        }
+    }
 
     if(const ok md_type{ctx.default_message_digest()}) {
         auto& ssl = ctx.ssl();
@@ -108,9 +123,22 @@ auto stored_message::store_and_sign(
 //------------------------------------------------------------------------------
 auto stored_message::verify_bits(context& ctx, main_ctx_object&) const noexcept
   -> verification_bits {
+    if(_verified) {
+        return *_verified;
+    }
+    if(crypto_flags.has(message_crypto_flag::session_mac)) {
+        return ctx.verify_session_mac(content(), signature(), source_id);
+    }
     return ctx.verify_remote_signature(content(), signature(), source_id);
 }
 //------------------------------------------------------------------------------
+void stored_message::cache_verify_bits(
+  context& ctx,
+  main_ctx_object& user) noexcept {
+    _verified.reset();
+    _verified = verify_bits(ctx, user);
+}
+//------------------------------------------------------------------------------
 // message_storage
 //------------------------------------------------------------------------------
 auto message_storage::fetch_all(const fetch_handler handler) noexcept -> bool {
@@ -228,6 +256,16 @@ void serialized_message_storage::push(
     }
 }
 //------------------------------------------------------------------------------
+auto serialized_message_storage::emplace(
+  const span_size_t size,
+  const message_priority priority) noexcept -> memory::block {
+    auto buf{_buffers.get(size)};
+    buf.resize(size);
+    auto& emplaced{_messages.emplace_back(
+      std::move(buf), _clock_t::now(), priority)};
+    return cover(std::get<0>(emplaced));
+}
+//------------------------------------------------------------------------------
 auto serialized_message_storage::pack_into(memory::block dest) noexcept
   -> message_pack_info {
     message_packing_context packing{dest};
@@ -283,23 +321,156 @@ void serialized_message_storage::log_stats(main_ctx_object& user) {
 auto message_priority_queue::process_all(
   const message_context& msg_ctx,
   const handler_type handler) noexcept -> span_size_t {
-    std::size_t result{_messages.size()};
-    bool clear_all{true};
-    for(auto& message : _messages) {
-        if(handler(msg_ctx, message)) {
-            _buffers.eat(message.release_buffer());
-            message.mark_too_old();
-        } else {
-            clear_all = false;
-        }
+    span_size_t result{0};
+    for(auto& ring : std::views::reverse(_rings)) {
+        result += ring.remove_if([&](stored_message& message) {
+            if(handler(msg_ctx, message)) {
+                _buffers.eat(message.release_buffer());
+                return true;
+            }
+            return false;
+        });
     }
-    if(clear_all) {
-        _messages.clear();
-    } else {
-        result = std::erase_if(
-          _messages, [](const auto& message) { return message.too_many_hops(); });
+    _count -= result;
+    return result;
+}
+//------------------------------------------------------------------------------
+// compact message header
+//------------------------------------------------------------------------------
+// The compact header is a fixed little-endian layout:
+//  [0] marker (never the first byte of a portable header), [1] version,
+//  [2] priority, [3] crypto flags, [4] hop count, [5] age, [6..9] sequence,
+//  [10..17] class id, [18..25] method id, [26..33] source id,
+//  [34..41] target id, [42..49] serializer id; followed by the content.
+constexpr const byte compact_header_marker{0xFFU};
+constexpr const byte compact_header_version{0x01U};
+//------------------------------------------------------------------------------
+template <typename T>
+static inline void compact_header_put(
+  memory::block dest,
+  span_size_t offs,
+  T value) noexcept {
+    for(std::size_t b = 0; b < sizeof(T); ++b) {
+        dest[offs++] = byte(std::uint64_t(value) >> (b * 8U));
+    }
+}
+//------------------------------------------------------------------------------
+template <typename T>
+static inline auto compact_header_get(
+  const memory::const_block src,
+  span_size_t offs) noexcept -> T {
+    std::uint64_t result{0U};
+    for(std::size_t b = 0; b < sizeof(T); ++b) {
+        result |= std::uint64_t(src[offs++]) << (b * 8U);
+    }
+    return T(result);
+}
+//------------------------------------------------------------------------------
+auto has_compact_message_header(const memory::const_block blk) noexcept
+  -> bool {
+    return (blk.size() >= compact_message_header_size()) and
+           (blk[0] == compact_header_marker);
+}
+//------------------------------------------------------------------------------
+static inline void compact_serialize_message_header(
+  const message_id msg_id,
+  const message_view& msg,
+  memory::block dest) noexcept {
+    assert(dest.size() >= compact_message_header_size());
+    dest[0] = compact_header_marker;
+    dest[1] = compact_header_version;
+    compact_header_put(dest, 2, std::uint8_t(msg.priority));
+    compact_header_put(dest, 3, std::uint8_t(msg.crypto_flags.bits()));
+    compact_header_put(dest, 4, std::uint8_t(msg.hop_count));
+    compact_header_put(dest, 5, std::uint8_t(msg.age_quarter_seconds));
+    compact_header_put(dest, 6, msg.sequence_no);
+    compact_header_put(dest, 10, msg_id.class_().value());
+    compact_header_put(dest, 18, msg_id.method().value());
+    compact_header_put(dest, 26, msg.source_id.value());
+    compact_header_put(dest, 34, msg.target_id.value());
+    compact_header_put(dest, 42, msg.serializer_id.value());
+}
+//------------------------------------------------------------------------------
+static inline auto compact_deserialize_message_header(
+  message_id& msg_id,
+  message_info& msg,
+  const memory::const_block src) noexcept -> bool {
+    if(not has_compact_message_header(src)) [[unlikely]] {
+        return false;
+    }
+    if(src[1] != compact_header_version) [[unlikely]] {
+        return false;
+    }
+    using U = std::uint8_t;
+    msg.priority = message_priority(compact_header_get<U>(src, 2));
+    msg.crypto_flags = message_crypto_flags{
+      message_crypto_flag(compact_header_get<U>(src, 3))};
+    msg.hop_count = message_info::hop_count_t(compact_header_get<U>(src, 4));
+    msg.age_quarter_seconds = message_info::age_t(compact_header_get<U>(src, 5));
+    msg.sequence_no = compact_header_get<message_sequence_t>(src, 6);
+    msg_id = {
+      identifier{compact_header_get<identifier_t>(src, 10)},
+      identifier{compact_header_get<identifier_t>(src, 18)}};
+    msg.source_id = endpoint_id_t{compact_header_get<identifier_t>(src, 26)};
+    msg.target_id = endpoint_id_t{compact_header_get<identifier_t>(src, 34)};
+    msg.serializer_id = endpoint_id_t{compact_header_get<identifier_t>(src, 42)};
+    return true;
+}
+//------------------------------------------------------------------------------
+auto compact_serialize_message(
+  const message_id msg_id,
+  const message_view& msg,
+  memory::block dest) noexcept -> memory::const_block {
+    const auto data{msg.data()};
+    const auto size{compact_message_header_size() + data.size()};
+    if(dest.size() < size) [[unlikely]] {
+        return {};
     }
-    return span_size(result);
+    compact_serialize_message_header(msg_id, msg, dest);
+    memory::copy(data, skip(dest, compact_message_header_size()));
+    return head(dest, size);
+}
+//------------------------------------------------------------------------------
+auto compact_deserialize_message(
+  message_id& msg_id,
+  message_view& msg,
+  const memory::const_block src) noexcept -> bool {
+    if(compact_deserialize_message_header(msg_id, msg, src)) [[likely]] {
+        msg = {msg, skip(src, compact_message_header_size())};
+        msg.set_serialized(src);
+        return true;
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+auto compact_deserialize_message(
+  message_id& msg_id,
+  stored_message& msg,
+  const memory::const_block src) noexcept -> bool {
+    if(compact_deserialize_message_header(msg_id, msg, src)) [[likely]] {
+        msg.store_content(skip(src, compact_message_header_size()));
+        return true;
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+// Indicates if the received compact form of a message can be forwarded as is,
+// with only the hop count and age (changed by the routers) patched in place.
+static inline auto compact_is_forwardable(
+  const message_id msg_id,
+  const message_view& msg) noexcept -> bool {
+    const auto src{msg.serialized()};
+    const auto data{msg.data()};
+    return has_compact_message_header(src) and
+           (src.size() == compact_message_header_size() + data.size()) and
+           (skip(src, compact_message_header_size()).data() == data.data()) and
+           (compact_header_get<identifier_t>(src, 10) ==
+            msg_id.class_().value()) and
+           (compact_header_get<identifier_t>(src, 18) ==
+            msg_id.method().value()) and
+           (compact_header_get<identifier_t>(src, 26) ==
+            msg.source_id.value()) and
+           (compact_header_get<identifier_t>(src, 34) == msg.target_id.value());
 }
 //------------------------------------------------------------------------------
 // connection_outgoing_messages
@@ -308,7 +479,35 @@ auto connection_outgoing_messages::enqueue(
   main_ctx_object& user,
   const message_id msg_id,
   const message_view& message,
-  memory::block temp) noexcept -> bool {
+  memory::block temp,
+  const message_header_format header_format) noexcept -> bool {
+
+    if(header_format == message_header_format::compact) {
+        // the fixed-layout header and the content are written directly
+        // into the outgoing storage, without the temporary buffer
+        const auto size{compact_message_header_size() + message.data().size()};
+        if(size <= temp.size()) [[likely]] {
+            if(compact_is_forwardable(msg_id, message)) {
+                // the received form is reused with the hop count and age
+                // patched in place, without serializing the header again
+                auto dest{_serialized.emplace(size, message.priority)};
+                memory::copy(message.serialized(), dest);
+                compact_header_put(dest, 4, std::uint8_t(message.hop_count));
+                compact_header_put(
+                  dest, 5, std::uint8_t(message.age_quarter_seconds));
+            } else {
+                compact_serialize_message(
+                  msg_id, message, _serialized.emplace(size, message.priority));
+            }
+            user.log_trace("enqueuing message ${message} to be sent")
+              .arg("message", msg_id);
+            return true;
+        }
+        user.log_error("failed to serialize message ${message}")
+          .arg("message", msg_id)
+          .arg("content", message.content());
+        return false;
+    }
 
     block_data_sink sink(temp);
     default_serializer_backend backend(sink);
@@ -329,20 +528,98 @@ auto connection_outgoing_messages::enqueue(
 //------------------------------------------------------------------------------
 // connection_incoming_messages
 //------------------------------------------------------------------------------
+// The header format notices are exchanged directly between the two ends
+// of a connection, in the portable format and marked as too old, so that
+// nodes not supporting them drop them instead of routing them further.
+auto connection_outgoing_messages::enqueue_header_format_notice(
+  main_ctx_object& user,
+  const bool acknowledge,
+  memory::block temp) noexcept -> bool {
+    const std::array<byte, 1> content{compact_header_version};
+    message_view message{view(content)};
+    message.set_priority(message_priority::critical);
+    message.mark_too_old();
+    return enqueue(
+      user,
+      acknowledge ? msgbus_id{"hdrFmtAck"} : msgbus_id{"hdrFmtCap"},
+      message,
+      temp);
+}
+//------------------------------------------------------------------------------
+auto connection_incoming_messages::_handle_header_format_notice(
+  const message_id msg_id,
+  const message_view& message) noexcept -> bool {
+    if(is_special_message(msg_id)) [[unlikely]] {
+        const bool is_ack{msg_id.has_method("hdrFmtAck")};
+        if(is_ack or msg_id.has_method("hdrFmtCap")) {
+            const auto content{message.content()};
+            if(not content.empty() and
+               (content[0] == compact_header_version)) {
+                _peer_accepts_compact = true;
+                _should_ack_compact |= not is_ack;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
 auto connection_incoming_messages::fetch_messages(
   main_ctx_object& user,
   const fetch_handler handler) noexcept -> bool {
-    const auto unpacker{[this, &user](
+    // messages with the compact header that are not preceded by other
+    // pending messages are passed to the handler as views of the received
+    // block, without copying them into the unpacked storage
+    const auto dispatch_compact{[this, &user, handler](
+                                  const message_timestamp data_ts,
+                                  const memory::const_block blk) -> bool {
+        if(not _unpacked.empty()) {
+            return false;
+        }
+        message_id msg_id{};
+        message_view message{};
+        if(not compact_deserialize_message(msg_id, message, blk)) [[unlikely]] {
+            return false;
+        }
+        user.log_trace("fetched message ${message}").arg("message", msg_id);
+        if(_handle_header_format_notice(msg_id, message)) [[unlikely]] {
+            return true;
+        }
+        const auto msg_age{std::chrono::duration_cast<message_age>(
+          std::chrono::steady_clock::now() - data_ts)};
+        return handler(msg_id, msg_age, message);
+    }};
+
+    const auto unpacker{[this, &user, &dispatch_compact](
                           const message_timestamp data_ts,
                           const message_priority,
                           const memory::const_block data) {
         for_each_data_with_size(
-          data, [this, &user, data_ts](const memory::const_block blk) {
+          data,
+          [this, &user, &dispatch_compact, data_ts](const memory::const_block blk) {
               if(not blk.empty()) [[likely]] {
+                  if(has_compact_message_header(blk)) {
+                      _peer_header_format = message_header_format::compact;
+                      if(dispatch_compact(data_ts, blk)) [[likely]] {
+                          return;
+                      }
+                  }
                   _unpacked.push_if([&user, data_ts, blk](
                                       message_id& msg_id,
                                       message_timestamp& msg_ts,
                                       stored_message& message) {
+                      if(has_compact_message_header(blk)) {
+                          if(compact_deserialize_message(msg_id, message, blk))
+                            [[likely]] {
+                              user.log_trace("fetched message ${message}")
+                                .arg("message", msg_id);
+                              msg_ts = data_ts;
+                              return true;
+                          }
+                          user.log_error("failed to deserialize message")
+                            .arg("block", blk);
+                          return false;
+                      }
                       block_data_source source(blk);
                       default_deserializer_backend backend(source);
                       if(const auto deserialized{deserialize_message(
@@ -364,7 +641,17 @@ auto connection_incoming_messages::fetch_messages(
     }};
 
     if(_packed.fetch_all({construct_from, unpacker})) {
-        _unpacked.fetch_all(handler);
+        _unpacked.fetch_all(
+          {construct_from,
+           [this, handler](
+             const message_id msg_id,
+             const message_age msg_age,
+             const message_view& message) noexcept {
+               if(_handle_header_format_notice(msg_id, message)) [[unlikely]] {
+                   return true;
+               }
+               return handler(msg_id, msg_age, message);
+           }});
     }
     return false;
 }
@@ -658,10 +658,486 @@ void connection_in_out_messages_push_fetch(unsigned, auto& s) {
     test.check_equal(nout, ninc, "all transferred");
 }
 //------------------------------------------------------------------------------
+void message_compact_message_roundtrip(unsigned, auto& s) {
+    eagitest::case_ test{s, 14, "compact message round-trip"};
+    auto& rg{test.random()};
+
+    std::vector<eagine::byte> buffer;
+    std::vector<eagine::byte> content;
+
+    for(const auto& info :
+        eagine::enumerators<eagine::msgbus::message_priority>()) {
+        const eagine::message_id msg_id{
+          eagine::random_identifier(), eagine::random_identifier()};
+        content.resize(rg.get_between<std::size_t>(0, 1920));
+        rg.fill(content);
+
+        eagine::msgbus::message_view message{eagine::view(content)};
+        message.set_source_id(eagine::random_identifier().value());
+        message.set_target_id(eagine::random_identifier().value());
+        message.set_sequence_no(
+          rg.get_between<eagine::msgbus::message_sequence_t>(0U, 1000000U));
+        message.set_priority(info.enumerator);
+        const auto serialized_id{eagine::random_identifier()};
+        message.set_serializer_id(serialized_id);
+        const auto age{rg.get_between(
+          eagine::msgbus::message_age{1}, eagine::msgbus::message_age{25})};
+        message.add_age(age);
+
+        buffer.resize(std::size_t(
+          eagine::msgbus::compact_message_header_size() +
+          eagine::view(content).size()));
+        const auto serialized{eagine::msgbus::compact_serialize_message(
+          msg_id, message, eagine::cover(buffer))};
+        test.ensure(not serialized.empty(), "serialized");
+        test.check(
+          eagine::msgbus::has_compact_message_header(serialized),
+          "has compact header");
+        test.check(
+          eagine::msgbus::compact_serialize_message(
+            msg_id, message, head(eagine::cover(buffer), buffer.size() - 1U))
+            .empty(),
+          "does not fit");
+
+        eagine::message_id msg_id_d;
+        eagine::msgbus::stored_message dest;
+        test.ensure(
+          eagine::msgbus::compact_deserialize_message(msg_id_d, dest, serialized),
+          "deserialized");
+
+        test.check(msg_id == msg_id_d, "message id ok");
+        test.check(dest.source_id == message.source_id, "source ok");
+        test.check(dest.target_id == message.target_id, "target ok");
+        test.check(dest.sequence_no == message.sequence_no, "sequence ok");
+        test.check(dest.priority == info.enumerator, "priority ok");
+        test.check(dest.hop_count == message.hop_count, "hop count ok");
+        test.check(
+          dest.age_quarter_seconds == message.age_quarter_seconds, "age ok");
+        test.check(
+          dest.serializer_id == serialized_id.value(), "serializer ok");
+        test.check(
+          eagine::are_equal(eagine::view(content), dest.const_content()),
+          "content ok");
+    }
+}
+//------------------------------------------------------------------------------
+void connection_in_out_compact_header(unsigned, auto& s) {
+    eagitest::case_ test{s, 15, "connection in/out compact header"};
+    eagitest::track trck{test, 0, 1};
+    auto& rg{test.random()};
+
+    eagine::msgbus::connection_outgoing_messages out;
+    eagine::msgbus::connection_incoming_messages inc;
+    eagine::main_ctx_object user{"Test", s.context()};
+
+    test.check(
+      inc.peer_header_format() == eagine::msgbus::message_header_format::portable,
+      "portable by default");
+
+    const auto fetch_func = [&](
+                              const eagine::message_id msg_id,
+                              const eagine::msgbus::message_age,
+                              const eagine::msgbus::message_view& msg) {
+        test.check(
+          eagine::are_equal(
+            msg.content(), eagine::memory::as_bytes(msg_id.method().name().view())),
+          "content");
+        trck.checkpoint(1);
+        return true;
+    };
+
+    std::vector<eagine::byte> temp(1U << rg.get_std_size(10, 15));
+    const auto mc{rg.get_between(1U, 50U)};
+    for(unsigned m = 0; m < mc; ++m) {
+        const eagine::message_id msg_id{
+          eagine::random_identifier(), eagine::random_identifier()};
+        eagine::msgbus::message_view message{
+          eagine::memory::as_bytes(msg_id.method().name().view())};
+        test.check(
+          out.enqueue(
+            user,
+            msg_id,
+            message,
+            eagine::cover(temp),
+            eagine::msgbus::message_header_format::compact),
+          "enqueued");
+    }
+
+    while(not out.empty()) {
+        const auto packed{out.pack_into(eagine::cover(temp))};
+        inc.push(head(eagine::view(temp), packed.used()));
+        out.cleanup(packed);
+    }
+    while(not inc.empty()) {
+        inc.fetch_messages(user, {eagine::construct_from, fetch_func});
+    }
+
+    test.check(
+      inc.peer_header_format() == eagine::msgbus::message_header_format::compact,
+      "peer uses compact header");
+}
+//------------------------------------------------------------------------------
+// message priority queue order
+//------------------------------------------------------------------------------
+void message_priority_queue_order(unsigned, auto& s) {
+    eagitest::case_ test{s, 16, "message priority queue order"};
+    eagitest::track trck{test, 0, 1};
+    auto& rg{test.random()};
+
+    eagine::msgbus::message_priority_queue queue;
+    test.check(queue.empty(), "is empty");
+
+    const auto rc{rg.get_between(1U, 2000U)};
+    for(unsigned r = 0; r < rc; ++r) {
+        eagine::msgbus::message_view message{};
+        message.set_priority(eagine::msgbus::message_priority(
+          rg.get_between<unsigned>(0U, 4U)));
+        message.set_sequence_no(r);
+        queue.push(message);
+        test.check_equal(queue.size(), r + 1, "size");
+    }
+
+    auto prev_priority{eagine::msgbus::message_priority::critical};
+    eagine::msgbus::message_sequence_t prev_sequence_no{0U};
+    bool first{true};
+    for(auto& message : queue.give_messages()) {
+        test.check(message.priority <= prev_priority, "priority order");
+        if(message.priority == prev_priority and not first) {
+            test.check(message.sequence_no > prev_sequence_no, "FIFO order");
+        }
+        prev_priority = message.priority;
+        prev_sequence_no = message.sequence_no;
+        first = false;
+        trck.checkpoint(1);
+    }
+    test.check(queue.empty(), "is empty");
+}
+//------------------------------------------------------------------------------
+// message tracer
+//------------------------------------------------------------------------------
+void message_tracer_records(unsigned, auto& s) {
+    eagitest::case_ test{s, 17, "message tracer"};
+    using eagine::msgbus::message_trace_point;
+
+    eagine::msgbus::message_tracer disabled{};
+    test.check(not disabled.is_enabled(), "disabled");
+
+    eagine::msgbus::message_tracer tracer{
+      eagine::msgbus::node_kind::router, 1, 16};
+    test.check(tracer.is_enabled(), "enabled");
+
+    const eagine::message_id msg_id{"test", "method"};
+    const eagine::message_id special_id{eagine::msgbus::msgbus_id{"ping"}};
+    eagine::msgbus::message_view message{};
+    message.set_source_id(eagine::endpoint_id_t{1234});
+    message.set_sequence_no(5678U);
+    test.check(tracer.is_sampled(msg_id, message), "sampled");
+    test.check(not tracer.is_sampled(special_id, message), "special");
+
+    tracer.stamp(message_trace_point::receive, msg_id, message);
+    tracer.stamp(message_trace_point::enqueue, msg_id, message);
+    tracer.stamp(message_trace_point::submit, msg_id, message);
+    tracer.stamp(message_trace_point::accept, msg_id, message);
+    tracer.stamp(message_trace_point::accept, special_id, message);
+
+    const auto records{
+      tracer.fetch_records(eagine::endpoint_id_t{42}, std::chrono::seconds{0})};
+    test.check_equal(records.size(), std::size_t(1), "one record");
+    for(const auto& record : records) {
+        test.check(record.node_id == eagine::endpoint_id_t{42}, "node id");
+        test.check(record.source_id == eagine::endpoint_id_t{1234}, "source");
+        test.check_equal(record.sequence_no, 5678U, "sequence no");
+        test.check_equal(record.receive_ns, std::int64_t(0), "receive");
+        test.check(record.enqueue_ns >= 0, "enqueue");
+        test.check(record.submit_ns >= record.enqueue_ns, "submit");
+        test.check(record.accept_ns >= record.submit_ns, "accept");
+        test.check(record.dispatch_ns < 0, "not dispatched");
+    }
+    test.check(
+      tracer.fetch_records(eagine::endpoint_id_t{42}, std::chrono::seconds{0})
+        .empty(),
+      "fetched");
+
+    for(unsigned r = 0; r < 100U; ++r) {
+        message.set_sequence_no(r);
+        tracer.stamp(message_trace_point::receive, msg_id, message);
+    }
+    // the kept records are found again, the evicted ones are recorded anew
+    message.set_sequence_no(90U);
+    tracer.stamp(message_trace_point::dispatch, msg_id, message);
+    message.set_sequence_no(99U);
+    tracer.stamp(message_trace_point::dispatch, msg_id, message);
+    message.set_sequence_no(10U);
+    tracer.stamp(message_trace_point::dispatch, msg_id, message);
+
+    const auto kept{
+      tracer.fetch_records(eagine::endpoint_id_t{42}, std::chrono::seconds{0})};
+    test.check_equal(kept.size(), std::size_t(16), "capacity");
+    unsigned dispatched{0U};
+    for(const auto& record : kept) {
+        if(record.dispatch_ns >= 0) {
+            ++dispatched;
+            if(record.sequence_no == 10U) {
+                test.check(record.receive_ns < 0, "evicted not received");
+            } else {
+                test.check(record.receive_ns >= 0, "kept received");
+            }
+        }
+    }
+    test.check_equal(dispatched, 3U, "dispatched");
+}
+//------------------------------------------------------------------------------
+// connection header format negotiation
+//------------------------------------------------------------------------------
+void connection_header_format_negotiation(unsigned, auto& s) {
+    eagitest::case_ test{s, 18, "connection header format negotiation"};
+    eagitest::track trck{test, 0, 1};
+
+    eagine::msgbus::connection_outgoing_messages a_out;
+    eagine::msgbus::connection_incoming_messages a_inc;
+    eagine::msgbus::connection_outgoing_messages b_out;
+    eagine::msgbus::connection_incoming_messages b_inc;
+    eagine::main_ctx_object user{"Test", s.context()};
+    std::vector<eagine::byte> temp(4096);
+
+    const auto transfer{[&](auto& out, auto& inc) {
+        while(not out.empty()) {
+            const auto packed{out.pack_into(eagine::cover(temp))};
+            inc.push(head(eagine::view(temp), packed.used()));
+            out.cleanup(packed);
+        }
+    }};
+    const auto fetch_func = [&](
+                              const eagine::message_id msg_id,
+                              const eagine::msgbus::message_age,
+                              const eagine::msgbus::message_view&) {
+        test.check(msg_id == eagine::message_id{"test", "method"}, "not notice");
+        trck.checkpoint(1);
+        return true;
+    };
+
+    test.check(not a_inc.peer_accepts_compact(), "a does not know b");
+    test.check(not b_inc.peer_accepts_compact(), "b does not know a");
+
+    // a announces compact headers, followed by a regular message
+    const eagine::message_id msg_id{"test", "method"};
+    eagine::msgbus::message_view message{};
+    test.check(
+      a_out.enqueue_header_format_notice(user, false, eagine::cover(temp)),
+      "announced");
+    test.check(a_out.enqueue(user, msg_id, message, eagine::cover(temp)), "sent");
+    transfer(a_out, b_inc);
+    while(not b_inc.empty()) {
+        b_inc.fetch_messages(user, {eagine::construct_from, fetch_func});
+    }
+    test.check(b_inc.peer_accepts_compact(), "b knows a");
+    test.check(b_inc.should_acknowledge_compact(), "b should ack");
+    test.check(not b_inc.should_acknowledge_compact(), "b acks once");
+
+    // a learns about the support only from the acknowledgement
+    test.check(not a_inc.peer_accepts_compact(), "a still does not know b");
+    test.check(
+      b_out.enqueue_header_format_notice(user, true, eagine::cover(temp)),
+      "acknowledged");
+    transfer(b_out, a_inc);
+    while(not a_inc.empty()) {
+        a_inc.fetch_messages(user, {eagine::construct_from, fetch_func});
+    }
+    test.check(a_inc.peer_accepts_compact(), "a knows b");
+    test.check(not a_inc.should_acknowledge_compact(), "a does not ack ack");
+    test.check(
+      a_inc.peer_header_format() == eagine::msgbus::message_header_format::portable,
+      "notices are portable");
+}
+//------------------------------------------------------------------------------
+// connection mixed header formats
+//------------------------------------------------------------------------------
+void connection_in_out_mixed_headers(unsigned, auto& s) {
+    eagitest::case_ test{s, 19, "connection in/out mixed header formats"};
+    eagitest::track trck{test, 0, 1};
+    auto& rg{test.random()};
+    using eagine::msgbus::message_header_format;
+
+    eagine::msgbus::connection_outgoing_messages out;
+    eagine::msgbus::connection_incoming_messages inc;
+    eagine::main_ctx_object user{"Test", s.context()};
+    std::vector<eagine::byte> temp(1U << rg.get_std_size(11, 15));
+
+    const eagine::message_id msg_id{"test", "mixed"};
+    const eagine::endpoint_id_t source_id{1234};
+    const eagine::endpoint_id_t target_id{5678};
+    eagine::msgbus::message_sequence_t next_sent{0U};
+    eagine::msgbus::message_sequence_t next_received{0U};
+
+    const auto fetch_func = [&](
+                              const eagine::message_id fetched_id,
+                              const eagine::msgbus::message_age,
+                              const eagine::msgbus::message_view& msg) {
+        test.check(fetched_id == msg_id, "message id");
+        test.check_equal(msg.sequence_no, next_received, "order");
+        test.check(msg.source_id == source_id, "source");
+        test.check(msg.target_id == target_id, "target");
+        test.check_equal(
+          int(msg.hop_count), int(msg.sequence_no % 7U), "hop count");
+        test.check(
+          eagine::are_equal(
+            msg.content(),
+            eagine::memory::as_bytes(fetched_id.method().name().view())),
+          "content");
+        ++next_received;
+        trck.checkpoint(1);
+        return true;
+    };
+
+    for(unsigned r = 0; r < test.repeats(20); ++r) {
+        const auto mc{rg.get_between(1U, 50U)};
+        for(unsigned m = 0; m < mc; ++m) {
+            eagine::msgbus::message_view message{
+              eagine::memory::as_bytes(msg_id.method().name().view())};
+            message.set_source_id(source_id);
+            message.set_target_id(target_id);
+            message.set_sequence_no(next_sent);
+            for(unsigned h = 0; h < next_sent % 7U; ++h) {
+                message.add_hop();
+            }
+            ++next_sent;
+            test.check(
+              out.enqueue(
+                user,
+                msg_id,
+                message,
+                eagine::cover(temp),
+                rg.get_bool() ? message_header_format::compact
+                              : message_header_format::portable),
+              "enqueued");
+        }
+        while(not out.empty()) {
+            const auto packed{out.pack_into(eagine::cover(temp))};
+            inc.push(head(eagine::view(temp), packed.used()));
+            out.cleanup(packed);
+            if(rg.get_bool()) {
+                inc.fetch_messages(user, {eagine::construct_from, fetch_func});
+            }
+        }
+    }
+    while(not inc.empty()) {
+        inc.fetch_messages(user, {eagine::construct_from, fetch_func});
+    }
+    test.check_equal(next_received, next_sent, "all received");
+}
+//------------------------------------------------------------------------------
+// connection compact forwarding
+//------------------------------------------------------------------------------
+void connection_compact_forwarding(unsigned, auto& s) {
+    eagitest::case_ test{s, 20, "connection compact forwarding"};
+    eagitest::track trck{test, 0, 2};
+    auto& rg{test.random()};
+    using eagine::msgbus::message_header_format;
+
+    eagine::msgbus::connection_outgoing_messages out1;
+    eagine::msgbus::connection_incoming_messages inc1;
+    eagine::msgbus::connection_outgoing_messages out2;
+    eagine::msgbus::connection_incoming_messages inc2;
+    eagine::main_ctx_object user{"Test", s.context()};
+    std::vector<eagine::byte> temp(1U << rg.get_std_size(11, 15));
+
+    const eagine::message_id msg_id{"test", "forward"};
+    const eagine::endpoint_id_t source_id{1234};
+    const eagine::endpoint_id_t target_id{5678};
+    const eagine::endpoint_id_t other_id{8765};
+    eagine::msgbus::message_sequence_t next_sent{0U};
+    eagine::msgbus::message_sequence_t next_received{0U};
+
+    // forwards the messages like the router, some of them are re-addressed
+    const auto forward_func = [&](
+                                const eagine::message_id fetched_id,
+                                const eagine::msgbus::message_age,
+                                const eagine::msgbus::message_view& msg) {
+        test.check(not msg.serialized().empty(), "has serialized");
+        auto forwarded{msg};
+        forwarded.add_hop();
+        forwarded.add_age(eagine::msgbus::message_age{50});
+        if(forwarded.sequence_no % 3U == 0U) {
+            forwarded.set_target_id(other_id);
+        }
+        test.check(
+          out2.enqueue(
+            user,
+            fetched_id,
+            forwarded,
+            eagine::cover(temp),
+            message_header_format::compact),
+          "forwarded");
+        trck.checkpoint(1);
+        return true;
+    };
+
+    const auto fetch_func = [&](
+                              const eagine::message_id fetched_id,
+                              const eagine::msgbus::message_age,
+                              const eagine::msgbus::message_view& msg) {
+        test.check(fetched_id == msg_id, "message id");
+        test.check_equal(msg.sequence_no, next_received, "order");
+        test.check(msg.source_id == source_id, "source");
+        test.check(
+          msg.target_id == (msg.sequence_no % 3U == 0U ? other_id : target_id),
+          "target");
+        test.check_equal(
+          int(msg.hop_count), int(msg.sequence_no % 5U) + 1, "hop count");
+        test.check_equal(int(msg.age_quarter_seconds), 2, "age");
+        test.check(
+          eagine::are_equal(
+            msg.content(),
+            eagine::memory::as_bytes(fetched_id.method().name().view())),
+          "content");
+        ++next_received;
+        trck.checkpoint(2);
+        return true;
+    };
+
+    const auto transfer{[&](auto& out, auto& inc) {
+        while(not out.empty()) {
+            const auto packed{out.pack_into(eagine::cover(temp))};
+            inc.push(head(eagine::view(temp), packed.used()));
+            out.cleanup(packed);
+        }
+    }};
+
+    const auto mc{rg.get_between(1U, 100U)};
+    for(unsigned m = 0; m < mc; ++m) {
+        eagine::msgbus::message_view message{
+          eagine::memory::as_bytes(msg_id.method().name().view())};
+        message.set_source_id(source_id);
+        message.set_target_id(target_id);
+        message.set_sequence_no(next_sent);
+        for(unsigned h = 0; h < next_sent % 5U; ++h) {
+            message.add_hop();
+        }
+        ++next_sent;
+        test.check(
+          out1.enqueue(
+            user,
+            msg_id,
+            message,
+            eagine::cover(temp),
+            message_header_format::compact),
+          "enqueued");
+    }
+    transfer(out1, inc1);
+    while(not inc1.empty()) {
+        inc1.fetch_messages(user, {eagine::construct_from, forward_func});
+    }
+    transfer(out2, inc2);
+    while(not inc2.empty()) {
+        inc2.fetch_messages(user, {eagine::construct_from, fetch_func});
+    }
+    test.check_equal(next_received, next_sent, "all received");
+}
+//------------------------------------------------------------------------------
 // main
 //------------------------------------------------------------------------------
 auto test_main(eagine::test_ctx& ctx) -> int {
-    eagitest::ctx_suite test{ctx, "message", 13};
+    eagitest::ctx_suite test{ctx, "message", 20};
     test.once(message_valid_endpoint_id);
     test.once(message_is_special);
     test.once(message_serialize_header_roundtrip);
@@ -675,6 +1151,13 @@ auto test_main(eagine::test_ctx& ctx) -> int {
     test.repeat(10, serialized_message_storage_push_fetch);
     test.repeat(10, serialized_message_storage_push_if_fetch);
     test.repeat(10, connection_in_out_messages_push_fetch);
+    test.repeat(10, message_compact_message_roundtrip);
+    test.repeat(10, connection_in_out_compact_header);
+    test.repeat(10, message_priority_queue_order);
+    test.once(message_tracer_records);
+    test.repeat(10, connection_header_format_negotiation);
+    test.repeat(10, connection_in_out_mixed_headers);
+    test.repeat(10, connection_compact_forwarding);
     return test.exit_code();
 }
 //------------------------------------------------------------------------------
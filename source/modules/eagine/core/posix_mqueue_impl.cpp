@@ -11,6 +11,7 @@ module;
 	__has_include(<mqueue.h>) && \
 	__has_include(<sys/resource.h>)
 #include <cassert>
+#include <ctime>
 #include <fcntl.h>
 #include <mqueue.h>
 #include <sys/resource.h>
@@ -19,6 +20,14 @@ module;
 #define EAGINE_POSIX 0
 #endif
 
+// on Linux message queue descriptors are file descriptors that can be polled
+#if EAGINE_POSIX && defined(__linux__) && __has_include(<poll.h>)
+#include <poll.h>
+#define EAGINE_POSIX_MQUEUE_POLL 1
+#else
+#define EAGINE_POSIX_MQUEUE_POLL 0
+#endif
+
 module eagine.msgbus.core;
 
 import std;
@@ -140,6 +149,10 @@ public:
         return 2 * 1024;
     }
 
+    constexpr static auto default_queue_depth() noexcept -> span_size_t {
+        return 8;
+    }
+
     /// @brief Returns the absolute maximum block size that can be sent in a message.
     /// @see data_size
     auto max_data_size() noexcept -> valid_if_positive<span_size_t>;
@@ -149,6 +162,12 @@ public:
         return max_data_size().value_or(default_data_size());
     }
 
+    /// @brief Returns the size of the buffer needed to receive any message.
+    /// @note The size of the input queue can differ from that of the output.
+    auto receive_size() const noexcept -> span_size_t {
+        return _receive_size > 0 ? _receive_size : default_data_size();
+    }
+
     /// @brief Sends a block of data with the specified priority.
     auto send(const unsigned priority, const span<const char> blk) noexcept
       -> posix_mqueue&;
@@ -160,6 +179,19 @@ public:
     /// @brief Receives messages and calls the specified handler on them.
     auto receive(memory::span<char>, const receive_handler) noexcept -> bool;
 
+    /// @brief Waits until a message can be received or the timeout expires.
+    auto wait_for_receive(
+      const std::chrono::steady_clock::duration timeout) noexcept -> bool;
+
+    /// @brief Returns the handle that becomes readable when a message arrives.
+    auto wait_handle() const noexcept -> work_wait_handle {
+#if EAGINE_POSIX_MQUEUE_POLL
+        return {.native = _ihandle};
+#else
+        return {};
+#endif
+    }
+
 private:
     std::string _s2cname{};
     std::string _c2sname{};
@@ -168,9 +200,22 @@ private:
         return ::mqd_t(-1);
     }
 
+    auto _queue_attributes() noexcept -> ::mq_attr;
+    void _do_create(::mq_attr& attr) noexcept;
+    void _after_open(const std::string& input_name) noexcept;
+
     ::mqd_t _ihandle{_invalid_handle()};
     ::mqd_t _ohandle{_invalid_handle()};
+    span_size_t _receive_size{0};
     int _last_errno{0};
+#if !EAGINE_POSIX_MQUEUE_POLL
+    // blocking handle of the input queue, used only by the timed waits
+    // so that the flags of the shared non-blocking handle are not changed
+    ::mqd_t _whandle{_invalid_handle()};
+    // messages received by timed waits, handed out by the next receives
+    std::mutex _waited_mutex;
+    std::deque<std::tuple<memory::buffer, unsigned>> _waited;
+#endif
 };
 //------------------------------------------------------------------------------
 posix_mqueue::posix_mqueue(posix_mqueue&& temp) noexcept
@@ -180,6 +225,11 @@ posix_mqueue::posix_mqueue(posix_mqueue&& temp) noexcept
     swap(_c2sname, temp._c2sname);
     swap(_ihandle, temp._ihandle);
     swap(_ohandle, temp._ohandle);
+    swap(_receive_size, temp._receive_size);
+#if !EAGINE_POSIX_MQUEUE_POLL
+    swap(_whandle, temp._whandle);
+    swap(_waited, temp._waited);
+#endif
 }
 //------------------------------------------------------------------------------
 posix_mqueue::~posix_mqueue() noexcept {
@@ -245,13 +295,26 @@ auto posix_mqueue::unlink() noexcept -> posix_mqueue& {
     return *this;
 }
 //------------------------------------------------------------------------------
-auto posix_mqueue::create() noexcept -> posix_mqueue& {
-    log_debug("creating new message queue ${name}").arg("name", get_name());
-
+auto posix_mqueue::_queue_attributes() noexcept -> ::mq_attr {
     struct ::mq_attr attr {};
     zero(as_bytes(cover_one(attr)));
-    attr.mq_maxmsg = limit_cast<long>(8);
-    attr.mq_msgsize = limit_cast<long>(default_data_size());
+    const auto depth{
+      app_config()
+        .get<span_size_t>("msgbus.posix_mqueue.queue_depth")
+        .value_or(default_queue_depth())};
+    // the size is limited by the size field of message_pack_info
+    const auto size{std::clamp(
+      app_config()
+        .get<span_size_t>("msgbus.posix_mqueue.message_size")
+        .value_or(default_data_size()),
+      default_data_size(),
+      span_size(std::numeric_limits<std::uint16_t>::max()))};
+    attr.mq_maxmsg = limit_cast<long>(std::max(depth, span_size(1)));
+    attr.mq_msgsize = limit_cast<long>(size);
+    return attr;
+}
+//------------------------------------------------------------------------------
+void posix_mqueue::_do_create(::mq_attr& attr) noexcept {
     errno = 0;
     // NOLINTNEXTLINE(hicpp-vararg)
     _ihandle = ::mq_open(
@@ -273,11 +336,42 @@ auto posix_mqueue::create() noexcept -> posix_mqueue& {
           &attr);
         _last_errno = errno;
     }
+}
+//------------------------------------------------------------------------------
+void posix_mqueue::_after_open(
+  [[maybe_unused]] const std::string& input_name) noexcept {
+    struct ::mq_attr attr {};
+    if(::mq_getattr(_ihandle, &attr) == 0) [[likely]] {
+        _receive_size = span_size(attr.mq_msgsize);
+    }
+#if !EAGINE_POSIX_MQUEUE_POLL
+    // NOLINTNEXTLINE(hicpp-vararg)
+    _whandle = ::mq_open(input_name.c_str(), O_RDONLY);
+#endif
+}
+//------------------------------------------------------------------------------
+auto posix_mqueue::create() noexcept -> posix_mqueue& {
+    log_debug("creating new message queue ${name}").arg("name", get_name());
+
+    auto attr{_queue_attributes()};
+    _do_create(attr);
+    if((_last_errno == EINVAL) and (_ihandle == _invalid_handle())) {
+        // the configured attributes exceed the system limits
+        log_warning("using default attributes for message queue ${name}")
+          .arg("name", get_name())
+          .arg("depth", attr.mq_maxmsg)
+          .arg("size", "ByteSize", attr.mq_msgsize);
+        attr.mq_maxmsg = limit_cast<long>(default_queue_depth());
+        attr.mq_msgsize = limit_cast<long>(default_data_size());
+        _do_create(attr);
+    }
     if(_last_errno) {
         log_error("failed to create message queue ${name}")
           .arg("name", get_name())
           .arg("errno", _last_errno)
           .arg("message", error_message(_last_errno));
+    } else {
+        _after_open(_c2sname);
     }
     return *this;
 }
@@ -311,6 +405,8 @@ auto posix_mqueue::open() noexcept -> posix_mqueue& {
           .arg("name", get_name())
           .arg("errno", _last_errno)
           .arg("message", error_message(_last_errno));
+    } else {
+        _after_open(_s2cname);
     }
     return *this;
 }
@@ -324,6 +420,14 @@ auto posix_mqueue::close() noexcept -> posix_mqueue& {
         _ihandle = _invalid_handle();
         _ohandle = _invalid_handle();
         _last_errno = errno;
+#if !EAGINE_POSIX_MQUEUE_POLL
+        if(_whandle != _invalid_handle()) {
+            ::mq_close(_whandle);
+            _whandle = _invalid_handle();
+        }
+        const std::unique_lock lock{_waited_mutex};
+        _waited.clear();
+#endif
     }
     return *this;
 }
@@ -359,6 +463,17 @@ auto posix_mqueue::receive(
   memory::span<char> blk,
   const receive_handler handler) noexcept -> bool {
     if(is_open()) [[likely]] {
+#if !EAGINE_POSIX_MQUEUE_POLL
+        {
+            const std::unique_lock lock{_waited_mutex};
+            if(not _waited.empty()) {
+                const auto& [waited, priority] = _waited.front();
+                handler(priority, head(as_chars(view(waited)), blk.size()));
+                _waited.pop_front();
+                return true;
+            }
+        }
+#endif
         unsigned priority{0U};
         errno = 0;
         const auto received =
@@ -376,6 +491,57 @@ auto posix_mqueue::receive(
     return false;
 }
 //------------------------------------------------------------------------------
+auto posix_mqueue::wait_for_receive(
+  const std::chrono::steady_clock::duration timeout) noexcept -> bool {
+#if EAGINE_POSIX_MQUEUE_POLL
+    if(is_open()) [[likely]] {
+        ::pollfd pfd{.fd = _ihandle, .events = POLLIN, .revents = 0};
+        const auto timeout_ms{std::max(
+          std::chrono::ceil<std::chrono::milliseconds>(timeout).count(),
+          std::chrono::milliseconds::rep(1))};
+        return ::poll(&pfd, 1, limit_cast<int>(timeout_ms)) > 0;
+    }
+#else
+    if(is_open() and (_whandle != _invalid_handle())) [[likely]] {
+        {
+            const std::unique_lock lock{_waited_mutex};
+            if(not _waited.empty()) {
+                return true;
+            }
+        }
+        const auto ns{std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::system_clock::now().time_since_epoch() +
+                        timeout)
+                        .count()};
+        ::timespec deadline{};
+        deadline.tv_sec =
+          static_cast<decltype(deadline.tv_sec)>(ns / 1'000'000'000);
+        deadline.tv_nsec =
+          static_cast<decltype(deadline.tv_nsec)>(ns % 1'000'000'000);
+
+        // received without the lock, the receivers are not blocked
+        memory::buffer waited;
+        waited.resize(receive_size());
+        unsigned priority{0U};
+        const auto received{::mq_timedreceive(
+          _whandle,
+          as_chars(cover(waited)).data(),
+          std_size(waited.size()),
+          &priority,
+          &deadline)};
+        if(received > 0) {
+            waited.resize(span_size(received));
+            const std::unique_lock lock{_waited_mutex};
+            _waited.emplace_back(std::move(waited), priority);
+            return true;
+        }
+        return false;
+    }
+#endif
+    std::this_thread::sleep_for(timeout);
+    return false;
+}
+//------------------------------------------------------------------------------
 // connection
 //------------------------------------------------------------------------------
 struct posix_mqueue_shared_state {
@@ -405,6 +571,12 @@ public:
     }
 };
 //------------------------------------------------------------------------------
+// with the packed format enabled each queue message starts with the version
+// of the format of the rest, currently the size-prefixed bus messages packed
+// by pack_into, otherwise each queue message contains a single bus message
+static constexpr const byte posix_mqueue_wire_version{0xA2U};
+static constexpr const span_size_t posix_mqueue_wire_header_size{1};
+//------------------------------------------------------------------------------
 [[nodiscard]] static constexpr auto posix_mqueue_translate_priority(
   const message_priority priority) noexcept {
     return limit_cast<unsigned>(std::to_underlying(priority));
@@ -440,7 +612,9 @@ public:
     }
 
     auto max_data_size() noexcept -> valid_if_positive<span_size_t> final {
-        return {_buffer.size()};
+        return {
+          _buffer.size() -
+          (_packed_format ? posix_mqueue_wire_header_size : span_size(0))};
     }
 
     auto update() noexcept -> work_done override {
@@ -453,9 +627,22 @@ public:
     auto send(const message_id msg_id, const message_view& message) noexcept
       -> bool final;
 
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done final {
+        // the data queue is not locked here, that would block the senders
+        return _data_queue.wait_for_receive(timeout);
+    }
+
+    auto add_wait_handles(work_waiter& waiter) noexcept -> bool final {
+        return waiter.add_handle(_data_queue.wait_handle());
+    }
+
     auto fetch_messages(const fetch_handler handler) noexcept -> work_done final {
         const std::unique_lock lock{_mutex_incoming};
-        return _incoming.fetch_all(handler);
+        some_true something_done{};
+        something_done(_single_incoming.fetch_all(handler));
+        something_done(_incoming.fetch_messages(*this, handler));
+        return something_done;
     }
 
     auto query_statistics(connection_statistics&) noexcept -> bool final {
@@ -471,6 +658,7 @@ protected:
     auto _checkup(posix_mqueue& connect_queue) noexcept -> work_done;
     auto _receive() noexcept -> work_done;
     auto _send() noexcept -> bool;
+    auto _send_packed() noexcept -> bool;
 
     auto _handle_send(
       const message_timestamp,
@@ -484,12 +672,25 @@ protected:
     std::mutex _mutex_data_queue;
     std::mutex _mutex_incoming;
     std::mutex _mutex_outgoing;
+    // used for the packed queue messages, guarded by the data queue mutex
     memory::buffer _buffer;
-    message_storage _incoming;
-    serialized_message_storage _outgoing;
+    // used for the received queue messages, guarded by the data queue mutex
+    memory::buffer _recv_buffer;
+    // used for the serialization of single messages, guarded by outgoing mutex
+    memory::buffer _push_buffer;
+    connection_incoming_messages _incoming;
+    // messages received in the single message format
+    message_storage _single_incoming;
+    connection_outgoing_messages _outgoing;
     posix_mqueue _data_queue{*this};
     timeout _reconnect_timeout{std::chrono::seconds{2}, nothing};
     shared_holder<posix_mqueue_shared_state> _shared_state;
+    bool _wire_mismatch_logged{false};
+    // the peers not knowing the packed format drop such messages
+    const bool _packed_format{
+      app_config()
+        .get<bool>("msgbus.posix_mqueue.packed_messages")
+        .value_or(false)};
 };
 //------------------------------------------------------------------------------
 posix_mqueue_connection::posix_mqueue_connection(
@@ -499,20 +700,16 @@ posix_mqueue_connection::posix_mqueue_connection(
   , _shared_state{std::move(shared_state)} {
     const std::unique_lock lock_data_queue{_mutex_data_queue};
     _buffer.resize(_data_queue.data_size());
+    _recv_buffer.resize(_data_queue.receive_size());
+    _push_buffer.resize(_buffer.size());
 }
 //------------------------------------------------------------------------------
 auto posix_mqueue_connection::send(
   const message_id msg_id,
   const message_view& message) noexcept -> bool {
     if(is_usable()) [[likely]] {
-        block_data_sink sink(cover(_buffer));
-        default_serializer_backend backend(sink);
-        if(serialize_message(msg_id, message, backend)) [[likely]] {
-            const std::unique_lock lock_outgoing{_mutex_outgoing};
-            _outgoing.push(sink.done(), message.priority);
-            return true;
-        }
-        log_error("failed to serialize message");
+        const std::unique_lock lock_outgoing{_mutex_outgoing};
+        return _outgoing.enqueue(*this, msg_id, message, cover(_push_buffer));
     }
     return false;
 }
@@ -534,7 +731,11 @@ auto posix_mqueue_connection::_receive() noexcept -> work_done {
         const std::unique_lock lock_incoming{_mutex_incoming};
         const posix_mqueue::receive_handler handler{
           make_callable_ref<&posix_mqueue_connection::_handle_receive>(this)};
-        while(_data_queue.receive(as_chars(cover(_buffer)), handler)) {
+        // the peer that created the queue decided its message size
+        if(_recv_buffer.size() < _data_queue.receive_size()) [[unlikely]] {
+            _recv_buffer.resize(_data_queue.receive_size());
+        }
+        while(_data_queue.receive(as_chars(cover(_recv_buffer)), handler)) {
             something_done();
         }
     }
@@ -545,12 +746,45 @@ auto posix_mqueue_connection::_send() noexcept -> bool {
     const std::unique_lock lock_data_queue{_mutex_data_queue};
     if(_data_queue.is_usable()) [[likely]] {
         const std::unique_lock lock_outgoing{_mutex_outgoing};
+        if(_packed_format) {
+            return _send_packed();
+        }
         return _outgoing.fetch_all(
           make_callable_ref<&posix_mqueue_connection::_handle_send>(this));
     }
     return false;
 }
 //------------------------------------------------------------------------------
+auto posix_mqueue_connection::_handle_send(
+  const message_timestamp,
+  const message_priority priority,
+  const memory::const_block data) noexcept -> bool {
+    const auto uprio{posix_mqueue_translate_priority(priority)};
+    return not _data_queue.send(uprio, as_chars(data)).had_error();
+}
+//------------------------------------------------------------------------------
+auto posix_mqueue_connection::_send_packed() noexcept -> bool {
+    some_true something_done{};
+    // as many messages as fit are packed into each queue message
+    while(not _outgoing.empty()) {
+        const auto packed{_outgoing.pack_into(
+          skip(cover(_buffer), posix_mqueue_wire_header_size))};
+        if(packed.is_empty()) [[unlikely]] {
+            break;
+        }
+        const auto uprio{posix_mqueue_translate_priority(packed.max_priority())};
+        cover(_buffer)[0] = posix_mqueue_wire_version;
+        const auto blk{head(
+          view(_buffer), posix_mqueue_wire_header_size + packed.used())};
+        if(_data_queue.send(uprio, as_chars(blk)).had_error()) {
+            break;
+        }
+        _outgoing.cleanup(packed);
+        something_done();
+    }
+    return something_done;
+}
+//------------------------------------------------------------------------------
 auto posix_mqueue_connection::_reconnect(posix_mqueue& connect_queue) noexcept
   -> work_done {
     some_true something_done{};
@@ -578,6 +812,9 @@ auto posix_mqueue_connection::_reconnect(posix_mqueue& connect_queue) noexcept
                       posix_mqueue_translate_priority(message_priority::normal),
                       as_chars(sink.done()));
                     _buffer.resize(_data_queue.data_size());
+                    _recv_buffer.resize(_data_queue.receive_size());
+                    const std::unique_lock lock_outgoing{_mutex_outgoing};
+                    _push_buffer.resize(_buffer.size());
                     something_done();
                 } else {
                     log_error("failed to serialize connection name")
@@ -594,23 +831,29 @@ auto posix_mqueue_connection::_reconnect(posix_mqueue& connect_queue) noexcept
     return something_done;
 }
 //------------------------------------------------------------------------------
-auto posix_mqueue_connection::_handle_send(
-  const message_timestamp,
-  const message_priority priority,
-  const memory::const_block data) noexcept -> bool {
-    const auto uprio{posix_mqueue_translate_priority(priority)};
-    return not _data_queue.send(uprio, as_chars(data)).had_error();
-}
-//------------------------------------------------------------------------------
 void posix_mqueue_connection::_handle_receive(
   const unsigned,
   const memory::span<const char> data) noexcept {
-    _incoming.push_if(
-      [data](message_id& msg_id, message_timestamp&, stored_message& message) {
-          block_data_source source(as_bytes(data));
+    const auto blk{as_bytes(data)};
+    if(not blk.empty() and (blk[0] == posix_mqueue_wire_version)) {
+        _incoming.push(skip(blk, posix_mqueue_wire_header_size));
+        return;
+    }
+    // a single message from a peer not using the packed format
+    const auto deserialize{
+      [blk](message_id& msg_id, message_timestamp&, stored_message& message) {
+          block_data_source source(blk);
           default_deserializer_backend backend(source);
           return bool(deserialize_message(msg_id, message, backend));
-      });
+      }};
+    if(not _single_incoming.push_if(deserialize)) [[unlikely]] {
+        if(not _wire_mismatch_logged) {
+            _wire_mismatch_logged = true;
+            log_error("received message in an unsupported format from ${name}")
+              .arg("name", _data_queue.get_name())
+              .arg("size", "ByteSize", blk.size());
+        }
+    }
 }
 //------------------------------------------------------------------------------
 // connector
@@ -700,7 +943,7 @@ public:
       : main_ctx_object{"MQueConnAc", parent}
       , _accept_queue{*this, std::move(name)}
       , _shared_state{std::move(shared_state)} {
-        _buffer.resize(_accept_queue.data_size());
+        _buffer.resize(_accept_queue.receive_size());
     }
 
     /// @brief Construction from parent main context object and queue identifier.
@@ -729,6 +972,15 @@ public:
         return something_done;
     }
 
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done final {
+        return _accept_queue.wait_for_receive(timeout);
+    }
+
+    auto add_wait_handles(work_waiter& waiter) noexcept -> bool final {
+        return waiter.add_handle(_accept_queue.wait_handle());
+    }
+
     auto process_accepted(const accept_handler handler) noexcept -> work_done final;
 
 private:
@@ -775,7 +1027,7 @@ auto posix_mqueue_acceptor::_checkup() noexcept -> work_done {
             _accept_queue.close();
             _accept_queue.unlink();
             if(not _accept_queue.create().had_error()) {
-                _buffer.resize(_accept_queue.data_size());
+                _buffer.resize(_accept_queue.receive_size());
                 something_done();
             }
             _reconnect_timeout.reset();
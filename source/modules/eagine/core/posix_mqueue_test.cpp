@@ -136,13 +136,182 @@ void posix_mqueue_roundtrip(auto& s) {
     }
 }
 //------------------------------------------------------------------------------
+// connects a reading connector to an accepted writing connection
+auto posix_mqueue_connect(
+  eagitest::case_& test,
+  eagine::msgbus::connection_factory& fact,
+  eagine::msgbus::acceptor& cacc,
+  const eagine::identifier name)
+  -> std::tuple<
+    eagine::shared_holder<eagine::msgbus::connection>,
+    eagine::shared_holder<eagine::msgbus::connection>> {
+    auto read_conn{fact.make_connector(name)};
+    test.ensure(bool(read_conn), "has read connection");
+    eagine::shared_holder<eagine::msgbus::connection> write_conn;
+    const eagine::timeout accept_time{std::chrono::seconds{5}};
+    while(not write_conn and not accept_time.is_expired()) {
+        read_conn->update();
+        cacc.update();
+        cacc.process_accepted(
+          {eagine::construct_from,
+           [&](eagine::shared_holder<eagine::msgbus::connection> conn) {
+               write_conn = std::move(conn);
+           }});
+    }
+    test.ensure(bool(write_conn), "has write connection");
+    return {std::move(read_conn), std::move(write_conn)};
+}
+//------------------------------------------------------------------------------
+// message batch
+//------------------------------------------------------------------------------
+void posix_mqueue_message_batch(auto& s) {
+    if(auto fact{
+         eagine::msgbus::make_posix_mqueue_connection_factory(s.context())}) {
+        eagitest::case_ test{s, 4, "message batch"};
+        auto cacc{fact->make_acceptor(eagine::identifier{"batch"})};
+        test.ensure(bool(cacc), "has acceptor");
+        auto [read_conn, write_conn]{posix_mqueue_connect(
+          test, *fact, *cacc, eagine::identifier{"batch"})};
+
+        // many more messages than the depth of the queue
+        const eagine::message_id test_msg_id{"test", "batch"};
+        const eagine::msgbus::message_sequence_t count{200};
+        std::array<eagine::byte, 16> content{};
+        for(eagine::msgbus::message_sequence_t seq = 0; seq < count; ++seq) {
+            content.fill(eagine::byte(seq % 256));
+            eagine::msgbus::message_view message{eagine::view(content)};
+            message.set_sequence_no(seq);
+            test.check(write_conn->send(test_msg_id, message), "sent");
+        }
+
+        eagine::msgbus::message_sequence_t next{0};
+        const auto read_func = [&](
+                                 const eagine::message_id msg_id,
+                                 const eagine::msgbus::message_age,
+                                 const eagine::msgbus::message_view& msg) -> bool {
+            test.check(msg_id == test_msg_id, "message id");
+            test.check_equal(msg.sequence_no, next, "in order");
+            for(const auto b : msg.content()) {
+                test.check(b == eagine::byte(next % 256), "content");
+            }
+            ++next;
+            return true;
+        };
+        const eagine::timeout receive_time{std::chrono::seconds{5}};
+        while(next < count and not receive_time.is_expired()) {
+            write_conn->update();
+            read_conn->update();
+            read_conn->fetch_messages({eagine::construct_from, read_func});
+        }
+        test.check_equal(next, count, "all received");
+    }
+}
+//------------------------------------------------------------------------------
+// large message
+//------------------------------------------------------------------------------
+void posix_mqueue_large_message(auto& s) {
+    if(auto fact{
+         eagine::msgbus::make_posix_mqueue_connection_factory(s.context())}) {
+        eagitest::case_ test{s, 5, "large message"};
+        auto cacc{fact->make_acceptor(eagine::identifier{"large"})};
+        test.ensure(bool(cacc), "has acceptor");
+        auto [read_conn, write_conn]{posix_mqueue_connect(
+          test, *fact, *cacc, eagine::identifier{"large"})};
+
+        // most of the queue message is used by a single bus message
+        const auto max_size{write_conn->max_data_size().value_or(0)};
+        test.ensure(max_size > 0, "max data size");
+        const eagine::message_id test_msg_id{"test", "large"};
+        std::vector<eagine::byte> content(
+          eagine::std_size(max_size * 3 / 4), eagine::byte{0x5AU});
+        test.check(
+          write_conn->send(
+            test_msg_id, eagine::msgbus::message_view{eagine::view(content)}),
+          "sent");
+
+        bool received{false};
+        const auto read_func = [&](
+                                 const eagine::message_id msg_id,
+                                 const eagine::msgbus::message_age,
+                                 const eagine::msgbus::message_view& msg) -> bool {
+            test.check(msg_id == test_msg_id, "message id");
+            test.check_equal(
+              msg.content().size(), eagine::span_size(content.size()), "size");
+            received = true;
+            return true;
+        };
+        const eagine::timeout receive_time{std::chrono::seconds{5}};
+        while(not received and not receive_time.is_expired()) {
+            write_conn->update();
+            read_conn->update();
+            read_conn->fetch_messages({eagine::construct_from, read_func});
+        }
+        test.check(received, "received");
+    }
+}
+//------------------------------------------------------------------------------
+// wait for work
+//------------------------------------------------------------------------------
+void posix_mqueue_wait_for_work(auto& s) {
+    if(auto fact{
+         eagine::msgbus::make_posix_mqueue_connection_factory(s.context())}) {
+        eagitest::case_ test{s, 6, "wait for work"};
+        auto cacc{fact->make_acceptor(eagine::identifier{"wait"})};
+        test.ensure(bool(cacc), "has acceptor");
+        auto [read_conn, write_conn]{posix_mqueue_connect(
+          test, *fact, *cacc, eagine::identifier{"wait"})};
+        read_conn->update();
+
+        test.check(
+          not read_conn->wait_for_work(std::chrono::milliseconds{5}),
+          "nothing to wait for");
+
+        // the waits and the receives of the same connection run concurrently
+        const eagine::message_id test_msg_id{"test", "wait"};
+        const int count{20};
+        std::atomic<int> received{0};
+        std::atomic<bool> done{false};
+        std::thread waiter{[&] {
+            while(not done) {
+                read_conn->wait_for_work(std::chrono::milliseconds{2});
+            }
+        }};
+        const auto read_func = [&](
+                                 const eagine::message_id msg_id,
+                                 const eagine::msgbus::message_age,
+                                 const eagine::msgbus::message_view&) -> bool {
+            test.check(msg_id == test_msg_id, "message id");
+            ++received;
+            return true;
+        };
+        const eagine::timeout receive_time{std::chrono::seconds{5}};
+        for(int i = 0; i < count; ++i) {
+            write_conn->send(test_msg_id, eagine::msgbus::message_view{});
+            write_conn->update();
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            read_conn->update();
+            read_conn->fetch_messages({eagine::construct_from, read_func});
+        }
+        while(received < count and not receive_time.is_expired()) {
+            read_conn->update();
+            read_conn->fetch_messages({eagine::construct_from, read_func});
+        }
+        done = true;
+        waiter.join();
+        test.check_equal(received.load(), count, "all received");
+    }
+}
+//------------------------------------------------------------------------------
 // main
 //------------------------------------------------------------------------------
 auto test_main(eagine::test_ctx& ctx) -> int {
-    eagitest::ctx_suite test{ctx, "POSIX connection", 3};
+    eagitest::ctx_suite test{ctx, "POSIX connection", 6};
     test.once(posix_mqueue_type_id);
     test.once(posix_mqueue_addr_kind);
     test.once(posix_mqueue_roundtrip);
+    test.once(posix_mqueue_message_batch);
+    test.once(posix_mqueue_large_message);
+    test.once(posix_mqueue_wait_for_work);
     return test.exit_code();
 }
 //------------------------------------------------------------------------------
@@ -16,6 +16,7 @@ import eagine.core.types;
 import eagine.core.memory;
 import eagine.core.identifier;
 import eagine.core.utility;
+import eagine.core.runtime;
 import eagine.core.main_ctx;
 import :types;
 import :direct;
@@ -26,16 +27,44 @@ import :setup;
 import :service;
 
 namespace eagine::msgbus {
+struct registered_entry;
+//------------------------------------------------------------------------------
+class registered_entry_work_unit : public latched_work_unit {
+public:
+    registered_entry_work_unit() noexcept = default;
+    registered_entry_work_unit(
+      registered_entry& entry,
+      bool process,
+      std::latch& completed,
+      some_true_atomic& something_done) noexcept
+      : latched_work_unit{completed}
+      , _entry{&entry}
+      , _something_done{&something_done}
+      , _process{process} {}
+
+    auto do_it() noexcept -> bool final;
+
+private:
+    registered_entry* _entry{nullptr};
+    some_true_atomic* _something_done{nullptr};
+    bool _process{false};
+};
 //------------------------------------------------------------------------------
 struct registered_entry {
     unique_holder<endpoint> _endpoint{};
     unique_holder<service_interface> _service{};
+    registered_entry_work_unit _update_work{};
 
     auto endpoint() noexcept -> msgbus::endpoint& {
         return *_endpoint;
     }
     auto update_service() noexcept -> work_done;
     auto update_and_process_service() noexcept -> work_done;
+    void enqueue_update(
+      workshop&,
+      bool process,
+      std::latch&,
+      some_true_atomic&) noexcept;
 };
 //------------------------------------------------------------------------------
 /// @brief Class combining a local bus router and a set of endpoints.
@@ -117,6 +146,13 @@ public:
     /// @see update_only
     auto update_and_process() noexcept -> work_done;
 
+    /// @brief Sets whether the services are updated by the worker threads.
+    /// @see update_only
+    /// @see update_and_process
+    void use_workers(const bool value) noexcept {
+        _use_workers = value;
+    }
+
     auto is_done() noexcept -> bool {
         return _router.is_done();
     }
@@ -129,8 +165,10 @@ private:
     shared_holder<direct_acceptor_intf> _acceptor;
     router _router;
     std::vector<registered_entry> _entries;
+    bool _use_workers{false};
 
     auto _add_entry(const identifier log_id) noexcept -> registered_entry&;
+    auto _update_services(const bool process) noexcept -> work_done;
 };
 //------------------------------------------------------------------------------
 } // namespace eagine::msgbus
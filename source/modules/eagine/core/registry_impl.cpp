@@ -16,10 +16,22 @@ import eagine.core.types;
 import eagine.core.memory;
 import eagine.core.identifier;
 import eagine.core.utility;
+import eagine.core.runtime;
 import eagine.core.main_ctx;
 
 namespace eagine::msgbus {
 //------------------------------------------------------------------------------
+// registered_entry_work_unit
+//------------------------------------------------------------------------------
+auto registered_entry_work_unit::do_it() noexcept -> bool {
+    (*_something_done)(
+      _process ? _entry->update_and_process_service()
+               : _entry->update_service());
+    return true;
+}
+//------------------------------------------------------------------------------
+// registered_entry
+//------------------------------------------------------------------------------
 auto registered_entry::update_service() noexcept -> work_done {
     some_true something_done;
     if(_service) [[likely]] {
@@ -36,10 +48,23 @@ auto registered_entry::update_and_process_service() noexcept -> work_done {
     return something_done;
 }
 //------------------------------------------------------------------------------
+void registered_entry::enqueue_update(
+  workshop& workers,
+  bool process,
+  std::latch& completed,
+  some_true_atomic& something_done) noexcept {
+    _update_work = {*this, process, completed, something_done};
+    workers.enqueue(_update_work);
+}
+//------------------------------------------------------------------------------
+// registry
+//------------------------------------------------------------------------------
 registry::registry(main_ctx_parent parent) noexcept
   : main_ctx_object{"MsgBusRgtr", parent}
   , _acceptor{make_direct_acceptor(*this)}
-  , _router{*this} {
+  , _router{*this}
+  , _use_workers{
+      app_config().get<bool>("msgbus.registry.use_workers").value_or(false)} {
     _router.add_acceptor(_acceptor);
 
     locate<message_bus_setup>().and_then(
@@ -69,14 +94,33 @@ auto registry::update_self() noexcept -> work_done {
     return _router.update(8);
 }
 //------------------------------------------------------------------------------
+auto registry::_update_services(const bool process) noexcept -> work_done {
+    // each endpoint has its own connection to the router, so the services
+    // can be updated independently of each other
+    if(_use_workers and (_entries.size() > 1)) {
+        some_true_atomic something_done{};
+        std::latch completed{limit_cast<std::ptrdiff_t>(_entries.size())};
+        for(auto& entry : _entries) {
+            entry.enqueue_update(workers(), process, completed, something_done);
+        }
+        completed.wait();
+        return something_done;
+    }
+
+    some_true something_done{};
+    for(auto& entry : _entries) {
+        something_done(
+          process ? entry.update_and_process_service()
+                  : entry.update_service());
+    }
+    return something_done;
+}
+//------------------------------------------------------------------------------
 auto registry::update_only() noexcept -> work_done {
     some_true something_done{};
 
     something_done(_router.do_work());
-
-    for(auto& entry : _entries) {
-        something_done(entry.update_service());
-    }
+    something_done(_update_services(false));
 
     something_done(_router.do_work());
     something_done(_router.do_maintenance());
@@ -88,10 +132,7 @@ auto registry::update_and_process() noexcept -> work_done {
     some_true something_done{};
 
     something_done(_router.do_work());
-
-    for(auto& entry : _entries) {
-        something_done(entry.update_and_process_service());
-    }
+    something_done(_update_services(true));
 
     something_done(_router.do_work());
     something_done(_router.do_maintenance());
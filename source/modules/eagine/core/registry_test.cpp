@@ -343,19 +343,55 @@ void registry_queues(auto& s) {
     the_reg.finish();
 }
 //------------------------------------------------------------------------------
+// ping/pong workers
+//------------------------------------------------------------------------------
+void registry_workers_ping_pong(auto& s) {
+    eagitest::case_ test{s, 7, "workers / ping-pong"};
+    auto& ctx{s.context()};
+    eagine::msgbus::registry the_reg{ctx};
+    the_reg.use_workers(true);
+
+    // the services are updated on the worker threads, so no tracking here
+    auto& ponger = the_reg.emplace<eagine::msgbus::service_composition<
+      eagine::msgbus::require_services<eagine::msgbus::subscriber, test_pong>>>(
+      "TestPong");
+    auto& pinger = the_reg.emplace<eagine::msgbus::service_composition<
+      eagine::msgbus::require_services<eagine::msgbus::subscriber, test_ping>>>(
+      "TestPing");
+
+    if(not the_reg.wait_for_ids(std::chrono::minutes{1})) {
+        test.fail("get-id timeout");
+    } else {
+        pinger.assign_target(ponger.bus_node().get_id());
+
+        eagine::timeout ping_time{std::chrono::minutes{1}};
+        while(not pinger.success()) {
+            if(ping_time.is_expired()) {
+                test.fail("ping timeout");
+                break;
+            }
+            the_reg.update_and_process().or_sleep_for(std::chrono::milliseconds(1));
+        }
+        test.check(pinger.success(), "ping success");
+    }
+
+    the_reg.finish();
+}
+//------------------------------------------------------------------------------
 // main
 //------------------------------------------------------------------------------
 auto test_main(eagine::test_ctx& ctx) -> int {
     enable_message_bus(ctx);
     ctx.preinitialize();
 
-    eagitest::ctx_suite test{ctx, "registry", 6};
+    eagitest::ctx_suite test{ctx, "registry", 7};
     test.once(registry_get_id_1);
     test.once(registry_get_id_2);
     test.once(registry_get_id_3);
     test.once(registry_ping_pong);
     test.once(registry_wait_ping_pong);
     test.once(registry_queues);
+    test.once(registry_workers_ping_pong);
     return test.exit_code();
 }
 //------------------------------------------------------------------------------
@@ -885,6 +885,9 @@ public:
     /// @brief Returns count of bytes per second sent through the connection.
     auto bytes_per_second() const noexcept -> valid_if_nonnegative<float>;
 
+    /// @brief Returns the average send batching latency in milliseconds.
+    auto send_latency_ms() const noexcept -> valid_if_nonnegative<float>;
+
 private:
     shared_holder<node_connection_impl> _pimpl{};
 
@@ -911,6 +914,8 @@ public:
     auto set_kind(const connection_kind) noexcept -> node_connection_state&;
     auto assign(const connection_statistics&) noexcept
       -> node_connection_state&;
+    auto assign(const connection_latency_statistics&) noexcept
+      -> node_connection_state&;
 };
 //------------------------------------------------------------------------------
 /// @brief Class providing information about connections from the perspective of a node.
@@ -110,6 +110,7 @@ class node_connection_impl {
 public:
     float block_usage_ratio{-1.F};
     float bytes_per_second{-1.F};
+    float send_latency_ms{-1.F};
     connection_kind kind{connection_kind::unknown};
 };
 //------------------------------------------------------------------------------
@@ -1112,6 +1113,14 @@ auto node_connection::bytes_per_second() const noexcept
     return {-1.F};
 }
 //------------------------------------------------------------------------------
+auto node_connection::send_latency_ms() const noexcept
+  -> valid_if_nonnegative<float> {
+    if(auto impl{_impl()}) {
+        return {impl->send_latency_ms};
+    }
+    return {-1.F};
+}
+//------------------------------------------------------------------------------
 // node_connection_state
 //------------------------------------------------------------------------------
 auto node_connection_state::set_kind(const connection_kind kind) noexcept
@@ -1142,6 +1151,20 @@ auto node_connection_state::assign(const connection_statistics& stats) noexcept
     return *this;
 }
 //------------------------------------------------------------------------------
+auto node_connection_state::assign(
+  const connection_latency_statistics& stats) noexcept
+  -> node_connection_state& {
+    if(auto impl{_impl()}) {
+        impl->send_latency_ms = stats.send_latency_ms;
+        _tracker.get_node(stats.local_id)
+          .notice_alive()
+          .add_change(remote_node_change::connection_info);
+        _tracker.get_node(stats.remote_id)
+          .add_change(remote_node_change::connection_info);
+    }
+    return *this;
+}
+//------------------------------------------------------------------------------
 // remote_node_tracker
 //------------------------------------------------------------------------------
 class remote_node_tracker_impl {
@@ -21,6 +21,9 @@ import :message;
 import :interface;
 import :blobs;
 import :context;
+import :trace;
+import :wait;
+import :endpoint_index;
 
 namespace eagine::msgbus {
 export class router;
@@ -39,18 +42,24 @@ public:
     auto is_subscribed_to(const message_id) noexcept -> bool;
     auto is_not_subscribed_to(const message_id) noexcept -> bool;
     auto subscriptions() noexcept -> std::vector<message_id>;
+    auto has_subscription_info() const noexcept -> bool;
+    auto has_complete_subscriptions() const noexcept -> bool;
+    auto is_settling_subscriptions() const noexcept -> bool;
 
-    auto has_instance_id() noexcept -> bool;
+    auto has_instance_id() const noexcept -> bool;
     auto instance_id() noexcept -> process_instance_id_t;
-    void assign_instance_id(const message_view& msg) noexcept;
+    auto assign_instance_id(const message_view& msg) noexcept -> bool;
     void apply_instance_id(message_view& msg) noexcept;
     auto is_outdated() const noexcept -> bool;
 
 private:
-    std::vector<message_id> _subscriptions{};
-    std::vector<message_id> _unsubscriptions{};
+    flat_set<message_id> _subscriptions{};
+    flat_set<message_id> _unsubscriptions{};
     process_instance_id_t _instance_id{0};
     timeout _is_outdated{adjusted_duration(std::chrono::seconds{60})};
+    // endpoints announce all their subscriptions at once, the list is
+    // considered complete when no new subscription arrived for a while
+    timeout _subscriptions_settle{adjusted_duration(std::chrono::seconds{5})};
 };
 //------------------------------------------------------------------------------
 class router_pending {
@@ -165,7 +174,10 @@ public:
 
     auto is_allowed(const message_id) const noexcept -> bool;
 
-    void setup(shared_holder<connection>, bool maybe_router) noexcept;
+    void setup(
+      shared_holder<connection>,
+      bool maybe_router,
+      message_tracer&) noexcept;
 
     void enqueue_route_messages(
       workshop&,
@@ -180,8 +192,10 @@ public:
       some_true_atomic&) noexcept;
 
     void mark_not_a_router() noexcept;
+    auto maybe_router() const noexcept -> bool;
     auto do_update_connection() noexcept -> work_done;
     auto update_connection() noexcept -> work_done;
+    void add_to(work_waiter&) noexcept;
     void handle_bye_bye() noexcept;
     auto should_disconnect() const noexcept -> bool;
     void cleanup_connection() noexcept;
@@ -191,6 +205,12 @@ public:
     auto send(const main_ctx_object&, const message_id, const message_view&)
       const noexcept -> bool;
 
+    auto forward(
+      const main_ctx_object&,
+      const message_id,
+      const message_view&,
+      const bool enqueue) const noexcept -> bool;
+
     auto route_messages(
       router&,
       const endpoint_id_t incoming_id,
@@ -200,18 +220,31 @@ public:
     auto try_route(
       const main_ctx_object&,
       const message_id,
-      const message_view&) const noexcept -> bool;
+      const message_view&,
+      const bool enqueue) const noexcept -> bool;
 
     auto process_blobs(const endpoint_id_t node_id, router_blobs& blobs) noexcept
       -> work_done;
 
 private:
+    auto _send(const message_id, const message_view&) const noexcept -> bool;
+    auto _flush_forwarded() noexcept -> work_done;
+
+    // messages forwarded to this node by the router workers, sent by the
+    // work unit updating this node's connection
+    struct forward_queue {
+        spinlock lock;
+        double_buffer<message_storage> messages;
+    };
+
     unique_holder<std::shared_mutex> _lock{default_selector};
+    unique_holder<forward_queue> _forward_queue{default_selector};
     shared_holder<connection> _connection{};
+    message_tracer* _tracer{nullptr};
     route_node_messages_work_unit _route_messages_work{};
     connection_update_work_unit _update_connection_work{};
-    std::vector<message_id> _message_block_list{};
-    std::vector<message_id> _message_allow_list{};
+    flat_set<message_id> _message_block_list{};
+    flat_set<message_id> _message_allow_list{};
     bool _maybe_router{true};
     bool _do_disconnect{false};
 };
@@ -243,6 +276,8 @@ public:
     auto update(main_ctx_object&, const endpoint_id_t id_base) noexcept
       -> work_done;
 
+    void add_to(work_waiter&) noexcept;
+
     auto send(const main_ctx_object&, const message_id, const message_view&)
       const noexcept -> bool;
 
@@ -271,6 +306,7 @@ public:
     void add_acceptor(shared_holder<acceptor> an_acceptor) noexcept;
     auto handle_pending(router&) noexcept -> work_done;
     auto handle_accept(router&) noexcept -> work_done;
+    void add_to(work_waiter&) noexcept;
     auto remove_timeouted(const main_ctx_object&) noexcept -> work_done;
     auto is_disconnected(const endpoint_id_t endpoint_id) const noexcept
       -> bool;
@@ -284,6 +320,12 @@ public:
       -> std::tuple<tribool, tribool, process_instance_id_t>;
     auto subscriptions_of(const endpoint_id_t target_id) noexcept
       -> std::tuple<std::vector<message_id>, process_instance_id_t>;
+    void subscriptions_changed() noexcept;
+    auto update_subscription_index() noexcept -> work_done;
+    auto leads_to_subscriber(
+      const endpoint_id_t node_id,
+      const adjacent_node& node,
+      const message_id) const noexcept -> bool;
     void erase(const endpoint_id_t) noexcept;
     void cleanup() noexcept;
 
@@ -294,9 +336,16 @@ private:
     small_vector<shared_holder<acceptor>, 2> _acceptors;
     std::vector<router_pending> _pending;
     flat_map<endpoint_id_t, adjacent_node> _nodes;
-    flat_map<endpoint_id_t, endpoint_id_t> _endpoint_idx;
+    endpoint_index _endpoint_idx;
     flat_map<endpoint_id_t, router_endpoint_info> _endpoint_infos;
     flat_map<endpoint_id_t, timeout> _recently_disconnected;
+    // adjacent node id -> messages subscribed by endpoints behind that node
+    flat_map<endpoint_id_t, flat_set<message_id>> _node_subscriptions;
+    std::atomic<bool> _node_subscriptions_outdated{false};
+    // some endpoint subscription lists may become complete later
+    bool _has_settling_subscriptions{false};
+    timeout _should_recheck_subscriptions{
+      adjusted_duration(std::chrono::seconds{1})};
 };
 //------------------------------------------------------------------------------
 class router_stats {
@@ -305,9 +354,15 @@ public:
     auto time_since_last_routing() noexcept -> auto;
     auto update_stats() noexcept
       -> std::tuple<std::optional<message_flow_info>>;
-    void update_avg_msg_age(
-      const std::chrono::steady_clock::duration message_age_inc) noexcept;
+    void update_msg_stats(
+      const std::chrono::steady_clock::duration message_age,
+      const std::chrono::steady_clock::duration queuing_time) noexcept;
     auto avg_msg_age() noexcept -> std::chrono::microseconds;
+    auto queuing_histogram() noexcept -> latency_histogram;
+    auto next_queuing_interval() noexcept -> latency_histogram;
+    void remote_flow_info(
+      const endpoint_id_t node_id,
+      const message_flow_info&) noexcept;
     auto statistics() noexcept -> router_statistics;
 
     void message_dropped() noexcept;
@@ -319,12 +374,21 @@ private:
       std::chrono::steady_clock::now()};
     std::chrono::steady_clock::time_point _prev_route_time{
       std::chrono::steady_clock::now()};
-    std::chrono::steady_clock::time_point _forwarded_since_log{
+    // updated concurrently by the router workers
+    std::atomic<std::chrono::steady_clock::time_point> _forwarded_since_log{
       std::chrono::steady_clock::now()};
     std::chrono::steady_clock::time_point _forwarded_since_stat{
       std::chrono::steady_clock::now()};
     basic_sliding_average<std::chrono::steady_clock::duration, std::int32_t, 8, 64>
       _message_age_avg{};
+    // time the messages waited in this router until they were routed,
+    // in the current and previous statistics log interval
+    latency_histogram _queuing_hist{};
+    latency_histogram _prev_queuing_hist{};
+    std::atomic<std::int64_t> _forwarded_messages{0};
+    // message age reported by congested nodes, for example bridges
+    adjacent_flow_infos _remote_flow_infos{
+      adjusted_duration(std::chrono::seconds{5})};
     std::int64_t _prev_forwarded_messages{0};
     router_statistics _stats{};
     message_flow_info _flow_info{};
@@ -420,6 +484,23 @@ public:
     auto node_count() noexcept -> span_size_t;
     auto password_is_required() const noexcept -> bool;
 
+    /// @brief Limits the number of nodes routed concurrently by the workers.
+    /// @note Zero means that all nodes are routed concurrently.
+    void set_max_workers(const span_size_t count) noexcept {
+        _max_workers = std::max(count, span_size(0));
+    }
+
+    /// @brief Returns the limit of concurrently routed nodes (zero if unlimited).
+    auto max_workers() const noexcept -> span_size_t {
+        return _max_workers;
+    }
+
+    /// @brief Makes the router route by the workers of the specified workshop.
+    /// @note The workshop must outlive this router.
+    void use_workshop(workshop& workers) noexcept {
+        _workshop = &workers;
+    }
+
     void add_certificate_pem(const memory::const_block blk) noexcept;
     void add_ca_certificate_pem(const memory::const_block blk) noexcept;
 
@@ -436,6 +517,11 @@ public:
         return update(2);
     }
 
+    /// @brief Waits until there may be work for the router or the timeout expires.
+    /// Can be used instead of sleeping when the update did not do any work.
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done;
+
     void say_bye() noexcept;
     void cleanup() noexcept;
     void finish() noexcept;
@@ -535,6 +621,8 @@ private:
       -> message_handling_result;
     auto _handle_blob_prepare(const message_view&) noexcept
       -> message_handling_result;
+    auto _handle_flow_info(const endpoint_id_t, const message_view&) noexcept
+      -> message_handling_result;
 
     auto _handle_special_common(
       const message_id msg_id,
@@ -567,11 +655,22 @@ private:
         return _use_worker_threads;
     }
     void _update_use_workers() noexcept;
+    auto _routing_workers() noexcept -> workshop& {
+        return _workshop ? *_workshop : workers();
+    }
 
     auto _forward_to(
       const adjacent_node& node_out,
       const message_id msg_id,
       message_view& message) noexcept -> bool;
+    auto _send_to_parent(
+      const message_id msg_id,
+      const message_view& message) noexcept -> bool;
+    void _post_trace_records(const message_view& query) noexcept;
+    void _post_connection_latency(
+      const message_view& query,
+      const connection_statistics&) noexcept;
+    void _post_latency_histogram(const message_view& query) noexcept;
     auto _route_targeted_message(
       const message_id msg_id,
       const endpoint_id_t incoming_id,
@@ -601,6 +700,8 @@ private:
     auto _handle_special_parent_message(
       const message_id msg_id,
       message_view& message) noexcept -> bool;
+    template <typename Enqueue, typename Overlap>
+    void _enqueue_in_waves(Enqueue, Overlap) noexcept;
     void _route_messages_by_workers(some_true_atomic&) noexcept;
     auto _route_messages_by_router() noexcept -> work_done;
     void _update_connections_by_workers(some_true_atomic&) noexcept;
@@ -610,14 +711,19 @@ private:
     router_context _context;
     router_ids _ids;
     router_stats _stats;
+    message_tracer _tracer{node_kind::router, *this};
     parent_router _parent_router;
     router_nodes _nodes;
     router_blobs _blobs{*this};
+    work_waiter _waiter{};
 
     timeout _no_connection_timeout{adjusted_duration(std::chrono::seconds{30})};
 
     bool _password_is_required{false};
+    bool _filter_broadcasts{false};
     bool _use_worker_threads{false};
+    span_size_t _max_workers{0};
+    workshop* _workshop{nullptr};
 };
 //------------------------------------------------------------------------------
 } // namespace eagine::msgbus
@@ -24,31 +24,6 @@ import eagine.core.main_ctx;
 
 namespace eagine::msgbus {
 //------------------------------------------------------------------------------
-// helpers
-//------------------------------------------------------------------------------
-static inline auto message_id_list_contains(
-  const std::vector<message_id>& list,
-  const message_id& entry) noexcept -> bool {
-    return std::find(list.begin(), list.end(), entry) != list.end();
-}
-//------------------------------------------------------------------------------
-static inline void message_id_list_add(
-  std::vector<message_id>& list,
-  const message_id& entry) noexcept {
-    if(not message_id_list_contains(list, entry)) {
-        list.push_back(entry);
-    }
-}
-//------------------------------------------------------------------------------
-static inline void message_id_list_remove(
-  std::vector<message_id>& list,
-  const message_id& entry) noexcept {
-    const auto pos{std::find(list.begin(), list.end(), entry)};
-    if(pos != list.end()) {
-        list.erase(pos);
-    }
-}
-//------------------------------------------------------------------------------
 // router_pending
 //------------------------------------------------------------------------------
 router_pending::router_pending(
@@ -222,32 +197,51 @@ auto router_pending::release_connection() noexcept
 // router_endpoint_info
 //------------------------------------------------------------------------------
 void router_endpoint_info::add_subscription(const message_id msg_id) noexcept {
-    message_id_list_add(_subscriptions, msg_id);
-    message_id_list_remove(_unsubscriptions, msg_id);
+    if(not _subscriptions.contains(msg_id)) {
+        _subscriptions.insert(msg_id);
+        _subscriptions_settle.reset();
+    }
+    _unsubscriptions.erase(msg_id);
 }
 //------------------------------------------------------------------------------
 void router_endpoint_info::remove_subscription(const message_id msg_id) noexcept {
-    message_id_list_remove(_subscriptions, msg_id);
-    message_id_list_add(_unsubscriptions, msg_id);
+    _subscriptions.erase(msg_id);
+    _unsubscriptions.insert(msg_id);
 }
 //------------------------------------------------------------------------------
 auto router_endpoint_info::is_subscribed_to(const message_id msg_id) noexcept
   -> bool {
-    return message_id_list_contains(_subscriptions, msg_id);
+    return _subscriptions.contains(msg_id);
 }
 //------------------------------------------------------------------------------
 auto router_endpoint_info::is_not_subscribed_to(const message_id msg_id) noexcept
   -> bool {
-    return message_id_list_contains(_unsubscriptions, msg_id);
+    return _unsubscriptions.contains(msg_id);
 }
 //------------------------------------------------------------------------------
-auto router_endpoint_info::has_instance_id() noexcept -> bool {
+auto router_endpoint_info::has_instance_id() const noexcept -> bool {
     return _instance_id != 0;
 }
 //------------------------------------------------------------------------------
+auto router_endpoint_info::has_subscription_info() const noexcept -> bool {
+    return has_instance_id() and
+           not(_subscriptions.empty() and _unsubscriptions.empty());
+}
+//------------------------------------------------------------------------------
+auto router_endpoint_info::has_complete_subscriptions() const noexcept -> bool {
+    // unsubscriptions alone do not say anything about the other messages
+    return has_instance_id() and not _subscriptions.empty() and
+           _subscriptions_settle.is_expired();
+}
+//------------------------------------------------------------------------------
+auto router_endpoint_info::is_settling_subscriptions() const noexcept -> bool {
+    return has_instance_id() and not _subscriptions.empty() and
+           not _subscriptions_settle.is_expired();
+}
+//------------------------------------------------------------------------------
 auto router_endpoint_info::subscriptions() noexcept -> std::vector<message_id> {
     if(has_instance_id()) {
-        return _subscriptions;
+        return {_subscriptions.begin(), _subscriptions.end()};
     }
     return {};
 }
@@ -256,13 +250,17 @@ auto router_endpoint_info::instance_id() noexcept -> process_instance_id_t {
     return _instance_id;
 }
 //------------------------------------------------------------------------------
-void router_endpoint_info::assign_instance_id(const message_view& msg) noexcept {
+auto router_endpoint_info::assign_instance_id(const message_view& msg) noexcept
+  -> bool {
     _is_outdated.reset();
     if(_instance_id != msg.sequence_no) {
         _instance_id = msg.sequence_no;
         _subscriptions.clear();
         _unsubscriptions.clear();
+        _subscriptions_settle.reset();
+        return true;
     }
+    return false;
 }
 //------------------------------------------------------------------------------
 void router_endpoint_info::apply_instance_id(message_view& msg) noexcept {
@@ -290,10 +288,7 @@ auto connection_update_work_unit::do_it() noexcept -> bool {
 //------------------------------------------------------------------------------
 // adjacent_node
 //------------------------------------------------------------------------------
-adjacent_node::adjacent_node() noexcept {
-    _message_block_list.reserve(8);
-    _message_allow_list.reserve(8);
-}
+adjacent_node::adjacent_node() noexcept = default;
 //------------------------------------------------------------------------------
 auto adjacent_node::is_allowed(const message_id msg_id) const noexcept -> bool {
     if(is_special_message(msg_id)) {
@@ -301,19 +296,21 @@ auto adjacent_node::is_allowed(const message_id msg_id) const noexcept -> bool {
     }
     const std::shared_lock lk_list{*_lock};
     if(not _message_allow_list.empty()) {
-        return message_id_list_contains(_message_allow_list, msg_id);
+        return _message_allow_list.contains(msg_id);
     }
     if(not _message_block_list.empty()) {
-        return not message_id_list_contains(_message_block_list, msg_id);
+        return not _message_block_list.contains(msg_id);
     }
     return true;
 }
 //------------------------------------------------------------------------------
 void adjacent_node::setup(
   shared_holder<connection> conn,
-  bool maybe_router) noexcept {
+  bool maybe_router,
+  message_tracer& tracer) noexcept {
     _connection = std::move(conn);
     _maybe_router = maybe_router;
+    _tracer = &tracer;
 }
 //------------------------------------------------------------------------------
 void adjacent_node::enqueue_route_messages(
@@ -345,13 +342,55 @@ void adjacent_node::mark_not_a_router() noexcept {
     _maybe_router = false;
 }
 //------------------------------------------------------------------------------
+auto adjacent_node::maybe_router() const noexcept -> bool {
+    const std::shared_lock lk_list{*_lock};
+    return _maybe_router;
+}
+//------------------------------------------------------------------------------
+auto adjacent_node::_send(
+  const message_id msg_id,
+  const message_view& message) const noexcept -> bool {
+    if(_tracer) [[likely]] {
+        _tracer->stamp(message_trace_point::submit, msg_id, message);
+        if(_connection->send(msg_id, message)) [[likely]] {
+            _tracer->stamp(message_trace_point::accept, msg_id, message);
+            return true;
+        }
+        return false;
+    }
+    return _connection->send(msg_id, message);
+}
+//------------------------------------------------------------------------------
+auto adjacent_node::_flush_forwarded() noexcept -> work_done {
+    auto& queue{[this]() -> message_storage& {
+        const std::unique_lock lk_queue{_forward_queue->lock};
+        _forward_queue->messages.swap();
+        return _forward_queue->messages.current();
+    }()};
+    if(queue.empty()) [[likely]] {
+        return false;
+    }
+    const auto handler{[this](
+                         const message_id msg_id,
+                         const message_age msg_age,
+                         const message_view& message) {
+        message_view forwarded{message};
+        forwarded.add_age(msg_age);
+        _send(msg_id, forwarded);
+        return true;
+    }};
+    return queue.fetch_all({construct_from, handler});
+}
+//------------------------------------------------------------------------------
 auto adjacent_node::do_update_connection() noexcept -> work_done {
-    return _connection->update();
+    some_true something_done{_flush_forwarded()};
+    something_done(_connection->update());
+    return something_done;
 }
 //------------------------------------------------------------------------------
 auto adjacent_node::update_connection() noexcept -> work_done {
     if(_connection) [[likely]] {
-        return _connection->update();
+        return do_update_connection();
     }
     return false;
 }
@@ -395,7 +434,7 @@ auto adjacent_node::send(
   const message_id msg_id,
   const message_view& message) const noexcept -> bool {
     if(_connection) [[likely]] {
-        if(not _connection->send(msg_id, message)) [[unlikely]] {
+        if(not _send(msg_id, message)) [[unlikely]] {
             user.log_debug("failed to send message to connected node");
             return false;
         }
@@ -406,6 +445,29 @@ auto adjacent_node::send(
     return true;
 }
 //------------------------------------------------------------------------------
+void adjacent_node::add_to(work_waiter& waiter) noexcept {
+    if(_connection) [[likely]] {
+        waiter.add(*_connection);
+    }
+}
+//------------------------------------------------------------------------------
+auto adjacent_node::forward(
+  const main_ctx_object& user,
+  const message_id msg_id,
+  const message_view& message,
+  const bool enqueue) const noexcept -> bool {
+    if(enqueue) {
+        if(_connection) [[likely]] {
+            const std::unique_lock lk_queue{_forward_queue->lock};
+            _forward_queue->messages.next().push(msg_id, message);
+            return true;
+        }
+        user.log_debug("missing or unusable node connection");
+        return false;
+    }
+    return send(user, msg_id, message);
+}
+//------------------------------------------------------------------------------
 auto adjacent_node::route_messages(
   router& parent,
   const endpoint_id_t incoming_id,
@@ -427,9 +489,10 @@ auto adjacent_node::route_messages(
 auto adjacent_node::try_route(
   const main_ctx_object& user,
   const message_id msg_id,
-  const message_view& message) const noexcept -> bool {
+  const message_view& message,
+  const bool enqueue) const noexcept -> bool {
     if(_maybe_router) {
-        return send(user, msg_id, message);
+        return forward(user, msg_id, message, enqueue);
     }
     return false;
 }
@@ -456,12 +519,12 @@ auto adjacent_node::process_blobs(
 //------------------------------------------------------------------------------
 void adjacent_node::block_message(const message_id msg_id) noexcept {
     const std::unique_lock lk_list{*_lock};
-    message_id_list_add(_message_block_list, msg_id);
+    _message_block_list.insert(msg_id);
 }
 //------------------------------------------------------------------------------
 void adjacent_node::allow_message(const message_id msg_id) noexcept {
     const std::unique_lock lk_list{*_lock};
-    message_id_list_add(_message_allow_list, msg_id);
+    _message_allow_list.insert(msg_id);
 }
 //------------------------------------------------------------------------------
 void adjacent_node::clear_block_list() noexcept {
@@ -559,6 +622,12 @@ inline auto parent_router::update(
     return something_done;
 }
 //------------------------------------------------------------------------------
+void parent_router::add_to(work_waiter& waiter) noexcept {
+    if(_connection) [[likely]] {
+        waiter.add(*_connection);
+    }
+}
+//------------------------------------------------------------------------------
 auto parent_router::send(
   const main_ctx_object& user,
   const message_id msg_id,
@@ -609,7 +678,7 @@ auto router_nodes::find(const endpoint_id_t id) noexcept
 }
 //------------------------------------------------------------------------------
 auto router_nodes::find_outgoing(const endpoint_id_t target_id) -> endpoint_id_t {
-    return eagine::find(_endpoint_idx, target_id).or_default();
+    return _endpoint_idx.find(target_id);
 }
 //------------------------------------------------------------------------------
 auto router_nodes::has_some() noexcept -> bool {
@@ -639,7 +708,8 @@ void router_nodes::_adopt_pending(router& parent, router_pending& pending) noexc
         node.try_emplace(id);
         parent._update_use_workers();
     }
-    node->setup(pending.release_connection(), pending.maybe_router());
+    node->setup(
+      pending.release_connection(), pending.maybe_router(), parent._tracer);
     _recently_disconnected.erase(id);
 }
 //------------------------------------------------------------------------------
@@ -694,6 +764,15 @@ auto router_nodes::handle_accept(router& parent) noexcept -> work_done {
     return something_done;
 }
 //------------------------------------------------------------------------------
+void router_nodes::add_to(work_waiter& waiter) noexcept {
+    for(auto& entry : _nodes) {
+        std::get<1>(entry).add_to(waiter);
+    }
+    for(auto& an_acceptor : _acceptors) {
+        waiter.add(*an_acceptor);
+    }
+}
+//------------------------------------------------------------------------------
 auto router_nodes::remove_timeouted(const main_ctx_object& user) noexcept
   -> work_done {
     some_true something_done{};
@@ -714,6 +793,7 @@ auto router_nodes::remove_timeouted(const main_ctx_object& user) noexcept
         if(info.is_outdated()) {
             _endpoint_idx.erase(endpoint_id);
             mark_disconnected(endpoint_id);
+            subscriptions_changed();
             return true;
         }
         return false;
@@ -753,6 +833,7 @@ auto router_nodes::remove_disconnected(const main_ctx_object& user) noexcept
     something_done(_nodes.erase_if([this](auto& p) {
         if(p.second.should_disconnect()) [[unlikely]] {
             mark_disconnected(p.first);
+            subscriptions_changed();
             return true;
         }
         return false;
@@ -764,9 +845,13 @@ auto router_nodes::remove_disconnected(const main_ctx_object& user) noexcept
 auto router_nodes::update_endpoint_info(
   const endpoint_id_t incoming_id,
   const message_view& message) noexcept -> router_endpoint_info& {
-    _endpoint_idx[message.source_id] = incoming_id;
+    if(_endpoint_idx.set(message.source_id, incoming_id)) {
+        subscriptions_changed();
+    }
     auto& info = _endpoint_infos[message.source_id];
-    info.assign_instance_id(message);
+    if(info.assign_instance_id(message)) {
+        subscriptions_changed();
+    }
     return info;
 }
 //------------------------------------------------------------------------------
@@ -794,9 +879,65 @@ auto router_nodes::subscriptions_of(const endpoint_id_t target_id) noexcept
     return {{}, 0U};
 }
 //------------------------------------------------------------------------------
+void router_nodes::subscriptions_changed() noexcept {
+    _node_subscriptions_outdated = true;
+}
+//------------------------------------------------------------------------------
+auto router_nodes::update_subscription_index() noexcept -> work_done {
+    if(not _node_subscriptions_outdated) [[likely]] {
+        if(not _has_settling_subscriptions or
+           not _should_recheck_subscriptions.is_expired()) {
+            return false;
+        }
+    }
+    _should_recheck_subscriptions.reset();
+    _has_settling_subscriptions = false;
+    _node_subscriptions.clear();
+    // nodes leading to an endpoint with incomplete subscription information
+    flat_set<endpoint_id_t> unfiltered;
+    for(auto& [endpoint_id, info] : _endpoint_infos) {
+        if(const auto node_id{find_outgoing(endpoint_id)}) {
+            if(info.has_complete_subscriptions()) {
+                auto& node_subs = _node_subscriptions[node_id];
+                for(const auto& sub_msg_id : info.subscriptions()) {
+                    node_subs.insert(sub_msg_id);
+                }
+            } else {
+                _has_settling_subscriptions |= info.is_settling_subscriptions();
+                unfiltered.insert(node_id);
+            }
+        }
+    }
+    for(const auto node_id : unfiltered) {
+        _node_subscriptions.erase(node_id);
+    }
+    _node_subscriptions_outdated = false;
+    return true;
+}
+//------------------------------------------------------------------------------
+auto router_nodes::leads_to_subscriber(
+  const endpoint_id_t node_id,
+  const adjacent_node& node,
+  const message_id msg_id) const noexcept -> bool {
+    // other routers and bridges may have unknown endpoints behind them
+    if(node.maybe_router()) {
+        return true;
+    }
+    // the index is rebuilt during maintenance, until then forward everything
+    if(_node_subscriptions_outdated) [[unlikely]] {
+        return true;
+    }
+    if(const auto node_subs{eagine::find(_node_subscriptions, node_id)}) {
+        return node_subs->contains(msg_id);
+    }
+    // no complete subscription information about endpoints behind this node
+    return true;
+}
+//------------------------------------------------------------------------------
 void router_nodes::erase(const endpoint_id_t id) noexcept {
     _endpoint_idx.erase(id);
     _endpoint_infos.erase(id);
+    subscriptions_changed();
 }
 //------------------------------------------------------------------------------
 void router_nodes::cleanup() noexcept {
@@ -819,10 +960,12 @@ auto router_stats::time_since_last_routing() noexcept -> auto {
     return message_age_inc;
 }
 //------------------------------------------------------------------------------
-void router_stats::update_avg_msg_age(
-  const std::chrono::steady_clock::duration message_age_inc) noexcept {
+void router_stats::update_msg_stats(
+  const std::chrono::steady_clock::duration message_age,
+  const std::chrono::steady_clock::duration queuing_time) noexcept {
     const std::unique_lock lk{_lock};
-    _message_age_avg.add(message_age_inc);
+    _message_age_avg.add(message_age);
+    _queuing_hist.add(queuing_time);
 }
 //------------------------------------------------------------------------------
 auto router_stats::avg_msg_age() noexcept -> std::chrono::microseconds {
@@ -831,7 +974,28 @@ auto router_stats::avg_msg_age() noexcept -> std::chrono::microseconds {
       _message_age_avg.get());
 }
 //------------------------------------------------------------------------------
+auto router_stats::queuing_histogram() noexcept -> latency_histogram {
+    const std::shared_lock lk{_lock};
+    auto result{_prev_queuing_hist};
+    result.merge(_queuing_hist);
+    return result;
+}
+//------------------------------------------------------------------------------
+auto router_stats::next_queuing_interval() noexcept -> latency_histogram {
+    const std::unique_lock lk{_lock};
+    _prev_queuing_hist = std::exchange(_queuing_hist, {});
+    return _prev_queuing_hist;
+}
+//------------------------------------------------------------------------------
+void router_stats::remote_flow_info(
+  const endpoint_id_t node_id,
+  const message_flow_info& info) noexcept {
+    const std::unique_lock lk{_lock};
+    _remote_flow_infos.update(node_id, info);
+}
+//------------------------------------------------------------------------------
 auto router_stats::statistics() noexcept -> router_statistics {
+    _stats.forwarded_messages = _forwarded_messages;
     return _stats;
 }
 //------------------------------------------------------------------------------
@@ -841,6 +1005,7 @@ auto router_stats::update_stats() noexcept
     const auto now{std::chrono::steady_clock::now()};
     const std::chrono::duration<float> seconds{now - _forwarded_since_stat};
     _stats.uptime_seconds = uptime().count();
+    _stats.forwarded_messages = _forwarded_messages;
 
     if(seconds >= std::chrono::seconds{15}) [[unlikely]] {
         _forwarded_since_stat = now;
@@ -852,7 +1017,12 @@ auto router_stats::update_stats() noexcept
 
         const auto avg_msg_age_us =
           static_cast<std::int32_t>(avg_msg_age().count() + 500);
-        const auto avg_msg_age_ms = avg_msg_age_us / 1000;
+        const auto remote_msg_age_ms{[this] {
+            const std::unique_lock lk{_lock};
+            return _remote_flow_infos.max_message_age_ms();
+        }()};
+        const auto avg_msg_age_ms =
+          std::max(avg_msg_age_us / 1000, remote_msg_age_ms);
 
         _stats.message_age_us = avg_msg_age_us;
 
@@ -876,10 +1046,12 @@ constexpr auto router_log_stat_msg_count() noexcept {
 }
 //------------------------------------------------------------------------------
 void router_stats::log_stats(const main_ctx_object& user) noexcept {
-    if(++_stats.forwarded_messages % router_log_stat_msg_count() == 0) {
+    // called concurrently by the router workers
+    const auto forwarded_messages{++_forwarded_messages};
+    if(forwarded_messages % router_log_stat_msg_count() == 0) {
         const auto now{std::chrono::steady_clock::now()};
-        const std::chrono::duration<float> interval{now - _forwarded_since_log};
-        _forwarded_since_log = now;
+        const std::chrono::duration<float> interval{
+          now - _forwarded_since_log.exchange(now)};
 
         if(interval > interval.zero()) [[likely]] {
             const auto msgs_per_sec{
@@ -888,10 +1060,11 @@ void router_stats::log_stats(const main_ctx_object& user) noexcept {
             user.log_chart_sample("msgsPerSec", msgs_per_sec);
             user.log_stat("forwarded ${count} messages (${msgsPerSec})")
               .tag("msgStats")
-              .arg("count", _stats.forwarded_messages)
+              .arg("count", forwarded_messages)
               .arg("dropped", _stats.dropped_messages)
               .arg("interval", interval)
               .arg("avgMsgAge", avg_msg_age())
+              .arg("p99Queuing", next_queuing_interval().percentile(0.99F))
               .arg("msgsPerSec", "RatePerSec", msgs_per_sec);
         }
     }
@@ -1086,7 +1259,12 @@ router::router(main_ctx_parent parent) noexcept
   : main_ctx_object{"MsgBusRutr", parent}
   , _context{make_context(*this)}
   , _password_is_required{
-      app_config().get<bool>("msgbus.router.requires_password").value_or(false)} {
+      app_config().get<bool>("msgbus.router.requires_password").value_or(false)}
+  , _filter_broadcasts{
+      app_config().get<bool>("msgbus.router.filter_broadcasts").value_or(false)}
+  , _max_workers{std::max(
+      app_config().get<span_size_t>("msgbus.router.max_workers").value_or(0),
+      span_size(0))} {
     declare_state("multiThred", "multiThrd", "singleThrd");
     _ids.setup_from_config(*this);
     _ids.set_description(*this);
@@ -1256,6 +1434,7 @@ auto router::_handle_subscribed(
         auto& info = _update_endpoint_info(incoming_id, message);
         const std::unique_lock lk{_router_lock};
         info.add_subscription(sub_msg_id);
+        _nodes.subscriptions_changed();
     }
     return should_be_forwarded;
 }
@@ -1305,6 +1484,7 @@ auto router::_handle_not_subscribed(
         auto& info = _update_endpoint_info(incoming_id, message);
         const std::unique_lock lk{_router_lock};
         info.remove_subscription(sub_msg_id);
+        _nodes.subscriptions_changed();
     }
     return should_be_forwarded;
 }
@@ -1502,6 +1682,9 @@ auto router::_handle_stats_query(const message_view& message) noexcept
                 response.set_source_id(own_id);
                 this->_route_message(msgbus_id{"statsConn"}, own_id, response);
             }
+            if(conn_stats.send_latency_ms >= 0.F) {
+                _post_connection_latency(message, conn_stats);
+            }
         }
     }};
 
@@ -1511,9 +1694,55 @@ auto router::_handle_stats_query(const message_view& message) noexcept
     if(_parent_router) [[likely]] {
         respond(_parent_router.id(), _parent_router);
     }
+    _post_latency_histogram(message);
+    _post_trace_records(message);
     return should_be_forwarded;
 }
 //------------------------------------------------------------------------------
+void router::_post_connection_latency(
+  const message_view& query,
+  const connection_statistics& conn_stats) noexcept {
+    const auto own_id{get_id()};
+    const connection_latency_statistics latency{
+      .local_id = conn_stats.local_id,
+      .remote_id = conn_stats.remote_id,
+      .send_latency_ms = conn_stats.send_latency_ms};
+    auto temp{default_serialize_buffer_for(latency)};
+    if(const auto serialized{default_serialize(latency, cover(temp))})
+      [[likely]] {
+        message_view response{*serialized};
+        response.setup_response(query);
+        response.set_source_id(own_id);
+        this->_route_message(msgbus_id{"statsCnLat"}, own_id, response);
+    }
+}
+//------------------------------------------------------------------------------
+void router::_post_latency_histogram(const message_view& query) noexcept {
+    const auto own_id{get_id()};
+    const auto hist{_stats.queuing_histogram()};
+    auto temp{default_serialize_buffer_for(hist)};
+    if(const auto serialized{default_serialize(hist, cover(temp))}) [[likely]] {
+        message_view response{*serialized};
+        response.setup_response(query);
+        response.set_source_id(own_id);
+        this->_route_message(msgbus_id{"statsLtHst"}, own_id, response);
+    }
+}
+//------------------------------------------------------------------------------
+void router::_post_trace_records(const message_view& query) noexcept {
+    const auto own_id{get_id()};
+    for(const auto& record : _tracer.fetch_records(own_id)) {
+        auto temp{default_serialize_buffer_for(record)};
+        if(const auto serialized{default_serialize(record, cover(temp))})
+          [[likely]] {
+            message_view response{*serialized};
+            response.setup_response(query);
+            response.set_source_id(own_id);
+            this->_route_message(msgbus_id{"statsTrace"}, own_id, response);
+        }
+    }
+}
+//------------------------------------------------------------------------------
 auto router::_handle_bye_bye(
   const message_id msg_id,
   adjacent_node& node,
@@ -1558,6 +1787,16 @@ auto router::_handle_blob_prepare(const message_view& message) noexcept
     return should_be_forwarded;
 }
 //------------------------------------------------------------------------------
+auto router::_handle_flow_info(
+  const endpoint_id_t incoming_id,
+  const message_view& message) noexcept -> message_handling_result {
+    message_flow_info flow_info{};
+    if(default_deserialize(flow_info, message.content())) [[likely]] {
+        _stats.remote_flow_info(incoming_id, flow_info);
+    }
+    return was_handled;
+}
+//------------------------------------------------------------------------------
 auto router::_handle_special_common(
   const message_id msg_id,
   const endpoint_id_t incoming_id,
@@ -1599,9 +1838,13 @@ auto router::_handle_special_common(
         case id_v("statsBrdg"):
         case id_v("statsEndpt"):
         case id_v("statsConn"):
+        case id_v("statsCnLat"):
+        case id_v("statsTrace"):
+        case id_v("statsLtHst"):
             return should_be_forwarded;
-        case id_v("requestId"):
         case id_v("msgFlowInf"):
+            return _handle_flow_info(incoming_id, message);
+        case id_v("requestId"):
         case id_v("annEndptId"):
             return was_handled;
         [[unlikely]] default:
@@ -1704,7 +1947,25 @@ auto router::_forward_to(
   const message_id msg_id,
   message_view& message) noexcept -> bool {
     _stats.log_stats(*this);
-    return node_out.send(*this, msg_id, message);
+    // with worker threads messages are queued per target node, without
+    // taking the router lock, and sent when the node connection is updated
+    const bool enqueue{_use_workers()};
+    if(enqueue) {
+        _tracer.stamp(message_trace_point::enqueue, msg_id, message);
+    }
+    return node_out.forward(*this, msg_id, message, enqueue);
+}
+//------------------------------------------------------------------------------
+auto router::_send_to_parent(
+  const message_id msg_id,
+  const message_view& message) noexcept -> bool {
+    _tracer.stamp(message_trace_point::submit, msg_id, message);
+    const std::unique_lock lk{_router_lock};
+    if(_parent_router.send(*this, msg_id, message)) {
+        _tracer.stamp(message_trace_point::accept, msg_id, message);
+        return true;
+    }
+    return false;
 }
 //------------------------------------------------------------------------------
 auto router::_route_targeted_message(
@@ -1717,12 +1978,10 @@ auto router::_route_targeted_message(
     if(const auto outgoing_id{_nodes.find_outgoing(message.target_id)}) {
         // if the message should go through the parent router
         if(outgoing_id == own_id) {
-            const std::unique_lock lk{_router_lock};
-            has_routed |= _parent_router.send(*this, msg_id, message);
+            has_routed |= _send_to_parent(msg_id, message);
         } else {
             _nodes.find(outgoing_id).and_then([&](auto& node_out) {
                 if(node_out.is_allowed(msg_id)) {
-                    const std::unique_lock lk{_router_lock};
                     has_routed = _forward_to(node_out, msg_id, message);
                 }
             });
@@ -1730,27 +1989,25 @@ auto router::_route_targeted_message(
     }
 
     if(not has_routed) {
-        for(const auto& [outgoing_id, node_out] : _nodes.get()) {
-            if(outgoing_id == message.target_id) {
-                if(node_out.is_allowed(msg_id)) {
-                    const std::unique_lock lk{_router_lock};
-                    has_routed = _forward_to(node_out, msg_id, message);
-                }
+        // the target may be directly adjacent but not yet indexed
+        _nodes.find(message.target_id).and_then([&](auto& node_out) {
+            if(node_out.is_allowed(msg_id)) {
+                has_routed = _forward_to(node_out, msg_id, message);
             }
-        }
+        });
     }
 
     if(not has_routed) {
         if(not _nodes.is_disconnected(message.target_id)) [[likely]] {
-            const std::unique_lock lk{_router_lock};
             for(const auto& [outgoing_id, node_out] : _nodes.get()) {
                 if(incoming_id != outgoing_id) {
-                    has_routed |= node_out.try_route(*this, msg_id, message);
+                    has_routed |= node_out.try_route(
+                      *this, msg_id, message, _use_workers());
                 }
             }
             // if the message didn't come from the parent router
             if(incoming_id != own_id) {
-                has_routed |= _parent_router.send(*this, msg_id, message);
+                has_routed |= _send_to_parent(msg_id, message);
             }
         }
     }
@@ -1762,16 +2019,22 @@ auto router::_route_broadcast_message(
   const endpoint_id_t incoming_id,
   message_view& message) noexcept -> bool {
 
-    const std::unique_lock lk{_router_lock};
+    // special messages are always forwarded to all nodes
+    const bool filter{_filter_broadcasts and not is_special_message(msg_id)};
+
     for(const auto& [outgoing_id, node_out] : _nodes.get()) {
         if(incoming_id != outgoing_id) {
             if(node_out.is_allowed(msg_id)) {
-                _forward_to(node_out, msg_id, message);
+                if(
+                  not filter or
+                  _nodes.leads_to_subscriber(outgoing_id, node_out, msg_id)) {
+                    _forward_to(node_out, msg_id, message);
+                }
             }
         }
     }
     if(not has_id(incoming_id)) {
-        _parent_router.send(*this, msg_id, message);
+        _send_to_parent(msg_id, message);
     }
     return true;
 }
@@ -1805,7 +2068,11 @@ auto router::_handle_parent_message(
   const message_id msg_id,
   const message_age msg_age,
   message_view message) noexcept -> bool {
-    _stats.update_avg_msg_age(message.add_age(msg_age).age() + message_age_inc);
+    _tracer.stamp(message_trace_point::receive, msg_id, message);
+    // the message waited in the incoming queue of the connection since
+    // it was received by this router
+    _stats.update_msg_stats(
+      message.add_age(msg_age).age() + message_age_inc, msg_age);
 
     if(is_special_message(msg_id)) {
         return _handle_special_parent_message(msg_id, message);
@@ -1824,7 +2091,11 @@ auto router::_handle_node_message(
   const message_age msg_age,
   message_view message,
   adjacent_node& node) noexcept -> bool {
-    _stats.update_avg_msg_age(message.add_age(msg_age).age() + message_age_inc);
+    _tracer.stamp(message_trace_point::receive, msg_id, message);
+    // the message waited in the incoming queue of the connection since
+    // it was received by this router
+    _stats.update_msg_stats(
+      message.add_age(msg_age).age() + message_age_inc, msg_age);
 
     if(_handle_special(msg_id, incoming_id, node, message)) {
         return true;
@@ -1848,6 +2119,10 @@ auto router::_handle_special_parent_message(
         case id_v("confirmId"):
             _parent_router.confirm_id(*this, message);
             break;
+        case id_v("msgFlowInf"):
+            // the flow info of the parent describes the flow towards this
+            // router, the nodes get the information of this router instead
+            break;
         [[likely]] default:
             if(not _do_handle_special(msg_id, _parent_router.id(), message)) {
                 return _route_message(msg_id, get_id(), message);
@@ -1856,18 +2131,48 @@ auto router::_handle_special_parent_message(
     return true;
 }
 //------------------------------------------------------------------------------
+template <typename Enqueue, typename Overlap>
+void router::_enqueue_in_waves(Enqueue enqueue, Overlap overlap) noexcept {
+    // at most _max_workers nodes are processed by the workers at once
+    auto& nodes{_nodes.get()};
+    const auto total{span_size(nodes.size())};
+    const auto wave{_max_workers > 0 ? std::min(_max_workers, total) : total};
+    bool overlapped{false};
+    auto pos{nodes.begin()};
+    for(span_size_t done = 0; done < total; done += wave) {
+        const auto count{std::min(wave, total - done)};
+        std::latch completed{limit_cast<std::ptrdiff_t>(count)};
+        for(span_size_t i = 0; i < count; ++i, ++pos) {
+            auto& [node_id, node] = *pos;
+            enqueue(node_id, node, completed);
+        }
+        if(not overlapped) {
+            overlap();
+            overlapped = true;
+        }
+        completed.wait();
+    }
+    if(not overlapped) {
+        overlap();
+    }
+}
+//------------------------------------------------------------------------------
 void router::_route_messages_by_workers(some_true_atomic& something_done) noexcept {
     const auto message_age_inc{_stats.time_since_last_routing()};
-    std::latch completed{limit_cast<std::ptrdiff_t>(node_count())};
 
-    for(auto& [node_id, node] : _nodes.get()) {
-        node.enqueue_route_messages(
-          workers(), *this, node_id, message_age_inc, completed, something_done);
-    }
-
-    something_done(_parent_router.route_messages(*this, message_age_inc));
-
-    completed.wait();
+    _enqueue_in_waves(
+      [&, this](const endpoint_id_t node_id, auto& node, std::latch& completed) {
+          node.enqueue_route_messages(
+            _routing_workers(),
+            *this,
+            node_id,
+            message_age_inc,
+            completed,
+            something_done);
+      },
+      [&, this] {
+          something_done(_parent_router.route_messages(*this, message_age_inc));
+      });
 }
 //------------------------------------------------------------------------------
 auto router::_route_messages_by_router() noexcept -> work_done {
@@ -1885,19 +2190,16 @@ auto router::_route_messages_by_router() noexcept -> work_done {
 //------------------------------------------------------------------------------
 void router::_update_connections_by_workers(
   some_true_atomic& something_done) noexcept {
-    std::latch completed{limit_cast<std::ptrdiff_t>(node_count())};
-
-    for(auto& entry : _nodes.get()) {
-        std::get<1>(entry).enqueue_update_connection(
-          workers(), completed, something_done);
-    }
-    something_done(_parent_router.update(*this, get_id()));
+    _enqueue_in_waves(
+      [&, this](const endpoint_id_t, auto& node, std::latch& completed) {
+          node.enqueue_update_connection(
+            _routing_workers(), completed, something_done);
+      },
+      [&, this] { something_done(_parent_router.update(*this, get_id())); });
 
     if(_nodes.has_some()) [[likely]] {
         _no_connection_timeout.reset();
     }
-
-    completed.wait();
 }
 //------------------------------------------------------------------------------
 auto router::_update_connections_by_router() noexcept -> work_done {
@@ -1929,6 +2231,9 @@ auto router::do_maintenance() noexcept -> work_done {
 //------------------------------------------------------------------------------
 auto router::do_work_by_workers() noexcept -> work_done {
     some_true_atomic something_done{};
+    // new subscriptions are indexed before each routing round, while
+    // the workers that may change them are idle
+    something_done(_nodes.update_subscription_index());
 
     _route_messages_by_workers(something_done);
     _update_connections_by_workers(something_done);
@@ -1938,6 +2243,7 @@ auto router::do_work_by_workers() noexcept -> work_done {
 //------------------------------------------------------------------------------
 auto router::do_work_by_router() noexcept -> work_done {
     some_true something_done{};
+    something_done(_nodes.update_subscription_index());
 
     something_done(_route_messages_by_router());
     something_done(_update_connections_by_router());
@@ -1974,6 +2280,15 @@ auto router::update(const valid_if_positive<int>& count) noexcept -> work_done {
     return something_done;
 }
 //------------------------------------------------------------------------------
+auto router::wait_for_work(
+  const std::chrono::steady_clock::duration timeout) noexcept -> work_done {
+    // all connections and acceptors are waited on at once
+    _waiter.reset();
+    _nodes.add_to(_waiter);
+    _parent_router.add_to(_waiter);
+    return _waiter.wait(timeout);
+}
+//------------------------------------------------------------------------------
 void router::say_bye() noexcept {
     const auto msgid{msgbus_id{"byeByeRutr"}};
     message_view msg{};
@@ -0,0 +1,1275 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+module;
+
+#if __has_include(<fcntl.h>) && \
+	__has_include(<signal.h>) && \
+	__has_include(<sys/mman.h>) && \
+	__has_include(<sys/stat.h>) && \
+	__has_include(<unistd.h>)
+#include <cassert>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define EAGINE_POSIX 1
+#else
+#define EAGINE_POSIX 0
+#endif
+
+// on Linux the ring consumers can sleep on a futex in the shared memory
+#if EAGINE_POSIX && defined(__linux__) && \
+	__has_include(<linux/futex.h>) && \
+	__has_include(<sys/syscall.h>)
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#define EAGINE_SHMEM_RING_FUTEX 1
+#else
+#define EAGINE_SHMEM_RING_FUTEX 0
+#endif
+
+module eagine.msgbus.core;
+
+import std;
+import eagine.core.types;
+import eagine.core.memory;
+import eagine.core.identifier;
+import eagine.core.serialization;
+import eagine.core.valid_if;
+import eagine.core.utility;
+import eagine.core.runtime;
+import eagine.core.main_ctx;
+import <cerrno>;
+
+namespace eagine::msgbus {
+#if EAGINE_POSIX
+//------------------------------------------------------------------------------
+// signal
+//------------------------------------------------------------------------------
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+static_assert(std::atomic<std::int64_t>::is_always_lock_free);
+//------------------------------------------------------------------------------
+/// @brief Wake-up signal placed in shared memory, usable across processes.
+/// @ingroup msgbus
+/// @note Implementation detail. Do not use directly.
+struct shmem_ring_signal {
+    std::atomic<std::uint32_t> counter{0U};
+    std::atomic<std::uint32_t> waiting{0U};
+
+    /// @brief Wakes up the waiting side; makes a syscall only if it waits.
+    void notify() noexcept {
+        counter.fetch_add(1U);
+        if(waiting.load() > 0U) [[unlikely]] {
+#if EAGINE_SHMEM_RING_FUTEX
+            // NOLINTNEXTLINE(hicpp-vararg)
+            ::syscall(
+              SYS_futex,
+              reinterpret_cast<std::uint32_t*>(&counter),
+              FUTEX_WAKE,
+              std::numeric_limits<int>::max(),
+              nullptr,
+              nullptr,
+              0);
+#endif
+        }
+    }
+
+    /// @brief Waits until ready returns true, a notification or timeout.
+    template <typename Predicate>
+    auto wait_for(
+      const std::chrono::steady_clock::duration timeout,
+      const Predicate ready) noexcept -> bool {
+        const auto expected{counter.load()};
+        if(ready()) {
+            return true;
+        }
+        waiting.fetch_add(1U);
+        if(not ready()) {
+#if EAGINE_SHMEM_RING_FUTEX
+            const auto ns{std::max(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(timeout)
+                .count(),
+              std::chrono::nanoseconds::rep(0))};
+            ::timespec ts{};
+            ts.tv_sec = static_cast<decltype(ts.tv_sec)>(ns / 1'000'000'000);
+            ts.tv_nsec = static_cast<decltype(ts.tv_nsec)>(ns % 1'000'000'000);
+            // the wait returns immediately if the counter changed since
+            // it was read above, so no notification can get lost
+            // NOLINTNEXTLINE(hicpp-vararg)
+            ::syscall(
+              SYS_futex,
+              reinterpret_cast<std::uint32_t*>(&counter),
+              FUTEX_WAIT,
+              expected,
+              &ts,
+              nullptr,
+              0);
+#else
+            if(counter.load() == expected) {
+                std::this_thread::sleep_for(timeout);
+            }
+#endif
+        }
+        waiting.fetch_sub(1U);
+        return ready();
+    }
+
+    /// @brief Waits until a notification after the seen one or timeout.
+    auto wait_for_next(
+      std::uint32_t& seen,
+      const std::chrono::steady_clock::duration timeout) noexcept -> bool {
+        const bool notified{
+          wait_for(timeout, [&] { return counter.load() != seen; })};
+        seen = counter.load();
+        return notified;
+    }
+};
+//------------------------------------------------------------------------------
+// shared memory layout
+//------------------------------------------------------------------------------
+static constexpr const std::uint32_t shmem_ring_segment_magic{0xE4611E02U};
+static constexpr const std::uint32_t shmem_ring_accept_magic{0xE4611EACU};
+//------------------------------------------------------------------------------
+/// @brief Control block of a single-producer single-consumer ring buffer.
+/// @ingroup msgbus
+/// @note Implementation detail. Do not use directly.
+struct shmem_ring_header {
+    // byte counters, wrapping at 2^32, positions are masked by the capacity
+    alignas(64) std::atomic<std::uint32_t> head{0U};
+    alignas(64) std::atomic<std::uint32_t> tail{0U};
+    alignas(64) shmem_ring_signal signal{};
+    std::atomic<std::uint32_t> closed{0U};
+    // liveness of the producer, for the case that it ends without closing
+    alignas(64) std::atomic<std::int64_t> producer_pid{0};
+    std::atomic<std::int64_t> heartbeat{0};
+};
+//------------------------------------------------------------------------------
+/// @brief Header of a shared memory segment holding the rings of a connection.
+/// @ingroup msgbus
+/// @note Implementation detail. Do not use directly.
+struct shmem_ring_segment_header {
+    std::uint32_t magic{shmem_ring_segment_magic};
+    std::uint32_t capacity{0U};
+    std::atomic<std::uint32_t> accepted{0U};
+    // client-to-server and server-to-client
+    std::array<shmem_ring_header, 2> rings{};
+};
+//------------------------------------------------------------------------------
+static constexpr auto shmem_ring_data_offset() noexcept -> span_size_t {
+    return span_size((sizeof(shmem_ring_segment_header) + 63U) / 64U * 64U);
+}
+//------------------------------------------------------------------------------
+static constexpr auto shmem_ring_segment_size(const span_size_t capacity) noexcept
+  -> span_size_t {
+    return shmem_ring_data_offset() + 2 * capacity;
+}
+//------------------------------------------------------------------------------
+/// @brief Slot in the acceptor segment, used to request a new connection.
+/// @ingroup msgbus
+/// @note Implementation detail. Do not use directly.
+struct shmem_ring_accept_slot {
+    static constexpr const std::uint32_t free{0U};
+    static constexpr const std::uint32_t writing{1U};
+    static constexpr const std::uint32_t requested{2U};
+
+    std::atomic<std::uint32_t> state{free};
+    std::array<char, 60> name{};
+};
+//------------------------------------------------------------------------------
+/// @brief Header of the shared memory segment of an acceptor.
+/// @ingroup msgbus
+/// @note Implementation detail. Do not use directly.
+struct shmem_ring_accept_header {
+    std::uint32_t magic{shmem_ring_accept_magic};
+    shmem_ring_signal signal{};
+    std::array<shmem_ring_accept_slot, 64> slots{};
+
+    /// @brief Posts a request to connect the segment with the specified name.
+    auto request(const std::string& name) noexcept -> bool {
+        for(auto& slot : slots) {
+            if(name.size() >= slot.name.size()) [[unlikely]] {
+                return false;
+            }
+            auto expected{shmem_ring_accept_slot::free};
+            if(slot.state.compare_exchange_strong(
+                 expected, shmem_ring_accept_slot::writing)) {
+                std::copy(name.begin(), name.end(), slot.name.begin());
+                slot.name[name.size()] = '\0';
+                slot.state.store(shmem_ring_accept_slot::requested);
+                signal.notify();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    auto has_requests() const noexcept -> bool {
+        return std::any_of(slots.begin(), slots.end(), [](const auto& slot) {
+            return slot.state.load() == shmem_ring_accept_slot::requested;
+        });
+    }
+
+    /// @brief Calls the function on the names of requested segments.
+    template <typename Function>
+    auto accept(const Function& func) noexcept -> work_done {
+        some_true something_done{};
+        for(auto& slot : slots) {
+            if(slot.state.load() == shmem_ring_accept_slot::requested) {
+                func(std::string{slot.name.data()});
+                slot.state.store(shmem_ring_accept_slot::free);
+                something_done();
+            }
+        }
+        return something_done;
+    }
+};
+//------------------------------------------------------------------------------
+// shared memory segment
+//------------------------------------------------------------------------------
+/// @brief Class wrapping a POSIX shared memory segment mapped into memory.
+/// @ingroup msgbus
+class shmem_segment : public main_ctx_object {
+public:
+    shmem_segment(main_ctx_parent parent) noexcept
+      : main_ctx_object{"ShmemSeg", parent} {}
+
+    /// @brief Constructs the segment and sets the specified name.
+    shmem_segment(main_ctx_parent parent, std::string name) noexcept
+      : main_ctx_object{"ShmemSeg", parent} {
+        set_name(std::move(name));
+    }
+
+    shmem_segment(shmem_segment&&) = delete;
+    shmem_segment(const shmem_segment&) = delete;
+    auto operator=(shmem_segment&&) = delete;
+    auto operator=(const shmem_segment&) = delete;
+
+    ~shmem_segment() noexcept {
+        close();
+    }
+
+    /// @brief Returns the unique name of this segment.
+    auto get_name() const noexcept -> string_view {
+        return {_name};
+    }
+
+    /// @brief Sets the unique name of the segment.
+    auto set_name(std::string name) noexcept -> shmem_segment&;
+
+    /// @brief Constructs a segment name from an identifier.
+    static auto name_from(const identifier id) noexcept -> std::string;
+
+    auto error_message(const int error_number) const noexcept -> std::string;
+
+    /// @brief Indicates if there a previous operation finished with an error.
+    auto had_error() const noexcept -> bool {
+        return _last_errno != 0;
+    }
+
+    /// @brief Indicates if this segment is mapped into memory.
+    auto is_open() const noexcept -> bool {
+        return _addr != nullptr;
+    }
+
+    /// @brief Creates and maps a new segment with the specified size.
+    auto create(const span_size_t size) noexcept -> shmem_segment&;
+
+    /// @brief Opens and maps an existing segment.
+    auto open() noexcept -> shmem_segment&;
+
+    /// @brief Unmaps the segment.
+    auto close() noexcept -> shmem_segment&;
+
+    /// @brief Removes the name of the segment, the mappings stay valid.
+    auto unlink() noexcept -> shmem_segment&;
+
+    /// @brief Returns the mapped memory.
+    auto data() const noexcept -> memory::block {
+        return {static_cast<byte*>(_addr), _size};
+    }
+
+    /// @brief Constructs the header of the specified type at the segment start.
+    template <typename Header>
+    auto emplace_header() noexcept -> Header& {
+        assert(is_open() and (span_size(sizeof(Header)) <= _size));
+        return *new(_addr) Header{};
+    }
+
+    /// @brief Returns the header of the specified type, if the segment fits it.
+    template <typename Header>
+    auto header() const noexcept -> optional_reference<Header> {
+        if(is_open() and (span_size(sizeof(Header)) <= _size)) [[likely]] {
+            return {std::launder(static_cast<Header*>(_addr))};
+        }
+        return {};
+    }
+
+private:
+    auto _map(const int fd) noexcept -> shmem_segment&;
+
+    std::string _name{};
+    void* _addr{nullptr};
+    span_size_t _size{0};
+    int _last_errno{0};
+};
+//------------------------------------------------------------------------------
+auto shmem_segment::set_name(std::string name) noexcept -> shmem_segment& {
+    _name = std::move(name);
+    if(_name.empty()) {
+        _name = "/eagine-msgbus-shm";
+    } else if(_name.front() != '/') {
+        _name.insert(_name.begin(), '/');
+    }
+    return *this;
+}
+//------------------------------------------------------------------------------
+auto shmem_segment::name_from(const identifier id) noexcept -> std::string {
+    std::string result;
+    result.reserve(integer(identifier::max_size() + 1));
+    id.name().str(result);
+    return result;
+}
+//------------------------------------------------------------------------------
+auto shmem_segment::error_message(const int error_number) const noexcept
+  -> std::string {
+    if(error_number) {
+        char buf[128] = {};
+        [[maybe_unused]] auto unused{
+          ::strerror_r(error_number, static_cast<char*>(buf), sizeof(buf))};
+        return {static_cast<const char*>(buf)};
+    }
+    return {};
+}
+//------------------------------------------------------------------------------
+auto shmem_segment::_map(const int fd) noexcept -> shmem_segment& {
+    errno = 0;
+    void* addr{::mmap(
+      nullptr,
+      std::size_t(_size),
+      // NOLINTNEXTLINE(hicpp-signed-bitwise)
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED,
+      fd,
+      0)};
+    _last_errno = errno;
+    if(addr != MAP_FAILED) [[likely]] {
+        _addr = addr;
+    } else {
+        _size = 0;
+    }
+    ::close(fd);
+    return *this;
+}
+//------------------------------------------------------------------------------
+auto shmem_segment::create(const span_size_t size) noexcept -> shmem_segment& {
+    log_debug("creating shared memory segment ${name}")
+      .arg("name", get_name())
+      .arg("size", size);
+
+    errno = 0;
+    const int fd{::shm_open(
+      _name.c_str(),
+      // NOLINTNEXTLINE(hicpp-signed-bitwise)
+      O_RDWR | O_CREAT | O_EXCL,
+      // NOLINTNEXTLINE(hicpp-signed-bitwise)
+      S_IRUSR | S_IWUSR)};
+    _last_errno = errno;
+    if(fd >= 0) {
+        if(::ftruncate(fd, ::off_t(size)) == 0) [[likely]] {
+            _size = size;
+            _map(fd);
+        } else {
+            _last_errno = errno;
+            ::close(fd);
+        }
+    }
+    if(_last_errno) {
+        log_error("failed to create shared memory segment ${name}")
+          .arg("name", get_name())
+          .arg("errno", _last_errno)
+          .arg("message", error_message(_last_errno));
+    }
+    return *this;
+}
+//------------------------------------------------------------------------------
+auto shmem_segment::open() noexcept -> shmem_segment& {
+    log_debug("opening shared memory segment ${name}").arg("name", get_name());
+
+    errno = 0;
+    const int fd{::shm_open(
+      _name.c_str(),
+      O_RDWR,
+      // NOLINTNEXTLINE(hicpp-signed-bitwise)
+      S_IRUSR | S_IWUSR)};
+    _last_errno = errno;
+    if(fd >= 0) {
+        struct ::stat st {};
+        if(::fstat(fd, &st) == 0) [[likely]] {
+            _size = span_size(st.st_size);
+            _map(fd);
+        } else {
+            _last_errno = errno;
+            ::close(fd);
+        }
+    }
+    if(_last_errno) {
+        log_error("failed to open shared memory segment ${name}")
+          .arg("name", get_name())
+          .arg("errno", _last_errno)
+          .arg("message", error_message(_last_errno));
+    }
+    return *this;
+}
+//------------------------------------------------------------------------------
+auto shmem_segment::close() noexcept -> shmem_segment& {
+    if(is_open()) {
+        log_debug("closing shared memory segment ${name}")
+          .arg("name", get_name());
+        ::munmap(_addr, std::size_t(_size));
+        _addr = nullptr;
+        _size = 0;
+    }
+    return *this;
+}
+//------------------------------------------------------------------------------
+auto shmem_segment::unlink() noexcept -> shmem_segment& {
+    if(not _name.empty()) {
+        errno = 0;
+        ::shm_unlink(_name.c_str());
+        _last_errno = errno == ENOENT ? 0 : errno;
+    }
+    return *this;
+}
+//------------------------------------------------------------------------------
+// ring
+//------------------------------------------------------------------------------
+/// @brief View of a single-producer single-consumer byte ring in shared memory.
+/// @ingroup msgbus
+/// @note Each record is a 32-bit length followed by the data, aligned to 8 bytes.
+class shmem_ring {
+public:
+    shmem_ring() noexcept = default;
+
+    shmem_ring(shmem_ring_header& header, const memory::block data) noexcept
+      : _header{&header}
+      , _data{data}
+      , _capacity{limit_cast<std::uint32_t>(data.size())} {
+        assert(std::has_single_bit(_capacity));
+    }
+
+    auto is_valid() const noexcept -> bool {
+        return _header != nullptr;
+    }
+
+    /// @brief Indicates if the producer closed the ring.
+    auto is_closed() const noexcept -> bool {
+        return not is_valid() or (_header->closed.load() != 0U);
+    }
+
+    /// @brief Closes the ring, called by the producer.
+    void close() noexcept {
+        if(is_valid()) {
+            _header->closed.store(1U);
+            _header->signal.notify();
+        }
+    }
+
+    /// @brief Marks the producer of the ring as alive, called by the producer.
+    void heartbeat() noexcept {
+        if(is_valid()) [[likely]] {
+            _header->producer_pid.store(::getpid(), std::memory_order_relaxed);
+            _header->heartbeat.store(
+              _clock_ticks(), std::memory_order_relaxed);
+        }
+    }
+
+    /// @brief Indicates if the producer process ended without closing the ring.
+    /// The process is checked only if it had no heartbeat for the grace period.
+    auto is_abandoned(
+      const std::chrono::steady_clock::duration grace) const noexcept -> bool {
+        if(not is_valid()) [[unlikely]] {
+            return false;
+        }
+        const auto pid{_header->producer_pid.load(std::memory_order_relaxed)};
+        const auto last{_header->heartbeat.load(std::memory_order_relaxed)};
+        if((pid <= 0) or (_clock_ticks() - last < grace.count())) [[likely]] {
+            return false;
+        }
+        return (::kill(static_cast<::pid_t>(pid), 0) != 0) and (errno == ESRCH);
+    }
+
+    /// @brief Wakes up the consumer of the ring.
+    void notify() noexcept {
+        if(is_valid()) [[likely]] {
+            _header->signal.notify();
+        }
+    }
+
+    /// @brief Returns the count of bytes released by the consumer so far.
+    auto consumed() const noexcept -> std::uint32_t {
+        return is_valid() ? _header->tail.load(std::memory_order_acquire) : 0U;
+    }
+
+    auto is_empty() const noexcept -> bool {
+        return not is_valid() or (_header->head.load(std::memory_order_acquire) ==
+                                  _header->tail.load(std::memory_order_relaxed));
+    }
+
+    /// @brief Reserves contiguous space for a record, called by the producer.
+    /// Returns an empty block if the ring has not enough free space.
+    auto begin_push(const span_size_t max_size) noexcept -> memory::block;
+
+    /// @brief Publishes the record of the specified size reserved before.
+    void commit_push(const span_size_t size) noexcept;
+
+    /// @brief Copies the specified block into the ring.
+    auto push(const memory::const_block blk) noexcept -> bool {
+        auto dest{begin_push(blk.size())};
+        if(not dest.empty()) [[likely]] {
+            memory::copy(blk, dest);
+            commit_push(blk.size());
+            return true;
+        }
+        return false;
+    }
+
+    /// @brief Alias for the popped record handler.
+    using pop_handler = callable_ref<void(memory::const_block) noexcept>;
+
+    /// @brief Calls the handler on all available records and releases them.
+    auto pop_all(const pop_handler handler) noexcept -> span_size_t;
+
+    /// @brief Waits until a record is pushed, the ring is closed or timeout.
+    /// The ready predicate can end the wait on other notifications of the ring.
+    template <typename Predicate>
+    auto wait_for_push(
+      const std::chrono::steady_clock::duration timeout,
+      const Predicate also_ready) noexcept -> bool {
+        if(is_valid()) [[likely]] {
+            return _header->signal.wait_for(timeout, [&] {
+                return not is_empty() or is_closed() or also_ready();
+            });
+        }
+        std::this_thread::sleep_for(timeout);
+        return false;
+    }
+
+    /// @brief Waits until a notification after the seen one or timeout.
+    auto wait_for_next(
+      std::uint32_t& seen,
+      const std::chrono::steady_clock::duration timeout) noexcept -> bool {
+        if(is_valid()) [[likely]] {
+            return _header->signal.wait_for_next(seen, timeout);
+        }
+        return false;
+    }
+
+private:
+    // the steady clock is system-wide, so the ticks compare across processes
+    static auto _clock_ticks() noexcept -> std::int64_t {
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    static constexpr const std::uint32_t _wrap_marker{~std::uint32_t(0U)};
+    static constexpr const std::uint32_t _length_size{sizeof(std::uint32_t)};
+
+    static constexpr auto _record_size(const std::uint32_t size) noexcept
+      -> std::uint32_t {
+        return (_length_size + size + 7U) & ~std::uint32_t(7U);
+    }
+
+    void _write_length(const std::uint32_t pos, const std::uint32_t length) noexcept {
+        std::memcpy(_data.data() + (pos & (_capacity - 1U)), &length, _length_size);
+    }
+
+    auto _read_length(const std::uint32_t pos) const noexcept -> std::uint32_t {
+        std::uint32_t length{0U};
+        std::memcpy(&length, _data.data() + (pos & (_capacity - 1U)), _length_size);
+        return length;
+    }
+
+    shmem_ring_header* _header{nullptr};
+    memory::block _data{};
+    std::uint32_t _capacity{0U};
+    std::uint32_t _push_skip{0U};
+};
+//------------------------------------------------------------------------------
+auto shmem_ring::begin_push(const span_size_t max_size) noexcept
+  -> memory::block {
+    if(not is_valid()) [[unlikely]] {
+        return {};
+    }
+    const auto head{_header->head.load(std::memory_order_relaxed)};
+    const auto tail{_header->tail.load(std::memory_order_acquire)};
+    const auto available{_capacity - (head - tail)};
+    const auto contiguous{_capacity - (head & (_capacity - 1U))};
+    const auto needed{_record_size(limit_cast<std::uint32_t>(max_size))};
+
+    _push_skip = 0U;
+    if(needed > contiguous) {
+        // the record does not fit before the end, wrap around
+        _push_skip = contiguous;
+    }
+    if(_push_skip + needed > available) {
+        return {};
+    }
+    const auto pos{(head + _push_skip) & (_capacity - 1U)};
+    return {_data.data() + pos + _length_size, max_size};
+}
+//------------------------------------------------------------------------------
+void shmem_ring::commit_push(const span_size_t size) noexcept {
+    auto head{_header->head.load(std::memory_order_relaxed)};
+    if(_push_skip > 0U) {
+        _write_length(head, _wrap_marker);
+        head += _push_skip;
+    }
+    const auto length{limit_cast<std::uint32_t>(size)};
+    _write_length(head, length);
+    head += _record_size(length);
+    _header->head.store(head, std::memory_order_release);
+    _header->signal.notify();
+}
+//------------------------------------------------------------------------------
+auto shmem_ring::pop_all(const pop_handler handler) noexcept -> span_size_t {
+    span_size_t count{0};
+    if(not is_valid()) [[unlikely]] {
+        return count;
+    }
+    auto tail{_header->tail.load(std::memory_order_relaxed)};
+    const auto head{_header->head.load(std::memory_order_acquire)};
+    while(tail != head) {
+        const auto pos{tail & (_capacity - 1U)};
+        const auto length{_read_length(tail)};
+        if(length == _wrap_marker) {
+            tail += _capacity - pos;
+            continue;
+        }
+        if(_record_size(length) > _capacity - pos) [[unlikely]] {
+            // corrupted ring, drop everything
+            tail = head;
+            break;
+        }
+        handler(memory::const_block{
+          _data.data() + pos + _length_size, span_size(length)});
+        tail += _record_size(length);
+        ++count;
+    }
+    // releasing the space once per batch keeps the producer's cache line quiet
+    _header->tail.store(tail, std::memory_order_release);
+    return count;
+}
+//------------------------------------------------------------------------------
+// connection
+//------------------------------------------------------------------------------
+struct shmem_ring_shared_state {
+    span_size_t capacity{1024 * 1024};
+    span_size_t max_data_size{16 * 1024};
+    std::chrono::steady_clock::duration peer_grace{std::chrono::seconds{1}};
+
+    auto make_id() const noexcept {
+        return random_identifier();
+    }
+};
+//------------------------------------------------------------------------------
+/// @brief Implementation of the connection_info interface for shared memory connection.
+/// @ingroup msgbus
+/// @see connection_info
+template <typename Base>
+class shmem_ring_connection_info : public Base {
+public:
+    using Base::Base;
+
+    auto kind() noexcept -> connection_kind final {
+        return connection_kind::local_interprocess;
+    }
+
+    auto addr_kind() noexcept -> connection_addr_kind final {
+        return connection_addr_kind::filepath;
+    }
+
+    auto type_id() noexcept -> identifier final {
+        return "ShmemRing";
+    }
+};
+//------------------------------------------------------------------------------
+/// @brief Implementation of connection on top of shared memory ring buffers.
+/// @ingroup msgbus
+/// @see shmem_ring
+/// @see shmem_ring_connector
+/// @see shmem_ring_acceptor
+class shmem_ring_connection
+  : public shmem_ring_connection_info<connection>
+  , public main_ctx_object {
+
+public:
+    /// @brief Alias for received message fetch handler callable.
+    using fetch_handler = connection::fetch_handler;
+
+    /// @brief Construction from parent main context object.
+    shmem_ring_connection(
+      main_ctx_parent parent,
+      shared_holder<shmem_ring_shared_state> shared_state) noexcept;
+
+    shmem_ring_connection(shmem_ring_connection&&) = delete;
+    shmem_ring_connection(const shmem_ring_connection&) = delete;
+    auto operator=(shmem_ring_connection&&) = delete;
+    auto operator=(const shmem_ring_connection&) = delete;
+
+    ~shmem_ring_connection() noexcept override {
+        _stop_watching();
+        _output.close();
+    }
+
+    /// @brief Attaches to the segment with the specified name, created by a connector.
+    auto open(std::string name) noexcept -> bool;
+
+    auto is_usable() noexcept -> bool final {
+        const std::unique_lock lock_output{_mutex_output};
+        return not _output.is_closed() and not _input.is_closed() and
+               not _input.is_abandoned(_shared_state->peer_grace);
+    }
+
+    auto max_data_size() noexcept -> valid_if_positive<span_size_t> final {
+        return {_buffer.size()};
+    }
+
+    auto update() noexcept -> work_done override {
+        some_true something_done{};
+        something_done(_receive());
+        something_done(_send());
+        return something_done;
+    }
+
+    auto send(const message_id msg_id, const message_view& message) noexcept
+      -> bool final;
+
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done final;
+
+    /// @brief Provides a work signal raised by a thread watching the input ring.
+    auto add_wait_handles(work_waiter& waiter) noexcept -> bool final;
+
+    auto fetch_messages(const fetch_handler handler) noexcept -> work_done final {
+        const std::unique_lock lock_input{_mutex_input};
+        return _incoming.fetch_all(handler);
+    }
+
+    auto query_statistics(connection_statistics&) noexcept -> bool final {
+        return false;
+    }
+
+    auto routing_weight() noexcept -> float final {
+        return 0.75F;
+    }
+
+protected:
+    void _attach(const bool is_server) noexcept;
+    void _detach() noexcept;
+    void _stop_watching() noexcept;
+    auto _receive() noexcept -> work_done;
+    auto _send() noexcept -> bool;
+
+    auto _handle_send(
+      const message_timestamp,
+      const message_priority,
+      const memory::const_block data) noexcept -> bool;
+
+    void _handle_receive(const memory::const_block data) noexcept;
+
+    std::mutex _mutex_input;
+    std::mutex _mutex_output;
+    memory::buffer _buffer;
+    message_storage _incoming;
+    serialized_message_storage _outgoing;
+    shmem_segment _segment{*this};
+    shmem_ring _input;
+    shmem_ring _output;
+    timeout _reconnect_timeout{std::chrono::seconds{2}, nothing};
+    shared_holder<shmem_ring_shared_state> _shared_state;
+    work_signal _signal;
+    std::thread _watcher;
+    std::atomic<bool> _watching{false};
+    // consumer position of the output ring when it last was full
+    std::uint32_t _blocked_at{0U};
+    bool _output_full{false};
+};
+//------------------------------------------------------------------------------
+shmem_ring_connection::shmem_ring_connection(
+  main_ctx_parent parent,
+  shared_holder<shmem_ring_shared_state> shared_state) noexcept
+  : main_ctx_object{"ShmemConn", parent}
+  , _shared_state{std::move(shared_state)} {
+    _buffer.resize(_shared_state->max_data_size);
+}
+//------------------------------------------------------------------------------
+auto shmem_ring_connection::open(std::string name) noexcept -> bool {
+    const std::unique_lock lock_input{_mutex_input};
+    const std::unique_lock lock_output{_mutex_output};
+    if(not _segment.set_name(std::move(name)).open().had_error()) {
+        if(const auto header{
+             _segment.header<shmem_ring_segment_header>()}) [[likely]] {
+            const auto capacity{span_size(header->capacity)};
+            if(
+              (header->magic == shmem_ring_segment_magic) and
+              std::has_single_bit(header->capacity) and
+              (shmem_ring_segment_size(capacity) <= _segment.data().size())) {
+                _attach(true);
+                header->accepted.store(1U);
+                return true;
+            }
+        }
+        log_error("invalid shared memory segment ${name}")
+          .arg("name", _segment.get_name());
+        _segment.close();
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+void shmem_ring_connection::_attach(const bool is_server) noexcept {
+    auto& header{*_segment.header<shmem_ring_segment_header>()};
+    const auto capacity{span_size(header.capacity)};
+    const auto data{skip(_segment.data(), shmem_ring_data_offset())};
+    shmem_ring client_to_server{header.rings[0], head(data, capacity)};
+    shmem_ring server_to_client{
+      header.rings[1], head(skip(data, capacity), capacity)};
+    _input = is_server ? client_to_server : server_to_client;
+    _output = is_server ? server_to_client : client_to_server;
+    _output.heartbeat();
+}
+//------------------------------------------------------------------------------
+void shmem_ring_connection::_detach() noexcept {
+    _stop_watching();
+    _output.close();
+    _input = {};
+    _output = {};
+    _segment.close();
+}
+//------------------------------------------------------------------------------
+void shmem_ring_connection::_stop_watching() noexcept {
+    if(_watcher.joinable()) {
+        _watching = false;
+        _input.notify();
+        _watcher.join();
+    }
+}
+//------------------------------------------------------------------------------
+auto shmem_ring_connection::add_wait_handles(work_waiter& waiter) noexcept
+  -> bool {
+    const std::unique_lock lock_input{_mutex_input};
+    if(not _input.is_valid() or not work_waiter::has_native_handles()) {
+        return false;
+    }
+    if(not _watcher.joinable()) {
+        // the ring signal is a futex in the shared memory, which cannot be
+        // polled together with file descriptors, so a thread forwards it
+        _watching = true;
+        _watcher = std::thread{[this, input{_input}]() mutable {
+            // pushes, closing and the space released by the peer all notify
+            std::uint32_t seen{0U};
+            bool notified{true};
+            while(_watching) {
+                if(notified) {
+                    _signal.notify();
+                }
+                notified = input.wait_for_next(seen, std::chrono::seconds{1});
+            }
+        }};
+    }
+    return waiter.add_handle(_signal.wait_handle());
+}
+//------------------------------------------------------------------------------
+auto shmem_ring_connection::wait_for_work(
+  const std::chrono::steady_clock::duration timeout) noexcept -> work_done {
+    bool pending_output{false};
+    std::uint32_t blocked_at{0U};
+    {
+        const std::unique_lock lock_output{_mutex_output};
+        if(not _outgoing.empty()) {
+            // the peer released space in the output ring since it was full
+            if(_output.consumed() != _blocked_at) {
+                return true;
+            }
+            pending_output = true;
+            blocked_at = _blocked_at;
+        }
+    }
+    // the input is not locked here, that would block the receiving;
+    // the peer notifies the input ring also when it releases output space
+    return _input.wait_for_push(timeout, [&] {
+        return pending_output and (_output.consumed() != blocked_at);
+    });
+}
+//------------------------------------------------------------------------------
+auto shmem_ring_connection::send(
+  const message_id msg_id,
+  const message_view& message) noexcept -> bool {
+    const std::unique_lock lock_output{_mutex_output};
+    if(_output.is_closed()) [[unlikely]] {
+        return false;
+    }
+    if(_outgoing.empty()) [[likely]] {
+        // serialize right into the ring, without intermediate copies
+        auto dest{_output.begin_push(_buffer.size())};
+        if(not dest.empty()) [[likely]] {
+            block_data_sink sink(dest);
+            default_serializer_backend backend(sink);
+            if(serialize_message(msg_id, message, backend)) [[likely]] {
+                _output.commit_push(sink.done().size());
+                return true;
+            }
+            log_error("failed to serialize message");
+            return false;
+        }
+    }
+    // the ring is full, keep the message until the consumer catches up
+    _blocked_at = _output.consumed();
+    block_data_sink sink(cover(_buffer));
+    default_serializer_backend backend(sink);
+    if(serialize_message(msg_id, message, backend)) [[likely]] {
+        _outgoing.push(sink.done(), message.priority);
+        return true;
+    }
+    log_error("failed to serialize message");
+    return false;
+}
+//------------------------------------------------------------------------------
+auto shmem_ring_connection::_receive() noexcept -> work_done {
+    _signal.clear();
+    const std::unique_lock lock_input{_mutex_input};
+    _output.heartbeat();
+    if(
+      _input.pop_all(
+        make_callable_ref<&shmem_ring_connection::_handle_receive>(this)) > 0) {
+        // the peer may wait for the released space, it waits on its input
+        _output.notify();
+        return true;
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+auto shmem_ring_connection::_send() noexcept -> bool {
+    const std::unique_lock lock_output{_mutex_output};
+    if(not _outgoing.empty() and not _output.is_closed()) {
+        _output_full = false;
+        return _outgoing.fetch_all(
+          make_callable_ref<&shmem_ring_connection::_handle_send>(this));
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+auto shmem_ring_connection::_handle_send(
+  const message_timestamp,
+  const message_priority,
+  const memory::const_block data) noexcept -> bool {
+    // once the ring is full the rest must wait to keep the order
+    if(not _output_full) [[likely]] {
+        _output_full = not _output.push(data);
+        if(_output_full) [[unlikely]] {
+            _blocked_at = _output.consumed();
+        }
+    }
+    return not _output_full;
+}
+//------------------------------------------------------------------------------
+void shmem_ring_connection::_handle_receive(
+  const memory::const_block data) noexcept {
+    _incoming.push_if(
+      [data](message_id& msg_id, message_timestamp&, stored_message& message) {
+          block_data_source source(data);
+          default_deserializer_backend backend(source);
+          return bool(deserialize_message(msg_id, message, backend));
+      });
+}
+//------------------------------------------------------------------------------
+// connector
+//------------------------------------------------------------------------------
+/// @brief Implementation of connection on top of shared memory ring buffers.
+/// @ingroup msgbus
+/// @see shmem_ring
+/// @see shmem_ring_acceptor
+class shmem_ring_connector final : public shmem_ring_connection {
+    using base = shmem_ring_connection;
+
+public:
+    /// @brief Alias for received message fetch handler callable.
+    using fetch_handler = connection::fetch_handler;
+
+    /// @brief Construction from parent main context object and segment name.
+    shmem_ring_connector(
+      main_ctx_parent parent,
+      std::string name,
+      shared_holder<shmem_ring_shared_state> shared_state) noexcept
+      : base{parent, std::move(shared_state)}
+      , _connect_segment{*this, std::move(name)} {}
+
+    shmem_ring_connector(shmem_ring_connector&&) = delete;
+    shmem_ring_connector(const shmem_ring_connector&) = delete;
+    auto operator=(shmem_ring_connector&&) = delete;
+    auto operator=(const shmem_ring_connector&) = delete;
+
+    ~shmem_ring_connector() noexcept final {
+        _segment.unlink();
+    }
+
+    auto update() noexcept -> work_done final {
+        some_true something_done{};
+        something_done(_checkup());
+        something_done(_receive());
+        something_done(_send());
+        return something_done;
+    }
+
+private:
+    auto _checkup() noexcept -> work_done;
+    auto _reconnect() noexcept -> work_done;
+
+    shmem_segment _connect_segment;
+    bool _linked{false};
+};
+//------------------------------------------------------------------------------
+auto shmem_ring_connector::_checkup() noexcept -> work_done {
+    some_true something_done{};
+    if(_linked) {
+        // once the acceptor attached, the name is not needed anymore
+        const auto header{_segment.header<shmem_ring_segment_header>()};
+        if(header and header->accepted.load()) {
+            _segment.unlink();
+            _linked = false;
+            something_done();
+        }
+    }
+    if(not is_usable()) [[unlikely]] {
+        if(_reconnect_timeout) {
+            something_done(_reconnect());
+            _reconnect_timeout.reset();
+        }
+    }
+    return something_done;
+}
+//------------------------------------------------------------------------------
+auto shmem_ring_connector::_reconnect() noexcept -> work_done {
+    const std::unique_lock lock_input{_mutex_input};
+    const std::unique_lock lock_output{_mutex_output};
+    _detach();
+    _segment.unlink();
+    _linked = false;
+
+    log_debug("connecting to ${name}").arg("name", _connect_segment.get_name());
+
+    // the acceptor may have been restarted, so always map the current segment
+    _connect_segment.close();
+    if(_connect_segment.open().had_error()) {
+        return false;
+    }
+    const auto accept_header{
+      _connect_segment.header<shmem_ring_accept_header>()};
+    if(not accept_header or (accept_header->magic != shmem_ring_accept_magic))
+      [[unlikely]] {
+        log_warning("invalid acceptor segment ${name}")
+          .arg("name", _connect_segment.get_name());
+        _connect_segment.close();
+        return false;
+    }
+
+    const auto capacity{_shared_state->capacity};
+    if(_segment
+         .set_name(shmem_segment::name_from(_shared_state->make_id()))
+         .create(shmem_ring_segment_size(capacity))
+         .had_error()) {
+        _connect_segment.close();
+        return false;
+    }
+    _segment.emplace_header<shmem_ring_segment_header>().capacity =
+      limit_cast<std::uint32_t>(capacity);
+    _linked = true;
+    _attach(false);
+
+    const bool requested{accept_header->request(to_string(_segment.get_name()))};
+    _connect_segment.close();
+    if(not requested) [[unlikely]] {
+        log_warning("failed to connect to ${server}")
+          .arg("server", _connect_segment.get_name());
+        _detach();
+        _segment.unlink();
+        _linked = false;
+        return false;
+    }
+    return true;
+}
+//------------------------------------------------------------------------------
+// acceptor
+//------------------------------------------------------------------------------
+/// @brief Implementation of acceptor on top of shared memory ring buffers.
+/// @ingroup msgbus
+/// @see shmem_ring
+/// @see shmem_ring_connector
+class shmem_ring_acceptor final
+  : public shmem_ring_connection_info<acceptor>
+  , public main_ctx_object {
+
+public:
+    /// @brief Alias for accepted connection handler callable.
+    using accept_handler = acceptor::accept_handler;
+
+    /// @brief Construction from parent main context object and segment name.
+    shmem_ring_acceptor(
+      main_ctx_parent parent,
+      std::string name,
+      shared_holder<shmem_ring_shared_state> shared_state) noexcept
+      : main_ctx_object{"ShmConnAc", parent}
+      , _accept_segment{*this, std::move(name)}
+      , _shared_state{std::move(shared_state)} {}
+
+    shmem_ring_acceptor(shmem_ring_acceptor&&) = delete;
+    shmem_ring_acceptor(const shmem_ring_acceptor&) = delete;
+    auto operator=(shmem_ring_acceptor&&) = delete;
+    auto operator=(const shmem_ring_acceptor&) = delete;
+
+    ~shmem_ring_acceptor() noexcept final {
+        _accept_segment.unlink();
+    }
+
+    auto update() noexcept -> work_done final {
+        some_true something_done{};
+        something_done(_checkup());
+        something_done(_receive());
+        return something_done;
+    }
+
+    auto wait_for_work(const std::chrono::steady_clock::duration timeout) noexcept
+      -> work_done final {
+        if(const auto header{
+             _accept_segment.header<shmem_ring_accept_header>()}) [[likely]] {
+            return header->signal.wait_for(
+              timeout, [&] { return header->has_requests(); });
+        }
+        return acceptor::wait_for_work(timeout);
+    }
+
+    auto process_accepted(const accept_handler handler) noexcept -> work_done final;
+
+private:
+    auto _checkup() noexcept -> work_done;
+    auto _receive() noexcept -> work_done;
+
+    shmem_segment _accept_segment;
+    std::vector<std::string> _requests;
+    timeout _reconnect_timeout{std::chrono::seconds{2}, nothing};
+    shared_holder<shmem_ring_shared_state> _shared_state;
+};
+//------------------------------------------------------------------------------
+auto shmem_ring_acceptor::process_accepted(const accept_handler handler) noexcept
+  -> work_done {
+    some_true something_done{};
+    for(auto& name : _requests) {
+        log_debug("accepting connection from ${name}").arg("name", name);
+
+        if(unique_holder<shmem_ring_connection> conn{
+             default_selector, *this, _shared_state}) {
+            if(conn->open(std::move(name))) {
+                handler(std::move(conn));
+                something_done();
+            }
+        }
+    }
+    _requests.clear();
+    return something_done;
+}
+//------------------------------------------------------------------------------
+auto shmem_ring_acceptor::_checkup() noexcept -> work_done {
+    some_true something_done{};
+    if(not _accept_segment.is_open()) [[unlikely]] {
+        if(_reconnect_timeout) {
+            if(not _accept_segment.unlink()
+                     .create(span_size(sizeof(shmem_ring_accept_header)))
+                     .had_error()) {
+                _accept_segment.emplace_header<shmem_ring_accept_header>();
+                something_done();
+            }
+            _reconnect_timeout.reset();
+        }
+    }
+    return something_done;
+}
+//------------------------------------------------------------------------------
+auto shmem_ring_acceptor::_receive() noexcept -> work_done {
+    if(const auto header{_accept_segment.header<shmem_ring_accept_header>()})
+      [[likely]] {
+        return header->accept(
+          [this](std::string name) { _requests.emplace_back(std::move(name)); });
+    }
+    return false;
+}
+//------------------------------------------------------------------------------
+// factory
+//------------------------------------------------------------------------------
+/// @brief Implementation of connection_factory for shared memory ring connections.
+/// @ingroup msgbus
+/// @see shmem_ring_connector
+/// @see shmem_ring_acceptor
+class shmem_ring_connection_factory
+  : public shmem_ring_connection_info<connection_factory>
+  , public main_ctx_object {
+public:
+    /// @brief Construction from parent main context object.
+    shmem_ring_connection_factory(main_ctx_parent parent) noexcept
+      : main_ctx_object{"ShmConnFc", parent} {
+        _configure();
+    }
+
+    using connection_factory::make_acceptor;
+    using connection_factory::make_connector;
+
+    /// @brief Makes an connection acceptor listening at segment with the specified name.
+    auto make_acceptor(const string_view address) noexcept
+      -> shared_holder<acceptor> final {
+        return {
+          hold<shmem_ring_acceptor>, *this, to_string(address), _shared_state};
+    }
+
+    /// @brief Makes a connector connecting to segment with the specified name.
+    auto make_connector(const string_view address) noexcept
+      -> shared_holder<connection> final {
+        return {
+          hold<shmem_ring_connector>, *this, to_string(address), _shared_state};
+    }
+
+private:
+    shared_holder<shmem_ring_shared_state> _shared_state{default_selector};
+
+    void _configure() noexcept {
+        // the capacity must be a power of two and fit several messages
+        const auto capacity{std::bit_ceil(std::clamp(
+          app_config()
+            .get<std::uint32_t>("msgbus.shmem_ring.capacity")
+            .value_or(1024U * 1024U),
+          64U * 1024U,
+          256U * 1024U * 1024U))};
+        _shared_state->capacity = span_size(capacity);
+        _shared_state->max_data_size =
+          std::min(span_size(16 * 1024), span_size(capacity / 8U));
+        log_debug("shared memory ring capacity: ${capacity}")
+          .arg("capacity", _shared_state->capacity)
+          .arg("maxDataSiz", _shared_state->max_data_size);
+    }
+};
+#endif // EAGINE_POSIX
+//------------------------------------------------------------------------------
+auto make_shmem_ring_connection_factory([[maybe_unused]] main_ctx_parent parent)
+  -> unique_holder<connection_factory> {
+#if EAGINE_POSIX
+    return {hold<shmem_ring_connection_factory>, parent};
+#else
+    return {};
+#endif
+}
+//------------------------------------------------------------------------------
+} // namespace eagine::msgbus
@@ -0,0 +1,307 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+
+#if __has_include(<sys/wait.h>) && __has_include(<unistd.h>)
+#include <sys/wait.h>
+#include <unistd.h>
+#define EAGINE_SHMEM_RING_TEST_FORK 1
+#else
+#define EAGINE_SHMEM_RING_TEST_FORK 0
+#endif
+
+#include <eagine/testing/unit_begin_ctx.hpp>
+import std;
+import eagine.core;
+import eagine.msgbus.core;
+//------------------------------------------------------------------------------
+// type_id
+//------------------------------------------------------------------------------
+void shmem_ring_type_id(auto& s) {
+    if(auto fact{
+         eagine::msgbus::make_shmem_ring_connection_factory(s.context())}) {
+        eagitest::case_ test{s, 1, "type id"};
+        test.ensure(bool(fact), "has factory");
+        auto cacc{fact->make_acceptor(eagine::identifier{"test"})};
+        test.ensure(bool(cacc), "has acceptor");
+        auto conn{fact->make_connector(eagine::identifier{"test"})};
+        test.ensure(bool(conn), "has connection");
+
+        test.check(not cacc->type_id().is_empty(), "has name");
+        test.check(not conn->type_id().is_empty(), "has name");
+    }
+}
+//------------------------------------------------------------------------------
+// address kind
+//------------------------------------------------------------------------------
+void shmem_ring_addr_kind(auto& s) {
+    if(auto fact{
+         eagine::msgbus::make_shmem_ring_connection_factory(s.context())}) {
+        eagitest::case_ test{s, 2, "addr kind"};
+        test.ensure(bool(fact), "has factory");
+        auto cacc{fact->make_acceptor(eagine::identifier{"localhost"})};
+        test.ensure(bool(cacc), "has acceptor");
+        auto conn{fact->make_connector(eagine::identifier{"localhost"})};
+        test.ensure(bool(conn), "has connection");
+
+        test.check(
+          cacc->addr_kind() == eagine::msgbus::connection_addr_kind::filepath,
+          "no address");
+        test.check(
+          conn->addr_kind() == eagine::msgbus::connection_addr_kind::filepath,
+          "no address");
+    }
+}
+//------------------------------------------------------------------------------
+// roundtrip
+//------------------------------------------------------------------------------
+void shmem_ring_roundtrip(auto& s) {
+
+    if(auto fact{
+         eagine::msgbus::make_shmem_ring_connection_factory(s.context())}) {
+        eagitest::case_ test{s, 3, "roundtrip"};
+        eagitest::track trck{test, 0, 1};
+
+        auto& rg{test.random()};
+
+        test.ensure(bool(fact), "has factory");
+        auto cacc{fact->make_acceptor(eagine::identifier{"roundtrip"})};
+        test.ensure(bool(cacc), "has acceptor");
+        auto read_conn{fact->make_connector(eagine::identifier{"roundtrip"})};
+        test.ensure(bool(read_conn), "has read connection");
+
+        eagine::shared_holder<eagine::msgbus::connection> write_conn;
+        test.check(not bool(write_conn), "has not write connection");
+
+        const eagine::timeout accept_time{std::chrono::seconds{5}};
+        while(not write_conn) {
+            read_conn->update();
+            cacc->update();
+            cacc->process_accepted(
+              {eagine::construct_from,
+               [&](eagine::shared_holder<eagine::msgbus::connection> conn) {
+                   write_conn = std::move(conn);
+               }});
+            if(accept_time.is_expired()) {
+                break;
+            }
+        }
+        test.ensure(bool(write_conn), "has write connection");
+
+        const eagine::message_id test_msg_id{"test", "method"};
+
+        std::map<eagine::msgbus::message_sequence_t, std::size_t> hashes;
+        std::vector<eagine::byte> src;
+
+        eagine::msgbus::message_sequence_t seq{0};
+
+        const auto read_func = [&](
+                                 const eagine::message_id msg_id,
+                                 const eagine::msgbus::message_age,
+                                 const eagine::msgbus::message_view& msg) -> bool {
+            test.check(msg_id == test_msg_id, "message id");
+            std::size_t h{0};
+            for(const auto b : msg.content()) {
+                h ^= std::hash<eagine::byte>{}(b);
+            }
+            test.check_equal(h, hashes[msg.sequence_no], "same hash");
+            hashes.erase(msg.sequence_no);
+            trck.checkpoint(1);
+            return true;
+        };
+
+        for(unsigned r = 0; r < test.repeats(100); ++r) {
+            for(unsigned i = 0, n = rg.get_between<unsigned>(0, 20); i < n; ++i) {
+                cacc->update();
+                read_conn->update();
+                write_conn->update();
+                src.resize(rg.get_std_size(0, 1024));
+                rg.fill(src);
+
+                eagine::msgbus::message_view message{eagine::view(src)};
+                message.set_sequence_no(seq);
+                write_conn->send(test_msg_id, message);
+                std::size_t h{0};
+                for(const auto b : src) {
+                    h ^= std::hash<eagine::byte>{}(b);
+                }
+                hashes[seq] = h;
+                ++seq;
+            }
+            read_conn->update();
+            write_conn->update();
+            if(rg.get_bool()) {
+                read_conn->fetch_messages({eagine::construct_from, read_func});
+            }
+        }
+        read_conn->update();
+        write_conn->update();
+        read_conn->fetch_messages({eagine::construct_from, read_func});
+    }
+}
+//------------------------------------------------------------------------------
+// accepts a connection from the specified connector
+auto shmem_ring_accept(
+  eagine::msgbus::acceptor& cacc,
+  const eagine::shared_holder<eagine::msgbus::connection>& read_conn)
+  -> eagine::shared_holder<eagine::msgbus::connection> {
+    eagine::shared_holder<eagine::msgbus::connection> write_conn;
+    const eagine::timeout accept_time{std::chrono::seconds{5}};
+    while(not write_conn and not accept_time.is_expired()) {
+        if(read_conn) {
+            read_conn->update();
+        }
+        cacc.update();
+        cacc.process_accepted(
+          {eagine::construct_from,
+           [&](eagine::shared_holder<eagine::msgbus::connection> conn) {
+               write_conn = std::move(conn);
+           }});
+    }
+    return write_conn;
+}
+//------------------------------------------------------------------------------
+// wait handles
+//------------------------------------------------------------------------------
+void shmem_ring_wait_handles(auto& s) {
+    if(auto fact{
+         eagine::msgbus::make_shmem_ring_connection_factory(s.context())}) {
+        eagitest::case_ test{s, 4, "wait handles"};
+        auto cacc{fact->make_acceptor(eagine::identifier{"waithndls"})};
+        test.ensure(bool(cacc), "has acceptor");
+        auto read_conn{fact->make_connector(eagine::identifier{"waithndls"})};
+        test.ensure(bool(read_conn), "has read connection");
+        auto write_conn{shmem_ring_accept(*cacc, read_conn)};
+        test.ensure(bool(write_conn), "has write connection");
+
+        eagine::msgbus::work_waiter waiter;
+        if(not eagine::msgbus::work_waiter::has_native_handles()) {
+            return;
+        }
+        test.check(
+          read_conn->add_wait_handles(waiter), "provides wait handles");
+        waiter.wait(std::chrono::milliseconds{100});
+        read_conn->update();
+        test.check(
+          not waiter.wait(std::chrono::milliseconds{5}), "nothing to wait for");
+
+        const eagine::message_id test_msg_id{"test", "method"};
+        std::thread writer{[&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+            write_conn->send(test_msg_id, eagine::msgbus::message_view{});
+        }};
+        test.check(waiter.wait(std::chrono::seconds{5}), "woken up by send");
+        writer.join();
+
+        // fill the ring, the rest is kept until the reader releases space
+        std::vector<eagine::byte> src(4096U);
+        const unsigned count{600U};
+        for(unsigned i = 0; i < count; ++i) {
+            test.check(
+              write_conn->send(test_msg_id, eagine::msgbus::message_view{
+                                               eagine::view(src)}),
+              "sent");
+        }
+        write_conn->update();
+        test.check(
+          not write_conn->wait_for_work(std::chrono::milliseconds{5}),
+          "output blocked");
+
+        unsigned received{0U};
+        const auto read_func{[&](
+                               const eagine::message_id msg_id,
+                               const eagine::msgbus::message_age,
+                               const eagine::msgbus::message_view&) -> bool {
+            if(msg_id == test_msg_id) {
+                ++received;
+            }
+            return true;
+        }};
+        read_conn->update();
+        test.check(
+          write_conn->wait_for_work(std::chrono::seconds{5}), "space released");
+
+        const eagine::timeout receive_time{std::chrono::seconds{10}};
+        while(received < count + 1U and not receive_time.is_expired()) {
+            write_conn->update();
+            read_conn->update();
+            read_conn->fetch_messages({eagine::construct_from, read_func});
+        }
+        test.check_equal(received, count + 1U, "all received");
+    }
+}
+//------------------------------------------------------------------------------
+// crashed peer
+//------------------------------------------------------------------------------
+void shmem_ring_crashed_peer(auto& s) {
+#if EAGINE_SHMEM_RING_TEST_FORK
+    if(auto fact{
+         eagine::msgbus::make_shmem_ring_connection_factory(s.context())}) {
+        eagitest::case_ test{s, 5, "crashed peer"};
+        auto cacc{fact->make_acceptor(eagine::identifier{"crashpeer"})};
+        test.ensure(bool(cacc), "has acceptor");
+        cacc->update();
+
+        const eagine::message_id test_msg_id{"test", "method"};
+        const ::pid_t child{::fork()};
+        test.ensure(child >= 0, "forked");
+        if(child == 0) {
+            // connects and ends without closing the connection
+            auto conn{fact->make_connector(eagine::identifier{"crashpeer"})};
+            bool received{false};
+            const eagine::timeout receive_time{std::chrono::seconds{10}};
+            while(not received and not receive_time.is_expired()) {
+                conn->update();
+                conn->fetch_messages(
+                  {eagine::construct_from,
+                   [&](
+                     const eagine::message_id,
+                     const eagine::msgbus::message_age,
+                     const eagine::msgbus::message_view&) -> bool {
+                       received = true;
+                       return true;
+                   }});
+            }
+            std::_Exit(0);
+        }
+
+        auto write_conn{shmem_ring_accept(*cacc, {})};
+        test.ensure(bool(write_conn), "has write connection");
+        test.check(write_conn->is_usable(), "usable");
+        write_conn->send(test_msg_id, eagine::msgbus::message_view{});
+        write_conn->update();
+
+        int status{0};
+        test.check_equal(::waitpid(child, &status, 0), child, "child ended");
+
+        const eagine::timeout detect_time{std::chrono::seconds{10}};
+        while(write_conn->is_usable() and not detect_time.is_expired()) {
+            write_conn->update();
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+        test.check(not write_conn->is_usable(), "not usable");
+    }
+#endif
+}
+//------------------------------------------------------------------------------
+// main
+//------------------------------------------------------------------------------
+auto test_main(eagine::test_ctx& ctx) -> int {
+    eagitest::ctx_suite test{ctx, "shared memory connection", 5};
+    test.once(shmem_ring_type_id);
+    test.once(shmem_ring_addr_kind);
+    test.once(shmem_ring_roundtrip);
+    test.once(shmem_ring_wait_handles);
+    test.once(shmem_ring_crashed_peer);
+    return test.exit_code();
+}
+//------------------------------------------------------------------------------
+auto main(int argc, const char** argv) -> int {
+    return eagine::test_main_impl(argc, argv, test_main);
+}
+//------------------------------------------------------------------------------
+#include <eagine/testing/unit_end_ctx.hpp>
@@ -277,7 +277,8 @@ protected:
         for(const auto& entry : msg_handlers) {
             assert(entry.queue);
             const message_context msg_ctx{this->bus_node(), entry.msg_id};
-            if(entry.queue->process_all(msg_ctx, entry.handler)) {
+            if(this->bus_node().process_queue(
+                 *entry.queue, msg_ctx, entry.handler)) {
                 return true;
             }
         }
@@ -290,7 +291,8 @@ protected:
         for(const auto& entry : msg_handlers) {
             assert(entry.queue);
             const message_context msg_ctx{this->bus_node(), entry.msg_id};
-            done += entry.queue->process_all(msg_ctx, entry.handler);
+            done += this->bus_node().process_queue(
+              *entry.queue, msg_ctx, entry.handler);
         }
         return done > 0;
     }
@@ -0,0 +1,280 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+export module eagine.msgbus.core:timer_wheel;
+
+import std;
+
+namespace eagine::msgbus {
+//------------------------------------------------------------------------------
+/// @brief Hierarchical timing wheel tracking deadlines of keyed entries.
+/// @ingroup msgbus
+///
+/// Scheduling, cancellation and lookup by key are constant-time operations.
+/// The expiration skips empty slots and cascades the entries from the coarser
+/// levels to the finer ones, so the pending entries are not scanned
+/// on each update.
+export template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class timer_wheel {
+public:
+    using clock_type = std::chrono::steady_clock;
+    using time_point = clock_type::time_point;
+    using duration = clock_type::duration;
+
+    /// @brief Construction with the specified tick duration and time origin.
+    timer_wheel(
+      const duration tick = std::chrono::milliseconds{1},
+      const time_point origin = clock_type::now()) noexcept
+      : _tick{std::max(tick, duration{1})}
+      , _origin{origin} {}
+
+    /// @brief Returns the duration of a single tick of the wheel.
+    auto tick() const noexcept -> duration {
+        return _tick;
+    }
+
+    /// @brief Indicates if there are no scheduled entries.
+    auto empty() const noexcept -> bool {
+        return _entries.empty();
+    }
+
+    /// @brief Returns the number of scheduled entries.
+    auto size() const noexcept -> std::size_t {
+        return _entries.size();
+    }
+
+    /// @brief Indicates if an entry with the specified key is scheduled.
+    auto contains(const Key& key) const noexcept -> bool {
+        return _entries.contains(key);
+    }
+
+    /// @brief Returns a pointer to the value of the specified entry or nullptr.
+    auto find(const Key& key) noexcept -> Value* {
+        if(const auto pos{_entries.find(key)}; pos != _entries.end()) {
+            return &pos->second.value;
+        }
+        return nullptr;
+    }
+
+    /// @brief Schedules (or re-schedules) an entry to expire at the time point.
+    /// @note Expiration always happens at the earliest in the next tick.
+    void schedule_at(const Key& key, Value value, const time_point when) {
+        _remove(key);
+        _place(
+          key, std::move(value), std::max(_ticks_ceil(when), _current + 1U));
+    }
+
+    /// @brief Schedules (or re-schedules) an entry to expire after a delay.
+    template <typename R, typename P>
+    void schedule(
+      const Key& key,
+      Value value,
+      const std::chrono::duration<R, P> delay) {
+        schedule_at(
+          key,
+          std::move(value),
+          clock_type::now() +
+            std::chrono::ceil<duration>(
+              std::max(delay, std::chrono::duration<R, P>::zero())));
+    }
+
+    /// @brief Removes the entry with the specified key, returns its value.
+    auto extract(const Key& key) noexcept -> std::optional<Value> {
+        if(const auto pos{_entries.find(key)}; pos != _entries.end()) {
+            std::optional<Value> result{std::move(pos->second.value)};
+            _unlink(pos->second);
+            _entries.erase(pos);
+            return result;
+        }
+        return {};
+    }
+
+    /// @brief Removes the entry with the specified key.
+    auto cancel(const Key& key) noexcept -> bool {
+        return _remove(key);
+    }
+
+    /// @brief Removes all scheduled entries.
+    void clear() noexcept {
+        for(auto& level : _slots) {
+            for(auto& slot : level) {
+                slot.clear();
+            }
+        }
+        _masks.fill(0U);
+        _entries.clear();
+    }
+
+    /// @brief Advances the wheel to now, calls func on the expired entries.
+    /// @note The expired entries are removed before func is called on them,
+    /// so they can be re-scheduled from inside of the function.
+    template <typename Function>
+    auto expire(const time_point now, Function func) -> std::size_t {
+        const auto target{_ticks_floor(now)};
+        std::size_t count{0U};
+        while(_current < target) {
+            if(_entries.empty()) {
+                _current = target;
+                break;
+            }
+            auto next{_current + 1U};
+            if(const auto index{next & _slot_mask}; index != 0U) {
+                if(const auto pending{_masks[0] >> index}; pending != 0U) {
+                    next += std::uint64_t(std::countr_zero(pending));
+                } else {
+                    next = (next | _slot_mask) + 1U;
+                }
+                if(next > target) {
+                    _current = target;
+                    break;
+                }
+            }
+            _current = next;
+            if((next & _slot_mask) == 0U) {
+                _cascade(next);
+            }
+            count += _expire_slot(next & _slot_mask, func);
+        }
+        return count;
+    }
+
+    /// @brief Advances the wheel to the current time point.
+    template <typename Function>
+    auto expire(Function func) -> std::size_t {
+        return expire(clock_type::now(), std::move(func));
+    }
+
+private:
+    static constexpr const std::size_t _slot_bits{6U};
+    static constexpr const std::size_t _slot_count{1U << _slot_bits};
+    static constexpr const std::uint64_t _slot_mask{_slot_count - 1U};
+    static constexpr const std::size_t _level_count{4U};
+
+    struct _entry {
+        std::uint64_t deadline;
+        std::uint32_t level;
+        std::uint32_t slot;
+        std::size_t index;
+        Value value;
+    };
+
+    auto _ticks_floor(const time_point tp) const noexcept -> std::uint64_t {
+        return tp > _origin ? std::uint64_t((tp - _origin) / _tick) : 0U;
+    }
+
+    auto _ticks_ceil(const time_point tp) const noexcept -> std::uint64_t {
+        if(tp > _origin) {
+            const auto since{tp - _origin};
+            return std::uint64_t((since + _tick - duration{1}) / _tick);
+        }
+        return 0U;
+    }
+
+    void _place(const Key& key, Value value, const std::uint64_t deadline) {
+        auto& entry{_entries
+                      .insert_or_assign(
+                        key, _entry{deadline, 0U, 0U, 0U, std::move(value)})
+                      .first->second};
+        _link(key, entry);
+    }
+
+    void _link(const Key& key, _entry& entry) {
+        const auto delta{
+          entry.deadline > _current ? entry.deadline - _current : 0U};
+        std::size_t level{0U};
+        while(
+          (level + 1U < _level_count) and
+          (delta >> (_slot_bits * (level + 1U))) != 0U) {
+            ++level;
+        }
+        const auto slot{
+          std::size_t((entry.deadline >> (_slot_bits * level)) & _slot_mask)};
+        auto& keys{_slots[level][slot]};
+        entry.level = std::uint32_t(level);
+        entry.slot = std::uint32_t(slot);
+        entry.index = keys.size();
+        keys.push_back(key);
+        _masks[level] |= (std::uint64_t(1U) << slot);
+    }
+
+    void _unlink(const _entry& entry) noexcept {
+        auto& keys{_slots[entry.level][entry.slot]};
+        if(entry.index + 1U < keys.size()) {
+            keys[entry.index] = std::move(keys.back());
+            _entries.find(keys[entry.index])->second.index = entry.index;
+        }
+        keys.pop_back();
+        if(keys.empty()) {
+            _masks[entry.level] &= ~(std::uint64_t(1U) << entry.slot);
+        }
+    }
+
+    auto _remove(const Key& key) noexcept -> bool {
+        if(const auto pos{_entries.find(key)}; pos != _entries.end()) {
+            _unlink(pos->second);
+            _entries.erase(pos);
+            return true;
+        }
+        return false;
+    }
+
+    void _cascade(const std::uint64_t tick) {
+        for(std::size_t level = _level_count - 1U; level > 0U; --level) {
+            const auto shift{_slot_bits * level};
+            if((tick & ((std::uint64_t(1U) << shift) - 1U)) != 0U) {
+                continue;
+            }
+            const auto slot{std::size_t((tick >> shift) & _slot_mask)};
+            if((_masks[level] & (std::uint64_t(1U) << slot)) == 0U) {
+                continue;
+            }
+            _masks[level] &= ~(std::uint64_t(1U) << slot);
+            _cascaded.swap(_slots[level][slot]);
+            for(const auto& key : _cascaded) {
+                _link(key, _entries.find(key)->second);
+            }
+            _cascaded.clear();
+        }
+    }
+
+    template <typename Function>
+    auto _expire_slot(const std::size_t slot, Function& func) -> std::size_t {
+        auto& keys{_slots[0][slot]};
+        if(keys.empty()) {
+            return 0U;
+        }
+        _masks[0] &= ~(std::uint64_t(1U) << slot);
+        std::vector<std::pair<Key, Value>> expired;
+        expired.swap(_expired);
+        expired.reserve(keys.size());
+        for(auto& key : keys) {
+            const auto pos{_entries.find(key)};
+            expired.emplace_back(std::move(key), std::move(pos->second.value));
+            _entries.erase(pos);
+        }
+        keys.clear();
+        for(auto& [key, value] : expired) {
+            func(key, value);
+        }
+        const auto count{expired.size()};
+        expired.clear();
+        _expired.swap(expired);
+        return count;
+    }
+
+    duration _tick;
+    time_point _origin;
+    std::uint64_t _current{0U};
+    std::array<std::uint64_t, _level_count> _masks{};
+    std::array<std::array<std::vector<Key>, _slot_count>, _level_count>
+      _slots{};
+    std::unordered_map<Key, _entry, Hash> _entries{};
+    std::vector<Key> _cascaded{};
+    std::vector<std::pair<Key, Value>> _expired{};
+};
+//------------------------------------------------------------------------------
+} // namespace eagine::msgbus
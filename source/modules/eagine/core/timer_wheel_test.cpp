@@ -0,0 +1,132 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+
+#include <eagine/testing/unit_begin_ctx.hpp>
+import std;
+import eagine.core;
+import eagine.msgbus.core;
+//------------------------------------------------------------------------------
+// expire
+//------------------------------------------------------------------------------
+void timer_wheel_expire(auto& s) {
+    using namespace std::chrono;
+    eagitest::case_ test{s, 1, "expire"};
+    const auto origin{steady_clock::now()};
+    eagine::msgbus::timer_wheel<int, int> wheel{milliseconds{1}, origin};
+
+    wheel.schedule_at(1, 10, origin + milliseconds{5});
+    wheel.schedule_at(2, 20, origin + milliseconds{70});
+    wheel.schedule_at(3, 30, origin + seconds{10});
+    wheel.schedule_at(4, 40, origin + hours{8});
+    test.check_equal(wheel.size(), std::size_t(4), "size 4");
+    test.check(wheel.contains(2), "contains 2");
+    test.ensure(wheel.find(3) != nullptr, "found 3");
+    test.check_equal(*wheel.find(3), 30, "value 3");
+
+    std::vector<int> expired;
+    const auto collect{[&](const int key, int& value) {
+        test.check_equal(key * 10, value, "value ok");
+        expired.push_back(key);
+    }};
+
+    test.check_equal(
+      wheel.expire(origin + milliseconds{4}, collect),
+      std::size_t(0),
+      "none expired");
+    test.check_equal(
+      wheel.expire(origin + milliseconds{5}, collect),
+      std::size_t(1),
+      "1 expired");
+    test.check(wheel.cancel(2), "cancel 2");
+    test.check(not wheel.cancel(2), "cancel 2 again");
+    test.check_equal(
+      wheel.expire(origin + seconds{9}, collect),
+      std::size_t(0),
+      "none expired");
+    test.check_equal(
+      wheel.expire(origin + seconds{11}, collect),
+      std::size_t(1),
+      "3 expired");
+    test.check_equal(
+      wheel.expire(origin + hours{7}, collect),
+      std::size_t(0),
+      "none expired");
+    test.check_equal(
+      wheel.expire(origin + hours{9}, collect),
+      std::size_t(1),
+      "4 expired");
+    test.check(wheel.empty(), "is empty");
+    test.ensure(expired.size() == 3U, "expired count");
+    test.check_equal(expired[0], 1, "1 first");
+    test.check_equal(expired[1], 3, "3 second");
+    test.check_equal(expired[2], 4, "4 third");
+}
+//------------------------------------------------------------------------------
+// random
+//------------------------------------------------------------------------------
+void timer_wheel_random(auto& s) {
+    using namespace std::chrono;
+    eagitest::case_ test{s, 2, "random"};
+    auto& rg{test.random()};
+    const auto origin{steady_clock::now()};
+    eagine::msgbus::timer_wheel<unsigned, long> wheel{milliseconds{1}, origin};
+    std::map<unsigned, long> expected;
+    long now{0};
+
+    for(unsigned r = 0; r < test.repeats(20000); ++r) {
+        const auto key{rg.get_between<unsigned>(0U, 999U)};
+        switch(rg.get_between<unsigned>(0U, 5U)) {
+            case 0U:
+            case 1U: {
+                const auto delay{
+                  rg.get_between<unsigned>(0U, 3U) == 0U
+                    ? rg.get_between<long>(1, 20000000)
+                    : rg.get_between<long>(1, 300)};
+                wheel.schedule_at(
+                  key, now + delay, origin + milliseconds{now + delay});
+                expected[key] = now + delay;
+                break;
+            }
+            case 2U:
+                test.check_equal(
+                  wheel.cancel(key), expected.erase(key) > 0U, "cancel ok");
+                break;
+            default:
+                now += rg.get_between<unsigned>(0U, 50U) == 0U
+                         ? rg.get_between<long>(0, 5000000)
+                         : rg.get_between<long>(0, 20);
+                wheel.expire(
+                  origin + milliseconds{now}, [&](const unsigned k, long& v) {
+                      test.check(v <= now, "not too early");
+                      const auto pos{expected.find(k)};
+                      test.ensure(pos != expected.end(), "is expected");
+                      test.check_equal(pos->second, v, "deadline ok");
+                      expected.erase(pos);
+                  });
+                for(const auto& entry : expected) {
+                    test.check(entry.second > now, "not too late");
+                }
+                test.check_equal(wheel.size(), expected.size(), "size ok");
+        }
+    }
+}
+//------------------------------------------------------------------------------
+// main
+//------------------------------------------------------------------------------
+auto test_main(eagine::test_ctx& ctx) -> int {
+    eagitest::ctx_suite test{ctx, "timer wheel", 2};
+    test.once(timer_wheel_expire);
+    test.once(timer_wheel_random);
+    return test.exit_code();
+}
+//------------------------------------------------------------------------------
+auto main(int argc, const char** argv) -> int {
+    return eagine::test_main_impl(argc, argv, test_main);
+}
+//------------------------------------------------------------------------------
+#include <eagine/testing/unit_end_ctx.hpp>
@@ -0,0 +1,107 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+export module eagine.msgbus.core:trace;
+
+import std;
+import eagine.core.types;
+import eagine.core.memory;
+import eagine.core.identifier;
+import eagine.core.main_ctx;
+import :types;
+import :message;
+
+namespace eagine::msgbus {
+//------------------------------------------------------------------------------
+/// @brief Records high-resolution timestamps of sampled messages in a bus node.
+/// @ingroup msgbus
+/// @see message_trace_record
+///
+/// The sampling depends only on the message source, type and sequence number,
+/// so all routers, bridges and endpoints on the path of a message make
+/// the same decision and the records of a message can be matched by
+/// the consumer, without any information added to the message itself.
+export class message_tracer {
+public:
+    /// @brief Default constructor. Constructs a disabled tracer.
+    message_tracer() noexcept = default;
+
+    /// @brief Construction with the sampling period and maximum record count.
+    /// @note Every sample_period-th message is traced, zero disables tracing.
+    message_tracer(
+      const node_kind kind,
+      const span_size_t sample_period,
+      const span_size_t capacity) noexcept;
+
+    /// @brief Construction with settings from the parent's configuration.
+    message_tracer(const node_kind kind, main_ctx_object& parent) noexcept;
+
+    /// @brief Indicates if any messages are traced.
+    auto is_enabled() const noexcept -> bool {
+        return bool(_state);
+    }
+
+    /// @brief Indicates if the specified message is sampled for tracing.
+    auto is_sampled(const message_id msg_id, const message_info& info)
+      const noexcept -> bool;
+
+    /// @brief Records the time when a sampled message reached the trace point.
+    void stamp(
+      const message_trace_point point,
+      const message_id msg_id,
+      const message_info& info) noexcept {
+        if(_state) [[unlikely]] {
+            const auto hash{_hash_of(msg_id, info)};
+            if(_is_sampled(msg_id, hash)) {
+                _do_stamp(point, msg_id, info, hash);
+            }
+        }
+    }
+
+    /// @brief Removes and returns the records older than the specified age.
+    auto fetch_records(
+      const endpoint_id_t node_id,
+      const std::chrono::steady_clock::duration min_age =
+        std::chrono::seconds{1}) noexcept -> std::vector<message_trace_record>;
+
+private:
+    static auto _hash_of(const message_id, const message_info&) noexcept
+      -> std::uint64_t;
+
+    auto _is_sampled(const message_id, const std::uint64_t hash) const noexcept
+      -> bool;
+
+    void _do_stamp(
+      const message_trace_point,
+      const message_id,
+      const message_info&,
+      const std::uint64_t hash) noexcept;
+
+    struct _pending_record {
+        message_trace_record record;
+        std::chrono::steady_clock::time_point origin;
+        std::uint64_t hash{0U};
+    };
+
+    struct _tracer_state {
+        std::mutex lock;
+        std::deque<_pending_record> records;
+        // sampling hash to the serial number of the latest matching record
+        std::unordered_map<std::uint64_t, std::uint64_t> index;
+        std::uint64_t front_serial{0U};
+        std::uint64_t sample_period{1U};
+        std::size_t capacity{1U};
+        node_kind kind{node_kind::unknown};
+
+        auto find(const std::uint64_t hash) noexcept -> _pending_record*;
+        void pop_front() noexcept;
+    };
+
+    unique_holder<_tracer_state> _state{};
+};
+//------------------------------------------------------------------------------
+} // namespace eagine::msgbus
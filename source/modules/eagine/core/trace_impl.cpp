@@ -0,0 +1,190 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+module eagine.msgbus.core;
+
+import std;
+import eagine.core.types;
+import eagine.core.identifier;
+import eagine.core.main_ctx;
+import :types;
+import :message;
+
+namespace eagine::msgbus {
+//------------------------------------------------------------------------------
+static auto trace_mix_bits(std::uint64_t h) noexcept -> std::uint64_t {
+    h ^= h >> 30U;
+    h *= 0xBF58476D1CE4E5B9U;
+    h ^= h >> 27U;
+    h *= 0x94D049BB133111EBU;
+    h ^= h >> 31U;
+    return h;
+}
+//------------------------------------------------------------------------------
+static auto trace_point_offset(
+  message_trace_record& record,
+  const message_trace_point point) noexcept -> std::int64_t& {
+    switch(point) {
+        case message_trace_point::enqueue:
+            return record.enqueue_ns;
+        case message_trace_point::submit:
+            return record.submit_ns;
+        case message_trace_point::accept:
+            return record.accept_ns;
+        case message_trace_point::receive:
+            return record.receive_ns;
+        case message_trace_point::dispatch:
+            break;
+    }
+    return record.dispatch_ns;
+}
+//------------------------------------------------------------------------------
+// message_tracer
+//------------------------------------------------------------------------------
+message_tracer::message_tracer(
+  const node_kind kind,
+  const span_size_t sample_period,
+  const span_size_t capacity) noexcept {
+    if(sample_period > 0) {
+        _state = unique_holder<_tracer_state>{default_selector};
+        _state->sample_period = std::uint64_t(sample_period);
+        _state->capacity = std::size_t(std::max(capacity, span_size(1)));
+        _state->kind = kind;
+    }
+}
+//------------------------------------------------------------------------------
+message_tracer::message_tracer(
+  const node_kind kind,
+  main_ctx_object& parent) noexcept
+  : message_tracer{
+      kind,
+      parent.app_config()
+        .get<span_size_t>("msgbus.trace.sample_period")
+        .value_or(0),
+      parent.app_config()
+        .get<span_size_t>("msgbus.trace.capacity")
+        .value_or(1024)} {
+    if(_state) {
+        parent.log_info("tracing every ${period}-th message")
+          .tag("msgTracing")
+          .arg("period", _state->sample_period)
+          .arg("capacity", _state->capacity);
+    }
+}
+//------------------------------------------------------------------------------
+auto message_tracer::_tracer_state::find(const std::uint64_t hash) noexcept
+  -> _pending_record* {
+    if(const auto pos{index.find(hash)}; pos != index.end()) {
+        return &records[std::size_t(pos->second - front_serial)];
+    }
+    return nullptr;
+}
+//------------------------------------------------------------------------------
+void message_tracer::_tracer_state::pop_front() noexcept {
+    const auto pos{index.find(records.front().hash)};
+    // the index may point to a newer record with the same hash
+    if((pos != index.end()) and (pos->second == front_serial)) {
+        index.erase(pos);
+    }
+    records.pop_front();
+    ++front_serial;
+}
+//------------------------------------------------------------------------------
+auto message_tracer::_hash_of(
+  const message_id msg_id,
+  const message_info& info) noexcept -> std::uint64_t {
+    return trace_mix_bits(
+      std::uint64_t(info.source_id.value()) ^
+      trace_mix_bits(
+        std::uint64_t(msg_id.class_().value()) ^
+        trace_mix_bits(
+          std::uint64_t(msg_id.method_id()) ^ std::uint64_t(info.sequence_no))));
+}
+//------------------------------------------------------------------------------
+auto message_tracer::_is_sampled(
+  const message_id msg_id,
+  const std::uint64_t hash) const noexcept -> bool {
+    // the bus control messages (including the trace reports) are not traced
+    if(not _state or is_special_message(msg_id)) {
+        return false;
+    }
+    return (hash % _state->sample_period) == 0U;
+}
+//------------------------------------------------------------------------------
+auto message_tracer::is_sampled(
+  const message_id msg_id,
+  const message_info& info) const noexcept -> bool {
+    return _is_sampled(msg_id, _hash_of(msg_id, info));
+}
+//------------------------------------------------------------------------------
+void message_tracer::_do_stamp(
+  const message_trace_point point,
+  const message_id msg_id,
+  const message_info& info,
+  const std::uint64_t hash) noexcept {
+    const auto now{std::chrono::steady_clock::now()};
+    const std::unique_lock lk{_state->lock};
+
+    const auto matches{[&](const message_trace_record& record) {
+        return (record.sequence_no == info.sequence_no) and
+               (record.source_id == info.source_id) and
+               (record.message_method == msg_id.method_id()) and
+               (record.message_class == msg_id.class_().value());
+    }};
+
+    if(auto found{_state->find(hash)}; found and matches(found->record)) {
+        // broadcast messages may pass a point several times, keep the first
+        auto& offset{trace_point_offset(found->record, point)};
+        if(offset < 0) {
+            offset = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       now - found->origin)
+                       .count();
+        }
+        return;
+    }
+
+    auto& records{_state->records};
+    if(records.size() >= _state->capacity) {
+        _state->pop_front();
+    }
+    _state->index[hash] = _state->front_serial + records.size();
+    auto& pending{records.emplace_back()};
+    pending.origin = now;
+    pending.hash = hash;
+    auto& record{pending.record};
+    record.source_id = info.source_id;
+    record.message_class = msg_id.class_().value();
+    record.message_method = msg_id.method_id();
+    record.sequence_no = info.sequence_no;
+    record.hop_count = info.hop_count;
+    record.recorded_by = _state->kind;
+    record.origin_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+    trace_point_offset(record, point) = 0;
+}
+//------------------------------------------------------------------------------
+auto message_tracer::fetch_records(
+  const endpoint_id_t node_id,
+  const std::chrono::steady_clock::duration min_age) noexcept
+  -> std::vector<message_trace_record> {
+    std::vector<message_trace_record> result;
+    if(_state) {
+        const auto settled{std::chrono::steady_clock::now() - min_age};
+        const std::unique_lock lk{_state->lock};
+        auto& records{_state->records};
+        // the records are ordered by the time of the first trace point
+        while(not records.empty() and (records.front().origin <= settled)) {
+            result.push_back(records.front().record);
+            result.back().node_id = node_id;
+            _state->pop_front();
+        }
+    }
+    return result;
+}
+//------------------------------------------------------------------------------
+} // namespace eagine::msgbus
@@ -277,6 +277,196 @@ export struct connection_statistics {
 
     /// @brief Number of bytes per second transferred.
     float bytes_per_second{-1.F};
+
+    /// @brief Average time (in milliseconds) messages wait for a block send.
+    /// @note Not serialized with the other members.
+    /// @see connection_latency_statistics
+    float send_latency_ms{-1.F};
+};
+//------------------------------------------------------------------------------
+/// @brief Structure holding message bus connection latency statistics.
+/// @ingroup msgbus
+/// @note Sent separately from connection_statistics, to keep its layout.
+export struct connection_latency_statistics {
+    /// @brief The local node message bus id.
+    endpoint_id_t local_id{};
+
+    /// @brief The remote node message bus id.
+    endpoint_id_t remote_id{};
+
+    /// @brief Average time (in milliseconds) messages wait for a block send.
+    float send_latency_ms{-1.F};
+};
+//------------------------------------------------------------------------------
+/// @brief Enumeration of points on the path of a message through a bus node.
+/// @ingroup msgbus
+/// @see message_trace_record
+export enum class message_trace_point : std::uint8_t {
+    /// @brief The message was queued to be sent later.
+    enqueue,
+    /// @brief The message was submitted to a connection.
+    /// @note The connection may serialize and write it later.
+    submit,
+    /// @brief The message was accepted by a connection for sending.
+    /// @note This is not the time when the message was written out.
+    accept,
+    /// @brief The message was received from a connection.
+    receive,
+    /// @brief The message was dispatched to a handler.
+    dispatch
+};
+//------------------------------------------------------------------------------
+/// @brief Structure holding the timestamps of a traced message in one bus node.
+/// @ingroup msgbus
+/// @see message_trace_point
+///
+/// The offsets of the trace points not reached by the message are negative.
+export struct message_trace_record {
+    /// @brief The id of the bus node that recorded the timestamps.
+    endpoint_id_t node_id{};
+
+    /// @brief The id of the endpoint that sent the traced message.
+    endpoint_id_t source_id{};
+
+    /// @brief The class identifier of the traced message.
+    identifier_t message_class{0U};
+
+    /// @brief The method identifier of the traced message.
+    identifier_t message_method{0U};
+
+    /// @brief The sequence number of the traced message.
+    message_sequence_t sequence_no{0U};
+
+    /// @brief The hop count of the message when it reached the node.
+    std::int8_t hop_count{0};
+
+    /// @brief The kind of the node that recorded the timestamps.
+    node_kind recorded_by{node_kind::unknown};
+
+    /// @brief The system clock time of the first trace point in microseconds.
+    std::int64_t origin_us{0};
+
+    /// @brief Offset of the enqueue trace point in nanoseconds.
+    std::int64_t enqueue_ns{-1};
+
+    /// @brief Offset of the submit trace point in nanoseconds.
+    std::int64_t submit_ns{-1};
+
+    /// @brief Offset of the accept trace point in nanoseconds.
+    std::int64_t accept_ns{-1};
+
+    /// @brief Offset of the receive trace point in nanoseconds.
+    std::int64_t receive_ns{-1};
+
+    /// @brief Offset of the dispatch trace point in nanoseconds.
+    std::int64_t dispatch_ns{-1};
+};
+//------------------------------------------------------------------------------
+/// @brief Fixed-size histogram of latencies with logarithmic buckets.
+/// @ingroup msgbus
+///
+/// Each power-of-two range of microseconds is split into four buckets,
+/// so the percentiles are reported with at most 25% relative error.
+/// Latencies exceeding the range of the last bucket are counted in it.
+export struct latency_histogram {
+    /// @brief The number of linear sub-buckets in each power-of-two range.
+    static constexpr const std::size_t sub_bucket_count = 4U;
+
+    /// @brief The number of histogram buckets.
+    static constexpr const std::size_t bucket_count = 104U;
+
+    /// @brief The sample counts in the individual buckets.
+    std::array<std::uint32_t, bucket_count> buckets{};
+
+    /// @brief The total number of samples.
+    std::int64_t sample_count{0};
+
+    /// @brief The maximum recorded latency in microseconds.
+    std::int64_t max_us{0};
+
+    /// @brief Returns the index of the bucket for the specified latency.
+    static constexpr auto bucket_of(const std::uint64_t us) noexcept
+      -> std::size_t {
+        if(us < sub_bucket_count) {
+            return std::size_t(us);
+        }
+        const auto e{std::size_t(std::bit_width(us)) - 1U};
+        const auto sub{std::size_t(us >> (e - 2U)) & (sub_bucket_count - 1U)};
+        return std::min((e - 1U) * sub_bucket_count + sub, bucket_count - 1U);
+    }
+
+    /// @brief Returns the smallest latency in microseconds in a bucket.
+    static constexpr auto bucket_lower_bound(const std::size_t index) noexcept
+      -> std::uint64_t {
+        if(index < sub_bucket_count) {
+            return std::uint64_t(index);
+        }
+        const auto e{index / sub_bucket_count + 1U};
+        const auto sub{index % sub_bucket_count};
+        return std::uint64_t(sub_bucket_count + sub) << (e - 2U);
+    }
+
+    /// @brief Records a single latency sample.
+    template <typename R, typename P>
+    void add(const std::chrono::duration<R, P> latency) noexcept {
+        const auto us{std::max(
+          std::chrono::duration_cast<std::chrono::microseconds>(latency).count(),
+          std::int64_t(0))};
+        auto& bucket{buckets[bucket_of(std::uint64_t(us))]};
+        if(bucket < std::numeric_limits<std::uint32_t>::max()) [[likely]] {
+            ++bucket;
+        }
+        ++sample_count;
+        max_us = std::max(max_us, us);
+    }
+
+    /// @brief Adds the samples from another histogram to this one.
+    void merge(const latency_histogram& that) noexcept {
+        for(std::size_t i = 0; i < bucket_count; ++i) {
+            buckets[i] = limit_cast<std::uint32_t>(
+              std::min<std::uint64_t>(
+                std::uint64_t(buckets[i]) + that.buckets[i],
+                std::numeric_limits<std::uint32_t>::max()));
+        }
+        sample_count += that.sample_count;
+        max_us = std::max(max_us, that.max_us);
+    }
+
+    /// @brief Removes all recorded samples.
+    void clear() noexcept {
+        *this = {};
+    }
+
+    /// @brief Indicates if no samples were recorded.
+    auto is_empty() const noexcept -> bool {
+        return sample_count == 0;
+    }
+
+    /// @brief Returns the latency not exceeded by the fraction of samples.
+    /// @note The returned value is the upper bound of the matching bucket.
+    auto percentile(const float fraction) const noexcept
+      -> std::chrono::microseconds {
+        std::uint64_t total{0U};
+        for(const auto count : buckets) {
+            total += count;
+        }
+        const auto rank{std::max<std::uint64_t>(
+          std::uint64_t(std::ceil(
+            double(total) * double(std::clamp(fraction, 0.F, 1.F)))),
+          1U)};
+        std::uint64_t seen{0U};
+        for(std::size_t i = 0; i < bucket_count; ++i) {
+            seen += buckets[i];
+            if(seen >= rank) {
+                if(i + 1U < bucket_count) {
+                    return std::chrono::microseconds{std::min(
+                      std::int64_t(bucket_lower_bound(i + 1U)) - 1, max_us)};
+                }
+                break;
+            }
+        }
+        return std::chrono::microseconds{max_us};
+    }
 };
 //------------------------------------------------------------------------------
 /// @brief Structure holding message bus data flow information.
@@ -301,6 +491,68 @@ export struct message_flow_info {
     auto operator!=(const message_flow_info&) const noexcept -> bool = default;
 };
 //------------------------------------------------------------------------------
+/// @brief Message flow information reported by the adjacent nodes of a router.
+/// @ingroup msgbus
+/// @see message_flow_info
+///
+/// Each node has its own entry that expires if the node stops reporting,
+/// for example because it disconnected or its congestion cleared.
+export class adjacent_flow_infos {
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    adjacent_flow_infos(const clock_type::duration max_age) noexcept
+      : _max_age{max_age} {}
+
+    /// @brief Updates the information reported by the specified node.
+    void update(
+      const endpoint_id_t node_id,
+      const message_flow_info& info,
+      const clock_type::time_point now = clock_type::now()) {
+        const auto pos{std::find_if(
+          _entries.begin(), _entries.end(), [node_id](const auto& entry) {
+              return std::get<0>(entry) == node_id;
+          })};
+        if(info.avg_msg_age_ms <= 0) {
+            // the node is not congested any more
+            if(pos != _entries.end()) {
+                _entries.erase(pos);
+            }
+        } else if(pos != _entries.end()) {
+            std::get<1>(*pos) = info.avg_msg_age_ms;
+            std::get<2>(*pos) = now;
+        } else {
+            _entries.emplace_back(node_id, info.avg_msg_age_ms, now);
+        }
+    }
+
+    /// @brief Removes the expired entries. Returns the number of remaining ones.
+    auto expire(const clock_type::time_point now = clock_type::now()) noexcept
+      -> std::size_t {
+        std::erase_if(_entries, [&](const auto& entry) {
+            return now - std::get<2>(entry) > _max_age;
+        });
+        return _entries.size();
+    }
+
+    /// @brief Returns the maximum message age reported by the nodes.
+    auto max_message_age_ms(
+      const clock_type::time_point now = clock_type::now()) noexcept
+      -> std::int32_t {
+        expire(now);
+        std::int32_t result{0};
+        for(const auto& entry : _entries) {
+            result = std::max(result, std::get<1>(entry));
+        }
+        return result;
+    }
+
+private:
+    clock_type::duration _max_age;
+    std::vector<std::tuple<endpoint_id_t, std::int32_t, clock_type::time_point>>
+      _entries;
+};
+//------------------------------------------------------------------------------
 /// @brief Alias for IPv4 port number value type.
 /// @ingroup msgbus
 export using ipv4_port = unsigned short int;
@@ -393,12 +645,23 @@ export enum class message_crypto_flag : std::uint8_t {
     /// @brief The message header is signed.
     signed_header = 1U << 1U,
     /// @brief The message content is signed.
-    signed_content = 1U << 2U
+    signed_content = 1U << 2U,
+    /// @brief The signature is a MAC with a per-peer session key.
+    session_mac = 1U << 3U
 };
 /// @brief  Alias for message crypto flags bitfield.
 /// @ingroup msgbus
 export using message_crypto_flags = bitfield<message_crypto_flag>;
 //------------------------------------------------------------------------------
+/// @brief Enumeration of wire formats of serialized message headers.
+/// @ingroup msgbus
+export enum class message_header_format : std::uint8_t {
+    /// @brief Header serialized with the default serializer backend.
+    portable,
+    /// @brief Fixed-layout, versioned binary header.
+    compact
+};
+//------------------------------------------------------------------------------
 } // namespace msgbus
 //------------------------------------------------------------------------------
 export template <>
@@ -488,10 +751,21 @@ export template <>
 struct enumerator_traits<msgbus::message_crypto_flag> {
     static constexpr auto mapping() noexcept {
         using msgbus::message_crypto_flag;
-        return enumerator_map_type<message_crypto_flag, 3>{
+        return enumerator_map_type<message_crypto_flag, 4>{
           {{"asymmetric", message_crypto_flag::asymmetric},
            {"signed_header", message_crypto_flag::signed_header},
-           {"signed_content", message_crypto_flag::signed_content}}};
+           {"signed_content", message_crypto_flag::signed_content},
+           {"session_mac", message_crypto_flag::session_mac}}};
+    }
+};
+//------------------------------------------------------------------------------
+export template <>
+struct enumerator_traits<msgbus::message_header_format> {
+    static constexpr auto mapping() noexcept {
+        using msgbus::message_header_format;
+        return enumerator_map_type<message_header_format, 2>{
+          {{"portable", message_header_format::portable},
+           {"compact", message_header_format::compact}}};
     }
 };
 //------------------------------------------------------------------------------
@@ -607,7 +881,12 @@ export template <>
 struct data_member_traits<msgbus::connection_statistics> {
     static constexpr auto mapping() noexcept {
         using S = msgbus::connection_statistics;
-        return make_data_member_mapping<S, endpoint_id_t, endpoint_id_t, float, float>(
+        return make_data_member_mapping<
+          S,
+          endpoint_id_t,
+          endpoint_id_t,
+          float,
+          float>(
           {"local_id", &S::local_id},
           {"remote_id", &S::remote_id},
           {"block_usage_ratio", &S::block_usage_ratio},
@@ -616,6 +895,67 @@ struct data_member_traits<msgbus::connection_statistics> {
 };
 //------------------------------------------------------------------------------
 export template <>
+struct data_member_traits<msgbus::connection_latency_statistics> {
+    static constexpr auto mapping() noexcept {
+        using S = msgbus::connection_latency_statistics;
+        return make_data_member_mapping<S, endpoint_id_t, endpoint_id_t, float>(
+          {"local_id", &S::local_id},
+          {"remote_id", &S::remote_id},
+          {"send_latency_ms", &S::send_latency_ms});
+    }
+};
+//------------------------------------------------------------------------------
+export template <>
+struct data_member_traits<msgbus::message_trace_record> {
+    static constexpr auto mapping() noexcept {
+        using S = msgbus::message_trace_record;
+        return make_data_member_mapping<
+          S,
+          endpoint_id_t,
+          endpoint_id_t,
+          identifier_t,
+          identifier_t,
+          msgbus::message_sequence_t,
+          std::int8_t,
+          msgbus::node_kind,
+          std::int64_t,
+          std::int64_t,
+          std::int64_t,
+          std::int64_t,
+          std::int64_t,
+          std::int64_t>(
+          {"node_id", &S::node_id},
+          {"source_id", &S::source_id},
+          {"message_class", &S::message_class},
+          {"message_method", &S::message_method},
+          {"sequence_no", &S::sequence_no},
+          {"hop_count", &S::hop_count},
+          {"recorded_by", &S::recorded_by},
+          {"origin_us", &S::origin_us},
+          {"enqueue_ns", &S::enqueue_ns},
+          {"submit_ns", &S::submit_ns},
+          {"accept_ns", &S::accept_ns},
+          {"receive_ns", &S::receive_ns},
+          {"dispatch_ns", &S::dispatch_ns});
+    }
+};
+//------------------------------------------------------------------------------
+export template <>
+struct data_member_traits<msgbus::latency_histogram> {
+    static constexpr auto mapping() noexcept {
+        using S = msgbus::latency_histogram;
+        return make_data_member_mapping<
+          S,
+          std::array<std::uint32_t, S::bucket_count>,
+          std::int64_t,
+          std::int64_t>(
+          {"buckets", &S::buckets},
+          {"sample_count", &S::sample_count},
+          {"max_us", &S::max_us});
+    }
+};
+//------------------------------------------------------------------------------
+export template <>
 struct data_member_traits<msgbus::message_flow_info> {
     static constexpr auto mapping() noexcept {
         using S = msgbus::message_flow_info;
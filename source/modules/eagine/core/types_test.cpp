@@ -25,11 +25,144 @@ void message_priority_inc_dec(auto& s) {
     test.check(P::critical == increased(P::critical), "6");
 }
 //------------------------------------------------------------------------------
+// latency histogram
+//------------------------------------------------------------------------------
+void latency_histogram_buckets(auto& s) {
+    using H = eagine::msgbus::latency_histogram;
+    eagitest::case_ test{s, 2, "latency histogram buckets"};
+    auto& rg{test.random()};
+
+    for(unsigned r = 0; r < test.repeats(10000); ++r) {
+        const auto us{rg.get_between<std::uint64_t>(0U, 60'000'000U)};
+        const auto idx{H::bucket_of(us)};
+        test.ensure(idx + 1U < H::bucket_count, "in range");
+        test.check(H::bucket_lower_bound(idx) <= us, "lower bound");
+        test.check(us < H::bucket_lower_bound(idx + 1U), "upper bound");
+    }
+    test.check_equal(
+      H::bucket_of(std::numeric_limits<std::uint64_t>::max()),
+      H::bucket_count - 1U,
+      "saturated");
+}
+//------------------------------------------------------------------------------
+void latency_histogram_percentiles(auto& s) {
+    using namespace std::chrono;
+    eagitest::case_ test{s, 3, "latency histogram percentiles"};
+
+    eagine::msgbus::latency_histogram lo;
+    eagine::msgbus::latency_histogram hi;
+    test.check(lo.is_empty(), "is empty");
+    for(int us = 1; us <= 500; ++us) {
+        lo.add(microseconds{us});
+        hi.add(microseconds{us + 500});
+    }
+    lo.merge(hi);
+    test.check(not lo.is_empty(), "not empty");
+    test.check_equal(lo.sample_count, std::int64_t(1000), "count");
+    test.check_equal(lo.max_us, std::int64_t(1000), "max");
+
+    const auto p50{lo.percentile(0.5F).count()};
+    test.check(p50 >= 500, "p50 min");
+    test.check(p50 <= 625, "p50 max");
+    const auto p99{lo.percentile(0.99F).count()};
+    test.check(p99 >= 990, "p99 min");
+    test.check(p99 <= 1000, "p99 max");
+    test.check_equal(lo.percentile(1.F).count(), std::int64_t(1000), "p100");
+
+    lo.clear();
+    test.check(lo.is_empty(), "cleared");
+}
+//------------------------------------------------------------------------------
+// adjacent flow infos
+//------------------------------------------------------------------------------
+void adjacent_flow_infos_expire(auto& s) {
+    using namespace std::chrono;
+    eagitest::case_ test{s, 4, "adjacent flow infos"};
+    const auto origin{steady_clock::now()};
+    eagine::msgbus::adjacent_flow_infos infos{seconds{5}};
+    const auto info{[](int ms) {
+        eagine::msgbus::message_flow_info result{};
+        result.set_average_message_age(milliseconds{ms});
+        return result;
+    }};
+    const eagine::endpoint_id_t node_a{1U};
+    const eagine::endpoint_id_t node_b{2U};
+
+    test.check_equal(infos.max_message_age_ms(origin), 0, "empty");
+
+    infos.update(node_a, info(200), origin);
+    infos.update(node_b, info(50), origin + seconds{3});
+    test.check_equal(infos.max_message_age_ms(origin + seconds{1}), 200, "a");
+
+    // the entries are kept per node
+    infos.update(node_a, info(20), origin + seconds{2});
+    test.check_equal(infos.max_message_age_ms(origin + seconds{2}), 50, "b");
+
+    // the entry of a node that stopped reporting expires
+    infos.update(node_a, info(300), origin + seconds{2});
+    test.check_equal(infos.max_message_age_ms(origin + seconds{6}), 300, "a");
+    test.check_equal(infos.max_message_age_ms(origin + seconds{8}), 50, "b");
+    test.check_equal(infos.expire(origin + seconds{9}), std::size_t(0), "none");
+
+    // a node that is not congested any more is forgotten right away
+    infos.update(node_a, info(100), origin + seconds{10});
+    infos.update(node_b, info(150), origin + seconds{10});
+    infos.update(node_b, info(0), origin + seconds{11});
+    test.check_equal(
+      infos.max_message_age_ms(origin + seconds{11}), 100, "cleared");
+    test.check_equal(infos.expire(origin + seconds{11}), std::size_t(1), "one");
+}
+//------------------------------------------------------------------------------
+// connection statistics serialization
+//------------------------------------------------------------------------------
+void connection_statistics_serialization(auto& s) {
+    eagitest::case_ test{s, 5, "connection statistics serialization"};
+    eagine::msgbus::connection_statistics stats{};
+    stats.local_id = eagine::endpoint_id_t{1U};
+    stats.remote_id = eagine::endpoint_id_t{2U};
+    stats.block_usage_ratio = 0.5F;
+    stats.bytes_per_second = 1000.F;
+    stats.send_latency_ms = 2.5F;
+
+    auto buffer{eagine::default_serialize_buffer_for(stats)};
+    const auto serialized{eagine::default_serialize(stats, cover(buffer))};
+    test.ensure(bool(serialized), "serialized");
+    eagine::msgbus::connection_statistics decoded{};
+    test.ensure(
+      bool(eagine::default_deserialize(decoded, *serialized)), "deserialized");
+    test.check(decoded.local_id == stats.local_id, "local id");
+    test.check(decoded.remote_id == stats.remote_id, "remote id");
+    test.check_equal(decoded.block_usage_ratio, 0.5F, "block usage");
+    test.check_equal(decoded.bytes_per_second, 1000.F, "bytes per second");
+    // the latency is sent separately, to keep the layout of older nodes
+    test.check_equal(decoded.send_latency_ms, -1.F, "no latency");
+
+    const eagine::msgbus::connection_latency_statistics latency{
+      .local_id = stats.local_id,
+      .remote_id = stats.remote_id,
+      .send_latency_ms = stats.send_latency_ms};
+    auto lt_buffer{eagine::default_serialize_buffer_for(latency)};
+    const auto lt_serialized{
+      eagine::default_serialize(latency, cover(lt_buffer))};
+    test.ensure(bool(lt_serialized), "latency serialized");
+    eagine::msgbus::connection_latency_statistics lt_decoded{};
+    test.ensure(
+      bool(eagine::default_deserialize(lt_decoded, *lt_serialized)),
+      "latency deserialized");
+    test.check(lt_decoded.local_id == stats.local_id, "latency local id");
+    test.check(lt_decoded.remote_id == stats.remote_id, "latency remote id");
+    test.check_equal(lt_decoded.send_latency_ms, 2.5F, "latency");
+}
+//------------------------------------------------------------------------------
 // main
 //------------------------------------------------------------------------------
 auto test_main(eagine::test_ctx& ctx) -> int {
-    eagitest::ctx_suite test{ctx, "types", 1};
+    eagitest::ctx_suite test{ctx, "types", 5};
     test.once(message_priority_inc_dec);
+    test.once(latency_histogram_buckets);
+    test.once(latency_histogram_percentiles);
+    test.once(adjacent_flow_infos_expire);
+    test.once(connection_statistics_serialization);
     return test.exit_code();
 }
 //------------------------------------------------------------------------------
@@ -0,0 +1,132 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+export module eagine.msgbus.core:wait;
+
+import std;
+import eagine.core.types;
+
+namespace eagine::msgbus {
+//------------------------------------------------------------------------------
+/// @brief Native handle that can be waited on for incoming work.
+/// @ingroup msgbus
+/// @see work_waiter
+export struct work_wait_handle {
+    /// @brief The native file descriptor, negative if not valid.
+    int native{-1};
+    /// @brief Indicates if the handle becoming writable also means work.
+    bool writable{false};
+
+    /// @brief Indicates if this handle is valid.
+    explicit operator bool() const noexcept {
+        return native >= 0;
+    }
+};
+//------------------------------------------------------------------------------
+/// @brief Returns the wait handle for the standard input if it can be waited on.
+/// @ingroup msgbus
+export auto stdin_wait_handle() noexcept -> work_wait_handle;
+//------------------------------------------------------------------------------
+/// @brief Signal raised from any thread that can wake up a work_waiter.
+/// @ingroup msgbus
+/// @see work_waiter
+///
+/// Uses an eventfd on Linux and a pipe on other POSIX systems. Only the first
+/// notification after a clear does a system call.
+export class work_signal {
+public:
+    work_signal() noexcept;
+    work_signal(work_signal&&) = delete;
+    work_signal(const work_signal&) = delete;
+    auto operator=(work_signal&&) = delete;
+    auto operator=(const work_signal&) = delete;
+    ~work_signal() noexcept;
+
+    /// @brief Raises the signal and wakes up the waiters.
+    void notify() noexcept;
+
+    /// @brief Clears the signal. Returns if it was raised.
+    auto clear() noexcept -> bool;
+
+    /// @brief Returns the handle that becomes readable when the signal is raised.
+    auto wait_handle() const noexcept -> work_wait_handle {
+        return {.native = _read_fd};
+    }
+
+private:
+    int _read_fd{-1};
+    int _write_fd{-1};
+    std::atomic<bool> _raised{false};
+};
+//------------------------------------------------------------------------------
+/// @brief Blocks once until any of a set of connections or acceptors has work.
+/// @ingroup msgbus
+/// @see work_wait_handle
+/// @see work_signal
+///
+/// The sources provide their native handles that are waited on together
+/// with a single system call. Those without a native handle are checked
+/// through their own wait_for_work function with zero timeout, between
+/// waits on the native handles no longer than the fallback interval.
+export class work_waiter {
+public:
+    using duration = std::chrono::steady_clock::duration;
+
+    /// @brief Indicates if native handles can be waited on on this platform.
+    static auto has_native_handles() noexcept -> bool;
+
+    /// @brief Removes all previously added handles and sources.
+    void reset() noexcept {
+        _handles.clear();
+        _fallbacks.clear();
+    }
+
+    /// @brief Indicates if there is nothing to wait on.
+    auto is_empty() const noexcept -> bool {
+        return _handles.empty() and _fallbacks.empty();
+    }
+
+    /// @brief Adds a native handle. Returns false if the handle is not valid.
+    auto add_handle(const work_wait_handle handle) noexcept -> bool {
+        if(handle and has_native_handles()) {
+            _handles.push_back(handle);
+            return true;
+        }
+        return false;
+    }
+
+    /// @brief Adds a connection or an acceptor.
+    /// If it does not provide native handles then its wait_for_work is used.
+    template <typename Source>
+    void add(Source& source) noexcept {
+        if(not source.add_wait_handles(*this)) {
+            _fallbacks.emplace_back(
+              static_cast<void*>(&source),
+              [](void* src, const duration timeout) noexcept -> work_done {
+                  return static_cast<Source*>(src)->wait_for_work(timeout);
+              });
+        }
+    }
+
+    /// @brief Sets how often the sources without native handles are checked.
+    void set_fallback_interval(const duration interval) noexcept {
+        _fallback_interval = std::max(interval, duration{1});
+    }
+
+    /// @brief Waits until any of the added handles or sources has work or timeout.
+    auto wait(const duration timeout) noexcept -> work_done;
+
+private:
+    auto _poll(const duration timeout) noexcept -> bool;
+
+    std::vector<work_wait_handle> _handles;
+    std::vector<std::tuple<void*, work_done (*)(void*, duration) noexcept>>
+      _fallbacks;
+    duration _fallback_interval{std::chrono::milliseconds{1}};
+};
+//------------------------------------------------------------------------------
+} // namespace eagine::msgbus
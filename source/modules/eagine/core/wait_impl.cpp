@@ -0,0 +1,158 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+module;
+
+#if __has_include(<poll.h>) && __has_include(<unistd.h>) && \
+  __has_include(<fcntl.h>)
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#define EAGINE_MSGBUS_WAIT_POLL 1
+#else
+#define EAGINE_MSGBUS_WAIT_POLL 0
+#endif
+
+#if EAGINE_MSGBUS_WAIT_POLL && defined(__linux__) && \
+  __has_include(<sys/eventfd.h>)
+#include <sys/eventfd.h>
+#define EAGINE_MSGBUS_WAIT_EVENTFD 1
+#else
+#define EAGINE_MSGBUS_WAIT_EVENTFD 0
+#endif
+
+module eagine.msgbus.core;
+
+import std;
+import eagine.core.types;
+import eagine.core.utility;
+
+namespace eagine::msgbus {
+//------------------------------------------------------------------------------
+auto stdin_wait_handle() noexcept -> work_wait_handle {
+#if EAGINE_MSGBUS_WAIT_POLL
+    return {.native = STDIN_FILENO};
+#else
+    return {};
+#endif
+}
+//------------------------------------------------------------------------------
+// work_signal
+//------------------------------------------------------------------------------
+work_signal::work_signal() noexcept {
+#if EAGINE_MSGBUS_WAIT_EVENTFD
+    _read_fd = _write_fd = ::eventfd(0U, EFD_NONBLOCK | EFD_CLOEXEC);
+#elif EAGINE_MSGBUS_WAIT_POLL
+    int fds[2]{-1, -1};
+    if(::pipe(fds) == 0) {
+        for(const int fd : fds) {
+            ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+            ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        _read_fd = fds[0];
+        _write_fd = fds[1];
+    }
+#endif
+}
+//------------------------------------------------------------------------------
+work_signal::~work_signal() noexcept {
+#if EAGINE_MSGBUS_WAIT_POLL
+    if(_write_fd >= 0 and _write_fd != _read_fd) {
+        ::close(_write_fd);
+    }
+    if(_read_fd >= 0) {
+        ::close(_read_fd);
+    }
+#endif
+}
+//------------------------------------------------------------------------------
+void work_signal::notify() noexcept {
+#if EAGINE_MSGBUS_WAIT_POLL
+    // a write after the last clear is enough to keep the handle readable
+    if(_write_fd >= 0 and not _raised.exchange(true)) {
+        const std::uint64_t value{1U};
+        [[maybe_unused]] const auto written{
+          ::write(_write_fd, &value, sizeof(value))};
+    }
+#endif
+}
+//------------------------------------------------------------------------------
+auto work_signal::clear() noexcept -> bool {
+#if EAGINE_MSGBUS_WAIT_POLL
+    if(_read_fd >= 0 and _raised.exchange(false)) {
+        // a notification racing with this read just causes a spurious wake-up
+        std::uint64_t value{0U};
+        while(::read(_read_fd, &value, sizeof(value)) > 0) {
+        }
+        return true;
+    }
+#endif
+    return false;
+}
+//------------------------------------------------------------------------------
+// work_waiter
+//------------------------------------------------------------------------------
+auto work_waiter::has_native_handles() noexcept -> bool {
+    return EAGINE_MSGBUS_WAIT_POLL != 0;
+}
+//------------------------------------------------------------------------------
+auto work_waiter::_poll(const duration timeout) noexcept -> bool {
+#if EAGINE_MSGBUS_WAIT_POLL
+    thread_local std::vector<::pollfd> pfds;
+    pfds.clear();
+    for(const auto& handle : _handles) {
+        pfds.push_back(
+          {.fd = handle.native,
+           .events = static_cast<short>(
+             handle.writable ? (POLLIN | POLLOUT) : POLLIN),
+           .revents = 0});
+    }
+    const auto timeout_ms{
+      std::chrono::ceil<std::chrono::milliseconds>(timeout).count()};
+    return ::poll(
+             pfds.data(),
+             limit_cast<::nfds_t>(pfds.size()),
+             limit_cast<int>(timeout_ms)) > 0;
+#else
+    std::this_thread::sleep_for(timeout);
+    return false;
+#endif
+}
+//------------------------------------------------------------------------------
+auto work_waiter::wait(const duration timeout) noexcept -> work_done {
+    if(_fallbacks.empty()) {
+        if(_handles.empty()) [[unlikely]] {
+            std::this_thread::sleep_for(timeout);
+            return false;
+        }
+        return _poll(timeout);
+    }
+    // the sources without a native handle are checked without blocking
+    // in between short waits on the native handles, so that work on any
+    // of the sources ends the wait within one interval
+    const auto deadline{std::chrono::steady_clock::now() + timeout};
+    while(true) {
+        for(const auto& [source, wait_func] : _fallbacks) {
+            if(wait_func(source, duration::zero())) {
+                return true;
+            }
+        }
+        const auto now{std::chrono::steady_clock::now()};
+        if(now >= deadline) {
+            return false;
+        }
+        const auto interval{
+          std::min<duration>(_fallback_interval, deadline - now)};
+        if(_handles.empty()) {
+            std::this_thread::sleep_for(interval);
+        } else if(_poll(interval)) {
+            return true;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+} // namespace eagine::msgbus
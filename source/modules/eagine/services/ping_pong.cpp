@@ -94,6 +94,8 @@ struct pinger_intf : interface<pinger_intf> {
     virtual auto update() noexcept -> work_done = 0;
 
     virtual auto has_pending_pings() noexcept -> bool = 0;
+
+    virtual auto ping_latencies() const noexcept -> const latency_histogram& = 0;
 };
 //------------------------------------------------------------------------------
 /// @brief Collection of signals emitted by the pinger service.
@@ -202,6 +204,12 @@ public:
         return _impl->has_pending_pings();
     }
 
+    /// @brief Returns the histogram of round-trip times of the responded pings.
+    /// @see ping_responded
+    auto ping_latencies() const noexcept -> const latency_histogram& {
+        return _impl->ping_latencies();
+    }
+
 protected:
     using Base::Base;
 
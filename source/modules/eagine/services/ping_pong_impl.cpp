@@ -16,6 +16,24 @@ import eagine.msgbus.core;
 
 namespace eagine::msgbus {
 //------------------------------------------------------------------------------
+struct pending_ping_key {
+    endpoint_id_t pingable_id;
+    message_sequence_t sequence_no;
+
+    auto operator==(const pending_ping_key& that) const noexcept -> bool {
+        return (pingable_id == that.pingable_id) and
+               (sequence_no == that.sequence_no);
+    }
+};
+//------------------------------------------------------------------------------
+struct pending_ping_key_hash {
+    auto operator()(const pending_ping_key& key) const noexcept -> std::size_t {
+        return std::size_t(
+          (std::uint64_t(key.pingable_id.value()) * 0x9E3779B97F4A7C15U) ^
+          std::uint64_t(key.sequence_no));
+    }
+};
+//------------------------------------------------------------------------------
 class pinger_impl : public pinger_intf {
 public:
     pinger_impl(subscriber& sub, pinger_signals& sigs) noexcept
@@ -44,6 +62,10 @@ public:
         return not _pending.empty();
     }
 
+    auto ping_latencies() const noexcept -> const latency_histogram& final {
+        return _latencies;
+    }
+
 private:
     auto _handle_pong(
       const message_context& msg_ctx,
@@ -52,29 +74,26 @@ private:
     subscriber& base;
     pinger_signals& signals;
 
-    std::vector<std::tuple<endpoint_id_t, message_sequence_t, timeout>> _pending{};
+    timer_wheel<pending_ping_key, timeout, pending_ping_key_hash> _pending{};
+    latency_histogram _latencies{};
 };
 //------------------------------------------------------------------------------
 auto pinger_impl::_handle_pong(
   const message_context& msg_ctx,
   const stored_message& message) noexcept -> bool {
-    std::erase_if(_pending, [&, this](auto& entry) {
-        auto& [pingable_id, sequence_no, ping_time] = entry;
-        const bool is_response = (message.source_id == pingable_id) and
-                                 (message.sequence_no == sequence_no);
-        if(is_response) {
-            signals.ping_responded(
-              result_context{msg_ctx, message},
-              ping_response{
-                .pingable_id = message.source_id,
-                .age = std::chrono::duration_cast<std::chrono::microseconds>(
-                  ping_time.elapsed_time()),
-                .sequence_no = message.sequence_no,
-                .verified = base.verify_bits(message)});
-            return true;
-        }
-        return false;
-    });
+    if(const auto ping_time{
+         _pending.extract({message.source_id, message.sequence_no})}) {
+        const auto age{std::chrono::duration_cast<std::chrono::microseconds>(
+          ping_time->elapsed_time())};
+        _latencies.add(age);
+        signals.ping_responded(
+          result_context{msg_ctx, message},
+          ping_response{
+            .pingable_id = message.source_id,
+            .age = age,
+            .sequence_no = message.sequence_no,
+            .verified = base.verify_bits(message)});
+    }
     return true;
 }
 //------------------------------------------------------------------------------
@@ -87,25 +106,20 @@ void pinger_impl::ping(
     message.set_priority(message_priority::low);
     base.bus_node().set_next_sequence_id(msg_id, message);
     base.bus_node().post(msg_id, message);
-    _pending.emplace_back(message.target_id, message.sequence_no, max_time);
+    _pending.schedule(
+      {message.target_id, message.sequence_no}, timeout{max_time}, max_time);
 }
 //------------------------------------------------------------------------------
 auto pinger_impl::decode_ping_response(
   const message_context& msg_ctx,
   const stored_message& message) noexcept -> std::optional<ping_response> {
     if(msg_ctx.is_special_message("pong")) {
-        const auto pos{
-          std::find_if(_pending.begin(), _pending.end(), [&](const auto& entry) {
-              const auto& [pingable_id, sequence_no, ping_time] = entry;
-              const bool is_response = (message.source_id == pingable_id) and
-                                       (message.sequence_no == sequence_no);
-              return is_response;
-          })};
-        if(pos != _pending.end()) {
+        if(const auto ping_time{
+             _pending.find({message.source_id, message.sequence_no})}) {
             return {ping_response{
               .pingable_id = message.source_id,
               .age = std::chrono::duration_cast<std::chrono::microseconds>(
-                std::get<2>(*pos).elapsed_time()),
+                ping_time->elapsed_time()),
               .sequence_no = message.sequence_no,
               .verified = base.verify_bits(message)}};
         }
@@ -117,18 +131,13 @@ auto pinger_impl::update() noexcept -> work_done {
     some_true something_done{};
 
     something_done(
-      std::erase_if(_pending, [this](const auto& entry) {
-          const auto& [pingable_id, sequence_no, ping_time] = entry;
-          if(ping_time.is_expired()) {
-              signals.ping_timeouted(ping_timeout{
-                .pingable_id = pingable_id,
-                .age = std::chrono::duration_cast<std::chrono::microseconds>(
-                  ping_time.elapsed_time()),
-                .sequence_no = sequence_no});
-              return true;
-          }
-          return false;
-      }) > 0);
+      _pending.expire([this](const auto& key, const timeout& ping_time) {
+          signals.ping_timeouted(ping_timeout{
+            .pingable_id = key.pingable_id,
+            .age = std::chrono::duration_cast<std::chrono::microseconds>(
+              ping_time.elapsed_time()),
+            .sequence_no = key.sequence_no});
+      }) > 0U);
     return something_done;
 }
 //------------------------------------------------------------------------------
@@ -45,6 +45,12 @@ export struct resource_server_driver : interface<resource_server_driver> {
     }
 };
 //------------------------------------------------------------------------------
+/// @brief Creates a blob target I/O object storing the data into a file.
+/// @ingroup msgbus
+/// @note Where supported the file is preallocated and written through a mapping.
+export auto make_target_blob_file_io(const std::filesystem::path& file_path)
+  -> unique_holder<target_blob_io>;
+//------------------------------------------------------------------------------
 struct resource_server_intf : interface<resource_server_intf> {
     virtual void add_methods() noexcept = 0;
     virtual auto update() noexcept -> work_done = 0;
@@ -154,6 +160,13 @@ struct resource_manipulator_intf : interface<resource_manipulator_intf> {
       shared_holder<target_blob_io> write_io,
       const message_priority priority,
       const std::chrono::seconds max_time) -> std::optional<message_sequence_t> = 0;
+
+    virtual auto query_resource_content(
+      endpoint_id_t endpoint_id,
+      const url& locator,
+      const std::filesystem::path& file_path,
+      const message_priority priority,
+      const std::chrono::seconds max_time) -> std::optional<message_sequence_t> = 0;
 };
 //------------------------------------------------------------------------------
 auto make_resource_manipulator_impl(subscriber&, resource_manipulator_signals&)
@@ -221,6 +234,20 @@ public:
           std::chrono::ceil<std::chrono::seconds>(max_timeout.period()));
     }
 
+    /// @brief Requests the contents of the file with the specified URL.
+    /// @see make_target_blob_file_io
+    ///
+    /// The received content is stored into the file at the specified path.
+    auto query_resource_content(
+      endpoint_id_t endpoint_id,
+      const url& locator,
+      const std::filesystem::path& file_path,
+      const message_priority priority,
+      const std::chrono::seconds max_time) -> std::optional<message_sequence_t> {
+        return _impl->query_resource_content(
+          endpoint_id, locator, file_path, priority, max_time);
+    }
+
     /// @brief Requests the contents of the file with the specified URL.
     /// @see server_endpoint_id
     auto query_resource_content(
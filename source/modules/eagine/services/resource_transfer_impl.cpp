@@ -9,6 +9,21 @@ module;
 
 #include <cassert>
 
+#if __has_include(<fcntl.h>) && \
+	__has_include(<sys/mman.h>) && \
+	__has_include(<sys/stat.h>) && \
+	__has_include(<unistd.h>)
+#include <fcntl.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define EAGINE_POSIX 1
+#else
+#define EAGINE_POSIX 0
+#endif
+
 module eagine.msgbus.services;
 
 import std;
@@ -167,8 +182,11 @@ public:
     auto store_fragment(
       const span_size_t offs,
       const memory::const_block src,
-      const blob_info&) noexcept -> bool final {
-        _file.seekg(_offs + offs, std::ios::beg);
+      const blob_info& info) noexcept -> bool final {
+        if(_size == 0) {
+            _size = _offs + info.total_size;
+        }
+        _file.seekp(_offs + offs, std::ios::beg);
         return write_to_stream(_file, head(src, _size - _offs - offs)).good();
     }
 
@@ -209,6 +227,288 @@ file_blob_io::file_blob_io(
         _offs = math::minimum(_size, *offs);
     }
 }
+//------------------------------------------------------------------------------
+// mapped_file_blob_io
+//------------------------------------------------------------------------------
+#if EAGINE_POSIX
+// The mapped file can be truncated by another process at any time and then
+// accessing the pages past its end raises SIGBUS. The copies from and into
+// the mapping are done with a handler that turns this into a failed copy.
+struct mapped_copy_guard {
+    const byte* bgn{nullptr};
+    const byte* end{nullptr};
+    ::sigjmp_buf env{};
+};
+static thread_local mapped_copy_guard* mapped_copy_active{nullptr};
+static struct ::sigaction mapped_copy_prev_action{};
+//------------------------------------------------------------------------------
+static void mapped_copy_sigbus(int sig, ::siginfo_t* info, void* context) {
+    auto* guard{mapped_copy_active};
+    const auto* addr{static_cast<const byte*>(info->si_addr)};
+    if(guard and addr >= guard->bgn and addr < guard->end) {
+        mapped_copy_active = nullptr;
+        ::siglongjmp(guard->env, 1);
+    }
+    // not a guarded copy, forward the signal to the previous handler
+    const auto& prev{mapped_copy_prev_action};
+    if((prev.sa_flags & SA_SIGINFO) != 0) {
+        if(prev.sa_sigaction) {
+            prev.sa_sigaction(sig, info, context);
+            return;
+        }
+    } else if((prev.sa_handler != SIG_DFL) and (prev.sa_handler != SIG_IGN)) {
+        prev.sa_handler(sig);
+        return;
+    }
+    // the default action terminates the process when the faulting
+    // instruction is re-executed, a fault cannot be ignored
+    struct ::sigaction action{};
+    action.sa_handler = SIG_DFL;
+    ::sigemptyset(&action.sa_mask);
+    ::sigaction(SIGBUS, &action, nullptr);
+}
+//------------------------------------------------------------------------------
+static auto mapped_copy_install() noexcept -> bool {
+    struct ::sigaction action{};
+    action.sa_sigaction = &mapped_copy_sigbus;
+    // SIGBUS stays unblocked after the jump, so the mask need not be saved
+    action.sa_flags = SA_SIGINFO | SA_NODEFER;
+    ::sigemptyset(&action.sa_mask);
+    return ::sigaction(SIGBUS, &action, &mapped_copy_prev_action) == 0;
+}
+//------------------------------------------------------------------------------
+static auto mapped_copy(
+  const memory::const_block src,
+  memory::block dst,
+  const memory::const_block mapping) noexcept -> bool {
+    static const bool installed{mapped_copy_install()};
+    if(not installed) [[unlikely]] {
+        std::memcpy(dst.data(), src.data(), std_size(src.size()));
+        return true;
+    }
+    mapped_copy_guard guard{
+      .bgn = mapping.data(), .end = mapping.data() + mapping.size()};
+    if(::sigsetjmp(guard.env, 0) != 0) {
+        return false;
+    }
+    mapped_copy_active = &guard;
+    std::memcpy(dst.data(), src.data(), std_size(src.size()));
+    mapped_copy_active = nullptr;
+    return true;
+}
+//------------------------------------------------------------------------------
+class mapped_file_blob_io final
+  : public source_blob_io
+  , public target_blob_io {
+public:
+    mapped_file_blob_io(int fd, const bool writable) noexcept
+      : _fd{fd}
+      , _writable{writable} {}
+
+    mapped_file_blob_io(mapped_file_blob_io&&) = delete;
+    mapped_file_blob_io(const mapped_file_blob_io&) = delete;
+    auto operator=(mapped_file_blob_io&&) = delete;
+    auto operator=(const mapped_file_blob_io&) = delete;
+
+    ~mapped_file_blob_io() noexcept override {
+        _close();
+    }
+
+    /// @brief Maps the specified range of the file for reading.
+    auto map_source(
+      std::optional<span_size_t> offs,
+      std::optional<span_size_t> size) noexcept -> bool;
+
+    auto is_at_eod(const span_size_t offs) noexcept -> bool final {
+        return offs >= total_size();
+    }
+
+    auto total_size() noexcept -> span_size_t final {
+        return _data.size();
+    }
+
+    auto fetch_fragment(const span_size_t offs, memory::block dst) noexcept
+      -> span_size_t final {
+        _read_ahead(offs);
+        const auto src{head(skip(_data, offs), dst.size())};
+        if(not mapped_copy(src, dst, _mapping())) [[unlikely]] {
+            return 0;
+        }
+        return src.size();
+    }
+
+    auto store_fragment(
+      const span_size_t offs,
+      const memory::const_block src,
+      const blob_info& info) noexcept -> bool final {
+        if(not _data and not _map_target(info.total_size)) [[unlikely]] {
+            return false;
+        }
+        const auto part{head(src, _data.size() - offs)};
+        return mapped_copy(part, skip(_data, offs), _mapping());
+    }
+
+    auto check_stored(const span_size_t, memory::const_block) noexcept
+      -> bool final {
+        return true;
+    }
+
+    void handle_finished(
+      const message_id,
+      const message_age,
+      const message_info&,
+      const blob_info&) noexcept final {
+        _close();
+    }
+
+    void handle_cancelled() noexcept final {
+        _close();
+    }
+
+private:
+    auto _mapping() const noexcept -> memory::const_block {
+        return {static_cast<const byte*>(_addr), span_size(_length)};
+    }
+
+    auto _map(const span_size_t offs, const span_size_t size) noexcept -> bool;
+    auto _map_target(const span_size_t size) noexcept -> bool;
+    void _read_ahead(const span_size_t offs) noexcept;
+    void _close() noexcept;
+
+    static constexpr const span_size_t _read_ahead_size{4 * 1024 * 1024};
+
+    int _fd{-1};
+    void* _addr{nullptr};
+    std::size_t _length{0U};
+    memory::block _data{};
+    span_size_t _read_ahead_end{0};
+    bool _writable{false};
+};
+//------------------------------------------------------------------------------
+auto mapped_file_blob_io::_map(
+  const span_size_t offs,
+  const span_size_t size) noexcept -> bool {
+    // the mapping has to start at a page boundary
+    const auto page_size{span_size(::sysconf(_SC_PAGESIZE))};
+    const auto map_offs{offs - offs % page_size};
+    _length = std::size_t(size + offs - map_offs);
+    if(_length == 0U) {
+        return true;
+    }
+    const int prot{_writable ? PROT_READ | PROT_WRITE : PROT_READ};
+    _addr = ::mmap(nullptr, _length, prot, MAP_SHARED, _fd, off_t(map_offs));
+    if(_addr == MAP_FAILED) [[unlikely]] {
+        _addr = nullptr;
+        _length = 0U;
+        return false;
+    }
+    ::posix_madvise(_addr, _length, POSIX_MADV_SEQUENTIAL);
+    _data = {static_cast<byte*>(_addr) + (offs - map_offs), size};
+    return true;
+}
+//------------------------------------------------------------------------------
+auto mapped_file_blob_io::map_source(
+  std::optional<span_size_t> offs,
+  std::optional<span_size_t> size) noexcept -> bool {
+    struct ::stat st{};
+    if(::fstat(_fd, &st) != 0) {
+        return false;
+    }
+    const auto file_size{span_size(st.st_size)};
+    const auto bgn{math::minimum(file_size, offs.value_or(0))};
+    const auto len{math::minimum(file_size - bgn, size.value_or(file_size))};
+    return _map(bgn, len);
+}
+//------------------------------------------------------------------------------
+auto mapped_file_blob_io::_map_target(const span_size_t size) noexcept -> bool {
+    if(size <= 0) {
+        return false;
+    }
+    // preallocate the whole target file before mapping it
+    if(::posix_fallocate(_fd, 0, off_t(size)) != 0) {
+        if(::ftruncate(_fd, off_t(size)) != 0) {
+            return false;
+        }
+    }
+    return _map(0, size);
+}
+//------------------------------------------------------------------------------
+void mapped_file_blob_io::_read_ahead(const span_size_t offs) noexcept {
+    if(offs + _read_ahead_size / 2 >= _read_ahead_end) {
+        const auto bgn{std::max(offs, _read_ahead_end)};
+        const auto end{math::minimum(offs + _read_ahead_size, _data.size())};
+        if(bgn < end) {
+            // the advice range must start at a page boundary too
+            auto* addr{_data.data() + bgn};
+            const auto page_size{span_size(::sysconf(_SC_PAGESIZE))};
+            const auto misalign{
+              span_size(reinterpret_cast<std::uintptr_t>(addr) % page_size)};
+            ::posix_madvise(
+              addr - misalign,
+              std::size_t(end - bgn + misalign),
+              POSIX_MADV_WILLNEED);
+            _read_ahead_end = end;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void mapped_file_blob_io::_close() noexcept {
+    if(_addr) {
+        if(_writable) {
+            ::msync(_addr, _length, MS_ASYNC);
+        }
+        ::munmap(_addr, _length);
+        _addr = nullptr;
+        _length = 0U;
+        _data = {};
+    }
+    if(_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+}
+#endif
+//------------------------------------------------------------------------------
+static auto make_source_blob_file_io(
+  const std::filesystem::path& file_path,
+  std::optional<span_size_t> offs,
+  std::optional<span_size_t> size) -> shared_holder<source_blob_io> {
+#if EAGINE_POSIX
+    if(const int fd{::open(file_path.c_str(), O_RDONLY | O_CLOEXEC)}; fd >= 0) {
+        shared_holder<mapped_file_blob_io> io{
+          hold<mapped_file_blob_io>, fd, false};
+        if(io->map_source(offs, size)) {
+            return io;
+        }
+    }
+#endif
+    std::fstream file{file_path, std::ios::in | std::ios::binary};
+    if(file.is_open()) {
+        return {hold<file_blob_io>, std::move(file), offs, size};
+    }
+    return {};
+}
+//------------------------------------------------------------------------------
+auto make_target_blob_file_io(const std::filesystem::path& file_path)
+  -> unique_holder<target_blob_io> {
+#if EAGINE_POSIX
+    if(const int fd{::open(
+         file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)};
+       fd >= 0) {
+        return {hold<mapped_file_blob_io>, fd, true};
+    }
+    return {};
+#else
+    std::fstream file{
+      file_path,
+      std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary};
+    if(file.is_open()) {
+        return {hold<file_blob_io>, std::move(file), 0, std::nullopt};
+    }
+    return {};
+#endif
+}
+//------------------------------------------------------------------------------
 // resource_server_impl
 //------------------------------------------------------------------------------
 class resource_server_impl : public resource_server_intf {
@@ -409,21 +709,17 @@ auto resource_server_impl::get_resource(
         } else if(locator.has_scheme("file")) {
             const auto file_path = get_file_path(locator);
             if(is_contained(file_path)) {
-                std::fstream file{file_path, std::ios::in | std::ios::binary};
-                if(file.is_open()) {
+                read_io = make_source_blob_file_io(
+                  file_path,
+                  from_string<span_size_t>(locator.argument("offs").or_default())
+                    .to_optional(),
+                  from_string<span_size_t>(locator.argument("size").or_default())
+                    .to_optional());
+                if(read_io) {
                     ctx.bus_node()
                       .log_info("sending file ${filePath} to ${target}")
                       .arg("target", endpoint_id)
                       .arg("filePath", "FsPath", file_path);
-                    read_io.emplace_derived(
-                      hold<file_blob_io>,
-                      std::move(file),
-                      from_string<span_size_t>(
-                        locator.argument("offs").or_default())
-                        .to_optional(),
-                      from_string<span_size_t>(
-                        locator.argument("size").or_default())
-                        .to_optional());
                 }
             }
         }
@@ -535,6 +831,14 @@ public:
       const std::chrono::seconds max_time)
       -> std::optional<message_sequence_t> final;
 
+    auto query_resource_content(
+      endpoint_id_t endpoint_id,
+      const url& locator,
+      const std::filesystem::path& file_path,
+      const message_priority priority,
+      const std::chrono::seconds max_time)
+      -> std::optional<message_sequence_t> final;
+
 private:
     void _handle_alive(
       const result_context&,
@@ -900,6 +1204,25 @@ auto resource_manipulator_impl::query_resource_content(
     return {};
 }
 //------------------------------------------------------------------------------
+auto resource_manipulator_impl::query_resource_content(
+  endpoint_id_t endpoint_id,
+  const url& locator,
+  const std::filesystem::path& file_path,
+  const message_priority priority,
+  const std::chrono::seconds max_time) -> std::optional<message_sequence_t> {
+    shared_holder<target_blob_io> write_io{};
+    write_io = make_target_blob_file_io(file_path);
+    if(not write_io) {
+        base.bus_node()
+          .log_error("failed to open resource target file ${filePath}")
+          .arg("filePath", "FsPath", file_path)
+          .arg("url", "URL", locator.str());
+        return {};
+    }
+    return query_resource_content(
+      endpoint_id, locator, std::move(write_io), priority, max_time);
+}
+//------------------------------------------------------------------------------
 auto make_resource_manipulator_impl(
   subscriber& base,
   resource_manipulator_signals& sigs) -> unique_holder<resource_manipulator_intf> {
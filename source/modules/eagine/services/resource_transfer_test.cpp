@@ -0,0 +1,126 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+
+#include <eagine/testing/unit_begin_ctx.hpp>
+import eagine.core;
+import eagine.msgbus.core;
+import eagine.msgbus.services;
+import std;
+//------------------------------------------------------------------------------
+auto make_resource_test_data(const eagine::span_size_t size)
+  -> std::vector<eagine::byte> {
+    std::vector<eagine::byte> data(eagine::std_size(size));
+    for(std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = eagine::byte(i % 251U);
+    }
+    return data;
+}
+//------------------------------------------------------------------------------
+auto resource_test_fragment(
+  const std::vector<eagine::byte>& data,
+  const eagine::span_size_t offs,
+  const eagine::span_size_t size) -> eagine::memory::const_block {
+    const auto end{std::min(offs + size, eagine::span_size(data.size()))};
+    return {data.data() + offs, end - offs};
+}
+//------------------------------------------------------------------------------
+// file target
+//------------------------------------------------------------------------------
+void resource_transfer_file_target(auto& s) {
+    eagitest::case_ test{s, 1, "file target"};
+    const auto file_path{
+      std::filesystem::temp_directory_path() /
+      "eagine-msgbus-resource_transfer-1.bin"};
+    const eagine::span_size_t fragment_size{1000};
+    const auto data{make_resource_test_data(10 * fragment_size + 123)};
+
+    eagine::msgbus::blob_info info{};
+    info.total_size = eagine::span_size(data.size());
+    {
+        auto io{eagine::msgbus::make_target_blob_file_io(file_path)};
+        test.ensure(bool(io), "has io");
+        // the fragments can arrive in any order
+        for(auto offs{info.total_size - info.total_size % fragment_size};
+            offs >= 0;
+            offs -= fragment_size) {
+            test.check(
+              io->store_fragment(
+                offs, resource_test_fragment(data, offs, fragment_size), info),
+              "stored");
+        }
+        io->handle_finished(
+          {"eagiTest", "resource"},
+          eagine::msgbus::message_age{},
+          eagine::msgbus::message_info{},
+          info);
+    }
+
+    std::ifstream file{file_path, std::ios::in | std::ios::binary};
+    test.ensure(file.is_open(), "file open");
+    std::vector<eagine::byte> stored(data.size() + 1U);
+    file.read(
+      reinterpret_cast<char*>(stored.data()),
+      static_cast<std::streamsize>(stored.size()));
+    test.check_equal(
+      static_cast<std::size_t>(file.gcount()), data.size(), "file size");
+    stored.resize(data.size());
+    test.check(stored == data, "file content");
+    file.close();
+
+    std::filesystem::remove(file_path);
+}
+//------------------------------------------------------------------------------
+// truncated file target
+//------------------------------------------------------------------------------
+void resource_transfer_truncated_target(auto& s) {
+    eagitest::case_ test{s, 2, "truncated target"};
+    const auto file_path{
+      std::filesystem::temp_directory_path() /
+      "eagine-msgbus-resource_transfer-2.bin"};
+    const eagine::span_size_t fragment_size{16 * 1024};
+    const auto data{make_resource_test_data(4 * fragment_size)};
+
+    eagine::msgbus::blob_info info{};
+    info.total_size = eagine::span_size(data.size());
+
+    {
+        auto io{eagine::msgbus::make_target_blob_file_io(file_path)};
+        test.ensure(bool(io), "has io");
+        test.check(
+          io->store_fragment(
+            0, resource_test_fragment(data, 0, fragment_size), info),
+          "first stored");
+
+        // somebody else truncates the file while it is being received
+        std::filesystem::resize_file(file_path, 0U);
+
+        const auto offs{3 * fragment_size};
+        test.check(
+          not io->store_fragment(
+            offs, resource_test_fragment(data, offs, fragment_size), info),
+          "past end not stored");
+        io->handle_cancelled();
+    }
+
+    std::filesystem::remove(file_path);
+}
+//------------------------------------------------------------------------------
+// main
+//------------------------------------------------------------------------------
+auto test_main(eagine::test_ctx& ctx) -> int {
+    eagitest::ctx_suite test{ctx, "resource transfer", 2};
+    test.once(resource_transfer_file_target);
+    test.once(resource_transfer_truncated_target);
+    return test.exit_code();
+}
+//------------------------------------------------------------------------------
+auto main(int argc, const char** argv) -> int {
+    return eagine::test_main_impl(argc, argv, test_main);
+}
+//------------------------------------------------------------------------------
+#include <eagine/testing/unit_end_ctx.hpp>
@@ -50,6 +50,25 @@ export struct statistics_consumer_signals {
     /// @see endpoint_stats_received
     signal<void(const result_context&, const connection_statistics&) noexcept>
       connection_stats_received;
+
+    /// @brief Triggered on receipt of connection latency statistics information.
+    /// @see connection_stats_received
+    signal<void(
+      const result_context&,
+      const connection_latency_statistics&) noexcept>
+      connection_latency_received;
+
+    /// @brief Triggered on receipt of timestamps of a traced message.
+    /// @see router_stats_received
+    /// @see bridge_stats_received
+    /// @see endpoint_stats_received
+    signal<void(const result_context&, const message_trace_record&) noexcept>
+      message_trace_received;
+
+    /// @brief Triggered on receipt of router message queuing time histogram.
+    /// @see router_stats_received
+    signal<void(const result_context&, const latency_histogram&) noexcept>
+      router_latency_received;
 };
 //------------------------------------------------------------------------------
 struct statistics_consumer_intf : interface<statistics_consumer_intf> {
@@ -76,6 +95,21 @@ struct statistics_consumer_intf : interface<statistics_consumer_intf> {
       const message_context& msg_ctx,
       const stored_message& message) noexcept
       -> std::optional<connection_statistics> = 0;
+
+    virtual auto decode_connection_latency(
+      const message_context& msg_ctx,
+      const stored_message& message) noexcept
+      -> std::optional<connection_latency_statistics> = 0;
+
+    virtual auto decode_message_trace(
+      const message_context& msg_ctx,
+      const stored_message& message) noexcept
+      -> std::optional<message_trace_record> = 0;
+
+    virtual auto decode_router_latency(
+      const message_context& msg_ctx,
+      const stored_message& message) noexcept
+      -> std::optional<latency_histogram> = 0;
 };
 //------------------------------------------------------------------------------
 auto make_statistics_consumer_impl(subscriber&, statistics_consumer_signals&)
@@ -128,6 +162,27 @@ public:
         return _impl->decode_connection_statistics(msg_ctx, message);
     }
 
+    auto decode_connection_latency(
+      const message_context& msg_ctx,
+      const stored_message& message) noexcept
+      -> std::optional<connection_latency_statistics> {
+        return _impl->decode_connection_latency(msg_ctx, message);
+    }
+
+    auto decode_message_trace(
+      const message_context& msg_ctx,
+      const stored_message& message) noexcept
+      -> std::optional<message_trace_record> {
+        return _impl->decode_message_trace(msg_ctx, message);
+    }
+
+    auto decode_router_latency(
+      const message_context& msg_ctx,
+      const stored_message& message) noexcept
+      -> std::optional<latency_histogram> {
+        return _impl->decode_router_latency(msg_ctx, message);
+    }
+
     auto decode(const message_context& msg_ctx, const stored_message& message) {
         return this->decode_chain(
           msg_ctx,
@@ -137,7 +192,10 @@ public:
           &statistics_consumer::decode_router_statistics,
           &statistics_consumer::decode_bridge_statistics,
           &statistics_consumer::decode_endpoint_statistics,
-          &statistics_consumer::decode_connection_statistics);
+          &statistics_consumer::decode_connection_statistics,
+          &statistics_consumer::decode_connection_latency,
+          &statistics_consumer::decode_message_trace,
+          &statistics_consumer::decode_router_latency);
     }
 
 protected:
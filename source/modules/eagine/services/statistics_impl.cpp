@@ -37,6 +37,17 @@ public:
         base.add_method(
           this,
           msgbus_map<"statsConn", &statistics_consumer_impl::_handle_connection>{});
+        base.add_method(
+          this,
+          msgbus_map<
+            "statsCnLat",
+            &statistics_consumer_impl::_handle_connection_latency>{});
+        base.add_method(
+          this,
+          msgbus_map<"statsTrace", &statistics_consumer_impl::_handle_trace>{});
+        base.add_method(
+          this,
+          msgbus_map<"statsLtHst", &statistics_consumer_impl::_handle_latency>{});
     }
 
     void query_statistics(endpoint_id_t node_id) noexcept final {
@@ -90,6 +101,40 @@ public:
         return {};
     }
 
+    auto decode_connection_latency(
+      const message_context& msg_ctx,
+      const stored_message& message) noexcept
+      -> std::optional<connection_latency_statistics> final {
+        if(msg_ctx.is_special_message("statsCnLat")) {
+            return default_deserialized<connection_latency_statistics>(
+                     message.content())
+              .to_optional();
+        }
+        return {};
+    }
+
+    auto decode_message_trace(
+      const message_context& msg_ctx,
+      const stored_message& message) noexcept
+      -> std::optional<message_trace_record> final {
+        if(msg_ctx.is_special_message("statsTrace")) {
+            return default_deserialized<message_trace_record>(message.content())
+              .to_optional();
+        }
+        return {};
+    }
+
+    auto decode_router_latency(
+      const message_context& msg_ctx,
+      const stored_message& message) noexcept
+      -> std::optional<latency_histogram> final {
+        if(msg_ctx.is_special_message("statsLtHst")) {
+            return default_deserialized<latency_histogram>(message.content())
+              .to_optional();
+        }
+        return {};
+    }
+
 private:
     auto _handle_router(
       const message_context& msg_ctx,
@@ -133,6 +178,39 @@ private:
         return true;
     }
 
+    auto _handle_connection_latency(
+      const message_context& msg_ctx,
+      const stored_message& message) noexcept -> bool {
+        connection_latency_statistics stats{};
+        if(default_deserialize(stats, message.content())) {
+            signals.connection_latency_received(
+              result_context{msg_ctx, message}, stats);
+        }
+        return true;
+    }
+
+    auto _handle_trace(
+      const message_context& msg_ctx,
+      const stored_message& message) noexcept -> bool {
+        message_trace_record record{};
+        if(default_deserialize(record, message.content())) {
+            signals.message_trace_received(
+              result_context{msg_ctx, message}, record);
+        }
+        return true;
+    }
+
+    auto _handle_latency(
+      const message_context& msg_ctx,
+      const stored_message& message) noexcept -> bool {
+        latency_histogram hist{};
+        if(default_deserialize(hist, message.content())) {
+            signals.router_latency_received(
+              result_context{msg_ctx, message}, hist);
+        }
+        return true;
+    }
+
     subscriber& base;
     statistics_consumer_signals& signals;
 };
@@ -0,0 +1,114 @@
+/// @file
+///
+/// Copyright Matus Chochlik.
+/// Distributed under the Boost Software License, Version 1.0.
+/// See accompanying file LICENSE_1_0.txt or copy at
+/// https://www.boost.org/LICENSE_1_0.txt
+///
+
+#include <eagine/testing/unit_begin_ctx.hpp>
+import std;
+import eagine.core;
+import eagine.msgbus.core;
+import eagine.msgbus.services;
+//------------------------------------------------------------------------------
+// router latency
+//------------------------------------------------------------------------------
+void statistics_router_latency(auto& s) {
+    eagitest::case_ test{s, 1, "router latency"};
+    eagitest::track trck{test, 0, 2};
+    auto& ctx{s.context()};
+
+    eagine::msgbus::endpoint stats_ept{"StatsEndpt", ctx};
+    eagine::msgbus::endpoint query_ept{"QueryEndpt", ctx};
+
+    auto acceptor = eagine::msgbus::make_direct_acceptor(ctx);
+    stats_ept.add_connection(acceptor->make_connection());
+    query_ept.add_connection(acceptor->make_connection());
+
+    eagine::msgbus::router router(ctx);
+    router.add_acceptor(std::move(acceptor));
+
+    eagine::msgbus::service_composition<
+      eagine::msgbus::statistics_consumer<>>
+      consumer{stats_ept};
+
+    eagine::timeout get_id_time{std::chrono::seconds{5}};
+    while(not(stats_ept.has_id() and query_ept.has_id())) {
+        if(get_id_time.is_expired()) {
+            test.fail("failed to get id");
+            return;
+        }
+        router.update();
+        consumer.update();
+        query_ept.update();
+        consumer.process_all();
+    }
+    const auto router_id{router.get_id()};
+
+    // handled by the consumer service
+    bool received{false};
+    const auto handle_latency{[&](
+                                const eagine::msgbus::result_context& rc,
+                                const eagine::msgbus::latency_histogram& hist) {
+        if(rc.source_id() == router_id) {
+            test.check(not hist.is_empty(), "has samples");
+            test.check(hist.max_us >= 0, "max");
+            trck.checkpoint(1);
+            received = true;
+        }
+    }};
+    consumer.router_latency_received.connect(
+      {eagine::construct_from, handle_latency});
+    consumer.query_statistics(router_id);
+
+    // decoded from the message stored in a plain endpoint
+    bool decoded{false};
+    const auto decode_latency{[&](
+                                const eagine::msgbus::message_context& msg_ctx,
+                                const eagine::msgbus::stored_message& message)
+                                noexcept -> bool {
+        test.check_equal(message.source_id, router_id, "source");
+        const auto hist{consumer.decode_router_latency(msg_ctx, message)};
+        test.ensure(hist.has_value(), "decoded");
+        test.check(not hist->is_empty(), "decoded samples");
+        trck.checkpoint(2);
+        decoded = true;
+        return true;
+    }};
+    eagine::msgbus::message_view query{};
+    query.set_target_id(router_id);
+    query_ept.post(eagine::msgbus::msgbus_id{"statsQuery"}, query);
+
+    eagine::timeout receive_time{std::chrono::seconds{10}};
+    while(not(received and decoded)) {
+        if(receive_time.is_expired()) {
+            test.fail("failed to receive latency histogram");
+            break;
+        }
+        router.update();
+        consumer.update();
+        query_ept.update();
+        consumer.process_all();
+        query_ept.process_all(
+          eagine::msgbus::msgbus_id{"statsLtHst"},
+          {eagine::construct_from, decode_latency});
+    }
+}
+//------------------------------------------------------------------------------
+// main
+//------------------------------------------------------------------------------
+auto test_main(eagine::test_ctx& ctx) -> int {
+    enable_message_bus(ctx);
+    ctx.preinitialize();
+
+    eagitest::ctx_suite test{ctx, "statistics", 1};
+    test.once(statistics_router_latency);
+    return test.exit_code();
+}
+//------------------------------------------------------------------------------
+auto main(int argc, const char** argv) -> int {
+    return eagine::test_main_impl(argc, argv, test_main);
+}
+//------------------------------------------------------------------------------
+#include <eagine/testing/unit_end_ctx.hpp>
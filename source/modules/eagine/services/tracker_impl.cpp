@@ -62,6 +62,8 @@ public:
           this, statistics.endpoint_stats_received);
         connect<&This::_handle_connection_stats_received>(
           this, statistics.connection_stats_received);
+        connect<&This::_handle_connection_latency_received>(
+          this, statistics.connection_latency_received);
         connect<&This::_handle_application_name_received>(
           this, application.application_name_received);
         connect<&This::_handle_endpoint_info_received>(
@@ -260,6 +262,12 @@ private:
         _get_connection(stats.local_id, stats.remote_id);
     }
 
+    void _handle_connection_latency_received(
+      const result_context&,
+      const connection_latency_statistics& stats) noexcept {
+        _get_connection(stats.local_id, stats.remote_id).assign(stats);
+    }
+
     void _handle_application_name_received(
       const result_context& ctx,
       const valid_if_not_empty<std::string>& app_name) noexcept {